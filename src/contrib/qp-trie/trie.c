@@ -83,12 +83,45 @@ typedef struct node {
 	void *p;
 } node_t;
 
+/*! \brief Memory block of a frozen trie, see trie_freeze().
+ *
+ * The block is shared by all the tries derived from the frozen one by
+ * copy-on-write, so it's reference counted. The objects inside the block
+ * are never freed or reallocated individually.
+ */
+typedef struct {
+	size_t refs;
+	size_t size;
+	uint8_t *mem;
+} frozen_t;
+
 struct trie {
 	node_t root; // undefined when weight == 0, see empty_root()
 	size_t weight;
 	knot_mm_t mm;
+	frozen_t *frozen; // NULL unless the trie has been frozen
 };
 
+/*! \brief Cache line size assumed by the frozen layout. */
+#define CACHE_LINE 64
+
+/*! \brief Runtime dispatch of the lookup paths to CPU-specific clones.
+ *
+ * The bitmap operations then use the popcnt instruction (and the BMI1/BMI2
+ * bit manipulation for the bitmap masks) instead of the generic x86-64 code.
+ */
+#if defined(HAVE_TARGET_CLONES) && defined(__x86_64__)
+#define HW_DISPATCH __attribute__((target_clones("arch=haswell", "popcnt", "default")))
+#else
+#define HW_DISPATCH
+#endif
+
+#ifdef HAVE_ATOMIC
+#define REFS_ADD(refs, val) __atomic_add_fetch(&(refs), (val), __ATOMIC_ACQ_REL)
+#else
+#define REFS_ADD(refs, val) __sync_add_and_fetch(&(refs), (val))
+#endif
+
 /*! \brief size (in bits) of nibble (half-byte) indexes into keys
  *
  * The bottom bit is clear for the upper nibble, and set for the lower
@@ -190,6 +223,34 @@ static node_t empty_root(void)
 	return mkbranch(TMAX_INDEX-1, 0, NULL);
 }
 
+/*! \brief Is the object (twig array or key) inside the frozen block? */
+static bool in_frozen(const frozen_t *fz, const void *obj)
+{
+	return fz != NULL && (const uint8_t *)obj >= fz->mem &&
+	       (const uint8_t *)obj < fz->mem + fz->size;
+}
+
+static void frozen_ref(frozen_t *fz)
+{
+	if (fz != NULL)
+		REFS_ADD(fz->refs, 1);
+}
+
+static void frozen_unref(frozen_t *fz)
+{
+	if (fz != NULL && REFS_ADD(fz->refs, -1) == 0) {
+		free(fz->mem);
+		free(fz);
+	}
+}
+
+/*! \brief Free a twig array or a key, unless it's inside the frozen block. */
+static void obj_free(knot_mm_t *mm, const frozen_t *fz, void *obj)
+{
+	if (!in_frozen(fz, obj))
+		mm_free(mm, obj);
+}
+
 /*! \brief Propagate error codes. */
 #define ERR_RETURN(x) \
 	do { \
@@ -289,6 +350,12 @@ static node_t* twigs(node_t *t)
 	return t->p;
 }
 
+/*! \brief Prefetch the object of the node (twigs of a branch or key of a leaf). */
+static void prefetch_node(const node_t *t)
+{
+	__builtin_prefetch(isbranch(t) ? t->p : (void *)(uintptr_t)(t->i & TMASK_LEAF));
+}
+
 /*! \brief Get pointer to a particular child of a branch node. */
 static node_t* twig(node_t *t, uint i)
 {
@@ -330,6 +397,7 @@ trie_t* trie_create(knot_mm_t *mm)
 	if (trie != NULL) {
 		trie->root = empty_root();
 		trie->weight = 0;
+		trie->frozen = NULL;
 		if (mm != NULL)
 			trie->mm = *mm;
 		else
@@ -339,15 +407,15 @@ trie_t* trie_create(knot_mm_t *mm)
 }
 
 /*! \brief Free anything under the trie node, except for the passed pointer itself. */
-static void clear_trie(node_t *trie, knot_mm_t *mm)
+static void clear_trie(node_t *trie, knot_mm_t *mm, const frozen_t *fz)
 {
 	if (!isbranch(trie)) {
-		mm_free(mm, tkey(trie));
+		obj_free(mm, fz, tkey(trie));
 	} else {
 		uint n = branch_weight(trie);
 		for (uint i = 0; i < n; ++i)
-			clear_trie(twig(trie, i), mm);
-		mm_free(mm, twigs(trie));
+			clear_trie(twig(trie, i), mm, fz);
+		obj_free(mm, fz, twigs(trie));
 	}
 }
 
@@ -356,16 +424,18 @@ void trie_free(trie_t *tbl)
 	if (tbl == NULL)
 		return;
 	if (tbl->weight)
-		clear_trie(&tbl->root, &tbl->mm);
+		clear_trie(&tbl->root, &tbl->mm, tbl->frozen);
+	frozen_unref(tbl->frozen);
 	mm_free(&tbl->mm, tbl);
 }
 
 void trie_clear(trie_t *tbl)
 {
 	assert(tbl);
-	if (!tbl->weight)
-		return;
-	clear_trie(&tbl->root, &tbl->mm);
+	if (tbl->weight)
+		clear_trie(&tbl->root, &tbl->mm, tbl->frozen);
+	frozen_unref(tbl->frozen);
+	tbl->frozen = NULL;
 	tbl->root = empty_root();
 	tbl->weight = 0;
 }
@@ -382,7 +452,7 @@ static bool dup_trie(node_t *copy, const node_t *orig, trie_dup_cb dup_cb, knot_
 		for (uint i = 0; i < n; ++i) {
 			if (!dup_trie(cotw + i, ortw + i, dup_cb, mm)) {
 				while (i-- > 0) {
-					clear_trie(cotw + i, mm);
+					clear_trie(cotw + i, mm, NULL);
 				}
 				mm_free(mm, cotw);
 				return false;
@@ -412,6 +482,7 @@ trie_t* trie_dup(const trie_t *orig, trie_dup_cb dup_cb, knot_mm_t *mm)
 		return NULL;
 	}
 	copy->weight = orig->weight;
+	copy->frozen = NULL;
 	if (mm != NULL) {
 		copy->mm = *mm;
 	} else {
@@ -432,18 +503,20 @@ size_t trie_weight(const trie_t *tbl)
 	return tbl->weight;
 }
 
+HW_DISPATCH
 trie_val_t* trie_get_try(trie_t *tbl, const trie_key_t *key, uint32_t len)
 {
 	assert(tbl);
 	if (!tbl->weight)
 		return NULL;
 	node_t *t = &tbl->root;
+	prefetch_node(t);
 	while (isbranch(t)) {
-		__builtin_prefetch(twigs(t));
 		bitmap_t b = twigbit(t, key, len);
 		if (!hastwig(t, b))
 			return NULL;
 		t = twig(t, twigoff(t, b));
+		prefetch_node(t);
 	}
 	tkey_t *lkey = tkey(t);
 	if (key_cmp(key, len, lkey->chars, lkey->len) != 0)
@@ -454,6 +527,7 @@ trie_val_t* trie_get_try(trie_t *tbl, const trie_key_t *key, uint32_t len)
 /* Optimization: the approach isn't ideal, as e.g. walking through the prefix
  * is duplicated and we explicitly construct the wildcard key.  Still, it's close
  * to optimum which would be significantly more complicated and error-prone to write. */
+HW_DISPATCH
 trie_val_t* trie_get_try_wildcard(trie_t *tbl, const trie_key_t *key, uint32_t len)
 {
 	assert(tbl);
@@ -461,11 +535,12 @@ trie_val_t* trie_get_try_wildcard(trie_t *tbl, const trie_key_t *key, uint32_t l
 		return NULL;
 	// Find leaf sharing the longest common prefix; see ns_find_branch() for explanation.
 	node_t *t = &tbl->root;
+	prefetch_node(t);
 	while (isbranch(t)) {
-		__builtin_prefetch(twigs(t));
 		bitmap_t b = twigbit(t, key, len);
 		uint i = hastwig(t, b) ? twigoff(t, b) : 0;
 		t = twig(t, i);
+		prefetch_node(t);
 	}
 	const tkey_t * const lcp_key = tkey(t);
 
@@ -490,12 +565,26 @@ trie_val_t* trie_get_try_wildcard(trie_t *tbl, const trie_key_t *key, uint32_t l
 	return trie_get_try(tbl, wild_key, wild_len);
 }
 
+/*! \brief Resize the twig array; the arrays in the frozen block are moved out of it. */
+static node_t *twigs_resize(trie_t *tbl, node_t *tp, uint cc, uint prev_cc)
+{
+	if (in_frozen(tbl->frozen, tp)) {
+		if (cc <= prev_cc) // shrink in place
+			return tp;
+		node_t *nt = mm_alloc(&tbl->mm, sizeof(node_t) * cc);
+		if (nt != NULL)
+			memcpy(nt, tp, sizeof(node_t) * prev_cc);
+		return nt;
+	}
+	return mm_realloc(&tbl->mm, tp, sizeof(node_t) * cc, sizeof(node_t) * prev_cc);
+}
+
 /*! \brief Delete leaf t with parent p; b is the bit for t under p.
  * Optionally return the deleted value via val.  The function can't fail. */
 static void del_found(trie_t *tbl, node_t *t, node_t *p, bitmap_t b, trie_val_t *val)
 {
 	assert(!tkey(t)->cow);
-	mm_free(&tbl->mm, tkey(t));
+	obj_free(&tbl->mm, tbl->frozen, tkey(t));
 	if (val != NULL)
 		*val = *tvalp(t); // we return trie_val_t directly when deleting
 	--tbl->weight;
@@ -512,13 +601,12 @@ static void del_found(trie_t *tbl, node_t *t, node_t *p, bitmap_t b, trie_val_t
 	if (cc == 2) {
 		// collapse binary node p: move the other child to the parent
 		*p = tp[1 - ci];
-		mm_free(&tbl->mm, tp);
+		obj_free(&tbl->mm, tbl->frozen, tp);
 		return;
 	}
 	memmove(tp + ci, tp + ci + 1, sizeof(node_t) * (cc - ci - 1));
 	p->i &= ~b;
-	node_t *newt = mm_realloc(&tbl->mm, tp, sizeof(node_t) * (cc - 1),
-				  sizeof(node_t) * cc);
+	node_t *newt = twigs_resize(tbl, tp, cc - 1, cc);
 	if (likely(newt != NULL))
 		p->p = newt;
 	// We can ignore mm_realloc failure because an oversized twig
@@ -638,6 +726,7 @@ static inline int ns_longer(nstack_t *ns)
  *
  *  \return KNOT_EOK or KNOT_ENOMEM.
  */
+HW_DISPATCH
 static int ns_find_branch(nstack_t *ns, const trie_key_t *key, uint32_t len,
                           index_t *idiff, bitmap_t *tbit, bitmap_t *kbit)
 {
@@ -646,7 +735,6 @@ static int ns_find_branch(nstack_t *ns, const trie_key_t *key, uint32_t len,
 	while (isbranch(ns->stack[ns->len - 1])) {
 		ERR_RETURN(ns_longer(ns));
 		node_t *t = ns->stack[ns->len - 1];
-		__builtin_prefetch(twigs(t));
 		bitmap_t b = twigbit(t, key, len);
 		// Even if our key is missing from this branch we need to
 		// keep iterating down to a leaf. It doesn't matter which
@@ -655,6 +743,7 @@ static int ns_find_branch(nstack_t *ns, const trie_key_t *key, uint32_t len,
 		// an out-of-bounds index if it equals twigmax(t).
 		uint i = hastwig(t, b) ? twigoff(t, b) : 0;
 		ns->stack[ns->len++] = twig(t, i);
+		prefetch_node(ns->stack[ns->len - 1]);
 	}
 	tkey_t *lkey = tkey(ns->stack[ns->len-1]);
 	// Find index of the first char that differs.
@@ -719,6 +808,7 @@ static int ns_last_leaf(nstack_t *ns)
 			return KNOT_EOK;
 		uint lasti = branch_weight(t) - 1;
 		ns->stack[ns->len++] = twig(t, lasti);
+		prefetch_node(ns->stack[ns->len - 1]);
 	} while (true);
 }
 
@@ -736,6 +826,7 @@ static int ns_first_leaf(nstack_t *ns)
 		if (!isbranch(t))
 			return KNOT_EOK;
 		ns->stack[ns->len++] = twig(t, 0);
+		prefetch_node(ns->stack[ns->len - 1]);
 	} while (true);
 }
 
@@ -957,8 +1048,7 @@ static trie_val_t* cow_get_ins(trie_cow_t *cow, trie_t *tbl,
 		// new child position and original child count
 		uint s = twigoff(t, kbit);
 		uint m = branch_weight(t);
-		node_t *nt = mm_realloc(&tbl->mm, twigs(t),
-				sizeof(node_t) * (m + 1), sizeof(node_t) * m);
+		node_t *nt = twigs_resize(tbl, twigs(t), m + 1, m);
 		if (unlikely(!nt))
 			goto err_leaf;
 		memmove(nt + s + 1, nt + s, sizeof(node_t) * (m - s));
@@ -995,6 +1085,227 @@ trie_val_t* trie_get_ins(trie_t *tbl, const trie_key_t *key, uint32_t len)
 	return cow_get_ins(NULL, tbl, key, len);
 }
 
+/*! \brief Branch node under construction by trie_bulk_build(). */
+typedef struct {
+	index_t index;
+	bitmap_t bmp;
+	uint n;
+	node_t twigs[TWIDTH_BMP];
+} bulk_level_t;
+
+/*!
+ * \brief Find the first nibble where the key differs from the previous one.
+ *
+ * \return KNOT_EOK, or KNOT_EINVAL if the key isn't greater than the previous one.
+ */
+static int bulk_diff(const tkey_t *prev, const trie_key_t *key, uint32_t len,
+                     index_t *idiff)
+{
+	uint32_t plen = prev->len;
+	uint32_t minlen = MIN(plen, len);
+	uint32_t bytei = 0;
+	while (bytei < minlen && prev->chars[bytei] == key[bytei])
+		++bytei;
+	if (bytei == minlen) {
+		// The previous key must be a proper prefix of the key.
+		if (len <= plen)
+			return KNOT_EINVAL;
+		*idiff = (index_t)bytei << 1;
+		return KNOT_EOK;
+	}
+	uint8_t k1 = (uint8_t)key[bytei];
+	uint8_t k2 = (uint8_t)prev->chars[bytei];
+	if (k1 < k2)
+		return KNOT_EINVAL;
+	*idiff = ((index_t)bytei << 1) + (((k1 ^ k2) & 0xf0) == 0);
+	return KNOT_EOK;
+}
+
+/*! \brief Finish the top branch with the last subtree as its last twig. */
+static int bulk_pop(bulk_level_t *level, node_t *last, const tkey_t *lkey, knot_mm_t *mm)
+{
+	level->bmp |= keybit(level->index, lkey->chars, lkey->len);
+	level->twigs[level->n++] = *last;
+	node_t *tw = mm_alloc(mm, sizeof(node_t) * level->n);
+	if (unlikely(!tw)) {
+		--level->n;
+		return KNOT_ENOMEM;
+	}
+	memcpy(tw, level->twigs, sizeof(node_t) * level->n);
+	*last = mkbranch(level->index, level->bmp, tw);
+	return KNOT_EOK;
+}
+
+int trie_bulk_build(trie_t *tbl, trie_bulk_cb *cb, void *d)
+{
+	assert(tbl && cb);
+	if (tbl->weight)
+		return KNOT_EINVAL;
+
+	// The right spine of the trie; each key only touches its bottom part.
+	uint32_t levels_max = 64, height = 0;
+	bulk_level_t *levels = malloc(levels_max * sizeof(*levels));
+	if (unlikely(!levels))
+		return KNOT_ENOMEM;
+
+	size_t weight = 0;
+	node_t leaf, last; // the subtree holding the last key, not yet attached
+	const tkey_t *lkey = NULL; // the last key
+	const trie_key_t *key;
+	uint32_t len;
+	trie_val_t val;
+	int ret;
+	while ((ret = cb(&key, &len, &val, d)) == KNOT_EOK) {
+		index_t idiff = 0;
+		if (lkey != NULL && (ret = bulk_diff(lkey, key, len, &idiff)) != KNOT_EOK)
+			goto fail;
+		if ((ret = mkleaf(&leaf, key, len, &tbl->mm)) != KNOT_EOK)
+			goto fail;
+		leaf.p = val;
+		if (lkey != NULL) {
+			// Close the branches below the branching point.
+			while (height > 0 && levels[height - 1].index > idiff) {
+				ret = bulk_pop(&levels[height - 1], &last, lkey, &tbl->mm);
+				if (ret != KNOT_EOK)
+					goto fail_leaf;
+				--height;
+			}
+			if (height == 0 || levels[height - 1].index < idiff) {
+				if (height == levels_max) {
+					bulk_level_t *nl = realloc(levels, 2 * levels_max * sizeof(*levels));
+					if (unlikely(!nl)) {
+						ret = KNOT_ENOMEM;
+						goto fail_leaf;
+					}
+					levels = nl;
+					levels_max *= 2;
+				}
+				levels[height++] = (bulk_level_t){ .index = idiff };
+			}
+			bulk_level_t *top = &levels[height - 1];
+			top->bmp |= keybit(idiff, lkey->chars, lkey->len);
+			top->twigs[top->n++] = last;
+		}
+		last = leaf;
+		lkey = tkey(&leaf);
+		++weight;
+	}
+	if (ret != KNOT_ENOENT)
+		goto fail;
+
+	// Close the whole spine.
+	while (height > 0) {
+		ret = bulk_pop(&levels[height - 1], &last, lkey, &tbl->mm);
+		if (ret != KNOT_EOK)
+			goto fail;
+		--height;
+	}
+	if (weight > 0) {
+		tbl->root = last;
+		tbl->weight = weight;
+	}
+	free(levels);
+	return KNOT_EOK;
+fail_leaf:
+	mm_free(&tbl->mm, tkey(&leaf));
+fail:
+	if (weight > 0)
+		clear_trie(&last, &tbl->mm, NULL);
+	while (height > 0) {
+		bulk_level_t *level = &levels[--height];
+		for (uint i = 0; i < level->n; ++i)
+			clear_trie(&level->twigs[i], &tbl->mm, NULL);
+	}
+	free(levels);
+	return ret;
+}
+
+/*! \brief Size of a key in the frozen block, keeping the alignment of nodes. */
+static size_t frozen_key_size(const tkey_t *lkey)
+{
+	size_t align = sizeof(node_t);
+	return (sizeof(tkey_t) + lkey->len + align - 1) & ~(align - 1);
+}
+
+/*! \brief Offset of a twig array in the frozen block, so that the arrays fitting
+ *         in a cache line don't span two cache lines. */
+static size_t frozen_twigs_pos(size_t pos, size_t size)
+{
+	if (size <= CACHE_LINE && pos % CACHE_LINE + size > CACHE_LINE)
+		return pos + CACHE_LINE - pos % CACHE_LINE;
+	return pos;
+}
+
+/*!
+ * \brief Move the objects under the branch into the frozen block.
+ *
+ * The twig array is followed by the keys of its leaves, so the final step
+ * of a lookup likely hits the same cache line, then the subtries follow
+ * in depth-first order. If mem is NULL, only the size is computed.
+ */
+static void freeze_branch(trie_t *tbl, node_t *t, uint8_t *mem, size_t *pos)
+{
+	uint cc = branch_weight(t);
+	size_t size = sizeof(node_t) * cc;
+	*pos = frozen_twigs_pos(*pos, size);
+	node_t *tw = twigs(t);
+	if (mem != NULL) {
+		tw = memcpy(mem + *pos, tw, size);
+		obj_free(&tbl->mm, tbl->frozen, twigs(t));
+		t->p = tw;
+	}
+	*pos += size;
+	for (uint i = 0; i < cc; ++i) {
+		if (isbranch(&tw[i]))
+			continue;
+		tkey_t *lkey = tkey(&tw[i]);
+		if (mem != NULL) {
+			memcpy(mem + *pos, lkey, sizeof(tkey_t) + lkey->len);
+			obj_free(&tbl->mm, tbl->frozen, lkey);
+			tw[i].i = (uintptr_t)(mem + *pos) | (tw[i].i & ~TMASK_LEAF);
+		}
+		*pos += frozen_key_size(tkey(&tw[i]));
+	}
+	for (uint i = 0; i < cc; ++i) {
+		if (isbranch(&tw[i]))
+			freeze_branch(tbl, &tw[i], mem, pos);
+	}
+}
+
+int trie_freeze(trie_t *tbl)
+{
+	assert(tbl);
+	if (!isbranch(&tbl->root)) { // empty or single leaf
+		frozen_unref(tbl->frozen);
+		tbl->frozen = NULL;
+		return KNOT_EOK;
+	}
+	if (twigs(&tbl->root)->i & TFLAG_COW)
+		return KNOT_EBUSY;
+
+	size_t size = 0;
+	freeze_branch(tbl, &tbl->root, NULL, &size);
+
+	frozen_t *fz = malloc(sizeof(*fz));
+	void *mem = NULL;
+	if (fz == NULL || posix_memalign(&mem, CACHE_LINE, size) != 0) {
+		free(fz);
+		return KNOT_ENOMEM;
+	}
+	fz->refs = 1;
+	fz->size = size;
+	fz->mem = mem;
+
+	size_t pos = 0;
+	freeze_branch(tbl, &tbl->root, fz->mem, &pos);
+	assert(pos == size);
+
+	frozen_unref(tbl->frozen);
+	tbl->frozen = fz;
+
+	return KNOT_EOK;
+}
+
 /*! \brief Apply a function to every trie_val_t*, in order; a recursive solution. */
 static int apply_nodes(node_t *t, int (*f)(trie_val_t *, void *), void *d)
 {
@@ -1356,6 +1667,8 @@ trie_cow_t* trie_cow(trie_t *old, trie_cb *mark_shared, void *d)
 	new->mm = old->mm;
 	new->root = old->root;
 	new->weight = old->weight;
+	new->frozen = old->frozen;
+	frozen_ref(new->frozen);
 	cow->old = old;
 	cow->new = new;
 	cow->mark_shared = mark_shared;
@@ -1412,7 +1725,7 @@ static void cow_cleanup(trie_cow_t *cow, node_t *t, trie_cb *cb, void *d)
 		uint cc = branch_weight(t);
 		for (uint ci = 0; ci < cc; ++ci)
 			cow_cleanup(cow, twig(t, ci), cb, d);
-		mm_free(&cow->new->mm, twigs(t));
+		obj_free(&cow->new->mm, cow->new->frozen, twigs(t));
 		return;
 	} else {
 		// application must decide how to clean up its values
@@ -1425,7 +1738,7 @@ static void cow_cleanup(trie_cow_t *cow, node_t *t, trie_cb *cb, void *d)
 		if (lkey->cow)
 			lkey->cow = 0;
 		else
-			mm_free(&cow->new->mm, lkey);
+			obj_free(&cow->new->mm, cow->new->frozen, lkey);
 		return;
 	}
 }
@@ -1435,6 +1748,7 @@ trie_t* trie_cow_commit(trie_cow_t *cow, trie_cb *cb, void *d)
 	trie_t *ret = cow->new;
 	if (cow->old->weight)
 		cow_cleanup(cow, &cow->old->root, cb, d);
+	frozen_unref(cow->old->frozen);
 	mm_free(&ret->mm, cow->old);
 	mm_free(&ret->mm, cow);
 	return ret;
@@ -1445,6 +1759,7 @@ trie_t* trie_cow_rollback(trie_cow_t *cow, trie_cb *cb, void *d)
 	trie_t *ret = cow->old;
 	if (cow->new->weight)
 		cow_cleanup(cow, &cow->new->root, cb, d);
+	frozen_unref(cow->new->frozen);
 	mm_free(&ret->mm, cow->new);
 	mm_free(&ret->mm, cow);
 	return ret;
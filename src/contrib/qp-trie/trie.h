@@ -56,6 +56,15 @@ typedef trie_val_t (*trie_dup_cb)(const trie_val_t val, knot_mm_t *mm);
  */
 typedef void trie_cb(trie_val_t val, const trie_key_t *key, size_t len, void *d);
 
+/*!
+ * \brief Callback providing the next key and value for trie_bulk_build().
+ *
+ * The key is copied, so its buffer may be reused by the next call.
+ *
+ * \return KNOT_EOK, KNOT_ENOENT if there are no more keys, or KNOT_E*.
+ */
+typedef int trie_bulk_cb(const trie_key_t **key, uint32_t *len, trie_val_t *val, void *d);
+
 /*! \brief Opaque type for holding the copy-on-write state for a QP-trie. */
 typedef struct trie_cow trie_cow_t;
 
@@ -88,6 +97,36 @@ trie_val_t* trie_get_try_wildcard(trie_t *tbl, const trie_key_t *key, uint32_t l
 /*! \brief Search the trie, inserting NULL trie_val_t on failure. */
 trie_val_t* trie_get_ins(trie_t *tbl, const trie_key_t *key, uint32_t len);
 
+/*!
+ * \brief Build the trie from keys in ascending order in one pass.
+ *
+ * The trie is built bottom-up without any searching or reallocation,
+ * which is much faster than inserting the keys one by one.
+ *
+ * \param tbl  Empty trie.
+ * \param cb   Callback providing the keys in strictly ascending order.
+ * \param d    Callback context.
+ *
+ * \return KNOT_EOK, KNOT_EINVAL if the trie isn't empty or the keys aren't
+ *         strictly ascending (the trie stays empty), or KNOT_E*.
+ */
+int trie_bulk_build(trie_t *tbl, trie_bulk_cb *cb, void *d);
+
+/*!
+ * \brief Relayout the trie into a single dense block for faster lookups.
+ *
+ * The twig arrays are placed in depth-first order so that small ones don't
+ * span two cache lines, followed by the keys in key order. The trie stays
+ * fully functional; modified parts are moved out of the block, which is
+ * shared with the tries derived by copy-on-write and freed with the last one.
+ *
+ * \note The trie must not have concurrent readers nor be in a COW transaction.
+ *
+ * \return KNOT_EOK, KNOT_EBUSY if in a COW transaction, or KNOT_ENOMEM
+ *         (the trie is unchanged).
+ */
+int trie_freeze(trie_t *tbl);
+
 /*!
  * \brief Search for less-or-equal element.
  *
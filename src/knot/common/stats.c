@@ -23,6 +23,8 @@
 #include "contrib/files.h"
 #include "knot/common/stats.h"
 #include "knot/common/log.h"
+#include "knot/dnssec/rrset-sign.h"
+#include "knot/journal/journal_read.h"
 #include "knot/nameserver/query_module.h"
 
 struct {
@@ -51,8 +53,103 @@ uint64_t server_zone_count(server_t *server)
 	return knot_zonedb_size(server->zone_db);
 }
 
+static uint64_t server_nsec3_hashes(server_t *server)
+{
+	return nsec3_caches_hashes(&server->nsec3_caches);
+}
+
+static uint64_t server_nsec3_hash_rate(server_t *server)
+{
+	return nsec3_caches_rate(&server->nsec3_caches, knot_time());
+}
+
+static uint64_t server_nsec3_cache_hits(server_t *server)
+{
+	return nsec3_caches_hits(&server->nsec3_caches);
+}
+
+static uint64_t server_journal_oldest_reader(server_t *server)
+{
+	(void)server;
+	return journal_read_oldest_age();
+}
+
+static uint64_t server_journal_write_txns(server_t *server)
+{
+	uint64_t txns, wait_us;
+	journal_shards_write_stats(&server->journaldb, &txns, &wait_us);
+	return txns;
+}
+
+static uint64_t server_journal_write_wait(server_t *server)
+{
+	uint64_t txns, wait_us;
+	journal_shards_write_stats(&server->journaldb, &txns, &wait_us);
+	return wait_us;
+}
+
+static uint64_t server_journal_group_commits(server_t *server)
+{
+	uint64_t commits, writes, max;
+	journal_shards_group_stats(&server->journaldb, &commits, &writes, &max);
+	return commits;
+}
+
+static uint64_t server_journal_group_writes(server_t *server)
+{
+	uint64_t commits, writes, max;
+	journal_shards_group_stats(&server->journaldb, &commits, &writes, &max);
+	return writes;
+}
+
+static uint64_t server_journal_group_max(server_t *server)
+{
+	uint64_t commits, writes, max;
+	journal_shards_group_stats(&server->journaldb, &commits, &writes, &max);
+	return max;
+}
+
+static uint64_t server_soa_probe_queries(server_t *server)
+{
+	uint64_t queries, batches;
+	soa_probe_stats(server->soa_probe, &queries, &batches);
+	return queries;
+}
+
+static uint64_t server_soa_probe_batches(server_t *server)
+{
+	uint64_t queries, batches;
+	soa_probe_stats(server->soa_probe, &queries, &batches);
+	return batches;
+}
+
+static uint64_t server_keystore_session_checkouts(server_t *server)
+{
+	(void)server;
+	return knot_sign_session_checkouts();
+}
+
+static uint64_t server_keystore_session_wait(server_t *server)
+{
+	(void)server;
+	return knot_sign_session_wait();
+}
+
 const stats_item_t server_stats[] = {
-	{ "zone-count", server_zone_count },
+	{ "zone-count",       server_zone_count },
+	{ "nsec3-hashes",     server_nsec3_hashes },
+	{ "nsec3-hash-rate",  server_nsec3_hash_rate },
+	{ "nsec3-cache-hits", server_nsec3_cache_hits },
+	{ "keystore-session-checkouts", server_keystore_session_checkouts },
+	{ "keystore-session-wait",      server_keystore_session_wait },
+	{ "journal-oldest-reader",      server_journal_oldest_reader },
+	{ "journal-write-txns",         server_journal_write_txns },
+	{ "journal-write-wait",         server_journal_write_wait },
+	{ "journal-group-commits",      server_journal_group_commits },
+	{ "journal-group-writes",       server_journal_group_writes },
+	{ "journal-group-max",          server_journal_group_max },
+	{ "soa-probe-queries",          server_soa_probe_queries },
+	{ "soa-probe-batches",          server_soa_probe_batches },
 	{ 0 }
 };
 
@@ -14,6 +14,7 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -62,6 +63,18 @@ void systemd_tasks_status_notify(int tasks)
 #endif
 }
 
+void systemd_loading_status_notify(size_t done, size_t total, int64_t eta)
+{
+#ifdef ENABLE_SYSTEMD
+	if (eta >= 0) {
+		sd_notifyf(0, "STATUS=Loading zones %zu/%zu, ETA %"PRId64" s...",
+		           done, total, eta);
+	} else {
+		sd_notifyf(0, "STATUS=Loading zones %zu/%zu...", done, total);
+	}
+#endif
+}
+
 void systemd_ready_notify(void)
 {
 #ifdef ENABLE_SYSTEMD
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 /*!
  * \brief Notify systemd about zone loading start.
  */
@@ -32,6 +35,15 @@ void systemd_zone_load_timeout_notify(void);
  */
 void systemd_tasks_status_notify(int tasks);
 
+/*!
+ * \brief Update systemd service status with zone loading progress.
+ *
+ * \param done   Number of loaded zones.
+ * \param total  Number of zones to be loaded.
+ * \param eta    Estimated remaining time in seconds, negative if unknown.
+ */
+void systemd_loading_status_notify(size_t done, size_t total, int64_t eta);
+
 /*!
  * \brief Notify systemd about service is ready.
  */
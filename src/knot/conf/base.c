@@ -169,6 +169,9 @@ static void init_cache(
 	val = conf_get(conf, C_SRV, C_TCP_FASTOPEN);
 	conf->cache.srv_tcp_fastopen = conf_bool(&val);
 
+	val = conf_get(conf, C_SRV, C_RMT_PROBE_WINDOW);
+	conf->cache.srv_rmt_probe_window = conf_int(&val);
+
 	conf->cache.srv_tcp_reuseport = running_tcp_reuseport;
 
 	conf->cache.srv_socket_affinity = running_socket_affinity;
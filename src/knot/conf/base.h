@@ -125,6 +125,7 @@ typedef struct {
 		int srv_tcp_remote_io_timeout;
 		bool srv_tcp_reuseport;
 		bool srv_tcp_fastopen;
+		int srv_rmt_probe_window;
 		bool srv_socket_affinity;
 		size_t srv_udp_threads;
 		size_t srv_tcp_threads;
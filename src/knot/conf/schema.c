@@ -23,6 +23,7 @@
 #include "knot/conf/confio.h"
 #include "knot/conf/tools.h"
 #include "knot/common/log.h"
+#include "knot/journal/journal_shards.h"
 #include "knot/updates/acl.h"
 #include "libknot/rrtype/opt.h"
 #include "libdnssec/tsig.h"
@@ -132,6 +133,12 @@ static const knot_lookup_t zone_digest[] = {
 	{ 0, NULL }
 };
 
+static const knot_lookup_t zone_digest_scheme[] = {
+	{ ZONE_DIGEST_SCHEME_SIMPLE, "simple" },
+	{ ZONE_DIGEST_SCHEME_MERKLE, "merkle" },
+	{ 0, NULL }
+};
+
 static const knot_lookup_t journal_content[] = {
 	{ JOURNAL_CONTENT_NONE,    "none" },
 	{ JOURNAL_CONTENT_CHANGES, "changes" },
@@ -139,6 +146,12 @@ static const knot_lookup_t journal_content[] = {
 	{ 0, NULL }
 };
 
+static const knot_lookup_t journal_compression[] = {
+	{ JOURNAL_COMPRESSION_NONE, "none" },
+	{ JOURNAL_COMPRESSION_ZLIB, "zlib" },
+	{ 0, NULL }
+};
+
 static const knot_lookup_t zonefile_load[] = {
 	{ ZONEFILE_LOAD_NONE,  "none" },
 	{ ZONEFILE_LOAD_DIFF,  "difference" },
@@ -197,6 +210,7 @@ static const yp_item_t desc_server[] = {
 	{ C_TCP_FASTOPEN,         YP_TBOOL, YP_VNONE },
 	{ C_RMT_POOL_LIMIT,       YP_TINT,  YP_VINT = { 0, INT32_MAX, 0 } },
 	{ C_RMT_POOL_TIMEOUT,     YP_TINT,  YP_VINT = { 1, INT32_MAX, 5, YP_STIME } },
+	{ C_RMT_PROBE_WINDOW,     YP_TINT,  YP_VINT = { 0, 1000, 0 } },
 	{ C_SOCKET_AFFINITY,      YP_TBOOL, YP_VNONE },
 	{ C_UDP_MAX_PAYLOAD,      YP_TINT,  YP_VINT = { KNOT_EDNS_MIN_DNSSEC_PAYLOAD,
 	                                                KNOT_EDNS_MAX_UDP_PAYLOAD,
@@ -209,6 +223,7 @@ static const yp_item_t desc_server[] = {
 	                                                1232, YP_SSIZE } },
 	{ C_ECS,                  YP_TBOOL, YP_VNONE },
 	{ C_ANS_ROTATION,         YP_TBOOL, YP_VNONE },
+	{ C_COLD_ZONES_MAX_SIZE,  YP_TINT,  YP_VINT = { 0, SSIZE_MAX, SSIZE_MAX, YP_SSIZE } },
 	{ C_LISTEN,               YP_TADDR, YP_VADDR = { 53 }, YP_FMULTI, { check_listen } },
 	{ C_COMMENT,              YP_TSTR,  YP_VNONE },
 	// Legacy items.
@@ -270,6 +285,8 @@ static const yp_item_t desc_database[] = {
 	{ C_JOURNAL_DB_MODE,     YP_TOPT,  YP_VOPT = { journal_modes, JOURNAL_MODE_ROBUST } },
 	{ C_JOURNAL_DB_MAX_SIZE, YP_TINT,  YP_VINT = { MEGA(1), VIRT_MEM_LIMIT(TERA(100)),
 	                                               VIRT_MEM_LIMIT(GIGA(20)), YP_SSIZE } },
+	{ C_JOURNAL_DB_SHARDS,   YP_TINT,  YP_VINT = { 1, JOURNAL_SHARDS_MAX, 1 } },
+	{ C_JOURNAL_DB_GROUP_WINDOW, YP_TINT, YP_VINT = { 0, 1000, 0 } },
 	{ C_KASP_DB,             YP_TSTR,  YP_VSTR = { "keys" } },
 	{ C_KASP_DB_MAX_SIZE,    YP_TINT,  YP_VINT = { MEGA(5), VIRT_MEM_LIMIT(GIGA(100)),
 	                                               MEGA(500), YP_SSIZE } },
@@ -287,6 +304,7 @@ static const yp_item_t desc_keystore[] = {
 	{ C_BACKEND, YP_TOPT, YP_VOPT = { keystore_backends, KEYSTORE_BACKEND_PEM },
 	                      CONF_IO_FRLD_ZONES },
 	{ C_CONFIG,  YP_TSTR, YP_VSTR = { "keys" }, CONF_IO_FRLD_ZONES },
+	{ C_SESSIONS, YP_TINT, YP_VINT = { 0, 255, 0 }, CONF_IO_FRLD_ZONES },
 	{ C_COMMENT, YP_TSTR, YP_VNONE },
 	{ NULL }
 };
@@ -370,6 +388,7 @@ static const yp_item_t desc_policy[] = {
 	                                   CONF_IO_FRLD_ZONES },
 	{ C_RRSIG_PREREFRESH,    YP_TINT,  YP_VINT = { 0, UINT32_MAX, HOURS(1), YP_STIME },
 	                                   CONF_IO_FRLD_ZONES },
+	{ C_RRSIG_INDEX,         YP_TBOOL, YP_VNONE, CONF_IO_FRLD_ZONES },
 	{ C_REPRO_SIGNING,       YP_TBOOL, YP_VNONE, CONF_IO_FRLD_ZONES },
 	{ C_NSEC3,               YP_TBOOL, YP_VNONE, CONF_IO_FRLD_ZONES },
 	{ C_NSEC3_ITER,          YP_TINT,  YP_VINT = { 0, UINT16_MAX, 10 }, CONF_IO_FRLD_ZONES },
@@ -403,13 +422,17 @@ static const yp_item_t desc_policy[] = {
 	{ C_JOURNAL_CONTENT,     YP_TOPT,  YP_VOPT = { journal_content, JOURNAL_CONTENT_CHANGES }, FLAGS }, \
 	{ C_JOURNAL_MAX_USAGE,   YP_TINT,  YP_VINT = { KILO(40), SSIZE_MAX, MEGA(100), YP_SSIZE } }, \
 	{ C_JOURNAL_MAX_DEPTH,   YP_TINT,  YP_VINT = { 2, SSIZE_MAX, 20 } }, \
+	{ C_JOURNAL_COMPRESSION, YP_TOPT,  YP_VOPT = { journal_compression, JOURNAL_COMPRESSION_NONE } }, \
 	{ C_ZONE_MAX_SIZE,       YP_TINT,  YP_VINT = { 0, SSIZE_MAX, SSIZE_MAX, YP_SSIZE }, FLAGS }, \
 	{ C_ADJUST_THR,          YP_TINT,  YP_VINT = { 1, UINT16_MAX, 1 } }, \
+	{ C_RDATA_DEDUP,         YP_TBOOL, YP_VNONE, FLAGS }, \
+	{ C_COLD_LOAD,           YP_TBOOL, YP_VNONE, FLAGS }, \
 	{ C_DNSSEC_SIGNING,      YP_TBOOL, YP_VNONE, FLAGS }, \
 	{ C_DNSSEC_VALIDATION,   YP_TBOOL, YP_VNONE, FLAGS }, \
 	{ C_DNSSEC_POLICY,       YP_TREF,  YP_VREF = { C_POLICY }, FLAGS, { check_ref_dflt } }, \
 	{ C_SERIAL_POLICY,       YP_TOPT,  YP_VOPT = { serial_policies, SERIAL_POLICY_INCREMENT } }, \
 	{ C_ZONEMD_GENERATE,     YP_TOPT,  YP_VOPT = { zone_digest, ZONE_DIGEST_NONE }, FLAGS }, \
+	{ C_ZONEMD_SCHEME,       YP_TOPT,  YP_VOPT = { zone_digest_scheme, ZONE_DIGEST_SCHEME_SIMPLE }, FLAGS }, \
 	{ C_ZONEMD_VERIFY,       YP_TBOOL, YP_VNONE, FLAGS }, \
 	{ C_REFRESH_MIN_INTERVAL,YP_TINT,  YP_VINT = { 2, UINT32_MAX, 2, YP_STIME } }, \
 	{ C_REFRESH_MAX_INTERVAL,YP_TINT,  YP_VINT = { 2, UINT32_MAX, UINT32_MAX, YP_STIME } }, \
@@ -40,6 +40,8 @@
 #define C_CDS_CDNSKEY		"\x13""cds-cdnskey-publish"
 #define C_CDS_DIGESTTYPE	"\x0F""cds-digest-type"
 #define C_CHK_INTERVAL		"\x0E""check-interval"
+#define C_COLD_LOAD		"\x09""cold-load"
+#define C_COLD_ZONES_MAX_SIZE	"\x13""cold-zones-max-size"
 #define C_COMMENT		"\x07""comment"
 #define C_CONFIG		"\x06""config"
 #define C_CTL			"\x07""control"
@@ -58,10 +60,13 @@
 #define C_ID			"\x02""id"
 #define C_IDENT			"\x08""identity"
 #define C_INCL			"\x07""include"
+#define C_JOURNAL_COMPRESSION	"\x13""journal-compression"
 #define C_JOURNAL_CONTENT	"\x0F""journal-content"
 #define C_JOURNAL_DB		"\x0A""journal-db"
+#define C_JOURNAL_DB_GROUP_WINDOW	"\x17""journal-db-group-window"
 #define C_JOURNAL_DB_MAX_SIZE	"\x13""journal-db-max-size"
 #define C_JOURNAL_DB_MODE	"\x0F""journal-db-mode"
+#define C_JOURNAL_DB_SHARDS	"\x11""journal-db-shards"
 #define C_JOURNAL_MAX_DEPTH	"\x11""journal-max-depth"
 #define C_JOURNAL_MAX_USAGE	"\x11""journal-max-usage"
 #define C_KASP_DB		"\x07""kasp-db"
@@ -91,13 +96,16 @@
 #define C_PIDFILE		"\x07""pidfile"
 #define C_POLICY		"\x06""policy"
 #define C_PROPAG_DELAY		"\x11""propagation-delay"
+#define C_RDATA_DEDUP		"\x0B""rdata-dedup"
 #define C_REFRESH_MAX_INTERVAL	"\x14""refresh-max-interval"
 #define C_REFRESH_MIN_INTERVAL	"\x14""refresh-min-interval"
 #define C_REPRO_SIGNING		"\x14""reproducible-signing"
 #define C_RMT			"\x06""remote"
 #define C_RMT_POOL_LIMIT	"\x11""remote-pool-limit"
 #define C_RMT_POOL_TIMEOUT	"\x13""remote-pool-timeout"
+#define C_RMT_PROBE_WINDOW	"\x13""remote-probe-window"
 #define C_ROUTE_CHECK		"\x0B""route-check"
+#define C_RRSIG_INDEX		"\x0B""rrsig-index"
 #define C_RRSIG_LIFETIME	"\x0E""rrsig-lifetime"
 #define C_RRSIG_PREREFRESH	"\x11""rrsig-pre-refresh"
 #define C_RRSIG_REFRESH		"\x0D""rrsig-refresh"
@@ -107,6 +115,7 @@
 #define C_SEM_CHECKS		"\x0F""semantic-checks"
 #define C_SERIAL_POLICY		"\x0D""serial-policy"
 #define C_SERVER		"\x06""server"
+#define C_SESSIONS		"\x08""sessions"
 #define C_SIGNING_THREADS	"\x0F""signing-threads"
 #define C_SINGLE_TYPE_SIGNING	"\x13""single-type-signing"
 #define C_SOCKET_AFFINITY	"\x0F""socket-affinity"
@@ -147,6 +156,7 @@
 #define C_ZONEFILE_LOAD		"\x0D""zonefile-load"
 #define C_ZONEFILE_SYNC		"\x0D""zonefile-sync"
 #define C_ZONEMD_GENERATE	"\x0F""zonemd-generate"
+#define C_ZONEMD_SCHEME		"\x0D""zonemd-scheme"
 #define C_ZONEMD_VERIFY		"\x0D""zonemd-verify"
 #define C_ZONE_MAX_SIZE		"\x0D""zone-max-size"
 #define C_ZONE_MAX_TLL		"\x0C""zone-max-ttl"
@@ -205,12 +215,22 @@ enum {
 	ZONE_DIGEST_REMOVE = 255,
 };
 
+enum {
+	ZONE_DIGEST_SCHEME_SIMPLE = 1,
+	ZONE_DIGEST_SCHEME_MERKLE = 240, // Private use scheme.
+};
+
 enum {
 	JOURNAL_CONTENT_NONE    = 0,
 	JOURNAL_CONTENT_CHANGES = 1,
 	JOURNAL_CONTENT_ALL     = 2,
 };
 
+enum {
+	JOURNAL_COMPRESSION_NONE = 0,
+	JOURNAL_COMPRESSION_ZLIB = 1,
+};
+
 enum {
 	JOURNAL_MODE_ROBUST = 0, // Robust journal DB disk synchronization.
 	JOURNAL_MODE_ASYNC  = 1, // Asynchronous journal DB disk synchronization.
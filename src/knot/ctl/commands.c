@@ -14,6 +14,7 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <inttypes.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
@@ -28,6 +29,7 @@
 #include "knot/events/handlers.h"
 #include "knot/journal/journal_metadata.h"
 #include "knot/nameserver/query_module.h"
+#include "knot/nameserver/xfr_cache.h"
 #include "knot/updates/zone-update.h"
 #include "knot/zone/backup.h"
 #include "knot/zone/digest.h"
@@ -320,6 +322,47 @@ static int zone_status(zone_t *zone, ctl_args_t *args)
 		}
 	}
 
+	if (MATCH_OR_FILTER(args, CTL_FILTER_STATUS_DIGEST)) {
+		data[KNOT_CTL_IDX_TYPE] = "digest";
+		if (zone->digest.computed) {
+			ret = snprintf(buff, sizeof(buff), "%.0f ms", zone->digest.duration);
+		} else {
+			ret = snprintf(buff, sizeof(buff), "none");
+		}
+		if (ret < 0 || ret >= sizeof(buff)) {
+			return KNOT_ESPACE;
+		}
+		data[KNOT_CTL_IDX_DATA] = buff;
+
+		ret = knot_ctl_send(args->ctl, type, &data);
+		if (ret != KNOT_EOK) {
+			return ret;
+		} else {
+			type = KNOT_CTL_TYPE_EXTRA;
+		}
+	}
+
+	if (MATCH_OR_FILTER(args, CTL_FILTER_STATUS_SIGNING)) {
+		data[KNOT_CTL_IDX_TYPE] = "signing";
+		char stats[256];
+		if (zone->signing.collected) {
+			ret = sign_stats_print(&zone->signing.last, stats, sizeof(stats));
+		} else {
+			ret = snprintf(stats, sizeof(stats), "none");
+		}
+		if (ret < 0 || ret >= sizeof(stats)) {
+			return KNOT_ESPACE;
+		}
+		data[KNOT_CTL_IDX_DATA] = stats;
+
+		ret = knot_ctl_send(args->ctl, type, &data);
+		if (ret != KNOT_EOK) {
+			return ret;
+		} else {
+			type = KNOT_CTL_TYPE_EXTRA;
+		}
+	}
+
 	if (MATCH_OR_FILTER(args, CTL_FILTER_STATUS_EVENTS)) {
 		for (zone_event_type_t i = 0; i < ZONE_EVENT_COUNT; i++) {
 			// Events not worth showing or used elsewhere.
@@ -473,7 +516,7 @@ static int init_backup(ctl_args_t *args, bool restore_mode)
 	                           args->data[KNOT_CTL_IDX_DATA],
 	                           knot_lmdb_copy_size(&args->server->kaspdb),
 	                           conf_int(&timer_db_size),
-	                           knot_lmdb_copy_size(&args->server->journaldb),
+	                           journal_shards_copy_size(&args->server->journaldb),
 	                           knot_lmdb_copy_size(&args->server->catalog.db),
 	                           &ctx);
 	if (ret != KNOT_EOK) {
@@ -1228,11 +1271,16 @@ static bool zone_names_distinct(const knot_dname_t *zone, void *data)
 	return !knot_dname_is_equal(zone, zone_to_purge);
 }
 
+typedef struct {
+	server_t *server;
+	knot_lmdb_db_t *shard;
+} orphan_ctx_t;
+
 static int drop_journal_if_orphan(const knot_dname_t *for_zone, void *ctx)
 {
-	server_t *server = ctx;
-	zone_journal_t j = { &server->journaldb, for_zone };
-	if (!zone_exists(for_zone, server->zone_db)) {
+	orphan_ctx_t *orphan = ctx;
+	zone_journal_t j = { orphan->shard, for_zone };
+	if (!zone_exists(for_zone, orphan->server->zone_db)) {
 		return journal_scrape_with_md(j, false);
 	}
 	return KNOT_EOK;
@@ -1274,9 +1322,14 @@ static int orphans_purge(ctl_args_t *args)
 
 		// Purge zone journals of unconfigured zones.
 		if (only_orphan || MATCH_AND_FILTER(args, CTL_FILTER_PURGE_JOURNAL)) {
-			ret = journals_walk(&args->server->journaldb,
-			                    drop_journal_if_orphan, args->server);
-			log_if_orphans_error(NULL, ret, "journal");
+			journal_shards_t *shards = &args->server->journaldb;
+			for (unsigned i = 0; i < shards->count; i++) {
+				orphan_ctx_t orphan = { args->server, &shards->shards[i] };
+				ret = journals_walk(orphan.shard, drop_journal_if_orphan, &orphan);
+				if (i == 0 || ret != KNOT_ENODB) { // unused shard
+					log_if_orphans_error(NULL, ret, "journal");
+				}
+			}
 		}
 
 		// Purge timers of unconfigured zones.
@@ -1311,7 +1364,8 @@ static int orphans_purge(ctl_args_t *args)
 
 				// Purge zone journal.
 				if (only_orphan || MATCH_AND_FILTER(args, CTL_FILTER_PURGE_JOURNAL)) {
-					zone_journal_t j = { &args->server->journaldb, zone_name };
+					zone_journal_t j = { journal_shard(&args->server->journaldb, zone_name),
+					                     zone_name };
 					ret = journal_scrape_with_md(j, true);
 					log_if_orphans_error(zone_name, ret, "journal");
 				}
@@ -1370,6 +1424,7 @@ static int zone_purge(zone_t *zone, ctl_args_t *args)
 
 	// Purge the zone journal.
 	if (MATCH_OR_FILTER(args, CTL_FILTER_PURGE_JOURNAL)) {
+		xfr_cache_clear(zone->xfr_cache);
 		ret = journal_scrape_with_md(zone_journal(zone), true);
 		RETURN_IF_FAILED(KNOT_ENOENT);
 	}
@@ -1617,6 +1672,21 @@ static int server_status(ctl_args_t *args)
 		               conf()->cache.srv_udp_threads, conf()->cache.srv_tcp_threads,
 		               conf()->cache.srv_xdp_threads, conf()->cache.srv_bg_threads,
 		               running_bkg_wrk, wrk_queue);
+	} else if (strcasecmp(type, "loading") == 0) {
+		load_progress_t progress;
+		load_plan_progress(&args->server->load_plan, &progress);
+		ret = snprintf(buff, sizeof(buff), "Loaded zones: %zu/%zu, "
+		               "loaded bytes: %"PRIu64"/%"PRIu64", ETA: ",
+		               progress.zones_done, progress.zones_total,
+		               progress.bytes_done, progress.bytes_total);
+		if (ret > 0 && ret < sizeof(buff)) {
+			if (progress.eta >= 0) {
+				ret += snprintf(buff + ret, sizeof(buff) - ret,
+				                "%"PRId64" s", progress.eta);
+			} else {
+				ret += snprintf(buff + ret, sizeof(buff) - ret, "unknown");
+			}
+		}
 	} else if (strcasecmp(type, "configure") == 0) {
 		ret = snprintf(buff, sizeof(buff), "%s", CONFIGURE_SUMMARY);
 	} else {
@@ -31,6 +31,8 @@
 #define CTL_FILTER_STATUS_TRANSACTION	't'
 #define CTL_FILTER_STATUS_FREEZE	'f'
 #define CTL_FILTER_STATUS_EVENTS	'e'
+#define CTL_FILTER_STATUS_DIGEST	'd'
+#define CTL_FILTER_STATUS_SIGNING	'g'
 
 #define CTL_FILTER_PURGE_EXPIRE		'e'
 #define CTL_FILTER_PURGE_ZONEFILE	'f'
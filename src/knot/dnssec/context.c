@@ -84,6 +84,9 @@ static void policy_load(knot_kasp_policy_t *policy, conf_t *conf, conf_val_t *id
 	val = conf_id_get(conf, C_POLICY, C_RRSIG_PREREFRESH, id);
 	policy->rrsig_prerefresh = conf_int(&val);
 
+	val = conf_id_get(conf, C_POLICY, C_RRSIG_INDEX, id);
+	policy->rrsig_index = conf_bool(&val);
+
 	val = conf_id_get(conf, C_POLICY, C_REPRO_SIGNING, id);
 	policy->reproducible_sign = conf_bool(&val);
 
@@ -202,7 +205,8 @@ int kdnssec_ctx_init(conf_t *conf, kdnssec_ctx_t *ctx, const knot_dname_t *zone_
 	conf_id_fix_default(&policy_id);
 	policy_load(ctx->policy, conf, &policy_id);
 
-	ret = zone_init_keystore(conf, &policy_id, &ctx->keystore, NULL);
+	ret = zone_init_keystore(conf, &policy_id, &ctx->keystore, NULL,
+	                         &ctx->keystore_sessions);
 	if (ret != KNOT_EOK) {
 		goto init_error;
 	}
@@ -34,6 +34,7 @@ typedef struct {
 	knot_kasp_zone_t *zone;
 	knot_kasp_policy_t *policy;
 	dnssec_keystore_t *keystore;
+	unsigned keystore_sessions;  // size of the keystore session pool, 0 if none
 
 	char *kasp_zone_path;
 
@@ -315,7 +315,8 @@ void free_key_params(key_params_t *parm)
 }
 
 int zone_init_keystore(conf_t *conf, conf_val_t *policy_id,
-                       dnssec_keystore_t **keystore, unsigned *backend)
+                       dnssec_keystore_t **keystore, unsigned *backend,
+                       unsigned *sessions)
 {
 	char *zone_path = conf_db(conf, C_KASP_DB);
 	if (zone_path == NULL) {
@@ -335,9 +336,20 @@ int zone_init_keystore(conf_t *conf, conf_val_t *policy_id,
 
 	int ret = keystore_load(config, _backend, zone_path, keystore);
 
+	// The session pool only makes sense for a token.
+	unsigned _sessions = 0;
+	if (ret == KNOT_EOK && _backend == KEYSTORE_BACKEND_PKCS11) {
+		val = conf_id_get(conf, C_KEYSTORE, C_SESSIONS, &keystore_id);
+		_sessions = conf_int(&val);
+		(void)dnssec_keystore_set_sessions(*keystore, _sessions);
+	}
+
 	if (backend != NULL) {
 		*backend = _backend;
 	}
+	if (sessions != NULL) {
+		*sessions = _sessions;
+	}
 
 	free(zone_path);
 	return ret;
@@ -48,7 +48,8 @@ void kasp_zone_free(knot_kasp_zone_t **zone);
 void free_key_params(key_params_t *parm);
 
 int zone_init_keystore(conf_t *conf, conf_val_t *policy_id,
-                       dnssec_keystore_t **keystore, unsigned *backend);
+                       dnssec_keystore_t **keystore, unsigned *backend,
+                       unsigned *sessions);
 
 int kasp_zone_keys_from_rr(knot_kasp_zone_t *zone,
                            const knot_rdataset_t *zone_dnskey,
@@ -106,6 +106,7 @@ typedef struct {
 	uint32_t rrsig_lifetime;            // like knot_time_t
 	uint32_t rrsig_refresh_before;      // like knot_timediff_t
 	uint32_t rrsig_prerefresh;          // like knot_timediff_t
+	bool rrsig_index;                   // re-sign just expiring signatures, spread them
 	// NSEC3
 	bool nsec3_enabled;
 	bool nsec3_opt_out;
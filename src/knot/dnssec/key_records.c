@@ -135,19 +135,22 @@ int key_records_sign(const zone_key_t *key, key_records_t *r, const kdnssec_ctx_
 	dnssec_sign_ctx_t *sign_ctx;
 	int ret = dnssec_sign_new(&sign_ctx, key->key);
 	if (ret != DNSSEC_EOK) {
-		ret = knot_error_from_libdnssec(ret);
+		return knot_error_from_libdnssec(ret);
 	}
 
-	if (!knot_rrset_empty(&r->dnskey) && knot_zone_sign_use_key(key, &r->dnskey)) {
-		ret = knot_sign_rrset(&r->rrsig, &r->dnskey, key->key, sign_ctx, kctx, NULL, expires);
-	}
-	if (ret == KNOT_EOK && !knot_rrset_empty(&r->cdnskey) && knot_zone_sign_use_key(key, &r->cdnskey)) {
-		ret = knot_sign_rrset(&r->rrsig, &r->cdnskey, key->key, sign_ctx, kctx, NULL, expires);
-	}
-	if (ret == KNOT_EOK && !knot_rrset_empty(&r->cds) && knot_zone_sign_use_key(key, &r->cds)) {
-		ret = knot_sign_rrset(&r->rrsig, &r->cds, key->key, sign_ctx, kctx, NULL, expires);
+	knot_rrset_t *rrsigs[] = { &r->rrsig, &r->rrsig, &r->rrsig };
+	const knot_rrset_t *covered[3];
+	size_t count = 0;
+
+	const knot_rrset_t *all_rr[] = { &r->dnskey, &r->cdnskey, &r->cds };
+	for (int i = 0; i < 3; i++) {
+		if (!knot_rrset_empty(all_rr[i]) && knot_zone_sign_use_key(key, all_rr[i])) {
+			covered[count++] = all_rr[i];
+		}
 	}
 
+	ret = knot_sign_rrsets(rrsigs, covered, count, key->key, sign_ctx, kctx, NULL, expires);
+
 	dnssec_sign_free(sign_ctx);
 	return ret;
 }
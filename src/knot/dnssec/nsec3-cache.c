@@ -0,0 +1,212 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/dnssec/nsec3-cache.h"
+#include "knot/dnssec/zone-nsec.h"
+#include "contrib/openbsd/siphash.h"
+#include "libdnssec/error.h"
+#include "libdnssec/random.h"
+#include "libknot/errcode.h"
+#include "libknot/error.h"
+
+#ifdef HAVE_ATOMIC
+#define ATOMIC_SET(dst, val) __atomic_store_n(&(dst), (val), __ATOMIC_RELAXED)
+#define ATOMIC_GET(src)      __atomic_load_n(&(src), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_SET(dst, val) ((dst) = (val))
+#define ATOMIC_GET(src)      (src)
+#endif
+
+#define HASH_LEN 20 // SHA-1, the only NSEC3 hash algorithm
+
+typedef struct {
+	uint64_t params;             /*!< Fingerprint of the NSEC3 parameters, 0 if empty. */
+	uint8_t hash[HASH_LEN];      /*!< Raw NSEC3 hash. */
+	knot_dname_storage_t name;   /*!< Hashed name. */
+} cache_entry_t;
+
+struct nsec3_cache {
+	uint64_t key[2];             /*!< SipHash key, against predictable collisions. */
+	cache_entry_t *entries;      /*!< Allocated on the first use. */
+
+	uint64_t hashes;             /*!< Computed hashes. */
+	uint64_t hits;               /*!< Hashes found in the cache. */
+	uint64_t rate_second;        /*!< Second of the current rate counter. */
+	uint64_t rate_cur;           /*!< Hashes computed in the current second. */
+	uint64_t rate_prev;          /*!< Hashes computed in the previous second. */
+};
+
+static uint64_t params_fingerprint(const nsec3_cache_t *cache,
+                                   const dnssec_nsec3_params_t *params)
+{
+	uint8_t head[4] = { params->algorithm, params->iterations >> 8,
+	                    params->iterations, params->salt.size };
+
+	SIPHASH_CTX ctx;
+	SipHash24_Init(&ctx, (const SIPHASH_KEY *)cache->key);
+	SipHash24_Update(&ctx, head, sizeof(head));
+	SipHash24_Update(&ctx, params->salt.data, params->salt.size);
+	uint64_t fp = SipHash24_End(&ctx);
+
+	return fp != 0 ? fp : 1;
+}
+
+static void count_hash(nsec3_cache_t *cache)
+{
+	uint64_t now = knot_time();
+	uint64_t second = cache->rate_second;
+	if (now != second) {
+		ATOMIC_SET(cache->rate_prev, (now == second + 1) ? cache->rate_cur : 0);
+		ATOMIC_SET(cache->rate_cur, 0);
+		ATOMIC_SET(cache->rate_second, now);
+	}
+	ATOMIC_SET(cache->rate_cur, cache->rate_cur + 1);
+	ATOMIC_SET(cache->hashes, cache->hashes + 1);
+}
+
+int nsec3_cache_owner(nsec3_cache_t *cache, knot_dname_storage_t out,
+                      const knot_dname_t *owner, const knot_dname_t *zone_apex,
+                      const dnssec_nsec3_params_t *params)
+{
+	if (out == NULL || owner == NULL || zone_apex == NULL || params == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (cache == NULL || dnssec_nsec3_hash_length(params->algorithm) != HASH_LEN) {
+		return knot_create_nsec3_owner(out, sizeof(knot_dname_storage_t),
+		                               owner, zone_apex, params);
+	}
+
+	if (cache->entries == NULL) {
+		cache->entries = calloc(NSEC3_CACHE_SIZE, sizeof(*cache->entries));
+		if (cache->entries == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	size_t owner_size = knot_dname_size(owner);
+	uint64_t params_fp = params_fingerprint(cache, params);
+	uint64_t slot = SipHash24((const SIPHASH_KEY *)cache->key, owner, owner_size) ^ params_fp;
+	cache_entry_t *entry = &cache->entries[slot % NSEC3_CACHE_SIZE];
+
+	if (entry->params == params_fp && memcmp(entry->name, owner, owner_size) == 0) {
+		ATOMIC_SET(cache->hits, cache->hits + 1);
+		return knot_nsec3_hash_to_dname(out, sizeof(knot_dname_storage_t),
+		                                entry->hash, HASH_LEN, zone_apex);
+	}
+
+	dnssec_binary_t data = { .data = (uint8_t *)owner, .size = owner_size };
+	int ret = dnssec_nsec3_hash_batch(&data, 1, params, entry->hash);
+	if (ret != DNSSEC_EOK) {
+		entry->params = 0;
+		return knot_error_from_libdnssec(ret);
+	}
+	count_hash(cache);
+
+	entry->params = params_fp;
+	memcpy(entry->name, owner, owner_size);
+
+	return knot_nsec3_hash_to_dname(out, sizeof(knot_dname_storage_t),
+	                                entry->hash, HASH_LEN, zone_apex);
+}
+
+int nsec3_caches_init(nsec3_caches_t *caches, unsigned count)
+{
+	if (caches == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	caches->caches = calloc(count, sizeof(*caches->caches));
+	if (caches->caches == NULL && count > 0) {
+		return KNOT_ENOMEM;
+	}
+	caches->count = count;
+
+	for (unsigned i = 0; i < count; i++) {
+		nsec3_cache_t *cache = calloc(1, sizeof(*cache));
+		if (cache == NULL) {
+			nsec3_caches_deinit(caches);
+			return KNOT_ENOMEM;
+		}
+		cache->key[0] = dnssec_random_uint64_t();
+		cache->key[1] = dnssec_random_uint64_t();
+		caches->caches[i] = cache;
+	}
+
+	return KNOT_EOK;
+}
+
+void nsec3_caches_deinit(nsec3_caches_t *caches)
+{
+	if (caches == NULL) {
+		return;
+	}
+
+	for (unsigned i = 0; i < caches->count && caches->caches != NULL; i++) {
+		if (caches->caches[i] != NULL) {
+			free(caches->caches[i]->entries);
+			free(caches->caches[i]);
+		}
+	}
+	free(caches->caches);
+	memset(caches, 0, sizeof(*caches));
+}
+
+nsec3_cache_t *nsec3_caches_get(const nsec3_caches_t *caches, unsigned thread_id)
+{
+	if (caches == NULL || thread_id >= caches->count) {
+		return NULL;
+	}
+
+	return caches->caches[thread_id];
+}
+
+uint64_t nsec3_caches_hashes(const nsec3_caches_t *caches)
+{
+	uint64_t res = 0;
+	for (unsigned i = 0; i < caches->count; i++) {
+		res += ATOMIC_GET(caches->caches[i]->hashes);
+	}
+	return res;
+}
+
+uint64_t nsec3_caches_rate(const nsec3_caches_t *caches, knot_time_t now)
+{
+	uint64_t res = 0;
+	for (unsigned i = 0; i < caches->count; i++) {
+		const nsec3_cache_t *cache = caches->caches[i];
+		uint64_t second = ATOMIC_GET(cache->rate_second);
+		if (second == now) {
+			res += ATOMIC_GET(cache->rate_prev);
+		} else if (second + 1 == now) {
+			res += ATOMIC_GET(cache->rate_cur);
+		}
+	}
+	return res;
+}
+
+uint64_t nsec3_caches_hits(const nsec3_caches_t *caches)
+{
+	uint64_t res = 0;
+	for (unsigned i = 0; i < caches->count; i++) {
+		res += ATOMIC_GET(caches->caches[i]->hits);
+	}
+	return res;
+}
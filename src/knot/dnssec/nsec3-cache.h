@@ -0,0 +1,90 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "contrib/time.h"
+#include "libdnssec/nsec.h"
+#include "libknot/dname.h"
+
+/*! \brief Number of cached hashes per thread. */
+#define NSEC3_CACHE_SIZE 1024
+
+/*!
+ * \brief Cache of NSEC3 hashes computed when answering queries.
+ *
+ * The cache is owned by one query processing thread, the counters may be
+ * read from any thread.
+ */
+typedef struct nsec3_cache nsec3_cache_t;
+
+/*!
+ * \brief NSEC3 caches of all query processing threads.
+ */
+typedef struct {
+	nsec3_cache_t **caches;
+	unsigned count;
+} nsec3_caches_t;
+
+/*!
+ * \brief Create NSEC3 owner name from regular owner name, using a cache.
+ *
+ * The entries are keyed by the name and the NSEC3 parameters, so a change
+ * of NSEC3PARAM makes the previous entries unused.
+ *
+ * \param cache      Cache of the current thread, NULL to compute the name only.
+ * \param out        Output buffer.
+ * \param owner      Node owner name.
+ * \param zone_apex  Zone apex name.
+ * \param params     Params for NSEC3 hashing function.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int nsec3_cache_owner(nsec3_cache_t *cache, knot_dname_storage_t out,
+                      const knot_dname_t *owner, const knot_dname_t *zone_apex,
+                      const dnssec_nsec3_params_t *params);
+
+/*!
+ * \brief Initialize caches for given number of threads.
+ */
+int nsec3_caches_init(nsec3_caches_t *caches, unsigned count);
+
+/*!
+ * \brief Free the caches.
+ */
+void nsec3_caches_deinit(nsec3_caches_t *caches);
+
+/*!
+ * \brief Get the cache of a thread, NULL if not available.
+ */
+nsec3_cache_t *nsec3_caches_get(const nsec3_caches_t *caches, unsigned thread_id);
+
+/*!
+ * \brief Get the total number of hashes computed by all threads.
+ */
+uint64_t nsec3_caches_hashes(const nsec3_caches_t *caches);
+
+/*!
+ * \brief Get the number of hashes computed by all threads in the last second.
+ */
+uint64_t nsec3_caches_rate(const nsec3_caches_t *caches, knot_time_t now);
+
+/*!
+ * \brief Get the total number of hashes found in the caches.
+ */
+uint64_t nsec3_caches_hits(const nsec3_caches_t *caches);
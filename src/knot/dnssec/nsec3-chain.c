@@ -221,17 +221,41 @@ static zone_node_t *create_nsec3_node(const knot_dname_t *owner,
 	return new_node;
 }
 
+/*!
+ * \brief Create type bitmap of the NSEC3 node for given regular node.
+ */
+static dnssec_nsec_bitmap_t *nsec3_bitmap_for_node(const zone_node_t *node,
+                                                    const zone_node_t *apex)
+{
+	dnssec_nsec_bitmap_t *rr_types = dnssec_nsec_bitmap_new();
+	if (!rr_types) {
+		return NULL;
+	}
+
+	bitmap_add_node_rrsets(rr_types, node, false);
+	if (node->rrset_count > 0 && node_should_be_signed_nsec3(node)) {
+		dnssec_nsec_bitmap_add(rr_types, KNOT_RRTYPE_RRSIG);
+	}
+	if (node == apex) {
+		dnssec_nsec_bitmap_add(rr_types, KNOT_RRTYPE_NSEC3PARAM);
+	}
+
+	return rr_types;
+}
+
 /*!
  * \brief Create new NSEC3 node for given regular node.
  *
- * \param node       Node for which the NSEC3 node is created.
- * \param apex       Zone apex node.
- * \param params     NSEC3 hash function parameters.
- * \param ttl        TTL of the new NSEC3 node.
+ * \param node         Node for which the NSEC3 node is created.
+ * \param nsec3_owner  Hashed owner of the node.
+ * \param apex         Zone apex node.
+ * \param params       NSEC3 hash function parameters.
+ * \param ttl          TTL of the new NSEC3 node.
  *
  * \return Error code, KNOT_EOK if successful.
  */
 static zone_node_t *create_nsec3_node_for_node(const zone_node_t *node,
+                                               const knot_dname_t *nsec3_owner,
                                                zone_node_t *apex,
                                                const dnssec_nsec3_params_t *params,
                                                uint32_t ttl)
@@ -240,26 +264,11 @@ static zone_node_t *create_nsec3_node_for_node(const zone_node_t *node,
 	assert(apex);
 	assert(params);
 
-	knot_dname_storage_t nsec3_owner;
-	int ret = knot_create_nsec3_owner(nsec3_owner, sizeof(nsec3_owner),
-	                                  node->owner, apex->owner, params);
-	if (ret != KNOT_EOK) {
-		return NULL;
-	}
-
-	dnssec_nsec_bitmap_t *rr_types = dnssec_nsec_bitmap_new();
+	dnssec_nsec_bitmap_t *rr_types = nsec3_bitmap_for_node(node, apex);
 	if (!rr_types) {
 		return NULL;
 	}
 
-	bitmap_add_node_rrsets(rr_types, node, false);
-	if (node->rrset_count > 0 && node_should_be_signed_nsec3(node)) {
-		dnssec_nsec_bitmap_add(rr_types, KNOT_RRTYPE_RRSIG);
-	}
-	if (node == apex) {
-		dnssec_nsec_bitmap_add(rr_types, KNOT_RRTYPE_NSEC3PARAM);
-	}
-
 	zone_node_t *nsec3_node = create_nsec3_node(nsec3_owner, params, apex,
 	                                            rr_types, ttl);
 	dnssec_nsec_bitmap_free(rr_types);
@@ -267,6 +276,80 @@ static zone_node_t *create_nsec3_node_for_node(const zone_node_t *node,
 	return nsec3_node;
 }
 
+/* - NSEC3 owners hashing in batches ---------------------------------------- */
+
+/*! \brief Number of owner names hashed at once. */
+#define NSEC3_BATCH 64
+
+/*!
+ * \brief Regular nodes waiting for their NSEC3 nodes.
+ *
+ * The owners and bitmaps are copied, as the regular node may be removed
+ * from the zone before the batch is processed.
+ */
+typedef struct {
+	knot_dname_storage_t owners[NSEC3_BATCH];
+	knot_dname_storage_t hashed[NSEC3_BATCH];
+	dnssec_nsec_bitmap_t *rr_types[NSEC3_BATCH];
+	size_t count;
+} nsec3_batch_t;
+
+static void nsec3_batch_clear(nsec3_batch_t *batch)
+{
+	for (size_t i = 0; i < batch->count; i++) {
+		dnssec_nsec_bitmap_free(batch->rr_types[i]);
+	}
+	batch->count = 0;
+}
+
+static int nsec3_batch_add(nsec3_batch_t *batch, const zone_node_t *node,
+                           const zone_node_t *apex)
+{
+	assert(batch->count < NSEC3_BATCH);
+
+	dnssec_nsec_bitmap_t *rr_types = nsec3_bitmap_for_node(node, apex);
+	if (rr_types == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	memcpy(batch->owners[batch->count], node->owner, knot_dname_size(node->owner));
+	batch->rr_types[batch->count++] = rr_types;
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Hash the owners in the batch and create their NSEC3 nodes.
+ */
+static int nsec3_batch_flush(nsec3_batch_t *batch, zone_node_t *apex,
+                             const dnssec_nsec3_params_t *params, uint32_t ttl,
+                             zone_tree_t *nsec3_nodes, sign_stats_t *stats)
+{
+	const knot_dname_t *owners[NSEC3_BATCH];
+	for (size_t i = 0; i < batch->count; i++) {
+		owners[i] = batch->owners[i];
+	}
+
+	int ret = knot_create_nsec3_owners(batch->hashed, owners, batch->count,
+	                                   apex->owner, params);
+	if (stats != NULL) {
+		stats->nsec3_hashes += batch->count;
+	}
+	for (size_t i = 0; i < batch->count && ret == KNOT_EOK; i++) {
+		zone_node_t *nsec3_node = create_nsec3_node(batch->hashed[i], params,
+		                                            apex, batch->rr_types[i], ttl);
+		if (nsec3_node == NULL) {
+			ret = KNOT_ENOMEM;
+			break;
+		}
+		ret = zone_tree_insert(nsec3_nodes, &nsec3_node);
+	}
+
+	nsec3_batch_clear(batch);
+
+	return ret;
+}
+
 /* - NSEC3 chain creation --------------------------------------------------- */
 
 // see connect_nsec3_nodes() for what this function does
@@ -420,6 +503,11 @@ static int create_nsec3_nodes(const zone_contents_t *zone,
 	assert(nsec3_nodes);
 	assert(update);
 
+	nsec3_batch_t *batch = calloc(1, sizeof(*batch));
+	if (batch == NULL) {
+		return KNOT_ENOMEM;
+	}
+
 	zone_tree_delsafe_it_t it = { 0 };
 	int result = zone_tree_delsafe_it_begin(zone->nodes, &it, false); // delsafe - removing nodes that contain only NSEC+RRSIG
 
@@ -439,15 +527,11 @@ static int create_nsec3_nodes(const zone_contents_t *zone,
 			continue;
 		}
 
-		zone_node_t *nsec3_node;
-		nsec3_node = create_nsec3_node_for_node(node, zone->apex,
-							params, ttl);
-		if (!nsec3_node) {
-			result = KNOT_ENOMEM;
-			break;
+		result = nsec3_batch_add(batch, node, zone->apex);
+		if (result == KNOT_EOK && batch->count == NSEC3_BATCH) {
+			result = nsec3_batch_flush(batch, zone->apex, params, ttl, nsec3_nodes,
+			                           update->sign_stats);
 		}
-
-		result = zone_tree_insert(nsec3_nodes, &nsec3_node);
 		if (result != KNOT_EOK) {
 			break;
 		}
@@ -457,40 +541,62 @@ static int create_nsec3_nodes(const zone_contents_t *zone,
 
 	zone_tree_delsafe_it_free(&it);
 
+	if (result == KNOT_EOK) {
+		result = nsec3_batch_flush(batch, zone->apex, params, ttl, nsec3_nodes,
+		                           update->sign_stats);
+	}
+	nsec3_batch_clear(batch);
+	free(batch);
+
 	return result;
 }
 
 /*!
- * \brief For given dname, check if anything changed in zone_update, and recreate (possibly unconnected) NSEC3 nodes appropriately.
- *
- * \param update    Zone update structure holding zone contents changes.
- * \param params    NSEC3 params.
- * \param ttl       TTL for newly created NSEC3 records.
- * \param for_node  Domain name of the node in question.
- *
- * \retval KNOT_ENORECORD if the NSEC3 chain shall be rather recreated completely.
- * \return KNOT_EOK, KNOT_E* if any error.
+ * \brief For given dname, check if anything changed in zone_update that affects its NSEC3 node.
  */
-static int fix_nsec3_for_node(zone_update_t *update, const dnssec_nsec3_params_t *params,
-                              uint32_t ttl, const knot_dname_t *for_node)
+static bool fix_nsec3_needed(zone_update_t *update, const dnssec_nsec3_params_t *params,
+                             const knot_dname_t *for_node, const zone_node_t **old_node,
+                             const zone_node_t **new_node)
 {
-	// check if we need to do something
 	const zone_node_t *old_n = zone_contents_find_node(update->zone->contents, for_node);
 	const zone_node_t *new_n = zone_contents_find_node(update->new_cont, for_node);
 
 	bool had_no_nsec = (old_n == NULL || old_n->nsec3_node == NULL || !(old_n->flags & NODE_FLAGS_NSEC3_NODE));
 	bool shall_no_nsec = (new_n == NULL || new_n->flags & NODE_FLAGS_NONAUTH || nsec3_empty(new_n, params) || new_n->flags & NODE_FLAGS_DELETED);
 
-	if (had_no_nsec == shall_no_nsec && node_bitmap_equal(old_n, new_n)) {
-		return KNOT_EOK;
+	if (old_node != NULL) {
+		*old_node = had_no_nsec ? NULL : old_n;
+	}
+	if (new_node != NULL) {
+		*new_node = shall_no_nsec ? NULL : new_n;
 	}
 
-	knot_dname_storage_t for_node_hashed;
-	int ret = knot_create_nsec3_owner(for_node_hashed, sizeof(for_node_hashed),
-	                                  for_node, update->new_cont->apex->owner, params);
-	if (ret != KNOT_EOK) {
-		return ret;
+	return had_no_nsec != shall_no_nsec || !node_bitmap_equal(old_n, new_n);
+}
+
+/*!
+ * \brief For given dname, recreate (possibly unconnected) NSEC3 nodes appropriately.
+ *
+ * \param update           Zone update structure holding zone contents changes.
+ * \param params           NSEC3 params.
+ * \param ttl              TTL for newly created NSEC3 records.
+ * \param for_node         Domain name of the node in question.
+ * \param for_node_hashed  NSEC3 owner name of the node.
+ *
+ * \retval KNOT_ENORECORD if the NSEC3 chain shall be rather recreated completely.
+ * \return KNOT_EOK, KNOT_E* if any error.
+ */
+static int fix_nsec3_for_node(zone_update_t *update, const dnssec_nsec3_params_t *params,
+                              uint32_t ttl, const knot_dname_t *for_node,
+                              const knot_dname_t *for_node_hashed)
+{
+	const zone_node_t *old_n = NULL, *new_n = NULL;
+	if (!fix_nsec3_needed(update, params, for_node, &old_n, &new_n)) {
+		return KNOT_EOK;
 	}
+	bool had_no_nsec = (old_n == NULL);
+	bool shall_no_nsec = (new_n == NULL);
+	int ret = KNOT_EOK;
 
 	// saved hash of next node
 	uint8_t *next_hash = NULL;
@@ -515,7 +621,8 @@ static int fix_nsec3_for_node(zone_update_t *update, const dnssec_nsec3_params_t
 
 	// add NSEC3 with correct bitmap
 	if (!shall_no_nsec && ret == KNOT_EOK) {
-		zone_node_t *new_nsec3_n = create_nsec3_node_for_node(new_n, update->new_cont->apex, params, ttl);
+		zone_node_t *new_nsec3_n = create_nsec3_node_for_node(new_n, for_node_hashed,
+		                                                      update->new_cont->apex, params, ttl);
 		if (new_nsec3_n == NULL) {
 			return KNOT_ENOMEM;
 		}
@@ -544,21 +651,56 @@ static int fix_nsec3_for_node(zone_update_t *update, const dnssec_nsec3_params_t
 	return ret;
 }
 
+static int fix_nsec3_batch(zone_update_t *update, const dnssec_nsec3_params_t *params,
+                           uint32_t ttl, const knot_dname_t **owners,
+                           knot_dname_storage_t *hashed, size_t count)
+{
+	int ret = knot_create_nsec3_owners(hashed, owners, count,
+	                                   update->new_cont->apex->owner, params);
+	if (update->sign_stats != NULL) {
+		update->sign_stats->nsec3_hashes += count;
+	}
+	for (size_t i = 0; i < count && ret == KNOT_EOK; i++) {
+		ret = fix_nsec3_for_node(update, params, ttl, owners[i], hashed[i]);
+	}
+
+	return ret;
+}
+
 static int fix_nsec3_nodes(zone_update_t *update, const dnssec_nsec3_params_t *params,
                            uint32_t ttl)
 {
 	assert(update);
 
+	// The regular nodes aren't modified, only the affected ones are hashed.
+	const knot_dname_t *owners[NSEC3_BATCH];
+	knot_dname_storage_t *hashed = malloc(NSEC3_BATCH * sizeof(*hashed));
+	if (hashed == NULL) {
+		return KNOT_ENOMEM;
+	}
+	size_t count = 0;
+
 	zone_tree_it_t it = { 0 };
 	int ret = zone_tree_it_begin(update->a_ctx->node_ptrs, &it);
 
 	while (!zone_tree_it_finished(&it) && ret == KNOT_EOK) {
 		zone_node_t *n = zone_tree_it_val(&it);
-		ret = fix_nsec3_for_node(update, params, ttl, n->owner);
+		if (fix_nsec3_needed(update, params, n->owner, NULL, NULL)) {
+			owners[count++] = n->owner;
+		}
+		if (count == NSEC3_BATCH) {
+			ret = fix_nsec3_batch(update, params, ttl, owners, hashed, count);
+			count = 0;
+		}
 		zone_tree_it_next(&it);
 	}
 	zone_tree_it_free(&it);
 
+	if (ret == KNOT_EOK && count > 0) {
+		ret = fix_nsec3_batch(update, params, ttl, owners, hashed, count);
+	}
+	free(hashed);
+
 	return ret;
 }
 
@@ -683,7 +825,7 @@ int knot_nsec3_fix_chain(zone_update_t *update,
 
 	// ensure that nsec3 node for zone root is in list of changed nodes
 	const zone_node_t *nsec3_for_root = NULL, *unused;
-	ret = zone_contents_find_nsec3_for_name(update->new_cont, update->zone->name, &nsec3_for_root, &unused);
+	ret = zone_contents_find_nsec3_for_name(update->new_cont, update->zone->name, NULL, &nsec3_for_root, &unused);
 	if (ret >= 0) {
 		assert(ret == ZONE_NAME_FOUND);
 		assert(!(nsec3_for_root->flags & NODE_FLAGS_DELETED));
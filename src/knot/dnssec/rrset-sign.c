@@ -19,6 +19,7 @@
 #include "contrib/wire_ctx.h"
 #include "libdnssec/error.h"
 #include "knot/dnssec/rrset-sign.h"
+#include "knot/dnssec/rrsig-index.h"
 #include "knot/dnssec/zone-sign.h"
 #include "libknot/libknot.h"
 
@@ -26,6 +27,20 @@
 
 #define RRSIG_INCEPT_IN_PAST (90 * 60)
 
+#ifdef HAVE_ATOMIC
+#define ATOMIC_ADD(dst, val) __atomic_add_fetch(&(dst), (val), __ATOMIC_RELAXED)
+#define ATOMIC_GET(src)      __atomic_load_n(&(src), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_ADD(dst, val) ((dst) += (val))
+#define ATOMIC_GET(src)      (src)
+#endif
+
+/*! \brief Keystore session pool usage, summed over all zones. */
+static struct {
+	uint64_t checkouts;
+	uint64_t wait_us;
+} session_stats;
+
 /*- Creating of RRSIGs -------------------------------------------------------*/
 
 /*!
@@ -156,13 +171,13 @@ static int sign_ctx_add_self(dnssec_sign_ctx_t *ctx, const uint8_t *rdata)
  */
 static int sign_ctx_add_records(dnssec_sign_ctx_t *ctx, const knot_rrset_t *covered)
 {
-	// huge block of rrsets can be optionally created
-	uint8_t *rrwf = malloc(KNOT_WIRE_MAX_PKTSIZE);
+	size_t rrwf_size = MIN(knot_rrset_size(covered), KNOT_WIRE_MAX_PKTSIZE);
+	uint8_t *rrwf = malloc(rrwf_size);
 	if (!rrwf) {
 		return KNOT_ENOMEM;
 	}
 
-	int written = knot_rrset_to_wire(covered, rrwf, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	int written = knot_rrset_to_wire(covered, rrwf, rrwf_size, NULL);
 	if (written < 0) {
 		free(rrwf);
 		return written;
@@ -194,113 +209,248 @@ int knot_sign_ctx_add_data(dnssec_sign_ctx_t *ctx,
 }
 
 /*!
- * \brief Create RRSIG RDATA.
+ * \brief Get the labels field of RRSIG covering given RR set.
+ */
+static uint8_t rrsig_owner_labels(const knot_rrset_t *covered)
+{
+	uint8_t owner_labels = knot_dname_labels(covered->owner, NULL);
+	if (knot_dname_is_wildcard(covered->owner)) {
+		owner_labels -= 1;
+	}
+
+	return owner_labels;
+}
+
+/*!
+ * \brief Create RRSIG RDATA for several RR sets signed with one key.
+ *
+ * The data to be signed (RRSIG RDATA without signature followed by the
+ * covered records) of all RR sets are laid out into one buffer, the RRSIG
+ * RDATA are assembled in another one with the signatures written in place.
  *
- * \param[in]  rrsigs        RR set with RRSIGS.
+ * \param[in]  rrsigs        RR sets with RRSIGS, one per covered RR set.
+ * \param[in]  covered       RR sets covered by the signatures.
+ * \param[in]  count         Number of covered RR sets.
  * \param[in]  ctx           DNSSEC signing context.
- * \param[in]  covered       RR covered by the signature.
  * \param[in]  key           Key used for signing.
  * \param[in]  sig_incepted  Timestamp of signature inception.
- * \param[in]  sig_expires   Timestamp of signature expiration.
+ * \param[in]  sig_expires   Timestamps of signature expiration.
  * \param[in]  sign_flags    Signing flags.
  * \param[in]  mm            Memory context.
  *
  * \return Error code, KNOT_EOK if successful.
  */
-static int rrsigs_create_rdata(knot_rrset_t *rrsigs, dnssec_sign_ctx_t *ctx,
-                               const knot_rrset_t *covered,
+static int rrsigs_create_rdata(knot_rrset_t *rrsigs[],
+                               const knot_rrset_t *covered[], size_t count,
+                               dnssec_sign_ctx_t *ctx,
                                const dnssec_key_t *key,
-                               uint32_t sig_incepted, uint32_t sig_expires,
+                               uint32_t sig_incepted, const uint32_t *sig_expires,
                                dnssec_sign_flags_t sign_flags,
                                knot_mm_t *mm)
 {
-	assert(rrsigs);
-	assert(rrsigs->type == KNOT_RRTYPE_RRSIG);
-	assert(!knot_rrset_empty(covered));
 	assert(key);
 
 	size_t header_size = rrsig_rdata_header_size(key);
 	assert(header_size != 0);
-
-	uint8_t owner_labels = knot_dname_labels(covered->owner, NULL);
-	if (knot_dname_is_wildcard(covered->owner)) {
-		owner_labels -= 1;
+	size_t rdata_size = header_size + dnssec_sign_max_size(ctx);
+
+	size_t data_size = 0;
+	size_t wire_sizes[count];
+	for (size_t i = 0; i < count; i++) {
+		assert(rrsigs[i]->type == KNOT_RRTYPE_RRSIG);
+		assert(!knot_rrset_empty(covered[i]));
+		wire_sizes[i] = MIN(knot_rrset_size(covered[i]), KNOT_WIRE_MAX_PKTSIZE);
+		data_size += header_size + wire_sizes[i];
 	}
 
-	uint8_t header[header_size];
-	int res = rrsig_write_rdata(header, header_size,
-	                            key, covered->type, owner_labels,
-	                            covered->ttl, sig_incepted, sig_expires);
-	assert(res == KNOT_EOK);
+	uint8_t *buf = malloc(data_size + count * rdata_size);
+	if (buf == NULL) {
+		return KNOT_ENOMEM;
+	}
+	uint8_t *rdata = buf + data_size;
+
+	dnssec_binary_t data[count];
+	dnssec_binary_t signatures[count];
+	uint8_t *pos = buf;
+	for (size_t i = 0; i < count; i++) {
+		int ret = rrsig_write_rdata(pos, header_size, key, covered[i]->type,
+		                            rrsig_owner_labels(covered[i]), covered[i]->ttl,
+		                            sig_incepted, sig_expires[i]);
+		assert(ret == KNOT_EOK);
+		memcpy(rdata + i * rdata_size, pos, header_size);
+
+		int written = knot_rrset_to_wire(covered[i], pos + header_size,
+		                                 wire_sizes[i], NULL);
+		if (written < 0) {
+			free(buf);
+			return written;
+		}
 
-	res = dnssec_sign_init(ctx);
-	if (res != KNOT_EOK) {
-		return res;
+		data[i].data = pos;
+		data[i].size = header_size + written;
+		signatures[i].data = rdata + i * rdata_size + header_size;
+		signatures[i].size = rdata_size - header_size;
+		pos += data[i].size;
 	}
 
-	res = knot_sign_ctx_add_data(ctx, header, covered);
-	if (res != KNOT_EOK) {
-		return res;
+	int ret = dnssec_sign_batch(ctx, sign_flags, data, count, signatures);
+	for (size_t i = 0; i < count && ret == KNOT_EOK; i++) {
+		assert(signatures[i].size > 0);
+		ret = knot_rrset_add_rdata(rrsigs[i], rdata + i * rdata_size,
+		                           header_size + signatures[i].size, mm);
 	}
 
-	dnssec_binary_t signature = { 0 };
-	res = dnssec_sign_write(ctx, sign_flags, &signature);
-	if (res != DNSSEC_EOK) {
-		return res;
+	free(buf);
+	return ret;
+}
+
+int knot_sign_rrsets(knot_rrset_t *rrsigs[], const knot_rrset_t *covered[],
+                     size_t count, const dnssec_key_t *key,
+                     dnssec_sign_ctx_t *sign_ctx, const kdnssec_ctx_t *dnssec_ctx,
+                     knot_mm_t *mm, knot_time_t *expires)
+{
+	if (rrsigs == NULL || covered == NULL || !key || !sign_ctx || !dnssec_ctx) {
+		return KNOT_EINVAL;
+	}
+	if (count == 0) {
+		return KNOT_EOK;
 	}
-	assert(signature.size > 0);
 
-	size_t rrsig_size = header_size + signature.size;
-	uint8_t rrsig[rrsig_size];
-	memcpy(rrsig, header, header_size);
-	memcpy(rrsig + header_size, signature.data, signature.size);
+	uint32_t sig_incept = dnssec_ctx->now - RRSIG_INCEPT_IN_PAST;
+	uint32_t sig_expires[count];
+	knot_time_t min_expire = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (knot_rrset_empty(covered[i]) || rrsigs[i]->type != KNOT_RRTYPE_RRSIG ||
+		    !knot_dname_is_equal(rrsigs[i]->owner, covered[i]->owner)) {
+			return KNOT_EINVAL;
+		}
 
-	dnssec_binary_free(&signature);
+		uint64_t sig_expire = dnssec_ctx->policy->rrsig_index ?
+		                      rrsig_index_spread(covered[i]->owner, dnssec_ctx) :
+		                      dnssec_ctx->now + dnssec_ctx->policy->rrsig_lifetime;
+		sig_expire = MIN(sig_expire, UINT32_MAX);
+		sig_expires[i] = sig_expire;
+		min_expire = knot_time_min(min_expire, sig_expire);
+	}
+	dnssec_sign_flags_t sign_flags = dnssec_ctx->policy->reproducible_sign ?
+	                                 DNSSEC_SIGN_REPRODUCIBLE : DNSSEC_SIGN_NORMAL;
 
-	return knot_rrset_add_rdata(rrsigs, rrsig, rrsig_size, mm);
+	int ret = rrsigs_create_rdata(rrsigs, covered, count, sign_ctx, key,
+	                              sig_incept, sig_expires, sign_flags, mm);
+	if (ret == KNOT_EOK && expires != NULL) {
+		*expires = knot_time_min(*expires, min_expire);
+	}
+	return ret;
 }
 
 int knot_sign_rrset(knot_rrset_t *rrsigs, const knot_rrset_t *covered,
                     const dnssec_key_t *key, dnssec_sign_ctx_t *sign_ctx,
                     const kdnssec_ctx_t *dnssec_ctx, knot_mm_t *mm, knot_time_t *expires)
 {
-	if (knot_rrset_empty(covered) || !key || !sign_ctx || !dnssec_ctx ||
-	    rrsigs->type != KNOT_RRTYPE_RRSIG ||
-	    !knot_dname_is_equal(rrsigs->owner, covered->owner)
-	) {
+	if (rrsigs == NULL || covered == NULL) {
 		return KNOT_EINVAL;
 	}
 
-	uint32_t sig_incept = dnssec_ctx->now - RRSIG_INCEPT_IN_PAST;
-	uint64_t sig_expire = dnssec_ctx->now + dnssec_ctx->policy->rrsig_lifetime;
-	sig_expire = MIN(sig_expire, UINT32_MAX);
-	dnssec_sign_flags_t sign_flags = dnssec_ctx->policy->reproducible_sign ?
-	                                 DNSSEC_SIGN_REPRODUCIBLE : DNSSEC_SIGN_NORMAL;
+	return knot_sign_rrsets(&rrsigs, &covered, 1, key, sign_ctx,
+	                        dnssec_ctx, mm, expires);
+}
 
-	int ret = rrsigs_create_rdata(rrsigs, sign_ctx, covered, key, sig_incept,
-	                              (uint32_t)sig_expire, sign_flags, mm);
-	if (ret == KNOT_EOK && expires != NULL) {
-		*expires = knot_time_min(*expires, sig_expire);
+int knot_sign_rrsets_ctx(zone_sign_ctx_t *sign_ctx, size_t key_pos,
+                         knot_rrset_t *rrsigs[], const knot_rrset_t *covered[],
+                         size_t count, knot_mm_t *mm, knot_time_t *expires)
+{
+	if (sign_ctx == NULL || key_pos >= sign_ctx->count) {
+		return KNOT_EINVAL;
 	}
+
+	const zone_key_t *key = &sign_ctx->keys[key_pos];
+	const kdnssec_ctx_t *dnssec_ctx = sign_ctx->dnssec_ctx;
+	if (count == 0 || dnssec_ctx->keystore_sessions == 0 || key->is_pub_only) {
+		return knot_sign_rrsets(rrsigs, covered, count, key->key,
+		                        sign_ctx->sign_ctxs[key_pos], dnssec_ctx,
+		                        mm, expires);
+	}
+
+	// Sign with a private key handle of a checked out keystore session.
+	dnssec_keystore_session_t *session = NULL;
+	uint64_t wait_ns = 0;
+	int ret = dnssec_keystore_session_get(dnssec_ctx->keystore, &session, &wait_ns);
+	if (ret != DNSSEC_EOK) {
+		return knot_error_from_libdnssec(ret);
+	}
+	ATOMIC_ADD(session_stats.checkouts, 1);
+	ATOMIC_ADD(session_stats.wait_us, wait_ns / 1000);
+
+	const dnssec_key_t *session_key = NULL;
+	dnssec_sign_ctx_t *session_ctx = NULL;
+	ret = dnssec_keystore_session_key(dnssec_ctx->keystore, session, key->id,
+	                                  key->key, &session_key);
+	if (ret == DNSSEC_EOK) {
+		ret = dnssec_sign_new(&session_ctx, session_key);
+	}
+	if (ret == DNSSEC_EOK) {
+		ret = knot_sign_rrsets(rrsigs, covered, count, session_key, session_ctx,
+		                       dnssec_ctx, mm, expires);
+	} else {
+		ret = knot_error_from_libdnssec(ret);
+	}
+
+	dnssec_sign_free(session_ctx);
+	dnssec_keystore_session_put(dnssec_ctx->keystore, session);
+
 	return ret;
 }
 
+uint64_t knot_sign_session_checkouts(void)
+{
+	return ATOMIC_GET(session_stats.checkouts);
+}
+
+uint64_t knot_sign_session_wait(void)
+{
+	return ATOMIC_GET(session_stats.wait_us);
+}
+
 int knot_sign_rrset2(knot_rrset_t *rrsigs, const knot_rrset_t *rrset,
                      zone_sign_ctx_t *sign_ctx, knot_mm_t *mm)
 {
-	if (rrsigs == NULL || rrset == NULL || sign_ctx == NULL) {
+	if (rrsigs == NULL || rrset == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	return knot_sign_rrsets2(&rrsigs, &rrset, 1, sign_ctx, mm);
+}
+
+int knot_sign_rrsets2(knot_rrset_t *rrsigs[], const knot_rrset_t *rrsets[],
+                      size_t count, zone_sign_ctx_t *sign_ctx, knot_mm_t *mm)
+{
+	if (rrsigs == NULL || rrsets == NULL || sign_ctx == NULL) {
 		return KNOT_EINVAL;
 	}
+	if (count == 0) {
+		return KNOT_EOK;
+	}
+
+	knot_rrset_t *key_rrsigs[count];
+	const knot_rrset_t *key_rrsets[count];
 
 	for (size_t i = 0; i < sign_ctx->count; i++) {
 		zone_key_t *key = &sign_ctx->keys[i];
 
-		if (!knot_zone_sign_use_key(key, rrset)) {
-			continue;
+		size_t key_count = 0;
+		for (size_t j = 0; j < count; j++) {
+			if (rrsigs[j] == NULL || rrsets[j] == NULL) {
+				return KNOT_EINVAL;
+			}
+			if (knot_zone_sign_use_key(key, rrsets[j])) {
+				key_rrsigs[key_count] = rrsigs[j];
+				key_rrsets[key_count] = rrsets[j];
+				key_count++;
+			}
 		}
 
-		int ret = knot_sign_rrset(rrsigs, rrset, key->key, sign_ctx->sign_ctxs[i],
-		                          sign_ctx->dnssec_ctx, mm, NULL);
+		int ret = knot_sign_rrsets_ctx(sign_ctx, i, key_rrsigs, key_rrsets,
+		                               key_count, mm, NULL);
 		if (ret != KNOT_EOK) {
 			return ret;
 		}
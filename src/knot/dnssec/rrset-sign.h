@@ -43,6 +43,68 @@ int knot_sign_rrset(knot_rrset_t *rrsigs,
                     knot_mm_t *mm,
                     knot_time_t *expires);
 
+/*!
+ * \brief Create RRSIG RRs for several RR sets with one key.
+ *
+ * The signatures are computed in one batch, sharing the buffers for the
+ * signed data and the resulting RDATA.
+ *
+ * \param rrsigs      RR sets with RRSIGs into which the results will be added,
+ *                    one per covered RR set (may repeat).
+ * \param covered     RR sets to create new signatures for.
+ * \param count       Number of covered RR sets.
+ * \param key         Signing key.
+ * \param sign_ctx    Signing context.
+ * \param dnssec_ctx  DNSSEC context.
+ * \param mm          Memory context.
+ * \param expires     Out: When will the earliest new RRSIG expire.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_sign_rrsets(knot_rrset_t *rrsigs[],
+                     const knot_rrset_t *covered[],
+                     size_t count,
+                     const dnssec_key_t *key,
+                     dnssec_sign_ctx_t *sign_ctx,
+                     const kdnssec_ctx_t *dnssec_ctx,
+                     knot_mm_t *mm,
+                     knot_time_t *expires);
+
+/*!
+ * \brief Create RRSIG RRs for several RR sets with a key of the zone signing context.
+ *
+ * If the keystore has a session pool, a session is checked out for the
+ * batch and its own private key handle is used, so that signing threads
+ * don't contend for a single token session.
+ *
+ * \param sign_ctx    Zone signing context.
+ * \param key_pos     Position of the signing key in the context.
+ * \param rrsigs      RR sets with RRSIGs into which the results will be added.
+ * \param covered     RR sets to create new signatures for.
+ * \param count       Number of covered RR sets.
+ * \param mm          Memory context.
+ * \param expires     Out: When will the earliest new RRSIG expire.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_sign_rrsets_ctx(zone_sign_ctx_t *sign_ctx,
+                         size_t key_pos,
+                         knot_rrset_t *rrsigs[],
+                         const knot_rrset_t *covered[],
+                         size_t count,
+                         knot_mm_t *mm,
+                         knot_time_t *expires);
+
+/*!
+ * \brief Get the number of keystore session checkouts.
+ */
+uint64_t knot_sign_session_checkouts(void);
+
+/*!
+ * \brief Get the total time spent waiting for keystore sessions (microseconds).
+ */
+uint64_t knot_sign_session_wait(void);
+
 /*!
  * \brief Create RRSIG RR for given RR set, choose which key to use.
  *
@@ -58,6 +120,26 @@ int knot_sign_rrset2(knot_rrset_t *rrsigs,
                      zone_sign_ctx_t *sign_ctx,
                      knot_mm_t *mm);
 
+/*!
+ * \brief Create RRSIG RRs for several RR sets, choose which keys to use.
+ *
+ * The RR sets signed by the same key are signed in one batch.
+ *
+ * \param rrsigs      RR sets with RRSIGs into which the results will be added,
+ *                    one per covered RR set.
+ * \param rrsets      RR sets to create new signatures for.
+ * \param count       Number of covered RR sets.
+ * \param sign_ctx    Zone signing context.
+ * \param mm          Memory context.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_sign_rrsets2(knot_rrset_t *rrsigs[],
+                      const knot_rrset_t *rrsets[],
+                      size_t count,
+                      zone_sign_ctx_t *sign_ctx,
+                      knot_mm_t *mm);
+
 /*!
  * \brief Add all data covered by signature into signing context.
  *
@@ -0,0 +1,338 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "knot/dnssec/rrsig-index.h"
+#include "knot/dnssec/zone-sign.h"
+#include "libknot/libknot.h"
+
+/*
+ * The 'due' trie is keyed by the big-endian 32-bit expiration followed by
+ * the 'nodes' key, which is a tree flag and the owner in wire format. The
+ * 'nodes' trie stores the expiration as the value, so that the 'due' entry
+ * can be found when the expiration changes.
+ */
+#define TIME_LEN	sizeof(uint32_t)
+#define KEY_MAXLEN	(TIME_LEN + 1 + KNOT_DNAME_MAXLEN)
+
+#define FNV_BASIS	0xcbf29ce484222325ULL
+#define FNV_PRIME	0x100000001b3ULL
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+#define HASH_VAL(hash, val) hash_bytes((hash), &(val), sizeof(val))
+
+static uint32_t time_u32(knot_time_t time)
+{
+	return MIN(time, UINT32_MAX);
+}
+
+/*! \brief Fill the key, return the 'nodes' key length, the 'due' key is longer by TIME_LEN. */
+static uint32_t make_key(uint8_t *key, const knot_dname_t *owner, bool nsec3)
+{
+	size_t owner_size = knot_dname_size(owner);
+	assert(owner_size <= KNOT_DNAME_MAXLEN);
+
+	key[TIME_LEN] = nsec3;
+	memcpy(key + TIME_LEN + 1, owner, owner_size);
+
+	return 1 + owner_size;
+}
+
+rrsig_index_t *rrsig_index_new(void)
+{
+	rrsig_index_t *index = calloc(1, sizeof(*index));
+	if (index == NULL) {
+		return NULL;
+	}
+
+	index->nodes = trie_create(NULL);
+	index->due = trie_create(NULL);
+	if (index->nodes == NULL || index->due == NULL) {
+		rrsig_index_free(index);
+		return NULL;
+	}
+
+	return index;
+}
+
+void rrsig_index_free(rrsig_index_t *index)
+{
+	if (index == NULL) {
+		return;
+	}
+
+	trie_free(index->nodes);
+	trie_free(index->due);
+	free(index);
+}
+
+void rrsig_index_clear(rrsig_index_t *index)
+{
+	if (index == NULL) {
+		return;
+	}
+
+	trie_clear(index->nodes);
+	trie_clear(index->due);
+	index->id = 0;
+}
+
+int rrsig_index_set(rrsig_index_t *index, const knot_dname_t *owner, bool nsec3,
+                    knot_time_t expires)
+{
+	if (index == NULL || owner == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	uint8_t key[KEY_MAXLEN];
+	uint32_t len = make_key(key, owner, nsec3);
+	uint8_t *node_key = key + TIME_LEN;
+	uint32_t expires32 = time_u32(expires);
+
+	trie_val_t *val = trie_get_try(index->nodes, node_key, len);
+	if (val != NULL) {
+		uint32_t prev = (uintptr_t)*val;
+		if (expires != 0 && prev == expires32) {
+			return KNOT_EOK;
+		}
+		knot_wire_write_u32(key, prev);
+		(void)trie_del(index->due, key, TIME_LEN + len, NULL);
+		if (expires == 0) {
+			(void)trie_del(index->nodes, node_key, len, NULL);
+			return KNOT_EOK;
+		}
+	} else if (expires == 0) {
+		return KNOT_EOK;
+	} else {
+		val = trie_get_ins(index->nodes, node_key, len);
+		if (val == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+	*val = (trie_val_t)(uintptr_t)expires32;
+
+	knot_wire_write_u32(key, expires32);
+	trie_val_t *due = trie_get_ins(index->due, key, TIME_LEN + len);
+	if (due == NULL) {
+		(void)trie_del(index->nodes, node_key, len, NULL);
+		return KNOT_ENOMEM;
+	}
+	*due = index;
+
+	return KNOT_EOK;
+}
+
+knot_time_t rrsig_index_node_expires(const zone_node_t *node)
+{
+	if (node == NULL || node->rrset_count == 0 || (node->flags & NODE_FLAGS_DELETED)) {
+		return 0;
+	}
+
+	knot_rrset_t rrsigs = node_rrset(node, KNOT_RRTYPE_RRSIG);
+	for (int i = 0; i < node->rrset_count; i++) {
+		knot_rrset_t rrset = node_rrset_at(node, i);
+		if (knot_zone_sign_rr_should_be_signed(node, &rrset) &&
+		    !rrsig_covers_type(&rrsigs, rrset.type)) {
+			return 1; // missing signature, due immediately
+		}
+	}
+
+	knot_time_t expires = 0;
+	knot_rdata_t *rrsig = rrsigs.rrs.rdata;
+	for (int i = 0; i < rrsigs.rrs.count; i++) {
+		expires = knot_time_min(expires, knot_time_from_u32(knot_rrsig_sig_expiration(rrsig)));
+		rrsig = knot_rdataset_next(rrsig);
+	}
+
+	return expires;
+}
+
+int rrsig_index_node(rrsig_index_t *index, const zone_node_t *node, bool nsec3)
+{
+	if (node == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	return rrsig_index_set(index, node->owner, nsec3, rrsig_index_node_expires(node));
+}
+
+int rrsig_index_due(const rrsig_index_t *index, knot_time_t until,
+                    rrsig_index_cb_t cb, void *ctx)
+{
+	if (index == NULL || cb == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	trie_it_t *it = trie_it_begin(index->due);
+	if (it == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	uint32_t until32 = time_u32(until);
+	for (; ret == KNOT_EOK && !trie_it_finished(it); trie_it_next(it)) {
+		size_t len;
+		const trie_key_t *key = trie_it_key(it, &len);
+		assert(len > TIME_LEN + 1);
+		if (knot_wire_read_u32(key) > until32) {
+			break;
+		}
+		ret = cb(key + TIME_LEN + 1, key[TIME_LEN], ctx);
+	}
+	trie_it_free(it);
+
+	return ret;
+}
+
+knot_time_t rrsig_index_next(const rrsig_index_t *index, knot_time_t after)
+{
+	if (index == NULL || after >= UINT32_MAX) {
+		return 0;
+	}
+
+	trie_it_t *it = trie_it_begin(index->due);
+	if (it == NULL) {
+		return 0;
+	}
+
+	// Position before the first entry later than 'after', if any.
+	uint8_t key[TIME_LEN];
+	knot_wire_write_u32(key, after + 1);
+	if (trie_it_get_leq(it, key, sizeof(key)) == KNOT_ENOENT) {
+		trie_it_free(it);
+		it = trie_it_begin(index->due);
+	} else {
+		trie_it_next(it);
+	}
+
+	knot_time_t next = 0;
+	if (it != NULL && !trie_it_finished(it)) {
+		size_t len;
+		next = knot_time_from_u32(knot_wire_read_u32(trie_it_key(it, &len)));
+	}
+	trie_it_free(it);
+
+	return next;
+}
+
+typedef struct {
+	rrsig_index_t *index;
+	bool nsec3;
+} index_node_ctx_t;
+
+static int index_node_cb(zone_node_t *node, void *data)
+{
+	index_node_ctx_t *ctx = data;
+	return rrsig_index_node(ctx->index, node, ctx->nsec3);
+}
+
+int rrsig_index_update(rrsig_index_t *index, const zone_contents_t *contents,
+                       zone_tree_t *nodes, zone_tree_t *nsec3, uint64_t id)
+{
+	if (index == NULL || contents == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (nodes == NULL) {
+		rrsig_index_clear(index);
+		nodes = contents->nodes;
+		nsec3 = contents->nsec3_nodes;
+	}
+
+	index_node_ctx_t ctx = { index, false };
+	int ret = zone_tree_apply(nodes, index_node_cb, &ctx);
+	if (ret == KNOT_EOK) {
+		ctx.nsec3 = true;
+		ret = zone_tree_apply(nsec3, index_node_cb, &ctx);
+	}
+
+	if (ret != KNOT_EOK) {
+		rrsig_index_clear(index);
+	} else if (nodes == contents->nodes) {
+		index->id = id;
+	}
+
+	return ret;
+}
+
+uint64_t rrsig_index_setup_id(const zone_keyset_t *keyset, const kdnssec_ctx_t *ctx)
+{
+	uint64_t hash = FNV_BASIS;
+
+	// The keys are summed up as their order in the keyset may vary.
+	uint64_t keys = 0;
+	for (size_t i = 0; i < keyset->count; i++) {
+		const zone_key_t *key = &keyset->keys[i];
+		uint64_t key_hash = FNV_BASIS;
+		if (key->id != NULL) {
+			key_hash = hash_bytes(key_hash, key->id, strlen(key->id));
+		}
+		uint16_t keytag = dnssec_key_get_keytag(key->key);
+		uint8_t algorithm = dnssec_key_get_algorithm(key->key);
+		uint8_t flags = key->is_ksk | key->is_zsk << 1 | key->is_active << 2 |
+		                key->is_ksk_active_plus << 3 | key->is_zsk_active_plus << 4;
+		key_hash = HASH_VAL(key_hash, keytag);
+		key_hash = HASH_VAL(key_hash, algorithm);
+		key_hash = HASH_VAL(key_hash, flags);
+		keys += key_hash;
+	}
+	hash = HASH_VAL(hash, keys);
+
+	const knot_kasp_policy_t *policy = ctx->policy;
+	uint8_t nsec3 = policy->nsec3_enabled | policy->nsec3_opt_out << 1 |
+	                policy->rrsig_index << 2;
+	hash = HASH_VAL(hash, policy->rrsig_lifetime);
+	hash = HASH_VAL(hash, policy->rrsig_refresh_before);
+	hash = HASH_VAL(hash, policy->rrsig_prerefresh);
+	hash = HASH_VAL(hash, policy->nsec3_iterations);
+	hash = HASH_VAL(hash, nsec3);
+	hash = hash_bytes(hash, ctx->zone->nsec3_salt.data, ctx->zone->nsec3_salt.size);
+	hash = HASH_VAL(hash, ctx->zone->nsec3_salt_created);
+
+	return hash != 0 ? hash : 1;
+}
+
+knot_time_t rrsig_index_spread(const knot_dname_t *owner, const kdnssec_ctx_t *ctx)
+{
+	const knot_kasp_policy_t *policy = ctx->policy;
+	uint64_t before = (uint64_t)policy->rrsig_refresh_before + policy->rrsig_prerefresh;
+	if (policy->rrsig_lifetime <= before) {
+		return knot_time_plus(ctx->now, policy->rrsig_lifetime);
+	}
+
+	// Refresh once per period at the owner's phase, the first time after
+	// the pre-refresh window, so that the new signature isn't due at once.
+	uint64_t period = policy->rrsig_lifetime - before;
+	uint64_t phase = hash_bytes(FNV_BASIS, owner, knot_dname_size(owner)) % period;
+	uint64_t base = ctx->now + policy->rrsig_prerefresh;
+	uint64_t refresh_at = base - base % period + phase;
+	if (refresh_at <= base) {
+		refresh_at += period;
+	}
+
+	return refresh_at + policy->rrsig_refresh_before;
+}
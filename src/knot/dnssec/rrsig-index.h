@@ -0,0 +1,139 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "contrib/qp-trie/trie.h"
+#include "contrib/time.h"
+#include "knot/dnssec/context.h"
+#include "knot/dnssec/zone-keys.h"
+#include "knot/zone/contents.h"
+
+/*!
+ * \brief Index of zone nodes ordered by the earliest RRSIG expiration.
+ *
+ * Each node with signatures has one entry with the earliest expiration of
+ * its RRSIGs, nodes with a signable RRset lacking any RRSIG are due
+ * immediately. The index is kept in sync with the zone contents on every
+ * commit, so a periodic re-sign may only visit the nodes due soon instead
+ * of walking the whole zone.
+ */
+typedef struct rrsig_index {
+	trie_t *nodes;  /*!< Tree flag and owner -> expiration. */
+	trie_t *due;    /*!< Expiration, tree flag and owner, ordered by time. */
+	uint64_t id;    /*!< Signing setup the whole zone is signed with, 0 if unknown. */
+} rrsig_index_t;
+
+/*! \brief Callback for the due entries, 'nsec3' for the NSEC3 tree. */
+typedef int (*rrsig_index_cb_t)(const knot_dname_t *owner, bool nsec3, void *ctx);
+
+/*!
+ * \brief Create an empty index.
+ */
+rrsig_index_t *rrsig_index_new(void);
+
+/*!
+ * \brief Free the index.
+ */
+void rrsig_index_free(rrsig_index_t *index);
+
+/*!
+ * \brief Remove all entries and forget the signing setup.
+ */
+void rrsig_index_clear(rrsig_index_t *index);
+
+/*!
+ * \brief Set the expiration of a node, remove the node if zero.
+ *
+ * \param index    Index.
+ * \param owner    Node owner.
+ * \param nsec3    The node belongs to the NSEC3 tree.
+ * \param expires  Earliest RRSIG expiration, 0 to remove the entry.
+ *
+ * \return KNOT_E*
+ */
+int rrsig_index_set(rrsig_index_t *index, const knot_dname_t *owner, bool nsec3,
+                    knot_time_t expires);
+
+/*!
+ * \brief Get the earliest RRSIG expiration in a node, as stored in the index.
+ *
+ * \return Expiration, 1 for missing signatures, 0 if nothing to sign.
+ */
+knot_time_t rrsig_index_node_expires(const zone_node_t *node);
+
+/*!
+ * \brief Update the entry of a node according to its RRSIGs.
+ */
+int rrsig_index_node(rrsig_index_t *index, const zone_node_t *node, bool nsec3);
+
+/*!
+ * \brief Call a callback for all entries expiring at most at the given time.
+ *
+ * \note The index must not be modified from the callback.
+ *
+ * \return KNOT_E* or the first non-KNOT_EOK from the callback.
+ */
+int rrsig_index_due(const rrsig_index_t *index, knot_time_t until,
+                    rrsig_index_cb_t cb, void *ctx);
+
+/*!
+ * \brief Get the earliest expiration later than given time, 0 if none.
+ */
+knot_time_t rrsig_index_next(const rrsig_index_t *index, knot_time_t after);
+
+/*!
+ * \brief Update the entries of given nodes, or rebuild the whole index.
+ *
+ * \param index      Index.
+ * \param contents   Zone contents the nodes belong to.
+ * \param nodes      Nodes to update, NULL to rebuild the index from the whole contents.
+ * \param nsec3      NSEC3 nodes to update.
+ * \param id         Signing setup ID if the whole zone has been signed, otherwise 0.
+ *
+ * \note On failure, the index is emptied and its signing setup forgotten.
+ *
+ * \return KNOT_E*
+ */
+int rrsig_index_update(rrsig_index_t *index, const zone_contents_t *contents,
+                       zone_tree_t *nodes, zone_tree_t *nsec3, uint64_t id);
+
+/*!
+ * \brief Compute ID of the signing setup: keys used for signing and the policy.
+ *
+ * The index may only drive re-signing if the whole zone has been signed
+ * with the same setup, otherwise the zone must be signed completely.
+ */
+uint64_t rrsig_index_setup_id(const zone_keyset_t *keyset, const kdnssec_ctx_t *ctx);
+
+/*!
+ * \brief Compute expiration of a new RRSIG spread over the validity period.
+ *
+ * Each owner has a refresh phase derived from its name, the signatures are
+ * refreshed once per (rrsig-lifetime - rrsig-refresh - rrsig-pre-refresh)
+ * at that phase, so the re-signing of a large zone is evenly spread in time
+ * instead of being done in bursts. The expiration is never later than with
+ * the plain rrsig-lifetime.
+ *
+ * \param owner  Owner of the signed RRSet.
+ * \param ctx    DNSSEC context.
+ *
+ * \return Signature expiration.
+ */
+knot_time_t rrsig_index_spread(const knot_dname_t *owner, const kdnssec_ctx_t *ctx);
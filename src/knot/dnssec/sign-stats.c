@@ -0,0 +1,62 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "contrib/time.h"
+#include "knot/dnssec/sign-stats.h"
+
+void sign_stats_phase(sign_stats_t *stats, sign_phase_t phase, struct timespec *begin)
+{
+	if (stats == NULL) {
+		return;
+	}
+
+	struct timespec now = time_now();
+	stats->phase_ms[phase] += time_diff_ms(begin, &now) - stats->nested_ms;
+	stats->nested_ms = 0;
+	*begin = now;
+}
+
+void sign_stats_nested(sign_stats_t *stats, sign_phase_t phase,
+                       const struct timespec *begin)
+{
+	if (stats == NULL) {
+		return;
+	}
+
+	struct timespec now = time_now();
+	double elapsed = time_diff_ms(begin, &now);
+	stats->phase_ms[phase] += elapsed;
+	stats->nested_ms += elapsed;
+}
+
+int sign_stats_print(const sign_stats_t *stats, char *out, size_t size)
+{
+	return snprintf(out, size, "keys %.0f ms, adjust %.0f ms, nsec %.0f ms, "
+	                "rrsig %.0f ms, apply %.0f ms, finish %.0f ms, "
+	                "RRSIGs created %"PRIu64" reused %"PRIu64" removed %"PRIu64", "
+	                "NSEC3 hashes %"PRIu64,
+	                stats->phase_ms[SIGN_PHASE_KEYS],
+	                stats->phase_ms[SIGN_PHASE_ADJUST],
+	                stats->phase_ms[SIGN_PHASE_NSEC],
+	                stats->phase_ms[SIGN_PHASE_RRSIG],
+	                stats->phase_ms[SIGN_PHASE_APPLY],
+	                stats->phase_ms[SIGN_PHASE_FINISH],
+	                stats->rrsigs_created, stats->rrsigs_reused,
+	                stats->rrsigs_removed, stats->nsec3_hashes);
+}
@@ -0,0 +1,78 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*!
+ * \brief Phases of a signing event.
+ */
+typedef enum {
+	SIGN_PHASE_KEYS = 0, /*!< Context initialization, key loading, DNSKEY update. */
+	SIGN_PHASE_ADJUST,   /*!< Zone contents adjusting. */
+	SIGN_PHASE_NSEC,     /*!< NSEC/NSEC3 chain creation or fix. */
+	SIGN_PHASE_RRSIG,    /*!< RRSIG generation and validation of the existing ones. */
+	SIGN_PHASE_APPLY,    /*!< Applying the signing changesets to the update. */
+	SIGN_PHASE_FINISH,   /*!< SOA serial increment and ZONEMD. */
+	SIGN_PHASES
+} sign_phase_t;
+
+/*!
+ * \brief Timing and counters of one signing event.
+ */
+typedef struct {
+	double phase_ms[SIGN_PHASES]; /*!< Duration of the phases in milliseconds. */
+	double nested_ms;             /*!< Nested phase time not yet subtracted from the outer one. */
+	uint64_t rrsigs_created;      /*!< Newly created signatures. */
+	uint64_t rrsigs_reused;       /*!< Existing valid signatures kept. */
+	uint64_t rrsigs_removed;      /*!< Existing signatures removed. */
+	uint64_t nsec3_hashes;        /*!< Computed NSEC3 owner hashes. */
+} sign_stats_t;
+
+/*!
+ * \brief Finish a phase started at 'begin' and start the next one.
+ *
+ * The time of the nested phases accounted since 'begin' is subtracted.
+ *
+ * \param stats  Statistics to be updated (may be NULL).
+ * \param phase  Finished phase.
+ * \param begin  Start of the phase, set to the current time.
+ */
+void sign_stats_phase(sign_stats_t *stats, sign_phase_t phase, struct timespec *begin);
+
+/*!
+ * \brief Account time of a phase nested in another one.
+ *
+ * \param stats  Statistics to be updated (may be NULL).
+ * \param phase  Nested phase.
+ * \param begin  Start of the nested phase.
+ */
+void sign_stats_nested(sign_stats_t *stats, sign_phase_t phase,
+                       const struct timespec *begin);
+
+/*!
+ * \brief Print the statistics in a human readable form.
+ *
+ * \param stats  Statistics to be printed.
+ * \param out    Output buffer.
+ * \param size   Output buffer size.
+ *
+ * \return Output length or negative error code (as snprintf).
+ */
+int sign_stats_print(const sign_stats_t *stats, char *out, size_t size);
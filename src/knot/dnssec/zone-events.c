@@ -19,10 +19,13 @@
 #include "libdnssec/error.h"
 #include "libdnssec/random.h"
 #include "libknot/libknot.h"
+#include "contrib/time.h"
 #include "knot/conf/conf.h"
 #include "knot/common/log.h"
 #include "knot/dnssec/key-events.h"
 #include "knot/dnssec/policy.h"
+#include "knot/dnssec/rrsig-index.h"
+#include "knot/dnssec/sign-stats.h"
 #include "knot/dnssec/zone-events.h"
 #include "knot/dnssec/zone-keys.h"
 #include "knot/dnssec/zone-nsec.h"
@@ -87,6 +90,65 @@ static int sign_init(zone_update_t *update, conf_t *conf, zone_sign_flags_t flag
 	return KNOT_EOK;
 }
 
+static void prepare_rrsig_index(zone_t *zone, const kdnssec_ctx_t *ctx)
+{
+	if (!ctx->policy->rrsig_index) {
+		rrsig_index_free(zone->rrsig_index);
+		zone->rrsig_index = NULL;
+	} else if (zone->rrsig_index == NULL) {
+		// Filled in on commit of the next complete signing.
+		zone->rrsig_index = rrsig_index_new();
+	}
+}
+
+static bool changes_only_rrsigs(const changeset_t *ch)
+{
+	changeset_iter_t itt;
+	if (changeset_iter_all(&itt, ch) != KNOT_EOK) {
+		return false;
+	}
+
+	knot_rrset_t rr = changeset_iter_next(&itt);
+	while (!knot_rrset_empty(&rr) && rr.type == KNOT_RRTYPE_RRSIG) {
+		rr = changeset_iter_next(&itt);
+	}
+	changeset_iter_clear(&itt);
+
+	return knot_rrset_empty(&rr);
+}
+
+static bool sign_due_only(zone_update_t *update, const zone_keyset_t *keyset,
+                          const kdnssec_ctx_t *ctx)
+{
+	const rrsig_index_t *index = update->zone->rrsig_index;
+
+	// Other changes may need NSEC(3) chain update.
+	return index != NULL && index->id != 0 && !ctx->rrsig_drop_existing &&
+	       !ctx->policy->offline_ksk && (update->flags & UPDATE_INCREMENTAL) &&
+	       changes_only_rrsigs(&update->change) &&
+	       index->id == rrsig_index_setup_id(keyset, ctx);
+}
+
+static void store_sign_stats(zone_update_t *update, sign_stats_t *stats,
+                             struct timespec *phase, int result)
+{
+	update->sign_stats = NULL;
+	if (result != KNOT_EOK) {
+		return;
+	}
+
+	sign_stats_phase(stats, SIGN_PHASE_FINISH, phase);
+
+	char buff[256];
+	int ret = sign_stats_print(stats, buff, sizeof(buff));
+	if (ret > 0 && ret < sizeof(buff)) {
+		log_zone_info(update->zone->name, "DNSSEC, signing statistics, %s", buff);
+	}
+
+	update->zone->signing.last = *stats;
+	update->zone->signing.collected = true;
+}
+
 static knot_time_t schedule_next(kdnssec_ctx_t *kctx, const zone_keyset_t *keyset,
 				 knot_time_t keys_expire, knot_time_t rrsigs_expire)
 {
@@ -178,6 +240,10 @@ int knot_dnssec_zone_sign(zone_update_t *update,
 	zone_keyset_t keyset = { 0 };
 	unsigned zonemd_alg;
 
+	sign_stats_t stats = { 0 };
+	struct timespec phase = time_now();
+	update->sign_stats = &stats;
+
 	// signing pipeline
 
 	result = sign_init(update, conf, flags, roll_flags, adjust_now,
@@ -197,6 +263,8 @@ int knot_dnssec_zone_sign(zone_update_t *update,
 
 	log_zone_info(zone_name, "DNSSEC, signing started");
 
+	prepare_rrsig_index(update->zone, &ctx);
+
 	knot_time_t next_resign = 0;
 	result = knot_zone_sign_update_dnskeys(update, &keyset, &ctx, &next_resign);
 	if (result != KNOT_EOK) {
@@ -204,27 +272,46 @@ int knot_dnssec_zone_sign(zone_update_t *update,
 			       knot_strerror(result));
 		goto done;
 	}
+	sign_stats_phase(&stats, SIGN_PHASE_KEYS, &phase);
 
-	result = zone_adjust_contents(update->new_cont, adjust_cb_flags, NULL,
-	                              false, false, 1, update->a_ctx->node_ptrs);
-	if (result != KNOT_EOK) {
-		return result;
-	}
+	knot_time_t zone_expire = 0;
+	if (sign_due_only(update, &keyset, &ctx)) {
+		result = knot_zone_sign_due(update, &keyset, &ctx, &zone_expire);
+		if (result != KNOT_EOK) {
+			log_zone_error(zone_name, "DNSSEC, failed to refresh signatures (%s)",
+			               knot_strerror(result));
+			goto done;
+		}
+		sign_stats_phase(&stats, SIGN_PHASE_RRSIG, &phase);
+	} else {
+		result = zone_adjust_contents(update->new_cont, adjust_cb_flags, NULL,
+		                              false, false, 1, update->a_ctx->node_ptrs);
+		if (result != KNOT_EOK) {
+			goto done;
+		}
+		sign_stats_phase(&stats, SIGN_PHASE_ADJUST, &phase);
 
-	result = knot_zone_create_nsec_chain(update, &ctx);
-	if (result != KNOT_EOK) {
-		log_zone_error(zone_name, "DNSSEC, failed to create NSEC%s chain (%s)",
-		               ctx.policy->nsec3_enabled ? "3" : "",
-		               knot_strerror(result));
-		goto done;
-	}
+		result = knot_zone_create_nsec_chain(update, &ctx);
+		if (result != KNOT_EOK) {
+			log_zone_error(zone_name, "DNSSEC, failed to create NSEC%s chain (%s)",
+			               ctx.policy->nsec3_enabled ? "3" : "",
+			               knot_strerror(result));
+			goto done;
+		}
+		sign_stats_phase(&stats, SIGN_PHASE_NSEC, &phase);
 
-	knot_time_t zone_expire = 0;
-	result = knot_zone_sign(update, &keyset, &ctx, &zone_expire);
-	if (result != KNOT_EOK) {
-		log_zone_error(zone_name, "DNSSEC, failed to sign zone content (%s)",
-		               knot_strerror(result));
-		goto done;
+		result = knot_zone_sign(update, &keyset, &ctx, &zone_expire);
+		if (result != KNOT_EOK) {
+			log_zone_error(zone_name, "DNSSEC, failed to sign zone content (%s)",
+			               knot_strerror(result));
+			goto done;
+		}
+		sign_stats_phase(&stats, SIGN_PHASE_RRSIG, &phase);
+
+		// The whole zone is signed, rebuild the RRSIG index on commit.
+		if (update->zone->rrsig_index != NULL) {
+			update->rrsig_index_id = rrsig_index_setup_id(&keyset, &ctx);
+		}
 	}
 
 	// SOA finishing
@@ -264,6 +351,8 @@ int knot_dnssec_zone_sign(zone_update_t *update,
 	log_zone_info(zone_name, "DNSSEC, successfully signed");
 
 done:
+	store_sign_stats(update, &stats, &phase, result);
+
 	if (result == KNOT_EOK) {
 		reschedule->next_sign = schedule_next(&ctx, &keyset, next_resign, zone_expire);
 	} else {
@@ -289,6 +378,10 @@ int knot_dnssec_sign_update(zone_update_t *update, conf_t *conf, zone_sign_resch
 	zone_keyset_t keyset = { 0 };
 	unsigned zonemd_alg;
 
+	sign_stats_t stats = { 0 };
+	struct timespec phase = time_now();
+	update->sign_stats = &stats;
+
 	result = sign_init(update, conf, 0, 0, 0, zone_kaspdb(update->zone), &ctx, &zonemd_alg, reschedule);
 	if (result != KNOT_EOK) {
 		log_zone_error(zone_name, "DNSSEC, failed to initialize (%s)",
@@ -312,12 +405,14 @@ int knot_dnssec_sign_update(zone_update_t *update, conf_t *conf, zone_sign_resch
 			goto done;
 		}
 	}
+	sign_stats_phase(&stats, SIGN_PHASE_KEYS, &phase);
 
 	result = zone_adjust_contents(update->new_cont, adjust_cb_flags, NULL,
 	                              false, false, 1, update->a_ctx->node_ptrs);
 	if (result != KNOT_EOK) {
 		goto done;
 	}
+	sign_stats_phase(&stats, SIGN_PHASE_ADJUST, &phase);
 
 	knot_time_t expire_at = 0;
 	result = knot_zone_sign_update(update, &keyset, &ctx, &expire_at);
@@ -326,6 +421,7 @@ int knot_dnssec_sign_update(zone_update_t *update, conf_t *conf, zone_sign_resch
 		               knot_strerror(result));
 		goto done;
 	}
+	sign_stats_phase(&stats, SIGN_PHASE_RRSIG, &phase);
 
 	result = knot_zone_fix_nsec_chain(update, &keyset, &ctx);
 	if (result != KNOT_EOK) {
@@ -334,6 +430,7 @@ int knot_dnssec_sign_update(zone_update_t *update, conf_t *conf, zone_sign_resch
 		               knot_strerror(result));
 		goto done;
 	}
+	sign_stats_phase(&stats, SIGN_PHASE_NSEC, &phase);
 
 	bool soa_changed = (knot_soa_serial(node_rdataset(update->zone->contents->apex, KNOT_RRTYPE_SOA)->rdata) !=
 			    knot_soa_serial(node_rdataset(update->new_cont->apex, KNOT_RRTYPE_SOA)->rdata));
@@ -374,6 +471,8 @@ int knot_dnssec_sign_update(zone_update_t *update, conf_t *conf, zone_sign_resch
 	log_zone_info(zone_name, "DNSSEC, successfully signed");
 
 done:
+	store_sign_stats(update, &stats, &phase, result);
+
 	if (result == KNOT_EOK) {
 		reschedule->next_sign = schedule_next(&ctx, &keyset, next_resign, expire_at);
 	}
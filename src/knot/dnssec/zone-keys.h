@@ -61,6 +61,9 @@ typedef struct {
 	zone_key_t *keys;                 // keys in keyset
 	dnssec_sign_ctx_t **sign_ctxs;    // signing buffers for keys in keyset
 	const kdnssec_ctx_t *dnssec_ctx;  // dnssec context
+	uint64_t rrsigs_created;          // signatures created with this context
+	uint64_t rrsigs_reused;           // valid signatures kept
+	uint64_t rrsigs_removed;          // signatures removed
 } zone_sign_ctx_t;
 
 /*!
@@ -83,6 +83,42 @@ int knot_create_nsec3_owner(uint8_t *out, size_t out_size,
 	return ret;
 }
 
+int knot_create_nsec3_owners(knot_dname_storage_t *out, const knot_dname_t **owners,
+                             size_t count, const knot_dname_t *zone_apex,
+                             const dnssec_nsec3_params_t *params)
+{
+	if (out == NULL || owners == NULL || zone_apex == NULL || params == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	size_t hash_size = dnssec_nsec3_hash_length(params->algorithm);
+	if (hash_size == 0) {
+		return knot_error_from_libdnssec(DNSSEC_INVALID_NSEC3_ALGORITHM);
+	}
+
+	dnssec_binary_t *data = malloc(count * (sizeof(*data) + hash_size));
+	if (data == NULL) {
+		return KNOT_ENOMEM;
+	}
+	uint8_t *hashes = (uint8_t *)(data + count);
+
+	for (size_t i = 0; i < count; i++) {
+		data[i].data = (uint8_t *)owners[i];
+		data[i].size = knot_dname_size(owners[i]);
+	}
+
+	int ret = dnssec_nsec3_hash_batch(data, count, params, hashes);
+	ret = knot_error_from_libdnssec(ret);
+	for (size_t i = 0; i < count && ret == KNOT_EOK; i++) {
+		ret = knot_nsec3_hash_to_dname(out[i], sizeof(out[i]), hashes + i * hash_size,
+		                               hash_size, zone_apex);
+	}
+
+	free(data);
+
+	return ret;
+}
+
 knot_dname_t *node_nsec3_hash(zone_node_t *node, const zone_contents_t *zone)
 {
 	if (node->nsec3_hash == NULL && knot_is_nsec3_enabled(zone)) {
@@ -74,6 +74,23 @@ int knot_create_nsec3_owner(uint8_t *out, size_t out_size,
                             const knot_dname_t *owner, const knot_dname_t *zone_apex,
                             const dnssec_nsec3_params_t *params);
 
+/*!
+ * \brief Create NSEC3 owner names for multiple regular owner names at once.
+ *
+ * Hashing the names in a batch is considerably faster than one by one.
+ *
+ * \param out        Output buffers.
+ * \param owners     Node owner names.
+ * \param count      Number of the owner names.
+ * \param zone_apex  Zone apex name.
+ * \param params     Params for NSEC3 hashing function.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_create_nsec3_owners(knot_dname_storage_t *out, const knot_dname_t **owners,
+                             size_t count, const knot_dname_t *zone_apex,
+                             const dnssec_nsec3_params_t *params);
+
 /*!
  * \brief Return (and compute of needed) the corresponding NSEC3 node's name.
  *
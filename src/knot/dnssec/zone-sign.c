@@ -26,11 +26,26 @@
 #include "knot/dnssec/key-events.h"
 #include "knot/dnssec/key_records.h"
 #include "knot/dnssec/rrset-sign.h"
+#include "knot/dnssec/rrsig-index.h"
+#include "knot/dnssec/sign-stats.h"
 #include "knot/dnssec/zone-sign.h"
+#include "knot/server/server.h"
 #include "libknot/libknot.h"
 #include "libknot/dynarray.h"
+#include "contrib/macros.h"
+#include "contrib/time.h"
 #include "contrib/wire_ctx.h"
 
+#ifdef HAVE_ATOMIC
+#define ATOMIC_SET(dst, val)       __atomic_store_n(&(dst), (val), __ATOMIC_RELAXED)
+#define ATOMIC_GET(src)            __atomic_load_n(&(src), __ATOMIC_RELAXED)
+#define ATOMIC_FETCH_ADD(dst, val) __atomic_fetch_add(&(dst), (val), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_SET(dst, val)       ((dst) = (val))
+#define ATOMIC_GET(src)            (src)
+#define ATOMIC_FETCH_ADD(dst, val) __sync_fetch_and_add(&(dst), (val))
+#endif
+
 typedef struct {
 	node_t n;
 	uint16_t type;
@@ -188,12 +203,56 @@ bool rrsig_covers_type(const knot_rrset_t *rrsig, uint16_t type)
 	return false;
 }
 
+/*!
+ * \brief Prepare RRSIG changes of a covered RR set, except new signatures.
+ *
+ * \param covered     RR set with covered records.
+ * \param rrsigs      RR set with RRSIGs.
+ * \param sign_ctx    Local zone signing context.
+ * \param to_add      RRSIGs to be added, initialized.
+ * \param to_remove   RRSIGs to be removed, initialized.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+static int prepare_rrsigs(const knot_rrset_t *covered,
+                          const knot_rrset_t *rrsigs,
+                          zone_sign_ctx_t *sign_ctx,
+                          knot_rrset_t *to_add,
+                          knot_rrset_t *to_remove)
+{
+	*to_add = create_empty_rrsigs_for(covered);
+	*to_remove = create_empty_rrsigs_for(covered);
+	int result = (!rrsig_covers_type(rrsigs, covered->type) ? KNOT_EOK :
+	             knot_synth_rrsig(covered->type, &rrsigs->rrs, &to_remove->rrs, NULL));
+
+	if (result == KNOT_EOK && sign_ctx->dnssec_ctx->offline_rrsig != NULL &&
+	    knot_dname_cmp(sign_ctx->dnssec_ctx->offline_rrsig->owner, covered->owner) == 0 &&
+	    rrsig_covers_type(sign_ctx->dnssec_ctx->offline_rrsig, covered->type)) {
+		result = knot_synth_rrsig(covered->type,
+		    &sign_ctx->dnssec_ctx->offline_rrsig->rrs, &to_add->rrs, NULL);
+		if (result == KNOT_EOK) {
+			// don't remove what shall be added
+			result = knot_rdataset_subtract(&to_remove->rrs, &to_add->rrs, NULL);
+		}
+		if (result == KNOT_EOK && !knot_rrset_empty(rrsigs)) {
+			// don't add what's already present
+			result = knot_rdataset_subtract(&to_add->rrs, &rrsigs->rrs, NULL);
+		}
+	}
+
+	return result;
+}
+
 /*!
  * \brief Add missing RRSIGs into the changeset for adding.
  *
  * \note Also removes invalid RRSIGs.
  *
- * \param covered     RR set with covered records.
+ * The covered RR sets share the owner and the RRSIGs, the missing signatures
+ * are created in one batch per key.
+ *
+ * \param covered     RR sets with covered records.
+ * \param count       Number of covered RR sets.
  * \param rrsigs      RR set with RRSIGs.
  * \param sign_ctx    Local zone signing context.
  * \param skip_crypto All RRSIGs in this node have been verified, just check validity.
@@ -204,6 +263,7 @@ bool rrsig_covers_type(const knot_rrset_t *rrsig, uint16_t type)
  * \return Error code, KNOT_EOK if successful.
  */
 static int add_missing_rrsigs(const knot_rrset_t *covered,
+                              size_t count,
                               const knot_rrset_t *rrsigs,
                               zone_sign_ctx_t *sign_ctx,
                               bool skip_crypto,
@@ -211,69 +271,82 @@ static int add_missing_rrsigs(const knot_rrset_t *covered,
                               zone_update_t *update,
                               knot_time_t *expires_at)
 {
-	assert(!knot_rrset_empty(covered));
+	assert(count > 0);
 	assert(sign_ctx);
 	assert((bool)changeset != (bool)update);
 
-	knot_rrset_t to_add = create_empty_rrsigs_for(covered);
-	knot_rrset_t to_remove = create_empty_rrsigs_for(covered);
-	int result = (!rrsig_covers_type(rrsigs, covered->type) ? KNOT_EOK :
-	             knot_synth_rrsig(covered->type, &rrsigs->rrs, &to_remove.rrs, NULL));
-
-	if (result == KNOT_EOK && sign_ctx->dnssec_ctx->offline_rrsig != NULL &&
-	    knot_dname_cmp(sign_ctx->dnssec_ctx->offline_rrsig->owner, covered->owner) == 0 &&
-	    rrsig_covers_type(sign_ctx->dnssec_ctx->offline_rrsig, covered->type)) {
-		result = knot_synth_rrsig(covered->type,
-		    &sign_ctx->dnssec_ctx->offline_rrsig->rrs, &to_add.rrs, NULL);
+	knot_rrset_t to_add[count];
+	knot_rrset_t to_remove[count];
+	int result = KNOT_EOK;
+	for (size_t j = 0; j < count; j++) {
+		assert(!knot_rrset_empty(&covered[j]));
+		knot_rrset_init_empty(&to_add[j]);
+		knot_rrset_init_empty(&to_remove[j]);
 		if (result == KNOT_EOK) {
-			// don't remove what shall be added
-			result = knot_rdataset_subtract(&to_remove.rrs, &to_add.rrs, NULL);
-		}
-		if (result == KNOT_EOK && !knot_rrset_empty(rrsigs)) {
-			// don't add what's already present
-			result = knot_rdataset_subtract(&to_add.rrs, &rrsigs->rrs, NULL);
+			result = prepare_rrsigs(&covered[j], rrsigs, sign_ctx,
+			                        &to_add[j], &to_remove[j]);
 		}
 	}
 
+	knot_rrset_t *batch_rrsigs[count];
+	const knot_rrset_t *batch_covered[count];
+	knot_timediff_t refresh = sign_ctx->dnssec_ctx->policy->rrsig_refresh_before +
+	                          sign_ctx->dnssec_ctx->policy->rrsig_prerefresh;
+
 	for (size_t i = 0; i < sign_ctx->count && result == KNOT_EOK; i++) {
 		const zone_key_t *key = &sign_ctx->keys[i];
-		if (!knot_zone_sign_use_key(key, covered)) {
-			continue;
-		}
+		size_t batch_count = 0;
 
-		uint16_t valid_at;
-		knot_timediff_t refresh = sign_ctx->dnssec_ctx->policy->rrsig_refresh_before +
-		                          sign_ctx->dnssec_ctx->policy->rrsig_prerefresh;
-		if (valid_signature_exists(covered, rrsigs, key->key, sign_ctx->sign_ctxs[i],
-		                           sign_ctx->dnssec_ctx, refresh, skip_crypto, NULL, &valid_at)) {
-			knot_rdata_t *valid_rr = knot_rdataset_at(&rrsigs->rrs, valid_at);
-			result = knot_rdataset_remove(&to_remove.rrs, valid_rr, NULL);
-			note_earliest_expiration(valid_rr, expires_at);
-			continue;
+		for (size_t j = 0; j < count && result == KNOT_EOK; j++) {
+			if (!knot_zone_sign_use_key(key, &covered[j])) {
+				continue;
+			}
+
+			uint16_t valid_at;
+			if (valid_signature_exists(&covered[j], rrsigs, key->key, sign_ctx->sign_ctxs[i],
+			                           sign_ctx->dnssec_ctx, refresh, skip_crypto, NULL, &valid_at)) {
+				knot_rdata_t *valid_rr = knot_rdataset_at(&rrsigs->rrs, valid_at);
+				result = knot_rdataset_remove(&to_remove[j].rrs, valid_rr, NULL);
+				note_earliest_expiration(valid_rr, expires_at);
+				sign_ctx->rrsigs_reused++;
+				continue;
+			}
+
+			batch_rrsigs[batch_count] = &to_add[j];
+			batch_covered[batch_count] = &covered[j];
+			batch_count++;
 		}
 
-		result = knot_sign_rrset(&to_add, covered, key->key, sign_ctx->sign_ctxs[i],
-		                         sign_ctx->dnssec_ctx, NULL, expires_at);
+		if (result == KNOT_EOK) {
+			result = knot_sign_rrsets_ctx(sign_ctx, i, batch_rrsigs, batch_covered,
+			                              batch_count, NULL, expires_at);
+			if (result == KNOT_EOK) {
+				sign_ctx->rrsigs_created += batch_count;
+			}
+		}
 	}
 
-	if (!knot_rrset_empty(&to_remove) && result == KNOT_EOK) {
-		if (changeset != NULL) {
-			result = changeset_add_removal(changeset, &to_remove, 0);
-		} else {
-			result = zone_update_remove(update, &to_remove);
+	for (size_t j = 0; j < count; j++) {
+		if (!knot_rrset_empty(&to_remove[j]) && result == KNOT_EOK) {
+			sign_ctx->rrsigs_removed += to_remove[j].rrs.count;
+			if (changeset != NULL) {
+				result = changeset_add_removal(changeset, &to_remove[j], 0);
+			} else {
+				result = zone_update_remove(update, &to_remove[j]);
+			}
 		}
-	}
 
-	if (!knot_rrset_empty(&to_add) && result == KNOT_EOK) {
-		if (changeset != NULL) {
-			result = changeset_add_addition(changeset, &to_add, 0);
-		} else {
-			result = zone_update_add(update, &to_add);
+		if (!knot_rrset_empty(&to_add[j]) && result == KNOT_EOK) {
+			if (changeset != NULL) {
+				result = changeset_add_addition(changeset, &to_add[j], 0);
+			} else {
+				result = zone_update_add(update, &to_add[j]);
+			}
 		}
-	}
 
-	knot_rdataset_clear(&to_add.rrs, NULL);
-	knot_rdataset_clear(&to_remove.rrs, NULL);
+		knot_rdataset_clear(&to_add[j].rrs, NULL);
+		knot_rdataset_clear(&to_remove[j].rrs, NULL);
+	}
 
 	return result;
 }
@@ -332,6 +405,7 @@ int knot_validate_rrsigs(const knot_rrset_t *covered,
  */
 static int remove_rrset_rrsigs(const knot_dname_t *owner, uint16_t type,
                                const knot_rrset_t *rrsigs,
+                               zone_sign_ctx_t *sign_ctx,
                                changeset_t *changeset)
 {
 	assert(owner);
@@ -347,6 +421,7 @@ static int remove_rrset_rrsigs(const knot_dname_t *owner, uint16_t type,
 		return KNOT_EOK;
 	}
 
+	sign_ctx->rrsigs_removed += synth_rrsig.rrs.count;
 	ret = changeset_add_removal(changeset, &synth_rrsig, 0);
 	knot_rdataset_clear(&synth_rrsig.rrs, NULL);
 
@@ -372,41 +447,18 @@ static int force_resign_rrset(const knot_rrset_t *covered,
 
 	if (!knot_rrset_empty(rrsigs)) {
 		int result = remove_rrset_rrsigs(covered->owner, covered->type,
-		                                 rrsigs, changeset);
+		                                 rrsigs, sign_ctx, changeset);
 		if (result != KNOT_EOK) {
 			return result;
 		}
 	}
 
-	return add_missing_rrsigs(covered, NULL, sign_ctx, false, changeset, NULL, NULL);
-}
-
-/*!
- * \brief Drop all expired and create new RRSIGs for covered records.
- *
- * \param covered     RR set with covered records.
- * \param rrsigs      Existing RRSIGs for covered RR set.
- * \param sign_ctx    Local zone signing context.
- * \param skip_crypto All RRSIGs in this node have been verified, just check validity.
- * \param changeset   Changeset to be updated.
- * \param expires_at  Current earliest expiration, will be updated.
- *
- * \return Error code, KNOT_EOK if successful.
- */
-static int resign_rrset(const knot_rrset_t *covered,
-                        const knot_rrset_t *rrsigs,
-                        zone_sign_ctx_t *sign_ctx,
-                        bool skip_crypto,
-                        changeset_t *changeset,
-                        knot_time_t *expires_at)
-{
-	assert(!knot_rrset_empty(covered));
-
-	return add_missing_rrsigs(covered, rrsigs, sign_ctx, skip_crypto, changeset, NULL, expires_at);
+	return add_missing_rrsigs(covered, 1, NULL, sign_ctx, false, changeset, NULL, NULL);
 }
 
 static int remove_standalone_rrsigs(const zone_node_t *node,
                                     const knot_rrset_t *rrsigs,
+                                    zone_sign_ctx_t *sign_ctx,
                                     changeset_t *changeset)
 {
 	if (rrsigs == NULL) {
@@ -425,6 +477,7 @@ static int remove_standalone_rrsigs(const zone_node_t *node,
 			if (ret != KNOT_EOK) {
 				return ret;
 			}
+			sign_ctx->rrsigs_removed++;
 			ret = changeset_add_removal(changeset, &to_remove, 0);
 			knot_rdataset_clear(&to_remove.rrs, NULL);
 			if (ret != KNOT_EOK) {
@@ -460,6 +513,11 @@ static int sign_node_rrsets(const zone_node_t *node,
 	knot_rrset_t rrsigs = node_rrset(node, KNOT_RRTYPE_RRSIG);
 	bool skip_crypto = (node->flags & NODE_FLAGS_RRSIGS_VALID) &&
 	                   !sign_ctx->dnssec_ctx->keytag_conflict;
+	bool drop_existing = sign_ctx->dnssec_ctx->rrsig_drop_existing;
+
+	// RR sets to be (re)signed, in one batch per key
+	knot_rrset_t to_sign[MAX(node->rrset_count, 1)];
+	size_t to_sign_count = 0;
 
 	for (int i = 0; result == KNOT_EOK && i < node->rrset_count; i++) {
 		knot_rrset_t rrset = node_rrset_at(node, i);
@@ -467,7 +525,8 @@ static int sign_node_rrsets(const zone_node_t *node,
 
 		if (!knot_zone_sign_rr_should_be_signed(node, &rrset)) {
 			if (!sign_ctx->dnssec_ctx->validation_mode) {
-				result = remove_rrset_rrsigs(rrset.owner, rrset.type, &rrsigs, changeset);
+				result = remove_rrset_rrsigs(rrset.owner, rrset.type, &rrsigs,
+				                             sign_ctx, changeset);
 			}
 			continue;
 		}
@@ -478,17 +537,28 @@ static int sign_node_rrsets(const zone_node_t *node,
 				hint->node = node->owner;
 				hint->rrtype = rrset.type;
 			}
-		} else if (sign_ctx->dnssec_ctx->rrsig_drop_existing) {
-			result = force_resign_rrset(&rrset, &rrsigs,
-			                            sign_ctx, changeset);
+			continue;
+		}
+
+		if (drop_existing && !knot_rrset_empty(&rrsigs)) {
+			result = remove_rrset_rrsigs(rrset.owner, rrset.type, &rrsigs,
+			                             sign_ctx, changeset);
+		}
+		to_sign[to_sign_count++] = rrset;
+	}
+
+	if (result == KNOT_EOK && to_sign_count > 0) {
+		if (drop_existing) {
+			result = add_missing_rrsigs(to_sign, to_sign_count, NULL, sign_ctx,
+			                            false, changeset, NULL, NULL);
 		} else {
-			result = resign_rrset(&rrset, &rrsigs, sign_ctx, skip_crypto,
-			                      changeset, expires_at);
+			result = add_missing_rrsigs(to_sign, to_sign_count, &rrsigs, sign_ctx,
+			                            skip_crypto, changeset, NULL, expires_at);
 		}
 	}
 
 	if (result == KNOT_EOK) {
-		result = remove_standalone_rrsigs(node, &rrsigs, changeset);
+		result = remove_standalone_rrsigs(node, &rrsigs, sign_ctx, changeset);
 	}
 	return result;
 }
@@ -497,17 +567,11 @@ static int sign_node_rrsets(const zone_node_t *node,
  * \brief Struct to carry data for 'sign_data' callback function.
  */
 typedef struct {
-	zone_tree_t *tree;
 	zone_sign_ctx_t *sign_ctx;
 	changeset_t changeset;
 	knot_time_t expires_at;
 	dnssec_validation_hint_t *hint;
-	size_t num_threads;
-	size_t thread_index;
-	size_t rrset_index;
 	int errcode;
-	int thread_init_errcode;
-	pthread_t thread;
 } node_sign_args_t;
 
 /*!
@@ -527,10 +591,6 @@ static int sign_node(zone_node_t *node, void *data)
 		return KNOT_EOK;
 	}
 
-	if (args->rrset_index++ % args->num_threads != args->thread_index) {
-		return KNOT_EOK;
-	}
-
 	int result = sign_node_rrsets(node, args->sign_ctx,
 	                              &args->changeset, &args->expires_at,
 	                              args->hint);
@@ -538,19 +598,220 @@ static int sign_node(zone_node_t *node, void *data)
 	return result;
 }
 
-static void *tree_sign_thread(void *_arg)
+static int set_signed(zone_node_t *node, _unused_ void *data)
 {
-	node_sign_args_t *arg = _arg;
-	arg->errcode = zone_tree_apply(arg->tree, sign_node, _arg);
-	return NULL;
+	node->flags |= NODE_FLAGS_RRSIGS_VALID;
+	return KNOT_EOK;
 }
 
-static int set_signed(zone_node_t *node, _unused_ void *data)
+/*! \brief Number of nodes signed as one unit of work in parallel signing. */
+#define SIGN_CHUNK_NODES 64
+
+/*! \brief Range of chunks initially assigned to one signing thread. */
+typedef struct {
+	size_t next; /*!< Next chunk to be signed, claimed atomically. */
+	size_t end;
+} sign_range_t;
+
+/*!
+ * \brief Parallel signing of a zone tree.
+ *
+ * The nodes are split into chunks and each thread starts with its own range
+ * of chunks. A thread finished with its range steals the remaining chunks of
+ * the other ranges. The helper threads are tasks of the background workers;
+ * as the signing may itself run in a background worker, the calling thread
+ * signs too and doesn't wait for the helpers which haven't started yet. They
+ * may start after the signing has finished, so this state is reference
+ * counted and the late helpers just release it.
+ */
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t idle;
+	size_t refs;        /*!< References, under lock. */
+	size_t active;      /*!< Helpers signing, under lock. */
+	size_t next_slot;   /*!< Next args slot for a helper, under lock. */
+	bool closed;        /*!< Signing finished, under lock. */
+	int failed;         /*!< Some thread failed, stop signing. */
+
+	zone_node_t **nodes;
+	size_t count;
+	size_t num_threads;
+	sign_range_t *ranges;
+	node_sign_args_t *args;
+	worker_task_t tasks[];
+} tree_sign_t;
+
+static int collect_node(zone_node_t *node, void *data)
 {
-	node->flags |= NODE_FLAGS_RRSIGS_VALID;
+	tree_sign_t *ts = data;
+	if (node->rrset_count > 0) {
+		ts->nodes[ts->count++] = node;
+	}
 	return KNOT_EOK;
 }
 
+static void tree_sign_unref(tree_sign_t *ts)
+{
+	if (ts == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&ts->lock);
+	bool last = (--ts->refs == 0);
+	pthread_mutex_unlock(&ts->lock);
+
+	if (last) {
+		pthread_cond_destroy(&ts->idle);
+		pthread_mutex_destroy(&ts->lock);
+		free(ts->nodes);
+		free(ts->ranges);
+		free(ts);
+	}
+}
+
+static tree_sign_t *tree_sign_new(zone_tree_t *tree, size_t num_threads)
+{
+	tree_sign_t *ts = calloc(1, sizeof(*ts) + (num_threads - 1) * sizeof(worker_task_t));
+	if (ts == NULL) {
+		return NULL;
+	}
+
+	size_t max_count = zone_tree_count(tree);
+	ts->nodes = malloc(MAX(max_count, 1) * sizeof(*ts->nodes));
+	ts->ranges = calloc(num_threads, sizeof(*ts->ranges));
+	if (ts->nodes == NULL || ts->ranges == NULL ||
+	    pthread_mutex_init(&ts->lock, NULL) != 0) {
+		free(ts->nodes);
+		free(ts->ranges);
+		free(ts);
+		return NULL;
+	}
+	if (pthread_cond_init(&ts->idle, NULL) != 0) {
+		pthread_mutex_destroy(&ts->lock);
+		free(ts->nodes);
+		free(ts->ranges);
+		free(ts);
+		return NULL;
+	}
+	ts->refs = 1;
+	ts->next_slot = 1;
+
+	(void)zone_tree_apply(tree, collect_node, ts);
+	assert(ts->count <= max_count);
+
+	// Don't use more threads than chunks.
+	size_t chunks = (ts->count + SIGN_CHUNK_NODES - 1) / SIGN_CHUNK_NODES;
+	ts->num_threads = MIN(num_threads, chunks);
+	if (ts->num_threads == 0) {
+		ts->num_threads = 1;
+	}
+	for (size_t i = 0; i < ts->num_threads; i++) {
+		ts->ranges[i].next = i * chunks / ts->num_threads;
+		ts->ranges[i].end = (i + 1) * chunks / ts->num_threads;
+	}
+
+	return ts;
+}
+
+/*! \brief Claim and sign one chunk of the range, return false if none left. */
+static bool sign_chunk(tree_sign_t *ts, sign_range_t *range, node_sign_args_t *args)
+{
+	size_t chunk = ATOMIC_FETCH_ADD(range->next, 1);
+	if (chunk >= range->end) {
+		return false;
+	}
+
+	size_t end = MIN((chunk + 1) * SIGN_CHUNK_NODES, ts->count);
+	for (size_t i = chunk * SIGN_CHUNK_NODES; i < end && args->errcode == KNOT_EOK; i++) {
+		args->errcode = sign_node(ts->nodes[i], args);
+	}
+
+	return true;
+}
+
+/*! \brief Sign own range of chunks, then steal from the other ranges. */
+static void sign_ranges(tree_sign_t *ts, size_t slot)
+{
+	node_sign_args_t *args = &ts->args[slot];
+
+	for (size_t i = 0; i < ts->num_threads; i++) {
+		sign_range_t *range = &ts->ranges[(slot + i) % ts->num_threads];
+		while (args->errcode == KNOT_EOK && !ATOMIC_GET(ts->failed) &&
+		       sign_chunk(ts, range, args));
+	}
+
+	if (args->errcode != KNOT_EOK) {
+		ATOMIC_SET(ts->failed, 1);
+	}
+}
+
+static void tree_sign_helper(worker_task_t *task)
+{
+	tree_sign_t *ts = task->ctx;
+
+	pthread_mutex_lock(&ts->lock);
+	size_t slot = ts->closed ? 0 : ts->next_slot++;
+	if (slot > 0) {
+		ts->active++;
+	}
+	pthread_mutex_unlock(&ts->lock);
+
+	if (slot > 0) {
+		sign_ranges(ts, slot);
+
+		pthread_mutex_lock(&ts->lock);
+		ts->active--;
+		pthread_cond_signal(&ts->idle);
+		pthread_mutex_unlock(&ts->lock);
+	}
+
+	tree_sign_unref(ts);
+}
+
+static void tree_sign_run(tree_sign_t *ts, worker_pool_t *pool, node_sign_args_t *args)
+{
+	ts->args = args;
+
+	size_t helpers = ts->num_threads - 1;
+	ts->refs += helpers;
+	for (size_t i = 0; i < helpers; i++) {
+		ts->tasks[i].ctx = ts;
+		ts->tasks[i].run = tree_sign_helper;
+		worker_pool_assign(pool, &ts->tasks[i]);
+	}
+
+	sign_ranges(ts, 0);
+
+	// Wait for the started helpers, the others won't touch the args.
+	pthread_mutex_lock(&ts->lock);
+	ts->closed = true;
+	while (ts->active > 0) {
+		pthread_cond_wait(&ts->idle, &ts->lock);
+	}
+	pthread_mutex_unlock(&ts->lock);
+}
+
+/*! \brief Get the background workers for parallel signing if available. */
+static worker_pool_t *sign_workers(zone_update_t *update)
+{
+	if (update == NULL || update->zone == NULL || update->zone->server == NULL) {
+		return NULL;
+	}
+	return update->zone->server->workers;
+}
+
+/*! \brief Add the signature counters of a local signing context to the update statistics. */
+static void sign_ctx_account(zone_update_t *update, const zone_sign_ctx_t *sign_ctx)
+{
+	if (update == NULL || update->sign_stats == NULL || sign_ctx == NULL) {
+		return;
+	}
+
+	update->sign_stats->rrsigs_created += sign_ctx->rrsigs_created;
+	update->sign_stats->rrsigs_reused += sign_ctx->rrsigs_reused;
+	update->sign_stats->rrsigs_removed += sign_ctx->rrsigs_removed;
+}
+
 /*!
  * \brief Update RRSIGs in a given zone tree by updating changeset.
  *
@@ -575,13 +836,26 @@ static int zone_tree_sign(zone_tree_t *tree,
 	assert(update || dnssec_ctx->validation_mode);
 
 	int ret = KNOT_EOK;
+	*expires_at = knot_time_plus(dnssec_ctx->now, dnssec_ctx->policy->rrsig_lifetime);
+
+	// The parallel signing is done by the background workers.
+	worker_pool_t *pool = sign_workers(update);
+	tree_sign_t *ts = NULL;
+	if (num_threads > 1 && pool != NULL) {
+		ts = tree_sign_new(tree, num_threads);
+		if (ts == NULL) {
+			return KNOT_ENOMEM;
+		}
+		num_threads = ts->num_threads;
+	} else {
+		num_threads = 1;
+	}
+
 	node_sign_args_t args[num_threads];
 	memset(args, 0, sizeof(args));
-	*expires_at = knot_time_plus(dnssec_ctx->now, dnssec_ctx->policy->rrsig_lifetime);
 
 	// init context structures
 	for (size_t i = 0; i < num_threads; i++) {
-		args[i].tree = tree;
 		args[i].sign_ctx = dnssec_ctx->validation_mode
 		                 ? zone_validation_ctx(dnssec_ctx)
 		                 : zone_sign_ctx(zone_keys, dnssec_ctx);
@@ -595,49 +869,34 @@ static int zone_tree_sign(zone_tree_t *tree,
 		}
 		args[i].expires_at = 0;
 		args[i].hint = &update->validation_hint;
-		args[i].num_threads = num_threads;
-		args[i].thread_index = i;
-		args[i].rrset_index = 0;
 		args[i].errcode = KNOT_EOK;
-		args[i].thread_init_errcode = -1;
 	}
 	if (ret != KNOT_EOK) {
 		for (size_t i = 0; i < num_threads; i++) {
 			changeset_clear(&args[i].changeset);
 			zone_sign_ctx_free(args[i].sign_ctx);
 		}
+		tree_sign_unref(ts);
 		return ret;
 	}
 
-	if (num_threads == 1) {
-		args[0].thread_init_errcode = 0;
-		tree_sign_thread(&args[0]);
+	if (ts == NULL) {
+		args[0].errcode = zone_tree_apply(tree, sign_node, &args[0]);
 	} else {
-		// start working threads
-		for (size_t i = 0; i < num_threads; i++) {
-			args[i].thread_init_errcode =
-				pthread_create(&args[i].thread, NULL, tree_sign_thread, &args[i]);
-		}
-
-		// join those threads that have been really started
-		for (size_t i = 0; i < num_threads; i++) {
-			if (args[i].thread_init_errcode == 0) {
-				args[i].thread_init_errcode = pthread_join(args[i].thread, NULL);
-			}
-		}
+		tree_sign_run(ts, pool, args);
+		tree_sign_unref(ts);
 	}
 
 	// collect return code and results
 	for (size_t i = 0; i < num_threads; i++) {
 		if (ret == KNOT_EOK) {
-			if (args[i].thread_init_errcode != 0) {
-				ret = knot_map_errno_code(args[i].thread_init_errcode);
-			} else {
-				ret = args[i].errcode;
-				if (ret == KNOT_EOK && !dnssec_ctx->validation_mode) {
-					ret = zone_update_apply_changeset(update, &args[i].changeset); // _fix not needed
-					*expires_at = knot_time_min(*expires_at, args[i].expires_at);
-				}
+			ret = args[i].errcode;
+			if (ret == KNOT_EOK && !dnssec_ctx->validation_mode) {
+				struct timespec begin = time_now();
+				ret = zone_update_apply_changeset(update, &args[i].changeset); // _fix not needed
+				sign_stats_nested(update->sign_stats, SIGN_PHASE_APPLY, &begin);
+				*expires_at = knot_time_min(*expires_at, args[i].expires_at);
+				sign_ctx_account(update, args[i].sign_ctx);
 			}
 		}
 		assert(!dnssec_ctx->validation_mode || changeset_empty(&args[i].changeset));
@@ -728,6 +987,122 @@ int knot_zone_sign(zone_update_t *update,
 	return result;
 }
 
+/*! \brief Due entry without a node in the zone. */
+typedef struct {
+	knot_dname_t *owner;
+	bool nsec3;
+} gone_node_t;
+
+knot_dynarray_declare(gone, gone_node_t, DYNARRAY_VISIBILITY_STATIC, 4)
+knot_dynarray_define(gone, gone_node_t, DYNARRAY_VISIBILITY_STATIC)
+
+/*!
+ * \brief Struct to carry data for collecting the nodes due for re-signing.
+ */
+typedef struct {
+	zone_contents_t *contents;
+	zone_tree_t *nodes;
+	zone_tree_t *nsec3_nodes;
+	gone_dynarray_t gone;
+} sign_due_ctx_t;
+
+static int collect_due(const knot_dname_t *owner, bool nsec3, void *data)
+{
+	sign_due_ctx_t *ctx = data;
+
+	zone_node_t *node = zone_tree_get(nsec3 ? ctx->contents->nsec3_nodes :
+	                                          ctx->contents->nodes, owner);
+	if (node == NULL) {
+		gone_node_t gone = { knot_dname_copy(owner, NULL), nsec3 };
+		if (gone.owner == NULL || gone_dynarray_add(&ctx->gone, &gone) == NULL) {
+			knot_dname_free(gone.owner, NULL);
+			return KNOT_ENOMEM;
+		}
+		return KNOT_EOK;
+	}
+
+	return zone_tree_insert(nsec3 ? ctx->nsec3_nodes : ctx->nodes, &node);
+}
+
+int knot_zone_sign_due(zone_update_t *update,
+                       zone_keyset_t *zone_keys,
+                       const kdnssec_ctx_t *dnssec_ctx,
+                       knot_time_t *expire_at)
+{
+	if (!update || !zone_keys || !dnssec_ctx || !expire_at ||
+	    !(update->flags & UPDATE_INCREMENTAL) || update->zone->rrsig_index == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	rrsig_index_t *index = update->zone->rrsig_index;
+	const knot_kasp_policy_t *policy = dnssec_ctx->policy;
+	knot_time_t until = knot_time_plus(dnssec_ctx->now,
+	                                   (knot_timediff_t)policy->rrsig_refresh_before +
+	                                   policy->rrsig_prerefresh);
+
+	sign_due_ctx_t ctx = {
+		.contents = update->new_cont,
+		.nodes = zone_tree_create(true),
+		.nsec3_nodes = zone_tree_create(true),
+	};
+	if (ctx.nodes == NULL || ctx.nsec3_nodes == NULL) {
+		zone_tree_free(&ctx.nodes);
+		zone_tree_free(&ctx.nsec3_nodes);
+		return KNOT_ENOMEM;
+	}
+	ctx.nodes->flags = update->new_cont->nodes->flags;
+	ctx.nsec3_nodes->flags = update->new_cont->nodes->flags;
+
+	int ret = rrsig_index_due(index, until, collect_due, &ctx);
+
+	// Fix the entries according to the current contents first, the signed
+	// nodes get their new entries when the update is committed.
+	knot_dynarray_foreach(gone, gone_node_t, gone, ctx.gone) {
+		if (ret == KNOT_EOK) {
+			ret = rrsig_index_set(index, gone->owner, gone->nsec3, 0);
+		}
+		knot_dname_free(gone->owner, NULL);
+	}
+	gone_dynarray_free(&ctx.gone);
+	if (ret == KNOT_EOK) {
+		ret = rrsig_index_update(index, update->new_cont, ctx.nodes,
+		                         ctx.nsec3_nodes, 0);
+	}
+
+	size_t count = zone_tree_count(ctx.nodes) + zone_tree_count(ctx.nsec3_nodes);
+	if (ret == KNOT_EOK && count > 0) {
+		log_zone_info(dnssec_ctx->zone->dname, "DNSSEC, refreshing signatures "
+		              "in %zu nodes", count);
+	}
+
+	knot_time_t normal_expire = 0;
+	if (ret == KNOT_EOK) {
+		ret = zone_tree_sign(ctx.nodes, policy->signing_threads, zone_keys,
+		                     dnssec_ctx, update, &normal_expire);
+	}
+
+	knot_time_t nsec3_expire = 0;
+	if (ret == KNOT_EOK) {
+		ret = zone_tree_sign(ctx.nsec3_nodes, policy->signing_threads, zone_keys,
+		                     dnssec_ctx, update, &nsec3_expire);
+	}
+
+	zone_tree_free(&ctx.nodes);
+	zone_tree_free(&ctx.nsec3_nodes);
+
+	if (ret == KNOT_EOK) {
+		ret = zone_tree_apply(update->a_ctx->node_ptrs, set_signed, NULL);
+	}
+	if (ret == KNOT_EOK) {
+		ret = zone_tree_apply(update->a_ctx->nsec3_ptrs, set_signed, NULL);
+	}
+
+	*expire_at = knot_time_min(knot_time_min(normal_expire, nsec3_expire),
+	                           rrsig_index_next(index, until));
+
+	return ret;
+}
+
 keyptr_dynarray_t knot_zone_sign_get_cdnskeys(const kdnssec_ctx_t *ctx,
 					      zone_keyset_t *zone_keys)
 {
@@ -939,7 +1314,7 @@ static int sign_in_changeset(zone_node_t *node, uint16_t rrtype, knot_rrset_t *r
 	if (knot_rrset_empty(&rr)) {
 		return KNOT_EOK;
 	}
-	return add_missing_rrsigs(&rr, rrsigs, sign_ctx, skip_crypto, NULL, up, NULL);
+	return add_missing_rrsigs(&rr, 1, rrsigs, sign_ctx, skip_crypto, NULL, up, NULL);
 }
 
 int knot_zone_sign_nsecs_in_changeset(const zone_keyset_t *zone_keys,
@@ -974,6 +1349,7 @@ int knot_zone_sign_nsecs_in_changeset(const zone_keyset_t *zone_keys,
 		zone_tree_it_next(&it);
 	}
 	zone_tree_it_free(&it);
+	sign_ctx_account(update, sign_ctx);
 	zone_sign_ctx_free(sign_ctx);
 
 	return ret;
@@ -1055,6 +1431,7 @@ int knot_zone_sign_apex_rr(zone_update_t *update, uint16_t rrtype,
 		if (ret == KNOT_EOK) {
 			ret = zone_update_apply_changeset(update, &ch);
 		}
+		sign_ctx_account(update, sign_ctx);
 		zone_sign_ctx_free(sign_ctx);
 	}
 	changeset_clear(&ch);
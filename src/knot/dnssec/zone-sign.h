@@ -105,6 +105,24 @@ int knot_zone_sign(zone_update_t *update,
                    const kdnssec_ctx_t *dnssec_ctx,
                    knot_time_t *expire_at);
 
+/*!
+ * \brief Update just the signatures due for refresh according to the RRSIG index.
+ *
+ * The zone must be completely signed with the same keys and policy, see
+ * rrsig_index_t. The NSEC(3) chain and DNSKEYs are not touched.
+ *
+ * \param update      Incremental zone update to be updated with new RRSIGs.
+ * \param zone_keys   Zone keys.
+ * \param dnssec_ctx  DNSSEC context.
+ * \param expire_at   Time, when the oldest signature in the zone expires.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_zone_sign_due(zone_update_t *update,
+                       zone_keyset_t *zone_keys,
+                       const kdnssec_ctx_t *dnssec_ctx,
+                       knot_time_t *expire_at);
+
 /*!
  * \brief Sign NSEC/NSEC3 nodes in changeset and update the changeset.
  *
@@ -25,6 +25,8 @@
 #include "knot/events/events.h"
 #include "knot/events/handlers.h"
 #include "knot/events/replan.h"
+#include "knot/server/server.h"
+#include "knot/zone/cold.h"
 #include "knot/zone/zone.h"
 
 #define ZONE_EVENT_IMMEDIATE 1 /* Fast-track to worker queue. */
@@ -51,6 +53,7 @@ static const event_info_t EVENT_INFO[] = {
 	{ ZONE_EVENT_NSEC3RESALT,  event_nsec3resalt, "NSEC3 resalt" },
 	{ ZONE_EVENT_DS_CHECK,     event_ds_check,    "DS check" },
 	{ ZONE_EVENT_DS_PUSH,      event_ds_push,     "DS push" },
+	{ ZONE_EVENT_EVICT,        event_evict,       "eviction" },
 	{ 0 }
 };
 
@@ -228,8 +231,18 @@ static void event_wrap(worker_task_t *task)
 	int ret = conf_clone(&conf);
 	rcu_read_unlock();
 	if (ret == KNOT_EOK) {
+		/* Load evicted contents of cold zone first. */
+		if (zone_cold_load_needed(zone, type)) {
+			ret = event_load(conf, zone);
+		}
 		/* Execute the event callback. */
-		ret = info->callback(conf, zone);
+		if (ret == KNOT_EOK) {
+			ret = info->callback(conf, zone);
+		}
+		zone_cold_update(conf, zone, type != ZONE_EVENT_EVICT);
+		if (type == ZONE_EVENT_LOAD && zone->server != NULL) {
+			load_plan_done(&zone->server->load_plan, zone);
+		}
 		conf_free(conf);
 	}
 
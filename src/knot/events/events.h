@@ -43,6 +43,7 @@ typedef enum zone_event_type {
 	ZONE_EVENT_NSEC3RESALT,
 	ZONE_EVENT_DS_CHECK,
 	ZONE_EVENT_DS_PUSH,
+	ZONE_EVENT_EVICT,
 	// terminator
 	ZONE_EVENT_COUNT,
 } zone_event_type_t;
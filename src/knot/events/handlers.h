@@ -19,11 +19,14 @@
 #include "knot/conf/conf.h"
 #include "knot/zone/zone.h"
 #include "knot/dnssec/zone-events.h" // zone_sign_reschedule_t
+#include "knot/query/soa_probe.h"
 
 /*! \brief Loads or reloads potentially changed zone. */
 int event_load(conf_t *conf, zone_t *zone);
 /*! \brief Refresh a zone from a master. */
 int event_refresh(conf_t *conf, zone_t *zone);
+/*! \brief Continues the refresh with the result of a batched SOA query. */
+void event_refresh_probed(zone_t *zone, const soa_probe_result_t *result);
 /*! \brief Processes DDNS updates in the zone's DDNS queue. */
 int event_update(conf_t *conf, zone_t *zone);
 /*! \brief Empties in-memory zone contents. */
@@ -49,3 +52,5 @@ int event_nsec3resalt(conf_t *conf, zone_t *zone);
 int event_ds_check(conf_t *conf, zone_t *zone);
 /*! \brief After change of CDS/CDNSKEY, push the new DS to parent zone as DDNS. */
 int event_ds_push(conf_t *conf, zone_t *zone);
+/*! \brief Drops unused contents of cold zone, to be loaded again on demand. */
+int event_evict(conf_t *conf, zone_t *zone);
@@ -0,0 +1,48 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <urcu.h>
+
+#include "knot/common/log.h"
+#include "knot/conf/conf.h"
+#include "knot/events/handlers.h"
+#include "knot/zone/cold.h"
+#include "knot/zone/contents.h"
+#include "knot/zone/zone.h"
+
+int event_evict(conf_t *conf, zone_t *zone)
+{
+	assert(zone);
+
+	if (!zone->cold.enabled || !zone_cold_evictable(conf, zone)) {
+		return KNOT_EOK;
+	}
+
+	zone_cold_forget(zone);
+
+	// Queries coming from now on plan the load again.
+	zone_cold_mark_evicted(zone);
+	zone_contents_t *evicted = zone_switch_contents(zone, NULL);
+	log_zone_info(zone->name, "zone evicted, %zu bytes", evicted->size);
+
+	synchronize_rcu();
+	knot_sem_wait(&zone->cow_lock);
+	zone_contents_deep_free(evicted);
+	knot_sem_post(&zone->cow_lock);
+
+	return KNOT_EOK;
+}
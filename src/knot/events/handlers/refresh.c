@@ -28,9 +28,11 @@
 #include "knot/query/layer.h"
 #include "knot/query/query.h"
 #include "knot/query/requestor.h"
+#include "knot/server/server.h"
 #include "knot/updates/changesets.h"
 #include "knot/zone/adjust.h"
 #include "knot/zone/digest.h"
+#include "knot/zone/ingest.h"
 #include "knot/zone/serial.h"
 #include "knot/zone/zone.h"
 #include "knot/zone/zonefile.h"
@@ -118,6 +120,8 @@ struct refresh_data {
 
 	struct {
 		zone_contents_t *zone;    //!< AXFR result, new zone.
+		zone_ingest_t *ingest;    //!< Inserting thread, if running.
+		bool has_soa;             //!< The initial SOA was received.
 	} axfr;
 
 	struct {
@@ -191,7 +195,8 @@ static void xfr_log_read_ms(const knot_dname_t *zone, int ret)
 static int axfr_init(struct refresh_data *data)
 {
 	zone_contents_t *new_zone = zone_contents_new(data->zone->name, true);
-	if (new_zone == NULL) {
+	if (new_zone == NULL || zone_contents_bulk_begin(new_zone) != KNOT_EOK) {
+		zone_contents_deep_free(new_zone);
 		return KNOT_ENOMEM;
 	}
 
@@ -201,6 +206,8 @@ static int axfr_init(struct refresh_data *data)
 
 static void axfr_cleanup(struct refresh_data *data)
 {
+	zone_ingest_abort(data->axfr.ingest);
+	data->axfr.ingest = NULL;
 	zone_contents_deep_free(data->axfr.zone);
 	data->axfr.zone = NULL;
 }
@@ -238,12 +245,26 @@ static int axfr_finalize(struct refresh_data *data)
 	uint32_t old_serial = zone_contents_serial(data->zone->contents), master_serial = 0;
 	bool bootstrap = (data->zone->contents == NULL);
 
+	int ret = KNOT_EOK;
+	if (data->axfr.ingest != NULL) {
+		ret = zone_ingest_finish(data->axfr.ingest);
+		data->axfr.ingest = NULL;
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	ret = zone_contents_bulk_end(new_zone);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
 	if (dnssec_enable) {
 		axfr_slave_sign_serial(new_zone, data->zone, data->conf, &master_serial);
 	}
 
 	zone_update_t up = { 0 };
-	int ret = zone_update_from_contents(&up, data->zone, new_zone, UPDATE_FULL);
+	ret = zone_update_from_contents(&up, data->zone, new_zone, UPDATE_FULL);
 	if (ret != KNOT_EOK) {
 		data->fallback->remote = false;
 		return ret;
@@ -306,20 +327,28 @@ static int axfr_consume_rr(const knot_rrset_t *rr, struct refresh_data *data)
 	assert(data);
 	assert(data->axfr.zone);
 
-	// zc is stateless structure which can be initialized for each rr
-	// the changes are stored only in data->axfr.zone (aka zc.z)
-	zcreator_t zc = {
-		.z = data->axfr.zone,
-		.master = false,
-		.ret = KNOT_EOK
-	};
-
+	// The contents may be being filled by the ingest thread, the SOA
+	// presence is tracked here instead.
 	if (rr->type == KNOT_RRTYPE_SOA &&
-	    node_rrtype_exists(zc.z->apex, KNOT_RRTYPE_SOA)) {
-		return KNOT_STATE_DONE;
+	    knot_dname_is_case_equal(rr->owner, data->zone->name)) {
+		if (data->axfr.has_soa) {
+			return KNOT_STATE_DONE;
+		}
+		data->axfr.has_soa = true;
 	}
 
-	data->ret = zcreator_step(&zc, rr);
+	if (data->axfr.ingest != NULL) {
+		data->ret = zone_ingest_add(data->axfr.ingest, rr);
+	} else {
+		// zc is stateless structure which can be initialized for each rr
+		// the changes are stored only in data->axfr.zone (aka zc.z)
+		zcreator_t zc = {
+			.z = data->axfr.zone,
+			.master = false,
+			.ret = KNOT_EOK
+		};
+		data->ret = zcreator_step(&zc, rr);
+	}
 	if (data->ret != KNOT_EOK) {
 		return KNOT_STATE_FAIL;
 	}
@@ -345,6 +374,16 @@ static int axfr_consume_packet(knot_pkt_t *pkt, struct refresh_data *data)
 	for (uint16_t i = 0; i < answer->count && ret == KNOT_STATE_CONSUME; ++i) {
 		ret = axfr_consume_rr(knot_pkt_rr(answer, i), data);
 	}
+
+	// Hand the records over to the ingest thread, which inserts them
+	// while the next message is being received.
+	if (data->axfr.ingest != NULL && ret != KNOT_STATE_FAIL) {
+		data->ret = zone_ingest_flush(data->axfr.ingest);
+		if (data->ret != KNOT_EOK) {
+			return KNOT_STATE_FAIL;
+		}
+	}
+
 	return ret;
 }
 
@@ -376,6 +415,13 @@ static int axfr_consume(knot_pkt_t *pkt, struct refresh_data *data)
 		AXFRIN_LOG(LOG_INFO, data->zone->name, data->remote, "started");
 		xfr_stats_begin(&data->stats);
 		data->change_size = 0;
+		data->axfr.has_soa = false;
+	} else if (data->axfr.ingest == NULL) {
+		// Multi-message transfer, insert the records on another thread.
+		// A single-message transfer doesn't pay for the thread.
+		if (zone_ingest_start(data->axfr.zone, &data->axfr.ingest) != KNOT_EOK) {
+			data->axfr.ingest = NULL; // continue inserting here
+		}
 	}
 
 	int next;
@@ -1229,6 +1275,128 @@ static int64_t max_refresh_interval(conf_t *conf, const knot_dname_t *zone)
 	return conf_int(&val);
 }
 
+typedef enum {
+	PROBE_SKIP,    // query the masters directly
+	PROBE_WAIT,    // SOA query submitted, the refresh resumes with its result
+	PROBE_CURRENT, // the zone is up-to-date
+} probe_step_t;
+
+static bool probe_submit(conf_t *conf, zone_t *zone)
+{
+	conf_val_t masters = conf_zone_get(conf, C_MASTER, zone->name);
+	if (masters.code != KNOT_EOK) {
+		return false;
+	}
+	conf_remote_t master = conf_remote(conf, &masters, 0);
+
+	struct query_edns_data edns;
+	query_edns_data_init(&edns, conf, zone->name, master.addr.ss_family);
+
+	// Set before submitting, the result can come anytime.
+	pthread_mutex_lock(&zone->preferred_lock);
+	zone->probe.state = ZONE_PROBE_PENDING;
+	pthread_mutex_unlock(&zone->preferred_lock);
+
+	int ret = soa_probe_submit(zone->server->soa_probe, zone->name, &master,
+	                           master.no_edns ? NULL : &edns);
+	if (ret != KNOT_EOK) {
+		pthread_mutex_lock(&zone->preferred_lock);
+		zone->probe.state = ZONE_PROBE_NONE;
+		pthread_mutex_unlock(&zone->preferred_lock);
+		return false;
+	}
+
+	return true;
+}
+
+static probe_step_t probe_result(conf_t *conf, zone_t *zone,
+                                 const soa_probe_result_t *result)
+{
+	const struct sockaddr *remote = (const struct sockaddr *)&result->remote;
+
+	if (result->ret != KNOT_EOK) {
+		REFRESH_LOG(LOG_DEBUG, zone->name, remote,
+		            "batched SOA query failed (%s)", knot_strerror(result->ret));
+		return PROBE_SKIP;
+	}
+
+	uint32_t local_serial;
+	if (slave_zone_serial(zone, conf, &local_serial) != KNOT_EOK) {
+		return PROBE_SKIP;
+	}
+	bool current = serial_is_current(local_serial, result->serial);
+	bool master_uptodate = serial_is_current(result->serial, local_serial);
+
+	if (current && master_uptodate) {
+		REFRESH_LOG(LOG_INFO, zone->name, remote,
+		            "remote serial %u, zone is up-to-date", result->serial);
+		return PROBE_CURRENT;
+	} else if (!current) {
+		// Transfer from the probed master first.
+		zone_set_preferred_master(zone, &result->remote);
+	}
+
+	return PROBE_SKIP;
+}
+
+/*!
+ * \brief Use the batched SOA query instead of a blocking one if possible.
+ *
+ * Zones being bootstrapped or with a preferred master (e.g. from NOTIFY)
+ * are refreshed directly.
+ */
+static probe_step_t refresh_probe(conf_t *conf, zone_t *zone)
+{
+	pthread_mutex_lock(&zone->preferred_lock);
+	zone_probe_state_t state = zone->probe.state;
+	bool preferred = (zone->preferred_master != NULL);
+	soa_probe_result_t result = {
+		.ret = zone->probe.ret,
+		.serial = zone->probe.serial,
+		.remote = zone->probe.remote,
+	};
+	if (state == ZONE_PROBE_DONE) {
+		zone->probe.state = ZONE_PROBE_NONE;
+	}
+	pthread_mutex_unlock(&zone->preferred_lock);
+
+	switch (state) {
+	case ZONE_PROBE_PENDING:
+		return preferred ? PROBE_SKIP : PROBE_WAIT;
+	case ZONE_PROBE_DONE:
+		return preferred ? PROBE_SKIP : probe_result(conf, zone, &result);
+	default:
+		break;
+	}
+
+	if (conf->cache.srv_rmt_probe_window == 0 || zone->server == NULL ||
+	    zone->server->soa_probe == NULL || zone->contents == NULL || preferred) {
+		return PROBE_SKIP;
+	}
+
+	return probe_submit(conf, zone) ? PROBE_WAIT : PROBE_SKIP;
+}
+
+void event_refresh_probed(zone_t *zone, const soa_probe_result_t *result)
+{
+	assert(zone);
+	assert(result);
+
+	pthread_mutex_lock(&zone->preferred_lock);
+	bool pending = (zone->probe.state == ZONE_PROBE_PENDING);
+	if (pending) {
+		zone->probe.state = ZONE_PROBE_DONE;
+		zone->probe.ret = result->ret;
+		zone->probe.serial = result->serial;
+		zone->probe.remote = result->remote;
+	}
+	pthread_mutex_unlock(&zone->preferred_lock);
+
+	if (pending) {
+		zone_events_schedule_now(zone, ZONE_EVENT_REFRESH);
+	}
+}
+
 int event_refresh(conf_t *conf, zone_t *zone)
 {
 	assert(zone);
@@ -1245,7 +1413,13 @@ int event_refresh(conf_t *conf, zone_t *zone)
 		zone->zonefile.retransfer = true;
 	}
 
-	int ret = zone_master_try(conf, zone, try_refresh, &trctx, "refresh");
+	int ret = KNOT_EOK;
+	probe_step_t probe = trctx.force_axfr ? PROBE_SKIP : refresh_probe(conf, zone);
+	if (probe == PROBE_WAIT) {
+		return KNOT_EOK; // resumed by event_refresh_probed()
+	} else if (probe == PROBE_SKIP) {
+		ret = zone_master_try(conf, zone, try_refresh, &trctx, "refresh");
+	}
 	zone_clear_preferred_master(zone);
 	if (ret != KNOT_EOK) {
 		log_zone_error(zone->name, "refresh, failed (%s)", knot_strerror(ret));
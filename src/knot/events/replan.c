@@ -17,6 +17,7 @@
 #include <assert.h>
 
 #include "knot/events/replan.h"
+#include "knot/zone/cold.h"
 
 #define TIME_CANCEL 0
 #define TIME_IGNORE (-1)
@@ -95,7 +96,8 @@ void replan_from_timers(conf_t *conf, zone_t *zone)
 	time_t refresh = TIME_CANCEL;
 	if (zone_is_slave(conf, zone)) {
 		refresh = zone->timers.next_refresh;
-		if (zone->contents == NULL && zone->timers.last_refresh_ok) { // zone disappeared w/o expiry
+		if (zone->contents == NULL && zone->timers.last_refresh_ok && // zone disappeared w/o expiry
+		    !zone->cold.evicted) {
 			refresh = now;
 		}
 		assert(refresh > 0);
@@ -187,3 +189,15 @@ void replan_load_updated(zone_t *zone, zone_t *old_zone)
 	// other events will cascade from load
 	zone_events_schedule_now(zone, ZONE_EVENT_LOAD);
 }
+
+void replan_load_cold(conf_t *conf, zone_t *zone, zone_t *old_zone)
+{
+	if (old_zone != NULL) {
+		replan_ddns(zone, old_zone);
+		replan_notify(zone, old_zone);
+	}
+
+	// load on demand, any planned event will load the zone first
+	zone_cold_mark_evicted(zone);
+	replan_from_timers(conf, zone);
+}
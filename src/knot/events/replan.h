@@ -32,4 +32,5 @@ void replan_load_new(zone_t *zone);
 void replan_load_bootstrap(conf_t *conf, zone_t *zone);
 void replan_load_current(conf_t *conf, zone_t *zone, zone_t *old_zone);
 void replan_load_updated(zone_t *zone, zone_t *old_zone);
+void replan_load_cold(conf_t *conf, zone_t *zone, zone_t *old_zone);
 /*! @} */
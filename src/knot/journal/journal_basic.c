@@ -14,8 +14,13 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#ifdef ENABLE_JOURNAL_COMPRESSION
+#include <zlib.h>
+#endif
+
 #include "knot/journal/journal_basic.h"
 #include "knot/journal/journal_metadata.h"
+#include "contrib/macros.h"
 #include "libknot/error.h"
 
 MDB_val journal_changeset_id_to_key(bool zone_in_journal, uint32_t serial, const knot_dname_t *zone)
@@ -49,11 +54,61 @@ void journal_del_zone(knot_lmdb_txn_t *txn, const knot_dname_t *zone)
 	free(prefix.mv_data);
 }
 
-void journal_make_header(void *chunk, uint32_t ch_serial_to)
+void journal_make_header(void *chunk, uint32_t ch_serial_to, int compression,
+                         uint32_t raw_size)
 {
-	knot_lmdb_make_key_part(chunk, JOURNAL_HEADER_SIZE, "IILLL", ch_serial_to,
+	knot_lmdb_make_key_part(chunk, JOURNAL_HEADER_SIZE, "IIIILL", ch_serial_to,
 	                        (uint32_t)0 /* we no longer care for # of chunks */,
-	                        (uint64_t)0, (uint64_t)0, (uint64_t)0);
+	                        (uint32_t)compression, raw_size, (uint64_t)0, (uint64_t)0);
+}
+
+int journal_chunk_compression(const MDB_val *chunk, uint32_t *raw_size)
+{
+	if (chunk->mv_size < JOURNAL_HEADER_SIZE) {
+		*raw_size = 0;
+		return JOURNAL_COMPRESSION_NONE;
+	}
+	const uint8_t *header = chunk->mv_data;
+	*raw_size = knot_wire_read_u32(header + 3 * sizeof(uint32_t));
+	return knot_wire_read_u32(header + 2 * sizeof(uint32_t));
+}
+
+size_t journal_compress(int compression, const uint8_t *src, size_t src_size,
+                        uint8_t *dst, size_t dst_size)
+{
+	switch (compression) {
+#ifdef ENABLE_JOURNAL_COMPRESSION
+	case JOURNAL_COMPRESSION_ZLIB:;
+		uLongf out_size = MIN(dst_size, src_size);
+		if (compress2(dst, &out_size, src, src_size, Z_BEST_SPEED) != Z_OK ||
+		    out_size >= src_size) {
+			return 0;
+		}
+		return out_size;
+#endif
+	default:
+		return 0;
+	}
+}
+
+int journal_decompress(int compression, const uint8_t *src, size_t src_size,
+                       uint8_t *dst, size_t dst_size)
+{
+	switch (compression) {
+	case JOURNAL_COMPRESSION_NONE:
+		return KNOT_EINVAL;
+#ifdef ENABLE_JOURNAL_COMPRESSION
+	case JOURNAL_COMPRESSION_ZLIB:;
+		uLongf out_size = dst_size;
+		if (uncompress(dst, &out_size, src, src_size) != Z_OK ||
+		    out_size != dst_size) {
+			return KNOT_EMALF;
+		}
+		return KNOT_EOK;
+#endif
+	default:
+		return KNOT_ENOTSUP;
+	}
 }
 
 uint32_t journal_next_serial(const MDB_val *chunk)
@@ -90,3 +145,13 @@ size_t journal_conf_max_changesets(zone_journal_t j)
 	conf_val_t val = conf_zone_get(j.conf, C_JOURNAL_MAX_DEPTH, j.zone);
 	return conf_int(&val);
 }
+
+int journal_conf_compression(zone_journal_t j)
+{
+#ifdef ENABLE_JOURNAL_COMPRESSION
+	conf_val_t val = conf_zone_get(j.conf, C_JOURNAL_COMPRESSION, j.zone);
+	return conf_opt(&val);
+#else
+	return JOURNAL_COMPRESSION_NONE;
+#endif
+}
@@ -72,10 +72,42 @@ void journal_del_zone(knot_lmdb_txn_t *txn, const knot_dname_t *zone);
 /*!
  * \brief Initialise chunk header.
  *
- * \param chunk   Pointer to the changeset chunk. It must be at least JOURNAL_HEADER_SIZE, perhaps more.
- * \param ch      Serial-to of the changeset being serialized.
+ * \param chunk         Pointer to the changeset chunk. It must be at least JOURNAL_HEADER_SIZE, perhaps more.
+ * \param ch            Serial-to of the changeset being serialized.
+ * \param compression   Compression of the chunk data (JOURNAL_COMPRESSION_*).
+ * \param raw_size      Size of the chunk data before compression.
  */
-void journal_make_header(void *chunk, uint32_t ch_serial_to);
+void journal_make_header(void *chunk, uint32_t ch_serial_to, int compression,
+                         uint32_t raw_size);
+
+/*!
+ * \brief Obtain compression of the chunk data.
+ *
+ * \note Chunks stored before the compression support have zeros in the header,
+ *       which means no compression.
+ *
+ * \param chunk      Changeset chunk including the header.
+ * \param raw_size   Output: size of the chunk data before compression.
+ *
+ * \return Chunk data compression (JOURNAL_COMPRESSION_*).
+ */
+int journal_chunk_compression(const MDB_val *chunk, uint32_t *raw_size);
+
+/*!
+ * \brief Compress chunk data.
+ *
+ * \return Size of the compressed data, 0 if not supported or not smaller than the source.
+ */
+size_t journal_compress(int compression, const uint8_t *src, size_t src_size,
+                        uint8_t *dst, size_t dst_size);
+
+/*!
+ * \brief Decompress chunk data into a buffer of exactly the original size.
+ *
+ * \return KNOT_E*
+ */
+int journal_decompress(int compression, const uint8_t *src, size_t src_size,
+                       uint8_t *dst, size_t dst_size);
 
 /*!
  * \brief Obtain serial-to of the serialized changeset.
@@ -114,3 +146,6 @@ size_t journal_conf_max_usage(zone_journal_t j);
 
 /*! \brief Return configured maximal depth of journal. */
 size_t journal_conf_max_changesets(zone_journal_t j);
+
+/*! \brief Return configured compression of newly stored changesets. */
+int journal_conf_compression(zone_journal_t j);
@@ -20,11 +20,14 @@
 #include "knot/journal/knot_lmdb.h"
 
 #include "contrib/macros.h"
+#include "contrib/time.h"
 #include "contrib/ucw/lists.h"
 #include "contrib/wire_ctx.h"
 #include "libknot/error.h"
 
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
 struct journal_read {
 	knot_lmdb_txn_t txn;
@@ -32,17 +35,119 @@ struct journal_read {
 	const knot_dname_t *zone;
 	wire_ctx_t wire;
 	uint32_t next;
+
+	// suspended reading, the current chunk is copied out of the txn
+	knot_lmdb_db_t *db;
+	MDB_val chunk_key;
+	uint8_t *chunk;
+	bool suspended;
+
+	// storage of the borrowed RRsets, see journal_read_rrset_borrowed()
+	knot_dname_storage_t owner;
+	uint8_t *rdata;
+	size_t rdata_max;
+
+	// list of readers holding a txn, ordered by the txn start
+	struct timespec since;
+	bool registered;
+	journal_read_t *prev_reader;
+	journal_read_t *next_reader;
 };
 
+static struct {
+	pthread_mutex_t lock;
+	journal_read_t *first;
+	journal_read_t *last;
+} readers = { PTHREAD_MUTEX_INITIALIZER };
+
+static void reader_add(journal_read_t *ctx)
+{
+	ctx->since = time_now();
+	ctx->registered = true;
+	pthread_mutex_lock(&readers.lock);
+	ctx->prev_reader = readers.last;
+	ctx->next_reader = NULL;
+	if (readers.last != NULL) {
+		readers.last->next_reader = ctx;
+	} else {
+		readers.first = ctx;
+	}
+	readers.last = ctx;
+	pthread_mutex_unlock(&readers.lock);
+}
+
+static void reader_rem(journal_read_t *ctx)
+{
+	if (!ctx->registered) {
+		return;
+	}
+	ctx->registered = false;
+	pthread_mutex_lock(&readers.lock);
+	if (ctx->prev_reader != NULL) {
+		ctx->prev_reader->next_reader = ctx->next_reader;
+	} else {
+		readers.first = ctx->next_reader;
+	}
+	if (ctx->next_reader != NULL) {
+		ctx->next_reader->prev_reader = ctx->prev_reader;
+	} else {
+		readers.last = ctx->prev_reader;
+	}
+	ctx->prev_reader = NULL;
+	ctx->next_reader = NULL;
+	pthread_mutex_unlock(&readers.lock);
+}
+
+uint64_t journal_read_oldest_age(void)
+{
+	uint64_t age = 0;
+	pthread_mutex_lock(&readers.lock);
+	if (readers.first != NULL) {
+		struct timespec now = time_now();
+		age = time_diff_ms(&readers.first->since, &now);
+	}
+	pthread_mutex_unlock(&readers.lock);
+	return age;
+}
+
 int journal_read_get_error(const journal_read_t *ctx, int another_error)
 {
 	return (ctx == NULL || ctx->txn.ret == KNOT_EOK ? another_error : ctx->txn.ret);
 }
 
-static void update_ctx_wire(journal_read_t *ctx)
+static bool update_ctx_wire(journal_read_t *ctx)
 {
-	ctx->wire = wire_ctx_init_const(ctx->txn.cur_val.mv_data, ctx->txn.cur_val.mv_size);
-	wire_ctx_skip(&ctx->wire, JOURNAL_HEADER_SIZE);
+	free(ctx->chunk);
+	ctx->chunk = NULL;
+
+	const MDB_val *val = &ctx->txn.cur_val;
+	uint32_t raw_size = 0;
+	int compression = journal_chunk_compression(val, &raw_size);
+	if (compression == JOURNAL_COMPRESSION_NONE) {
+		ctx->wire = wire_ctx_init_const(val->mv_data, val->mv_size);
+		wire_ctx_skip(&ctx->wire, JOURNAL_HEADER_SIZE);
+		return true;
+	}
+
+	// compressed chunk is inflated into a private buffer
+	ctx->wire = (wire_ctx_t){ 0 };
+	if (raw_size == 0 || raw_size > JOURNAL_CHUNK_MAX) {
+		ctx->txn.ret = KNOT_EMALF;
+		return false;
+	}
+	ctx->chunk = malloc(raw_size);
+	if (ctx->chunk == NULL) {
+		ctx->txn.ret = KNOT_ENOMEM;
+		return false;
+	}
+	int ret = journal_decompress(compression, val->mv_data + JOURNAL_HEADER_SIZE,
+	                             val->mv_size - JOURNAL_HEADER_SIZE, ctx->chunk, raw_size);
+	if (ret != KNOT_EOK) {
+		ctx->txn.ret = ret;
+		return false;
+	}
+	ctx->wire = wire_ctx_init_const(ctx->chunk, raw_size);
+	return true;
 }
 
 static bool go_next_changeset(journal_read_t *ctx, bool go_zone, const knot_dname_t *zone)
@@ -57,8 +162,7 @@ static bool go_next_changeset(journal_read_t *ctx, bool go_zone, const knot_dnam
 		return false;
 	}
 	ctx->next = journal_next_serial(&ctx->txn.cur_val);
-	update_ctx_wire(ctx);
-	return true;
+	return update_ctx_wire(ctx);
 }
 
 int journal_read_begin(zone_journal_t j, bool read_zone, uint32_t serial_from, journal_read_t **ctx)
@@ -75,8 +179,12 @@ int journal_read_begin(zone_journal_t j, bool read_zone, uint32_t serial_from, j
 
 	newctx->zone = j.zone;
 	newctx->next = serial_from;
+	newctx->db = j.db;
 
 	knot_lmdb_begin(j.db, &newctx->txn, false);
+	if (newctx->txn.opened) {
+		reader_add(newctx);
+	}
 
 	if (go_next_changeset(newctx, read_zone, j.zone)) {
 		*ctx = newctx;
@@ -90,15 +198,81 @@ int journal_read_begin(zone_journal_t j, bool read_zone, uint32_t serial_from, j
 void journal_read_end(journal_read_t *ctx)
 {
 	if (ctx != NULL) {
+		reader_rem(ctx);
 		free(ctx->key_prefix.mv_data);
+		free(ctx->chunk_key.mv_data);
+		free(ctx->chunk);
+		free(ctx->rdata);
 		knot_lmdb_abort(&ctx->txn);
 		free(ctx);
 	}
 }
 
+int journal_read_suspend(journal_read_t *ctx)
+{
+	if (ctx == NULL || ctx->suspended || ctx->txn.ret != KNOT_EOK) {
+		return journal_read_get_error(ctx, KNOT_EOK);
+	}
+
+	// copy the rest of the current chunk and its key, the txn is dropped
+	size_t rest = wire_ctx_available(&ctx->wire);
+	uint8_t *chunk = malloc(rest > 0 ? rest : 1);
+	void *key = malloc(ctx->txn.cur_key.mv_size);
+	if (chunk == NULL || key == NULL) {
+		free(chunk);
+		free(key);
+		return KNOT_ENOMEM;
+	}
+	memcpy(chunk, ctx->wire.position, rest);
+	memcpy(key, ctx->txn.cur_key.mv_data, ctx->txn.cur_key.mv_size);
+
+	free(ctx->chunk);
+	ctx->chunk = chunk;
+	ctx->wire = wire_ctx_init_const(chunk, rest);
+
+	free(ctx->chunk_key.mv_data);
+	ctx->chunk_key.mv_data = key;
+	ctx->chunk_key.mv_size = ctx->txn.cur_key.mv_size;
+
+	reader_rem(ctx);
+	knot_lmdb_abort(&ctx->txn);
+	ctx->suspended = true;
+
+	return KNOT_EOK;
+}
+
+static bool resume(journal_read_t *ctx)
+{
+	ctx->suspended = false;
+
+	knot_lmdb_begin(ctx->db, &ctx->txn, false);
+	if (!ctx->txn.opened) {
+		return false;
+	}
+	reader_add(ctx);
+
+	// the cursor had already moved past the changeset before the suspend
+	if (!knot_lmdb_is_prefix_of(&ctx->key_prefix, &ctx->chunk_key)) {
+		return false;
+	}
+
+	// the changeset may have been removed or replaced meanwhile
+	if (!knot_lmdb_find(&ctx->txn, &ctx->chunk_key, KNOT_LMDB_EXACT | KNOT_LMDB_FORCE)) {
+		return false;
+	}
+	if (ctx->next != journal_next_serial(&ctx->txn.cur_val)) {
+		ctx->txn.ret = KNOT_ENOENT;
+		return false;
+	}
+	return true;
+}
+
 static bool make_data_available(journal_read_t *ctx)
 {
 	if (wire_ctx_available(&ctx->wire) == 0) {
+		if (ctx->suspended && !resume(ctx)) {
+			return false;
+		}
 		if (!knot_lmdb_next(&ctx->txn)) {
 			return false;
 		}
@@ -110,7 +284,7 @@ static bool make_data_available(journal_read_t *ctx)
 			ctx->txn.ret = KNOT_EMALF;
 			return false;
 		}
-		update_ctx_wire(ctx);
+		return update_ctx_wire(ctx);
 	}
 	return true;
 }
@@ -120,16 +294,51 @@ static bool make_data_available(journal_read_t *ctx)
 // - endian
 // - optionally storing whole rdataset at once?
 
-bool journal_read_rrset(journal_read_t *ctx, knot_rrset_t *rrset, bool allow_next_changeset)
+static int add_rdata_borrowed(journal_read_t *ctx, knot_rdataset_t *rrs, uint16_t len)
+{
+	if (wire_ctx_available(&ctx->wire) < len) {
+		return KNOT_ERANGE;
+	}
+	size_t size = rrs->size + knot_rdata_size(len);
+	if (size > ctx->rdata_max) {
+		size_t rdata_max = MAX(size, 2 * ctx->rdata_max);
+		uint8_t *rdata = realloc(ctx->rdata, rdata_max);
+		if (rdata == NULL) {
+			return KNOT_ENOMEM;
+		}
+		ctx->rdata = rdata;
+		ctx->rdata_max = rdata_max;
+	}
+	// the rdata are stored in canonical order, so they can be just appended
+	knot_rdata_init((knot_rdata_t *)(ctx->rdata + rrs->size), len, ctx->wire.position);
+	rrs->size = size;
+	rrs->count++;
+	return KNOT_EOK;
+}
+
+static bool read_rrset(journal_read_t *ctx, knot_rrset_t *rrset, bool allow_next_changeset,
+                       bool borrow)
 {
-	//knot_rdataset_clear(&rrset->rrs, NULL);
-	//memset(rrset, 0, sizeof(*rrset));
 	if (!make_data_available(ctx)) {
 		if (!allow_next_changeset || !go_next_changeset(ctx, false, ctx->zone)) {
 			return false;
 		}
 	}
-	rrset->owner = knot_dname_copy(ctx->wire.position, NULL);
+	if (!borrow) {
+		rrset->owner = knot_dname_copy(ctx->wire.position, NULL);
+	} else if (ctx->chunk == NULL) {
+		// the mapped chunk stays valid until the txn ends
+		rrset->owner = (knot_dname_t *)ctx->wire.position;
+		knot_rdataset_init(&rrset->rrs);
+	} else if (knot_dname_store(ctx->owner, ctx->wire.position) > 0) {
+		// the private chunk might be replaced by the following one
+		rrset->owner = ctx->owner;
+		knot_rdataset_init(&rrset->rrs);
+	} else {
+		knot_rrset_init_empty(rrset);
+		ctx->txn.ret = KNOT_EMALF;
+		return false;
+	}
 	wire_ctx_skip(&ctx->wire, knot_dname_size(rrset->owner));
 	rrset->type = wire_ctx_read_u16(&ctx->wire);
 	rrset->rclass = wire_ctx_read_u16(&ctx->wire);
@@ -138,51 +347,241 @@ bool journal_read_rrset(journal_read_t *ctx, knot_rrset_t *rrset, bool allow_nex
 		if (!make_data_available(ctx)) {
 			ctx->wire.error = KNOT_EFEWDATA;
 		}
-		// TODO think of how to export serialized rr directly to knot_rdataset_add
-		// focus on: even address aligning
 		uint32_t ttl = wire_ctx_read_u32(&ctx->wire);
 		if (i == 0) {
 			rrset->ttl = ttl;
 		}
 		uint16_t len = wire_ctx_read_u16(&ctx->wire);
 		if (ctx->wire.error == KNOT_EOK) {
-			ctx->wire.error = knot_rrset_add_rdata(rrset, ctx->wire.position, len, NULL);
+			ctx->wire.error = borrow ? add_rdata_borrowed(ctx, &rrset->rrs, len) :
+			                  knot_rrset_add_rdata(rrset, ctx->wire.position, len, NULL);
 		}
 		wire_ctx_skip(&ctx->wire, len);
 	}
+	if (borrow && rrset->rrs.count > 0) {
+		rrset->rrs.rdata = (knot_rdata_t *)ctx->rdata;
+	}
 	if (ctx->txn.ret == KNOT_EOK) {
 		ctx->txn.ret = ctx->wire.error == KNOT_ERANGE ? KNOT_EMALF : ctx->wire.error;
 	}
 	if (ctx->txn.ret == KNOT_EOK) {
 		return true;
+	} else if (borrow) {
+		knot_rrset_init_empty(rrset);
+		return false;
 	} else {
 		journal_read_clear_rrset(rrset);
 		return false;
 	}
 }
 
+bool journal_read_rrset(journal_read_t *ctx, knot_rrset_t *rrset, bool allow_next_changeset)
+{
+	return read_rrset(ctx, rrset, allow_next_changeset, false);
+}
+
+bool journal_read_rrset_borrowed(journal_read_t *ctx, knot_rrset_t *rrset,
+                                 bool allow_next_changeset)
+{
+	return read_rrset(ctx, rrset, allow_next_changeset, true);
+}
+
 void journal_read_clear_rrset(knot_rrset_t *rr)
 {
 	knot_rrset_clear(rr, NULL);
 }
 
-int journal_read_rrsets(journal_read_t *read, journal_read_cb_t cb, void *ctx)
+static int read_rrsets(journal_read_t *read, bool allow_next_changeset,
+                       journal_read_cb_t cb, void *ctx)
 {
 	knot_rrset_t rr = { 0 };
 	bool in_remove_section = false;
 	int ret = KNOT_EOK;
-	while (ret == KNOT_EOK && journal_read_rrset(read, &rr, true)) {
+	while (ret == KNOT_EOK && journal_read_rrset_borrowed(read, &rr, allow_next_changeset)) {
 		if (rr_is_apex_soa(&rr, read->zone)) {
 			in_remove_section = !in_remove_section;
 		}
 		ret = cb(in_remove_section, &rr, ctx);
-		journal_read_clear_rrset(&rr);
 	}
-	ret = journal_read_get_error(read, ret);
+	return journal_read_get_error(read, ret);
+}
+
+int journal_read_rrsets(journal_read_t *read, journal_read_cb_t cb, void *ctx)
+{
+	int ret = read_rrsets(read, true, cb, ctx);
 	journal_read_end(read);
 	return ret;
 }
 
+#define PREFETCH_BATCH	1024
+#define PREFETCH_SLOTS	2
+
+typedef struct {
+	knot_rrset_t rrsets[PREFETCH_BATCH];
+	size_t count;
+	bool ready;
+	bool last;
+} prefetch_slot_t;
+
+typedef struct {
+	journal_read_t *read;
+	bool allow_next_changeset;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	prefetch_slot_t slots[PREFETCH_SLOTS];
+	bool stop;
+} prefetch_t;
+
+/*!
+ * \brief Drop the txn, so that the reading can continue in another thread.
+ *
+ * LMDB read txns are bound to the thread which started them.
+ */
+static void read_detach(journal_read_t *ctx)
+{
+	int ret = journal_read_suspend(ctx);
+	if (ctx->txn.opened) {
+		reader_rem(ctx);
+		knot_lmdb_abort(&ctx->txn);
+		if (ctx->txn.ret == KNOT_EOK) {
+			ctx->txn.ret = ret;
+		}
+	}
+}
+
+static void *prefetch_thread(void *arg)
+{
+	prefetch_t *pf = arg;
+
+	bool more = true;
+	for (size_t batch = 0; more; batch++) {
+		prefetch_slot_t *slot = &pf->slots[batch % PREFETCH_SLOTS];
+
+		pthread_mutex_lock(&pf->lock);
+		bool wait = slot->ready && !pf->stop;
+		pthread_mutex_unlock(&pf->lock);
+		if (wait) {
+			// don't hold the journal snapshot while the changes are applied
+			read_detach(pf->read);
+		}
+
+		pthread_mutex_lock(&pf->lock);
+		while (slot->ready && !pf->stop) {
+			pthread_cond_wait(&pf->cond, &pf->lock);
+		}
+		bool stop = pf->stop;
+		pthread_mutex_unlock(&pf->lock);
+		if (stop) {
+			break;
+		}
+
+		slot->count = 0;
+		while (slot->count < PREFETCH_BATCH) {
+			knot_rrset_t *rr = &slot->rrsets[slot->count];
+			knot_rrset_init_empty(rr);
+			if (!journal_read_rrset(pf->read, rr, pf->allow_next_changeset)) {
+				more = false;
+				break;
+			}
+			slot->count++;
+		}
+
+		pthread_mutex_lock(&pf->lock);
+		slot->last = !more;
+		slot->ready = true;
+		pthread_cond_broadcast(&pf->cond);
+		pthread_mutex_unlock(&pf->lock);
+	}
+
+	read_detach(pf->read);
+
+	return NULL;
+}
+
+static int apply_prefetched(prefetch_t *pf, journal_read_cb_t cb, void *ctx)
+{
+	bool in_remove_section = false;
+	int ret = KNOT_EOK;
+
+	for (size_t batch = 0; ret == KNOT_EOK; batch++) {
+		prefetch_slot_t *slot = &pf->slots[batch % PREFETCH_SLOTS];
+
+		pthread_mutex_lock(&pf->lock);
+		while (!slot->ready) {
+			pthread_cond_wait(&pf->cond, &pf->lock);
+		}
+		pthread_mutex_unlock(&pf->lock);
+
+		for (size_t i = 0; i < slot->count; i++) {
+			knot_rrset_t *rr = &slot->rrsets[i];
+			if (ret == KNOT_EOK) {
+				if (rr_is_apex_soa(rr, pf->read->zone)) {
+					in_remove_section = !in_remove_section;
+				}
+				ret = cb(in_remove_section, rr, ctx);
+			}
+			journal_read_clear_rrset(rr);
+		}
+		bool last = slot->last;
+
+		pthread_mutex_lock(&pf->lock);
+		slot->ready = false;
+		if (ret != KNOT_EOK) {
+			pf->stop = true;
+		}
+		pthread_cond_broadcast(&pf->cond);
+		pthread_mutex_unlock(&pf->lock);
+
+		if (last) {
+			break;
+		}
+	}
+
+	return ret;
+}
+
+int journal_read_rrsets_prefetch(journal_read_t *read, bool allow_next_changeset,
+                                 journal_read_cb_t cb, void *ctx)
+{
+	if (read == NULL || cb == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	prefetch_t *pf = calloc(1, sizeof(*pf));
+	if (pf == NULL) {
+		return read_rrsets(read, allow_next_changeset, cb, ctx);
+	}
+	pf->read = read;
+	pf->allow_next_changeset = allow_next_changeset;
+	pthread_mutex_init(&pf->lock, NULL);
+	pthread_cond_init(&pf->cond, NULL);
+
+	read_detach(read);
+
+	pthread_t thread;
+	int ret = pthread_create(&thread, NULL, prefetch_thread, pf);
+	if (ret == 0) {
+		ret = apply_prefetched(pf, cb, ctx);
+		pthread_join(thread, NULL);
+		ret = journal_read_get_error(read, ret);
+	} else {
+		ret = read_rrsets(read, allow_next_changeset, cb, ctx);
+	}
+
+	// the batches read after a failure
+	for (size_t i = 0; i < PREFETCH_SLOTS; i++) {
+		prefetch_slot_t *slot = &pf->slots[i];
+		for (size_t j = 0; slot->ready && j < slot->count; j++) {
+			journal_read_clear_rrset(&slot->rrsets[j]);
+		}
+	}
+	pthread_cond_destroy(&pf->cond);
+	pthread_mutex_destroy(&pf->lock);
+	free(pf);
+
+	return ret;
+}
+
 static int add_rr_to_contents(zone_contents_t *z, const knot_rrset_t *rrset)
 {
 	zone_node_t *n = NULL;
@@ -203,7 +602,7 @@ bool journal_read_changeset(journal_read_t *ctx, changeset_t *ch)
 	if (!journal_read_rrset(ctx, soa, true)) {
 		goto fail;
 	}
-	while (journal_read_rrset(ctx, &rr, false)) {
+	while (journal_read_rrset_borrowed(ctx, &rr, false)) {
 		if (rr_is_apex_soa(&rr, ctx->zone)) {
 			if (ch->soa_from != NULL) {
 				ctx->txn.ret = KNOT_EMALF;
@@ -211,17 +610,14 @@ bool journal_read_changeset(journal_read_t *ctx, changeset_t *ch)
 			}
 			ch->soa_from = soa;
 			ch->remove = tree;
-			soa = malloc(sizeof(*soa));
+			soa = knot_rrset_copy(&rr, NULL);
 			tree = zone_contents_new(ctx->zone, false);
 			if (tree == NULL || soa == NULL) {
 				ctx->txn.ret = KNOT_ENOMEM;
 				goto fail;
 			}
-			*soa = rr; // note this tricky assignment
-			memset(&rr, 0, sizeof(rr));
 		} else {
 			ctx->txn.ret = add_rr_to_contents(tree, &rr);
-			journal_read_clear_rrset(&rr);
 		}
 	}
 
@@ -231,9 +627,7 @@ bool journal_read_changeset(journal_read_t *ctx, changeset_t *ch)
 		return true;
 	} else {
 fail:
-		journal_read_clear_rrset(&rr);
-		journal_read_clear_rrset(soa);
-		free(soa);
+		knot_rrset_free(soa, NULL);
 		changeset_clear(ch);
 		zone_contents_deep_free(tree);
 		return false;
@@ -47,6 +47,23 @@ int journal_read_begin(zone_journal_t j, bool read_zone, uint32_t serial_from, j
  */
 bool journal_read_rrset(journal_read_t *ctx, knot_rrset_t *rr, bool allow_next_changeset);
 
+/*!
+ * \brief Read a single RRSet from a journal changeset without copying it out.
+ *
+ * The owner references the journal data directly if possible, the rdata are
+ * gathered into a buffer of the reading context. The RRSet is valid only until
+ * the next reading, journal_read_suspend(), or journal_read_end(), and it must
+ * be neither modified nor cleared. Copy it if it's needed longer.
+ *
+ * \param ctx                    Journal reading context.
+ * \param rr                     Output: RRSet referencing the journal data.
+ * \param allow_next_changeset   True to allow jumping to next changeset.
+ *
+ * \return False if no more RRSet in this changeset/journal, or failure.
+ */
+bool journal_read_rrset_borrowed(journal_read_t *ctx, knot_rrset_t *rr,
+                                 bool allow_next_changeset);
+
 /*!
  * \brief Free up heap allocations by journal_read_rrset().
  *
@@ -65,6 +82,9 @@ inline static bool rr_is_apex_soa(const knot_rrset_t *rr, const knot_dname_t *ap
  *
  * \note Closes reading context at the end.
  *
+ * \note The RRSets passed to the callback are borrowed, see
+ *       journal_read_rrset_borrowed().
+ *
  * \param read   Journal reading context.
  * \param cb     Callback to be called on each read.
  * \param ctx    Arbitrary context to be passed to the callback.
@@ -73,6 +93,26 @@ inline static bool rr_is_apex_soa(const knot_rrset_t *rr, const knot_dname_t *ap
  */
 int journal_read_rrsets(journal_read_t *read, journal_read_cb_t cb, void *ctx);
 
+/*!
+ * \brief Read RRSets like journal_read_rrsets(), but on a helper thread.
+ *
+ * The RRSets are read in batches ahead of the callback, which is called in
+ * the calling thread. The helper thread releases the LMDB transaction while
+ * waiting for the callback, see journal_read_suspend().
+ *
+ * \note Unlike journal_read_rrsets(), the reading context isn't closed.
+ *
+ * \param read                   Journal reading context.
+ * \param allow_next_changeset   True to read up to the end of journal, false
+ *                               for the current changeset only.
+ * \param cb                     Callback to be called on each read.
+ * \param ctx                    Arbitrary context to be passed to the callback.
+ *
+ * \return An error code from either journal operations or from the callback.
+ */
+int journal_read_rrsets_prefetch(journal_read_t *read, bool allow_next_changeset,
+                                 journal_read_cb_t cb, void *ctx);
+
 /*!
  * \brief Read a single changeset from journal.
  *
@@ -100,6 +140,25 @@ void journal_read_clear_changeset(changeset_t *ch);
  */
 int journal_read_get_error(const journal_read_t *ctx, int another_error);
 
+/*!
+ * \brief Release the LMDB transaction until the reading continues.
+ *
+ * The rest of the current chunk is copied out, so that a slow consumer
+ * doesn't keep an old snapshot of the journal. The reading is resumed
+ * in a new transaction and fails with KNOT_ENOENT if the changeset has
+ * been removed or replaced meanwhile.
+ *
+ * \param ctx   Journal reading context.
+ *
+ * \return KNOT_E*
+ */
+int journal_read_suspend(journal_read_t *ctx);
+
+/*!
+ * \brief Age of the oldest journal reading transaction in milliseconds (0 if none).
+ */
+uint64_t journal_read_oldest_age(void);
+
 /*!
  * \brief Finalise journal reading.
  *
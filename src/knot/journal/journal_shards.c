@@ -0,0 +1,212 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+
+#include "knot/journal/journal_shards.h"
+#include "knot/journal/journal_metadata.h"
+#include "contrib/macros.h"
+#include "contrib/string.h"
+#include "contrib/ucw/lists.h"
+#include "libknot/error.h"
+
+char *journal_shard_path(const char *path, unsigned index)
+{
+	if (index == 0) {
+		return strdup(path);
+	}
+	return sprintf_alloc("%s/shard-%u", path, index);
+}
+
+unsigned journal_shard_index(const knot_dname_t *zone, unsigned count)
+{
+	if (count <= 1) {
+		return 0;
+	}
+
+	// FNV-1a, the index must be stable across versions and platforms
+	uint32_t hash = 2166136261U;
+	for (size_t i = 0; i < knot_dname_size(zone); i++) {
+		hash ^= zone[i];
+		hash *= 16777619U;
+	}
+	return hash % count;
+}
+
+void journal_shards_init(journal_shards_t *js, const char *path, unsigned count,
+                         size_t mapsize, unsigned env_flags)
+{
+	assert(count > 0 && count <= JOURNAL_SHARDS_MAX);
+
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		char *shard_path = journal_shard_path(path, i);
+		knot_lmdb_init(&js->shards[i], shard_path != NULL ? shard_path : path,
+		               mapsize, env_flags, NULL);
+		free(shard_path);
+	}
+	js->count = count;
+}
+
+int journal_shards_reinit(journal_shards_t *js, const char *path, unsigned count,
+                          size_t mapsize, unsigned env_flags)
+{
+	assert(count > 0 && count <= JOURNAL_SHARDS_MAX);
+
+	if (count != js->count) {
+		for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+			if (knot_lmdb_is_open(&js->shards[i])) {
+				return KNOT_EISCONN;
+			}
+		}
+	}
+
+	int ret = KNOT_EOK;
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		char *shard_path = journal_shard_path(path, i);
+		if (shard_path == NULL) {
+			return KNOT_ENOMEM;
+		}
+		int shard_ret = knot_lmdb_reinit(&js->shards[i], shard_path, mapsize, env_flags);
+		if (shard_ret != KNOT_EOK) {
+			ret = shard_ret;
+		}
+		free(shard_path);
+	}
+	if (ret == KNOT_EOK) {
+		js->count = count;
+	}
+	return ret;
+}
+
+void journal_shards_set_group_window(journal_shards_t *js, unsigned window_ms)
+{
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		js->shards[i].group_window_ms = window_ms;
+	}
+}
+
+void journal_shards_deinit(journal_shards_t *js)
+{
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		knot_lmdb_deinit(&js->shards[i]);
+	}
+}
+
+knot_lmdb_db_t *journal_shard(journal_shards_t *js, const knot_dname_t *zone)
+{
+	return &js->shards[journal_shard_index(zone, js->count)];
+}
+
+static int add_zone_to_list(const knot_dname_t *zone, void *list)
+{
+	knot_dname_t *copy = knot_dname_copy(zone, NULL);
+	if (copy == NULL) {
+		return KNOT_ENOMEM;
+	}
+	return ptrlist_add(list, copy, NULL) == NULL ? KNOT_ENOMEM : KNOT_EOK;
+}
+
+static int migrate_shard(journal_shards_t *js, unsigned index, size_t *moved)
+{
+	knot_lmdb_db_t *from = &js->shards[index];
+
+	list_t zones;
+	init_list(&zones);
+	int ret = journals_walk(from, add_zone_to_list, &zones);
+
+	ptrnode_t *zone;
+	WALK_LIST(zone, zones) {
+		if (ret != KNOT_EOK) {
+			break;
+		}
+		knot_lmdb_db_t *to = journal_shard(js, zone->d);
+		if (to == from) {
+			continue;
+		}
+		ret = journal_copy_with_md(from, to, zone->d);
+		if (ret == KNOT_EOK) {
+			zone_journal_t j = { from, zone->d };
+			ret = journal_scrape_with_md(j, false);
+		}
+		if (ret == KNOT_EOK) {
+			(*moved)++;
+		}
+	}
+	ptrlist_deep_free(&zones, NULL);
+
+	return ret;
+}
+
+int journal_shards_migrate(journal_shards_t *js, size_t *moved)
+{
+	size_t moved_count = 0;
+	int ret = KNOT_EOK;
+
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX && ret == KNOT_EOK; i++) {
+		knot_lmdb_db_t *shard = &js->shards[i];
+		if (js->count == 1 && i == 0) {
+			continue; // all zones belong here
+		}
+		if (knot_lmdb_exists(shard) == KNOT_ENODB) {
+			continue;
+		}
+		ret = migrate_shard(js, i, &moved_count);
+		if (i >= js->count) {
+			knot_lmdb_close(shard);
+		}
+	}
+
+	if (moved != NULL) {
+		*moved = moved_count;
+	}
+	return ret;
+}
+
+size_t journal_shards_copy_size(journal_shards_t *js)
+{
+	size_t copy_size = 0;
+	for (unsigned i = 0; i < js->count; i++) {
+		copy_size += knot_lmdb_copy_size(&js->shards[i]);
+	}
+	return copy_size;
+}
+
+void journal_shards_write_stats(journal_shards_t *js, uint64_t *txns, uint64_t *wait_us)
+{
+	*txns = 0;
+	*wait_us = 0;
+	for (unsigned i = 0; i < js->count; i++) {
+		uint64_t shard_txns, shard_wait;
+		knot_lmdb_write_stats(&js->shards[i], &shard_txns, &shard_wait);
+		*txns += shard_txns;
+		*wait_us += shard_wait;
+	}
+}
+
+void journal_shards_group_stats(journal_shards_t *js, uint64_t *commits, uint64_t *writes,
+                                uint64_t *max)
+{
+	*commits = 0;
+	*writes = 0;
+	*max = 0;
+	for (unsigned i = 0; i < js->count; i++) {
+		uint64_t shard_commits, shard_writes, shard_max;
+		knot_lmdb_group_stats(&js->shards[i], &shard_commits, &shard_writes, &shard_max);
+		*commits += shard_commits;
+		*writes += shard_writes;
+		*max = MAX(*max, shard_max);
+	}
+}
@@ -0,0 +1,116 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "knot/journal/knot_lmdb.h"
+#include "libknot/dname.h"
+
+/*! \brief Maximum number of journal DB shards. */
+#define JOURNAL_SHARDS_MAX	64
+
+/*!
+ * \brief Journal DB split into independent LMDB environments by zone name.
+ *
+ * LMDB allows a single writer per environment, so zones in different shards
+ * store their changes concurrently. The first shard is the journal DB
+ * directory itself, the other ones are its subdirectories. An unsharded
+ * journal DB is a journal DB with one shard.
+ *
+ * All the possible shards are initialised, so the shards no longer in use
+ * can be migrated.
+ */
+typedef struct {
+	knot_lmdb_db_t shards[JOURNAL_SHARDS_MAX];
+	unsigned count;
+} journal_shards_t;
+
+/*!
+ * \brief Get the path of a shard environment.
+ *
+ * \return Allocated path or NULL.
+ */
+char *journal_shard_path(const char *path, unsigned index);
+
+/*!
+ * \brief Get the shard index of a zone.
+ */
+unsigned journal_shard_index(const knot_dname_t *zone, unsigned count);
+
+/*!
+ * \brief Initialise the shards, see knot_lmdb_init().
+ */
+void journal_shards_init(journal_shards_t *js, const char *path, unsigned count,
+                         size_t mapsize, unsigned env_flags);
+
+/*!
+ * \brief Re-initialise the shards with modified parameters.
+ *
+ * \note The number of shards can't be changed if any shard is open.
+ *
+ * \return KNOT_EOK on success, KNOT_EISCONN if not possible.
+ */
+int journal_shards_reinit(journal_shards_t *js, const char *path, unsigned count,
+                          size_t mapsize, unsigned env_flags);
+
+/*!
+ * \brief Set the group commit window of the shards, see knot_lmdb_group_write().
+ */
+void journal_shards_set_group_window(journal_shards_t *js, unsigned window_ms);
+
+/*!
+ * \brief Close and deinitialise the shards.
+ */
+void journal_shards_deinit(journal_shards_t *js);
+
+/*!
+ * \brief Get the journal DB of a zone.
+ */
+knot_lmdb_db_t *journal_shard(journal_shards_t *js, const knot_dname_t *zone);
+
+/*!
+ * \brief Move the zone journals stored in other than their shards.
+ *
+ * This is needed after the number of shards has been changed. The shards
+ * beyond the current count are closed afterwards.
+ *
+ * \param js      Journal DB shards.
+ * \param moved   Optional output: number of moved zone journals.
+ *
+ * \return KNOT_E*
+ */
+int journal_shards_migrate(journal_shards_t *js, size_t *moved);
+
+/*!
+ * \brief Big enough mapsize for a new database to hold a copy of all the shards.
+ */
+size_t journal_shards_copy_size(journal_shards_t *js);
+
+/*!
+ * \brief Sum the write transaction statistics of the shards in use.
+ */
+void journal_shards_write_stats(journal_shards_t *js, uint64_t *txns, uint64_t *wait_us);
+
+/*!
+ * \brief Sum the group commit statistics of the shards in use.
+ *
+ * \param js        Journal DB shards.
+ * \param commits   Output: number of group commits.
+ * \param writes    Output: number of writes committed in groups.
+ * \param max       Output: largest group size.
+ */
+void journal_shards_group_stats(journal_shards_t *js, uint64_t *commits, uint64_t *writes,
+                                uint64_t *max);
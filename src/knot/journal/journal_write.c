@@ -22,8 +22,41 @@
 #include "knot/journal/serialization.h"
 #include "libknot/error.h"
 
-static void journal_write_serialize(knot_lmdb_txn_t *txn, serialize_ctx_t *ser, const changeset_t *ch, uint32_t ch_serial_to)
+/*!
+ * \brief Store a compressed chunk, or the uncompressed one if compression doesn't help.
+ *
+ * \param raw      Buffer with space for the header followed by the serialized data.
+ * \param packed   Buffer of the same size for the compressed chunk.
+ */
+static void journal_write_compressed(knot_lmdb_txn_t *txn, MDB_val *key, int compression,
+                                     uint32_t ch_serial_to, uint8_t *raw, size_t raw_size,
+                                     uint8_t *packed)
+{
+	MDB_val chunk = { .mv_data = raw, .mv_size = JOURNAL_HEADER_SIZE + raw_size };
+	size_t packed_size = journal_compress(compression, raw + JOURNAL_HEADER_SIZE, raw_size,
+	                                      packed + JOURNAL_HEADER_SIZE, raw_size);
+	if (packed_size > 0) {
+		journal_make_header(packed, ch_serial_to, compression, raw_size);
+		chunk.mv_data = packed;
+		chunk.mv_size = JOURNAL_HEADER_SIZE + packed_size;
+	} else {
+		journal_make_header(raw, ch_serial_to, JOURNAL_COMPRESSION_NONE, 0);
+	}
+	(void)knot_lmdb_insert(txn, key, &chunk);
+}
+
+static void journal_write_serialize(knot_lmdb_txn_t *txn, serialize_ctx_t *ser, const changeset_t *ch,
+                                    uint32_t ch_serial_to, int compression)
 {
+	uint8_t *raw = NULL, *packed = NULL;
+	if (compression != JOURNAL_COMPRESSION_NONE) {
+		raw = malloc(JOURNAL_CHUNK_MAX);
+		packed = malloc(JOURNAL_CHUNK_MAX);
+		if (raw == NULL || packed == NULL) {
+			txn->ret = KNOT_ENOMEM;
+		}
+	}
+
 	MDB_val chunk;
 	uint32_t i = 0;
 	while (serialize_unfinished(ser) && txn->ret == KNOT_EOK) {
@@ -32,31 +65,39 @@ static void journal_write_serialize(knot_lmdb_txn_t *txn, serialize_ctx_t *ser,
 		if (chunk.mv_size == 0) {
 			break; // beware! If this is omitted, it creates empty chunk => EMALF when reading.
 		}
-		chunk.mv_size += JOURNAL_HEADER_SIZE;
-		chunk.mv_data = NULL;
 		MDB_val key = journal_changeset_to_chunk_key(ch, i);
-		if (knot_lmdb_insert(txn, &key, &chunk)) {
-			journal_make_header(chunk.mv_data, ch_serial_to);
-			serialize_chunk(ser, chunk.mv_data + JOURNAL_HEADER_SIZE, chunk.mv_size - JOURNAL_HEADER_SIZE);
+		if (compression != JOURNAL_COMPRESSION_NONE) {
+			serialize_chunk(ser, raw + JOURNAL_HEADER_SIZE, chunk.mv_size);
+			journal_write_compressed(txn, &key, compression, ch_serial_to,
+			                         raw, chunk.mv_size, packed);
+		} else {
+			chunk.mv_size += JOURNAL_HEADER_SIZE;
+			chunk.mv_data = NULL;
+			if (knot_lmdb_insert(txn, &key, &chunk)) {
+				journal_make_header(chunk.mv_data, ch_serial_to, JOURNAL_COMPRESSION_NONE, 0);
+				serialize_chunk(ser, chunk.mv_data + JOURNAL_HEADER_SIZE, chunk.mv_size - JOURNAL_HEADER_SIZE);
+			}
 		}
 		free(key.mv_data);
 		i++;
 	}
 	serialize_deinit(ser);
+	free(raw);
+	free(packed);
 	// return value is in the txn
 }
 
-void journal_write_changeset(knot_lmdb_txn_t *txn, const changeset_t *ch)
+void journal_write_changeset(knot_lmdb_txn_t *txn, const changeset_t *ch, int compression)
 {
 	serialize_ctx_t *ser = serialize_init(ch);
 	if (ser == NULL) {
 		txn->ret = KNOT_ENOMEM;
 		return;
 	}
-	journal_write_serialize(txn, ser, ch, changeset_to(ch));
+	journal_write_serialize(txn, ser, ch, changeset_to(ch), compression);
 }
 
-void journal_write_zone(knot_lmdb_txn_t *txn, const zone_contents_t *z)
+void journal_write_zone(knot_lmdb_txn_t *txn, const zone_contents_t *z, int compression)
 {
 	serialize_ctx_t *ser = serialize_zone_init(z);
 	if (ser == NULL) {
@@ -66,7 +107,7 @@ void journal_write_zone(knot_lmdb_txn_t *txn, const zone_contents_t *z)
 	changeset_t fake_ch;
 	fake_ch.soa_from = NULL;
 	fake_ch.add = (zone_contents_t *)z;
-	journal_write_serialize(txn, ser, &fake_ch, zone_contents_serial(z));
+	journal_write_serialize(txn, ser, &fake_ch, zone_contents_serial(z), compression);
 }
 
 static bool delete_one(knot_lmdb_txn_t *txn, bool del_zij, uint32_t del_serial,
@@ -113,7 +154,7 @@ void journal_merge(zone_journal_t j, knot_lmdb_txn_t *txn, bool merge_zij,
 	delete_one(txn, merge_zij, merge_serial, j.zone, &del_freed, &del_next_serial);
 	assert(del_freed > 0 && del_next_serial == *original_serial_to);
 
-	journal_write_changeset(txn, &merge);
+	journal_write_changeset(txn, &merge, journal_conf_compression(j));
 	journal_read_clear_changeset(&merge);
 }
 
@@ -230,7 +271,7 @@ int journal_insert_zone(zone_journal_t j, const zone_contents_t *z)
 	update_last_inserter(&txn, j.zone);
 	journal_del_zone_txn(&txn, j.zone);
 
-	journal_write_zone(&txn, z);
+	journal_write_zone(&txn, z, journal_conf_compression(j));
 
 	journal_metadata_t md = { 0 };
 	md.flags = JOURNAL_SERIAL_TO_VALID;
@@ -242,34 +283,32 @@ int journal_insert_zone(zone_journal_t j, const zone_contents_t *z)
 	return txn.ret;
 }
 
-int journal_insert(zone_journal_t j, const changeset_t *ch, const changeset_t *extra)
+typedef struct {
+	zone_journal_t j;
+	const changeset_t *ch;
+	const changeset_t *extra;
+	size_t ch_size;
+	size_t max_usage;
+} insert_ctx_t;
+
+static void insert_txn(knot_lmdb_txn_t *txn, void *ctx)
 {
-	size_t ch_size = changeset_serialized_size(ch);
-	size_t max_usage = journal_conf_max_usage(j);
-	if (ch_size >= max_usage) {
-		return KNOT_ESPACE;
-	}
-	if (extra != NULL && (changeset_to(extra) != changeset_to(ch) ||
-	     changeset_from(extra) == changeset_from(ch))) {
-		return KNOT_EINVAL;
-	}
-	int ret = knot_lmdb_open(j.db);
-	if (ret != KNOT_EOK) {
-		return ret;
-	}
-	knot_lmdb_txn_t txn = { 0 };
+	insert_ctx_t *ins = ctx;
+	zone_journal_t j = ins->j;
+	const changeset_t *ch = ins->ch, *extra = ins->extra;
+	size_t ch_size = ins->ch_size;
+
 	journal_metadata_t md = { 0 };
-	knot_lmdb_begin(j.db, &txn, true);
-	journal_load_metadata(&txn, j.zone, &md);
+	journal_load_metadata(txn, j.zone, &md);
 
-	update_last_inserter(&txn, j.zone);
+	update_last_inserter(txn, j.zone);
 
 	if (extra != NULL) {
-		if (journal_contains(&txn, true, 0, j.zone)) {
-			txn.ret = KNOT_ESEMCHECK;
+		if (journal_contains(txn, true, 0, j.zone)) {
+			txn->ret = KNOT_ESEMCHECK;
 		}
 		uint64_t merged_freed = 0;
-		delete_merged(&txn, j.zone, &md, &merged_freed);
+		delete_merged(txn, j.zone, &md, &merged_freed);
 		ch_size += changeset_serialized_size(extra);
 		ch_size -= merged_freed;
 		md.flushed_upto = md.serial_to; // set temporarily
@@ -277,32 +316,56 @@ int journal_insert(zone_journal_t j, const changeset_t *ch, const changeset_t *e
 	}
 
 	size_t chs_limit = journal_conf_max_changesets(j);
-	journal_fix_occupation(j, &txn, &md, max_usage - ch_size, chs_limit - 1);
+	journal_fix_occupation(j, txn, &md, ins->max_usage - ch_size, chs_limit - 1);
 
 	// avoid discontinuity
 	if ((md.flags & JOURNAL_SERIAL_TO_VALID) && md.serial_to != changeset_from(ch)) {
-		if (journal_contains(&txn, true, 0, j.zone)) {
-			txn.ret = KNOT_ESEMCHECK;
+		if (journal_contains(txn, true, 0, j.zone)) {
+			txn->ret = KNOT_ESEMCHECK;
 		} else {
-			journal_del_zone_txn(&txn, j.zone);
+			journal_del_zone_txn(txn, j.zone);
 			memset(&md, 0, sizeof(md));
 		}
 	}
 
 	// avoid cycle
-	if (journal_contains(&txn, false, changeset_to(ch), j.zone)) {
-		journal_fix_occupation(j, &txn, &md, INT64_MAX, 1);
+	if (journal_contains(txn, false, changeset_to(ch), j.zone)) {
+		journal_fix_occupation(j, txn, &md, INT64_MAX, 1);
 	}
 
-	journal_write_changeset(&txn, ch);
+	int compression = journal_conf_compression(j);
+	journal_write_changeset(txn, ch, compression);
 	journal_metadata_after_insert(&md, changeset_from(ch), changeset_to(ch));
 
 	if (extra != NULL) {
-		journal_write_changeset(&txn, extra);
+		journal_write_changeset(txn, extra, compression);
 		journal_metadata_after_extra(&md, changeset_from(extra), changeset_to(extra));
 	}
 
-	journal_store_metadata(&txn, j.zone, &md);
-	knot_lmdb_commit(&txn);
-	return txn.ret;
+	journal_store_metadata(txn, j.zone, &md);
+}
+
+int journal_insert(zone_journal_t j, const changeset_t *ch, const changeset_t *extra)
+{
+	insert_ctx_t ctx = {
+		.j = j,
+		.ch = ch,
+		.extra = extra,
+		.ch_size = changeset_serialized_size(ch),
+		.max_usage = journal_conf_max_usage(j),
+	};
+	if (ctx.ch_size >= ctx.max_usage) {
+		return KNOT_ESPACE;
+	}
+	if (extra != NULL && (changeset_to(extra) != changeset_to(ch) ||
+	     changeset_from(extra) == changeset_from(ch))) {
+		return KNOT_EINVAL;
+	}
+	int ret = knot_lmdb_open(j.db);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	// possibly committed together with other zones, see knot_lmdb_group_write()
+	return knot_lmdb_group_write(j.db, insert_txn, &ctx);
 }
@@ -14,6 +14,7 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <assert.h>
 #include <stdarg.h>
 #include <stdio.h> // snprintf
 #include <stdlib.h>
@@ -24,6 +25,8 @@
 
 #include "knot/conf/conf.h"
 #include "contrib/files.h"
+#include "contrib/macros.h"
+#include "contrib/time.h"
 #include "contrib/wire_ctx.h"
 #include "libknot/dname.h"
 #include "libknot/endian.h"
@@ -32,6 +35,14 @@
 #define LMDB_DIR_MODE   0770
 #define LMDB_FILE_MODE  0660
 
+#ifdef HAVE_ATOMIC
+#define ATOMIC_ADD(dst, val) __atomic_add_fetch(&(dst), (val), __ATOMIC_RELAXED)
+#define ATOMIC_GET(src)      __atomic_load_n(&(src), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_ADD(dst, val) __sync_add_and_fetch(&(dst), (val))
+#define ATOMIC_GET(src)      __sync_fetch_and_or(&(src), 0)
+#endif
+
 static void err_to_knot(int *err)
 {
 	switch (*err) {
@@ -78,9 +89,20 @@ void knot_lmdb_init(knot_lmdb_db_t *db, const char *path, size_t mapsize, unsign
 	db->mapsize = mapsize;
 	db->env_flags = env_flags;
 	db->dbname = dbname;
+	db->write_txns = 0;
+	db->write_wait_us = 0;
 	pthread_mutex_init(&db->opening_mutex, NULL);
 	db->maxdbs = 2;
 	db->maxreaders = conf_lmdb_readers(conf());
+	db->group_window_ms = 0;
+	pthread_mutex_init(&db->group_mutex, NULL);
+	pthread_cond_init(&db->group_cond, NULL);
+	db->group_pending = NULL;
+	db->group_pending_count = 0;
+	db->group_leader = false;
+	db->group_commits = 0;
+	db->group_writes = 0;
+	db->group_max = 0;
 }
 
 static int lmdb_stat(const char *lmdb_path, struct stat *st)
@@ -122,6 +144,22 @@ static int fix_mapsize(knot_lmdb_db_t *db)
 	return KNOT_EOK;
 }
 
+void knot_lmdb_write_stats(knot_lmdb_db_t *db, uint64_t *txns, uint64_t *wait_us)
+{
+	*txns = ATOMIC_GET(db->write_txns);
+	*wait_us = ATOMIC_GET(db->write_wait_us);
+}
+
+void knot_lmdb_group_stats(knot_lmdb_db_t *db, uint64_t *commits, uint64_t *writes,
+                           uint64_t *max)
+{
+	pthread_mutex_lock(&db->group_mutex);
+	*commits = db->group_commits;
+	*writes = db->group_writes;
+	*max = db->group_max;
+	pthread_mutex_unlock(&db->group_mutex);
+}
+
 size_t knot_lmdb_copy_size(knot_lmdb_db_t *to_copy)
 {
 	size_t copy_size = 1048576;
@@ -267,12 +305,24 @@ void knot_lmdb_deinit(knot_lmdb_db_t *db)
 {
 	knot_lmdb_close(db);
 	pthread_mutex_destroy(&db->opening_mutex);
+	pthread_mutex_destroy(&db->group_mutex);
+	pthread_cond_destroy(&db->group_cond);
 	free(db->path);
 }
 
 void knot_lmdb_begin(knot_lmdb_db_t *db, knot_lmdb_txn_t *txn, bool rw)
 {
+	struct timespec begin = { 0 };
+	if (rw) {
+		begin = time_now();
+	}
 	txn->ret = mdb_txn_begin(db->env, NULL, rw ? 0 : MDB_RDONLY, &txn->txn);
+	if (rw) {
+		// the write transaction waits for the environment writer lock
+		struct timespec end = time_now();
+		ATOMIC_ADD(db->write_txns, 1);
+		ATOMIC_ADD(db->write_wait_us, (uint64_t)(time_diff_ms(&begin, &end) * 1000));
+	}
 	err_to_knot(&txn->ret);
 	if (txn->ret == KNOT_EOK) {
 		txn->opened = true;
@@ -281,6 +331,22 @@ void knot_lmdb_begin(knot_lmdb_db_t *db, knot_lmdb_txn_t *txn, bool rw)
 	}
 }
 
+void knot_lmdb_begin_nested(knot_lmdb_txn_t *parent, knot_lmdb_txn_t *txn)
+{
+	assert(parent->opened && parent->is_rw);
+	if (parent->cursor != NULL) {
+		mdb_cursor_close(parent->cursor);
+		parent->cursor = NULL;
+	}
+	txn->ret = mdb_txn_begin(parent->db->env, parent->txn, 0, &txn->txn);
+	err_to_knot(&txn->ret);
+	if (txn->ret == KNOT_EOK) {
+		txn->opened = true;
+		txn->db = parent->db;
+		txn->is_rw = true;
+	}
+}
+
 void knot_lmdb_abort(knot_lmdb_txn_t *txn)
 {
 	if (txn->opened) {
@@ -319,6 +385,115 @@ void knot_lmdb_commit(knot_lmdb_txn_t *txn)
 	txn->opened = false;
 }
 
+#define GROUP_MAX 256
+
+typedef struct knot_lmdb_group_req {
+	knot_lmdb_group_cb cb;
+	void *ctx;
+	int ret;
+	bool done;
+	struct knot_lmdb_group_req *next;
+} knot_lmdb_group_req_t;
+
+static void group_commit(knot_lmdb_db_t *db, knot_lmdb_group_req_t *group)
+{
+	knot_lmdb_txn_t txn = { 0 };
+	knot_lmdb_begin(db, &txn, true);
+
+	for (knot_lmdb_group_req_t *req = group; req != NULL; req = req->next) {
+		knot_lmdb_txn_t nested = { 0 };
+		if (txn.ret == KNOT_EOK) {
+			knot_lmdb_begin_nested(&txn, &nested);
+		} else {
+			nested.ret = txn.ret;
+		}
+		if (nested.ret == KNOT_EOK) {
+			req->cb(&nested, req->ctx);
+			knot_lmdb_commit(&nested);
+		}
+		req->ret = nested.ret;
+	}
+
+	knot_lmdb_commit(&txn);
+	for (knot_lmdb_group_req_t *req = group; req != NULL; req = req->next) {
+		if (req->ret == KNOT_EOK) {
+			req->ret = txn.ret;
+		}
+	}
+}
+
+// called and returns with the group mutex locked
+static void group_lead(knot_lmdb_db_t *db)
+{
+	db->group_leader = true;
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += db->group_window_ms / 1000;
+	deadline.tv_nsec += (db->group_window_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	while (db->group_pending_count < GROUP_MAX &&
+	       pthread_cond_timedwait(&db->group_cond, &db->group_mutex, &deadline) == 0);
+
+	// take the pending requests in the order of arrival
+	knot_lmdb_group_req_t *group = NULL;
+	while (db->group_pending != NULL) {
+		knot_lmdb_group_req_t *req = db->group_pending;
+		db->group_pending = req->next;
+		req->next = group;
+		group = req;
+	}
+	size_t count = db->group_pending_count;
+	db->group_pending_count = 0;
+	pthread_mutex_unlock(&db->group_mutex);
+
+	group_commit(db, group);
+
+	pthread_mutex_lock(&db->group_mutex);
+	for (knot_lmdb_group_req_t *req = group; req != NULL; req = req->next) {
+		req->done = true;
+	}
+	db->group_commits++;
+	db->group_writes += count;
+	db->group_max = MAX(db->group_max, count);
+	db->group_leader = false;
+	pthread_cond_broadcast(&db->group_cond);
+}
+
+int knot_lmdb_group_write(knot_lmdb_db_t *db, knot_lmdb_group_cb cb, void *ctx)
+{
+	if (db->group_window_ms == 0 || (db->env_flags & MDB_WRITEMAP)) {
+		knot_lmdb_txn_t txn = { 0 };
+		knot_lmdb_begin(db, &txn, true);
+		if (txn.ret == KNOT_EOK) {
+			cb(&txn, ctx);
+		}
+		knot_lmdb_commit(&txn);
+		return txn.ret;
+	}
+
+	knot_lmdb_group_req_t req = { .cb = cb, .ctx = ctx };
+
+	pthread_mutex_lock(&db->group_mutex);
+	req.next = db->group_pending;
+	db->group_pending = &req;
+	db->group_pending_count++;
+	pthread_cond_broadcast(&db->group_cond);
+	while (!req.done) {
+		if (!db->group_leader) {
+			group_lead(db);
+		} else {
+			pthread_cond_wait(&db->group_cond, &db->group_mutex);
+		}
+	}
+	pthread_mutex_unlock(&db->group_mutex);
+
+	return req.ret;
+}
+
 // save the programmer's frequent checking for ENOMEM when creating search keys
 static bool txn_enomem(knot_lmdb_txn_t *txn, const MDB_val *tocheck)
 {
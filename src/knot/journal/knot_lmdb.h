@@ -31,12 +31,27 @@ typedef struct knot_lmdb_db {
 	// those are static options. Set them after knot_lmdb_init().
 	unsigned maxdbs;
 	unsigned maxreaders;
+	unsigned group_window_ms; // see knot_lmdb_group_write()
 
 	// those are internal options. Please don't touch them directly.
 	size_t mapsize;
 	unsigned env_flags; // MDB_NOTLS, MDB_RDONLY, MDB_WRITEMAP, MDB_DUPSORT, MDB_NOSYNC, MDB_MAPASYNC
 	const char *dbname;
 	char *path;
+
+	// statistics of write transactions, see knot_lmdb_write_stats()
+	uint64_t write_txns;
+	uint64_t write_wait_us;
+
+	// group commit state, see knot_lmdb_group_write()
+	pthread_mutex_t group_mutex;
+	pthread_cond_t group_cond;
+	struct knot_lmdb_group_req *group_pending; // newest first
+	size_t group_pending_count;
+	bool group_leader;
+	uint64_t group_commits;
+	uint64_t group_writes;
+	uint64_t group_max;
 } knot_lmdb_db_t;
 
 typedef struct {
@@ -96,6 +111,19 @@ void knot_lmdb_init(knot_lmdb_db_t *db, const char *path, size_t mapsize, unsign
  */
 int knot_lmdb_exists(knot_lmdb_db_t *db);
 
+/*!
+ * \brief Get the number of write transactions and the total time spent
+ *        waiting for the environment writer lock (in microseconds).
+ */
+void knot_lmdb_write_stats(knot_lmdb_db_t *db, uint64_t *txns, uint64_t *wait_us);
+
+/*!
+ * \brief Get the number of group commits, the total number of writes committed
+ *        by them, and the largest group size so far.
+ */
+void knot_lmdb_group_stats(knot_lmdb_db_t *db, uint64_t *commits, uint64_t *writes,
+                           uint64_t *max);
+
 /*!
  * \brief Big enough mapsize for new database to hold a copy of to_copy.
  */
@@ -172,6 +200,47 @@ inline static bool knot_lmdb_is_open(knot_lmdb_db_t *db) { return db != NULL &&
  */
 void knot_lmdb_begin(knot_lmdb_db_t *db, knot_lmdb_txn_t *txn, bool rw);
 
+/*!
+ * \brief Start a nested read-write transaction.
+ *
+ * Committing the nested transaction makes its changes part of the parent one,
+ * aborting it leaves the parent transaction intact.
+ *
+ * \param parent   Opened read-write transaction, not to be used until the nested one ends.
+ * \param txn      Transaction handling structure to be initialised.
+ *
+ * \note Not supported with MDB_WRITEMAP. The error code will be stored in txn->ret.
+ */
+void knot_lmdb_begin_nested(knot_lmdb_txn_t *parent, knot_lmdb_txn_t *txn);
+
+/*!
+ * \brief Callback performing a write operation in a (possibly shared) transaction.
+ *
+ * \note The error code shall be stored in txn->ret. The transaction may be
+ *       committed by the callback.
+ */
+typedef void (*knot_lmdb_group_cb)(knot_lmdb_txn_t *txn, void *ctx);
+
+/*!
+ * \brief Perform a write operation, possibly together with concurrent ones.
+ *
+ * If db->group_window_ms is set, the first caller collects the operations of
+ * other callers arriving within the window, performs each of them in a nested
+ * transaction, and commits them all at once. Every caller returns only after
+ * the shared commit. Otherwise, the operation is performed in its own
+ * transaction.
+ *
+ * \note Grouping isn't used with MDB_WRITEMAP as it doesn't allow nested
+ *       transactions.
+ *
+ * \param db    The database, already opened.
+ * \param cb    Write operation.
+ * \param ctx   Callback context.
+ *
+ * \return Error code of the operation or of the commit.
+ */
+int knot_lmdb_group_write(knot_lmdb_db_t *db, knot_lmdb_group_cb cb, void *ctx);
+
 /*!
  * \brief Abort a transaction.
  *
@@ -87,6 +87,9 @@ typedef struct {
 
 	uint16_t *nsec_force_types;
 
+	zone_sign_ctx_t **sign_ctxs;  // Per-thread signing contexts, guarded by signing_mutex.
+	unsigned sign_ctxs_count;
+
 	bool zone_doomed;
 } online_sign_ctx_t;
 
@@ -230,11 +233,39 @@ static knot_rrset_t *synth_nsec(knot_pkt_t *pkt, knotd_qdata_t *qdata, knotd_mod
 	return nsec;
 }
 
-static knot_rrset_t *sign_rrset(const knot_dname_t *owner,
-                                const knot_rrset_t *cover,
-                                knotd_mod_t *mod,
-                                zone_sign_ctx_t *sign_ctx,
-                                knot_mm_t *mm)
+/*!
+ * \brief Get signing context of the current thread, create it if needed.
+ *
+ * \note Must be called with the signing mutex locked.
+ */
+static zone_sign_ctx_t *thread_sign_ctx(online_sign_ctx_t *ctx, knotd_mod_t *mod,
+                                        unsigned thread_id)
+{
+	if (thread_id >= ctx->sign_ctxs_count) {
+		return NULL;
+	}
+
+	if (ctx->sign_ctxs[thread_id] == NULL) {
+		ctx->sign_ctxs[thread_id] = zone_sign_ctx(mod->keyset, mod->dnssec);
+	}
+
+	return ctx->sign_ctxs[thread_id];
+}
+
+/*!
+ * \brief Drop per-thread signing contexts (on keyset change).
+ *
+ * \note Must be called with the signing mutex write-locked.
+ */
+static void clear_sign_ctxs(online_sign_ctx_t *ctx)
+{
+	for (unsigned i = 0; i < ctx->sign_ctxs_count; i++) {
+		zone_sign_ctx_free(ctx->sign_ctxs[i]);
+		ctx->sign_ctxs[i] = NULL;
+	}
+}
+
+static knot_rrset_t *copy_rrset(const knot_dname_t *owner, const knot_rrset_t *cover)
 {
 	// copy of RR set with replaced owner name
 
@@ -249,28 +280,36 @@ static knot_rrset_t *sign_rrset(const knot_dname_t *owner,
 		return NULL;
 	}
 
-	// resulting RRSIG
-
-	knot_rrset_t *rrsig = knot_rrset_new(owner, KNOT_RRTYPE_RRSIG, copy->rclass,
-	                                     copy->ttl, mm);
-	if (!rrsig) {
-		knot_rrset_free(copy, NULL);
-		return NULL;
-	}
+	return copy;
+}
 
+/*!
+ * \brief Sign the RR sets with all suitable keys in one batch.
+ */
+static int sign_rrsets(knot_rrset_t *rrsigs[], const knot_rrset_t *rrsets[],
+                       size_t count, knotd_qdata_t *qdata, knotd_mod_t *mod,
+                       knot_mm_t *mm)
+{
 	online_sign_ctx_t *ctx = knotd_mod_ctx(mod);
 	pthread_rwlock_rdlock(&ctx->signing_mutex);
-	int ret = knot_sign_rrset2(rrsig, copy, sign_ctx, mm);
-	pthread_rwlock_unlock(&ctx->signing_mutex);
-	if (ret != KNOT_EOK) {
-		knot_rrset_free(copy, NULL);
-		knot_rrset_free(rrsig, mm);
-		return NULL;
+
+	zone_sign_ctx_t *sign_ctx = thread_sign_ctx(ctx, mod, qdata->params->thread_id);
+	bool temporary = (sign_ctx == NULL);
+	if (temporary) {
+		sign_ctx = zone_sign_ctx(mod->keyset, mod->dnssec);
+	}
+
+	int ret = KNOT_ENOMEM;
+	if (sign_ctx != NULL) {
+		ret = knot_sign_rrsets2(rrsigs, rrsets, count, sign_ctx, mm);
 	}
 
-	knot_rrset_free(copy, NULL);
+	if (temporary) {
+		zone_sign_ctx_free(sign_ctx);
+	}
+	pthread_rwlock_unlock(&ctx->signing_mutex);
 
-	return rrsig;
+	return ret;
 }
 
 static glue_t *find_glue_for(const knot_rrset_t *rr, const knot_pkt_t *pkt)
@@ -313,12 +352,16 @@ static knotd_in_state_t sign_section(knotd_in_state_t state, knot_pkt_t *pkt,
 	const knot_pktsection_t *section = knot_pkt_section(pkt, pkt->current);
 	assert(section);
 
-	zone_sign_ctx_t *sign_ctx = zone_sign_ctx(mod->keyset, mod->dnssec);
-	if (sign_ctx == NULL) {
-		return KNOTD_IN_STATE_ERROR;
+	uint16_t count_unsigned = section->count;
+	if (count_unsigned == 0) {
+		return state;
 	}
 
-	uint16_t count_unsigned = section->count;
+	knot_rrset_t *copies[count_unsigned];
+	knot_rrset_t *rrsigs[count_unsigned];
+	size_t count = 0;
+
+	int ret = KNOT_EOK;
 	for (int i = 0; i < count_unsigned; i++) {
 		const knot_rrset_t *rr = knot_pkt_rr(section, i);
 		if (!shall_sign_rr(rr, pkt, qdata)) {
@@ -331,23 +374,41 @@ static knotd_in_state_t sign_section(knotd_in_state_t state, knot_pkt_t *pkt,
 		knot_dname_unpack(owner, pkt->wire + rr_pos, sizeof(owner), pkt->wire);
 		knot_dname_to_lower(owner);
 
-		knot_rrset_t *rrsig = sign_rrset(owner, rr, mod, sign_ctx, &pkt->mm);
-		if (!rrsig) {
-			state = KNOTD_IN_STATE_ERROR;
+		copies[count] = copy_rrset(owner, rr);
+		if (copies[count] == NULL) {
+			ret = KNOT_ENOMEM;
 			break;
 		}
 
-		int r = knot_pkt_put(pkt, KNOT_COMPR_HINT_NONE, rrsig, KNOT_PF_FREE);
-		if (r != KNOT_EOK) {
-			knot_rrset_free(rrsig, &pkt->mm);
-			state = KNOTD_IN_STATE_ERROR;
+		// resulting RRSIG
+		rrsigs[count] = knot_rrset_new(owner, KNOT_RRTYPE_RRSIG, rr->rclass,
+		                               rr->ttl, &pkt->mm);
+		if (rrsigs[count] == NULL) {
+			knot_rrset_free(copies[count], NULL);
+			ret = KNOT_ENOMEM;
 			break;
 		}
+		count++;
 	}
 
-	zone_sign_ctx_free(sign_ctx);
+	if (ret == KNOT_EOK) {
+		ret = sign_rrsets(rrsigs, (const knot_rrset_t **)copies, count,
+		                  qdata, mod, &pkt->mm);
+	}
 
-	return state;
+	for (size_t i = 0; i < count; i++) {
+		knot_rrset_free(copies[i], NULL);
+
+		if (ret == KNOT_EOK) {
+			ret = knot_pkt_put(pkt, KNOT_COMPR_HINT_NONE, rrsigs[i], KNOT_PF_FREE);
+			if (ret == KNOT_EOK) {
+				continue;
+			}
+		}
+		knot_rrset_free(rrsigs[i], &pkt->mm);
+	}
+
+	return (ret == KNOT_EOK) ? state : KNOTD_IN_STATE_ERROR;
 }
 
 static knotd_in_state_t synth_authority(knotd_in_state_t state, knot_pkt_t *pkt,
@@ -513,6 +574,7 @@ static knotd_in_state_t pre_routine(knotd_in_state_t state, knot_pkt_t *pkt,
 		ctx->event_rollover = resch.next_rollover;
 
 		pthread_rwlock_wrlock(&ctx->signing_mutex);
+		clear_sign_ctxs(ctx);
 		knotd_mod_dnssec_unload_keyset(mod);
 		ret = knotd_mod_dnssec_load_keyset(mod, true);
 		if (ret != KNOT_EOK) {
@@ -605,6 +667,8 @@ static void online_sign_ctx_free(online_sign_ctx_t *ctx)
 	pthread_mutex_destroy(&ctx->event_mutex);
 	pthread_rwlock_destroy(&ctx->signing_mutex);
 
+	clear_sign_ctxs(ctx);
+	free(ctx->sign_ctxs);
 	free(ctx->nsec_force_types);
 	free(ctx);
 }
@@ -647,6 +711,14 @@ static int online_sign_ctx_new(online_sign_ctx_t **ctx_ptr, knotd_mod_t *mod)
 
 	ctx->event_rollover = knot_time_min(ctx->event_rollover, knot_get_next_zone_key_event(mod->keyset));
 
+	ctx->sign_ctxs_count = knotd_mod_threads(mod);
+	ctx->sign_ctxs = calloc(ctx->sign_ctxs_count, sizeof(*ctx->sign_ctxs));
+	if (ctx->sign_ctxs == NULL) {
+		knotd_mod_dnssec_unload_keyset(mod);
+		free(ctx);
+		return KNOT_ENOMEM;
+	}
+
 	pthread_mutex_init(&ctx->event_mutex, NULL);
 	pthread_rwlock_init(&ctx->signing_mutex, NULL);
 
@@ -37,6 +37,10 @@ struct axfr_proc {
 	trie_it_t *i;
 	zone_tree_it_t it;
 	unsigned cur_rrset;
+
+	/* Shared rendered messages to be sent instead of the zone trees. */
+	xfr_cache_entry_t *cached;
+	size_t cached_next;
 };
 
 static int axfr_put_rrsets(knot_pkt_t *pkt, zone_node_t *node,
@@ -95,12 +99,71 @@ static int axfr_process_node_tree(knot_pkt_t *pkt, const void *item,
 	return ret;
 }
 
+static void axfr_add_trees(list_t *nodes, const zone_contents_t *contents, knot_mm_t *mm)
+{
+	ptrlist_add(nodes, contents->nodes, mm);
+	/* Put NSEC3 data if exists. */
+	if (!zone_tree_is_empty(contents->nsec3_nodes)) {
+		ptrlist_add(nodes, contents->nsec3_nodes, mm);
+	}
+}
+
+static int axfr_render(xfr_cache_entry_t *entry, void *ctx)
+{
+	knotd_qdata_t *qdata = ctx;
+	const zone_contents_t *contents = qdata->extra->contents;
+
+	struct axfr_proc render = { 0 };
+	init_list(&render.proc.nodes);
+	axfr_add_trees(&render.proc.nodes, contents, NULL);
+
+	knot_rrset_t soa_rr = node_rrset(contents->apex, KNOT_RRTYPE_SOA);
+	int ret = xfr_render(entry, qdata->extra->zone->name, KNOT_RRTYPE_AXFR,
+	                     &soa_rr, &axfr_process_node_tree, &render.proc);
+
+	zone_tree_it_free(&render.it);
+	ptrlist_free(&render.proc.nodes, NULL);
+
+	return ret;
+}
+
+/*!
+ * \brief Get the rendered AXFR of the current contents, render it on first use.
+ *
+ * The messages are owned by the contents version and released with it.
+ *
+ * \return Rendered messages or NULL if the zone trees have to be sent.
+ */
+static xfr_cache_entry_t *axfr_cached(knot_pkt_t *pkt, knotd_qdata_t *qdata)
+{
+	/* Only full-size TCP answers of reasonably large zones are rendered. */
+	zone_contents_t *contents = (zone_contents_t *)qdata->extra->contents;
+	if ((qdata->params->flags & KNOTD_QUERY_FLAG_LIMIT_SIZE) ||
+	    qdata->params->xdp_msg != NULL || contents->size > XFR_CACHE_MAX_BYTES) {
+		return NULL;
+	}
+
+	xfr_cache_entry_t *entry = xfr_cache_render_once(qdata->extra->zone->xfr_cache,
+	                                                 &contents->axfr_wire,
+	                                                 &contents->axfr_wire_failed,
+	                                                 zone_contents_serial(contents),
+	                                                 axfr_render, qdata);
+
+	if (entry != NULL && !xfr_cached_usable(entry, pkt, qdata)) {
+		xfr_cache_entry_unref(entry);
+		entry = NULL;
+	}
+
+	return entry;
+}
+
 static void axfr_query_cleanup(knotd_qdata_t *qdata)
 {
 	struct axfr_proc *axfr = (struct axfr_proc *)qdata->extra->ext;
 
 	zone_tree_it_free(&axfr->it);
 	ptrlist_free(&axfr->proc.nodes, qdata->mm);
+	xfr_cache_entry_unref(axfr->cached);
 	mm_free(qdata->mm, axfr);
 
 	/* Allow zone changes (finished). */
@@ -116,7 +179,7 @@ static int axfr_query_check(knotd_qdata_t *qdata)
 	return KNOT_STATE_DONE;
 }
 
-static int axfr_query_init(knotd_qdata_t *qdata)
+static int axfr_query_init(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 {
 	assert(qdata);
 
@@ -143,10 +206,9 @@ static int axfr_query_init(knotd_qdata_t *qdata)
 	const zone_contents_t *contents = qdata->extra->contents;
 	/* Must be non-NULL for the first message. */
 	assert(contents);
-	ptrlist_add(&axfr->proc.nodes, contents->nodes, mm);
-	/* Put NSEC3 data if exists. */
-	if (!zone_tree_is_empty(contents->nsec3_nodes)) {
-		ptrlist_add(&axfr->proc.nodes, contents->nsec3_nodes, mm);
+	axfr->cached = axfr_cached(pkt, qdata);
+	if (axfr->cached == NULL) {
+		axfr_add_trees(&axfr->proc.nodes, contents, mm);
 	}
 
 	/* Set up cleanup callback. */
@@ -174,7 +236,7 @@ int axfr_process_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 	/* Initialize on first call. */
 	struct axfr_proc *axfr = qdata->extra->ext;
 	if (axfr == NULL) {
-		int ret = axfr_query_init(qdata);
+		int ret = axfr_query_init(pkt, qdata);
 		axfr = qdata->extra->ext;
 		switch (ret) {
 		case KNOT_EOK:      /* OK */
@@ -203,7 +265,11 @@ int axfr_process_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 	}
 
 	/* Answer current packet (or continue). */
-	ret = xfr_process_list(pkt, &axfr_process_node_tree, qdata);
+	if (axfr->cached != NULL) {
+		ret = xfr_process_cached(pkt, axfr->cached, &axfr->cached_next, qdata);
+	} else {
+		ret = xfr_process_list(pkt, &axfr_process_node_tree, qdata);
+	}
 	switch (ret) {
 	case KNOT_ESPACE: /* Couldn't write more, send packet and continue. */
 		return KNOT_STATE_PRODUCE; /* Check for more. */
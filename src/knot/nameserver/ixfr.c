@@ -41,6 +41,19 @@
 		return ret; \
 	}
 
+/*! \brief Copies the borrowed journal RR to be put into the next packet. */
+static int ixfr_keep_rr(struct ixfr_proc *ixfr, const knot_rrset_t *rr, int ret)
+{
+	knot_rrset_init(&ixfr->cur_rr, knot_dname_copy(rr->owner, NULL),
+	                rr->type, rr->rclass, rr->ttl);
+	if (ixfr->cur_rr.owner == NULL ||
+	    knot_rdataset_copy(&ixfr->cur_rr.rrs, &rr->rrs, NULL) != KNOT_EOK) {
+		knot_rrset_clear(&ixfr->cur_rr, NULL);
+		return KNOT_ENOMEM;
+	}
+	return ret;
+}
+
 /*! \brief Puts current RR into packet, stores state for retries. */
 static int ixfr_put_chg_part(knot_pkt_t *pkt, struct ixfr_proc *ixfr,
                              journal_read_t *read)
@@ -57,24 +70,29 @@ static int ixfr_put_chg_part(knot_pkt_t *pkt, struct ixfr_proc *ixfr,
 		journal_read_clear_rrset(&ixfr->cur_rr);
 	}
 
-	while (journal_read_rrset(read, &ixfr->cur_rr, true)) {
-		if (ixfr->cur_rr.type == KNOT_RRTYPE_SOA &&
+	// the RRs are valid only until the next reading or suspend, see
+	// journal_read_rrset_borrowed(), a copy is kept if the packet is full
+	knot_rrset_t rr;
+	while (journal_read_rrset_borrowed(read, &rr, true)) {
+		if (rr.type == KNOT_RRTYPE_SOA &&
 		    !ixfr->in_remove_section &&
-		    knot_soa_serial(ixfr->cur_rr.rrs.rdata) == ixfr->soa_to) {
+		    knot_soa_serial(rr.rrs.rdata) == ixfr->soa_to) {
 			break;
 		}
 
 		if (pkt->size > KNOT_WIRE_PTR_MAX) {
 			// optimization: once the XFR DNS message is > 16 KiB, compression
 			// is limited. Better wrap to next message.
-			return KNOT_ESPACE;
+			return ixfr_keep_rr(ixfr, &rr, KNOT_ESPACE);
 		}
 
-		IXFR_SAFE_PUT(pkt, &ixfr->cur_rr);
-		if (ixfr->cur_rr.type == KNOT_RRTYPE_SOA) {
+		int ret = knot_pkt_put(pkt, 0, &rr, KNOT_PF_NOTRUNC | KNOT_PF_ORIGTTL);
+		if (ret != KNOT_EOK) {
+			return ixfr_keep_rr(ixfr, &rr, ret);
+		}
+		if (rr.type == KNOT_RRTYPE_SOA) {
 			ixfr->in_remove_section = !ixfr->in_remove_section;
 		}
-		journal_read_clear_rrset(&ixfr->cur_rr);
 	}
 
 	return journal_read_get_error(read, KNOT_EOK);
@@ -128,6 +146,87 @@ static int ixfr_load_chsets(journal_read_t **journal_read, zone_t *zone,
 	return journal_read_begin(zone_journal(zone), false, serial_from, journal_read);
 }
 
+/*!
+ * \brief Render the whole IXFR answer without OPT and TSIG for the cache.
+ */
+static int ixfr_render(knotd_qdata_t *qdata, const knot_rrset_t *their_soa,
+                       xfr_cache_entry_t *entry)
+{
+	zone_t *zone = (zone_t *)qdata->extra->zone;
+	const zone_contents_t *contents = qdata->extra->contents;
+
+	journal_read_t *read = NULL;
+	int ret = ixfr_load_chsets(&read, zone, contents, their_soa);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	struct ixfr_proc render = {
+		.soa_from = entry->serial_from,
+		.soa_to = entry->serial_to,
+	};
+	init_list(&render.proc.nodes);
+	knot_rrset_init_empty(&render.cur_rr);
+	ptrlist_add(&render.proc.nodes, read, NULL);
+
+	knot_rrset_t soa_rr = node_rrset(contents->apex, KNOT_RRTYPE_SOA);
+	ret = xfr_render(entry, zone->name, KNOT_RRTYPE_IXFR, &soa_rr,
+	                 &ixfr_process_journal, &render.proc);
+
+	ptrlist_free(&render.proc.nodes, NULL);
+	knot_rrset_clear(&render.cur_rr, NULL);
+	journal_read_end(read);
+
+	return ret;
+}
+
+/*!
+ * \brief Get the rendered answer from the zone cache, render it if missing.
+ *
+ * \return Cached entry or NULL if the journal changes have to be sent.
+ */
+static xfr_cache_entry_t *ixfr_cached(knotd_qdata_t *qdata, knot_pkt_t *pkt,
+                                      const knot_rrset_t *their_soa)
+{
+	/* Only full-size TCP answers are cached. */
+	if ((qdata->params->flags & KNOTD_QUERY_FLAG_LIMIT_SIZE) ||
+	    qdata->params->xdp_msg != NULL) {
+		return NULL;
+	}
+
+	xfr_cache_t *cache = qdata->extra->zone->xfr_cache;
+	uint32_t serial_from = knot_soa_serial(their_soa->rrs.rdata);
+	uint32_t serial_to = zone_contents_serial(qdata->extra->contents);
+	if (serial_compare(serial_to, serial_from) & SERIAL_MASK_LEQ) {
+		return NULL;
+	}
+
+	xfr_cache_entry_t *entry = xfr_cache_get(cache, serial_from, serial_to);
+	if (entry == NULL) {
+		/* Concurrent requests of the same transfer wait for one rendering. */
+		pthread_mutex_lock(&cache->build);
+		entry = xfr_cache_get(cache, serial_from, serial_to);
+		if (entry == NULL) {
+			uint64_t epoch = xfr_cache_epoch(cache);
+			entry = xfr_cache_entry_new(serial_from, serial_to);
+			if (entry != NULL &&
+			    (ixfr_render(qdata, their_soa, entry) != KNOT_EOK ||
+			     xfr_cache_insert(cache, entry, epoch) != KNOT_EOK)) {
+				xfr_cache_entry_unref(entry);
+				entry = NULL;
+			}
+		}
+		pthread_mutex_unlock(&cache->build);
+	}
+
+	if (entry != NULL && !xfr_cached_usable(entry, pkt, qdata)) {
+		xfr_cache_entry_unref(entry);
+		entry = NULL;
+	}
+
+	return entry;
+}
+
 static int ixfr_query_check(knotd_qdata_t *qdata)
 {
 	NS_NEED_ZONE(qdata, KNOT_RCODE_NOTAUTH);
@@ -155,13 +254,14 @@ static void ixfr_answer_cleanup(knotd_qdata_t *qdata)
 	knot_rrset_clear(&ixfr->cur_rr, NULL);
 	ptrlist_free(&ixfr->proc.nodes, mm);
 	journal_read_end(ixfr->journal_ctx);
+	xfr_cache_entry_unref(ixfr->cached);
 	mm_free(mm, qdata->extra->ext);
 
 	/* Allow zone changes (finished). */
 	rcu_read_unlock();
 }
 
-static int ixfr_answer_init(knotd_qdata_t *qdata, uint32_t *serial_from)
+static int ixfr_answer_init(knot_pkt_t *pkt, knotd_qdata_t *qdata, uint32_t *serial_from)
 {
 	assert(qdata);
 
@@ -183,22 +283,24 @@ static int ixfr_answer_init(knotd_qdata_t *qdata, uint32_t *serial_from)
 		return KNOT_ENOMEM;
 	}
 	memset(xfer, 0, sizeof(*xfer));
+	init_list(&xfer->proc.nodes);
 
-	int ret = ixfr_load_chsets(&xfer->journal_ctx, (zone_t *)qdata->extra->zone,
-	                           qdata->extra->contents, their_soa);
-	if (ret != KNOT_EOK) {
-		mm_free(mm, xfer);
-		return ret;
+	xfer->cached = ixfr_cached(qdata, pkt, their_soa);
+	if (xfer->cached == NULL) {
+		int ret = ixfr_load_chsets(&xfer->journal_ctx, (zone_t *)qdata->extra->zone,
+		                           qdata->extra->contents, their_soa);
+		if (ret != KNOT_EOK) {
+			mm_free(mm, xfer);
+			return ret;
+		}
+		ptrlist_add(&xfer->proc.nodes, xfer->journal_ctx, mm);
 	}
 
 	xfr_stats_begin(&xfer->proc.stats);
 	xfer->state = IXFR_SOA_DEL;
-	init_list(&xfer->proc.nodes);
 	knot_rrset_init_empty(&xfer->cur_rr);
 	xfer->qdata = qdata;
 
-	ptrlist_add(&xfer->proc.nodes, xfer->journal_ctx, mm);
-
 	xfer->soa_from = knot_soa_serial(their_soa->rrs.rdata);
 	xfer->soa_to = zone_contents_serial(qdata->extra->contents);
 
@@ -258,7 +360,7 @@ int ixfr_process_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 	struct ixfr_proc *ixfr = qdata->extra->ext;
 	if (ixfr == NULL) {
 		uint32_t soa_from = 0;
-		int ret = ixfr_answer_init(qdata, &soa_from);
+		int ret = ixfr_answer_init(pkt, qdata, &soa_from);
 		ixfr = qdata->extra->ext;
 		switch (ret) {
 		case KNOT_EOK:       /* OK */
@@ -295,9 +397,15 @@ int ixfr_process_query(knot_pkt_t *pkt, knotd_qdata_t *qdata)
 	}
 
 	/* Answer current packet (or continue). */
-	ret = xfr_process_list(pkt, &ixfr_process_journal, qdata);
+	if (ixfr->cached != NULL) {
+		ret = xfr_process_cached(pkt, ixfr->cached, &ixfr->cached_next, qdata);
+	} else {
+		ret = xfr_process_list(pkt, &ixfr_process_journal, qdata);
+	}
 	switch (ret) {
 	case KNOT_ESPACE: /* Couldn't write more, send packet and continue. */
+		/* Don't keep the journal snapshot while the message is being sent. */
+		(void)journal_read_suspend(ixfr->journal_ctx);
 		return KNOT_STATE_PRODUCE; /* Check for more. */
 	case KNOT_EOK:    /* Last response. */
 		xfr_stats_end(&ixfr->proc.stats);
@@ -19,6 +19,7 @@
 #include "knot/journal/journal_read.h"
 #include "knot/nameserver/process_query.h"
 #include "knot/nameserver/xfr.h"
+#include "knot/nameserver/xfr_cache.h"
 #include "libknot/packet/pkt.h"
 
 /*! \brief IXFR-in processing states. */
@@ -42,6 +43,10 @@ struct ixfr_proc {
 	/* Changes to be sent. */
 	journal_read_t *journal_ctx;
 
+	/* Shared rendered messages to be sent instead of the journal changes. */
+	xfr_cache_entry_t *cached;
+	size_t cached_next;
+
 	/* Currently processed RRSet. */
 	knot_rrset_t cur_rr;
 
@@ -20,6 +20,7 @@
 #include "knot/nameserver/nsec_proofs.h"
 #include "knot/nameserver/internet.h"
 #include "knot/dnssec/zone-nsec.h"
+#include "knot/server/server.h"
 
 /*!
  * \brief Check if node is empty non-terminal.
@@ -213,7 +214,11 @@ static int put_covering_nsec3(const zone_contents_t *zone,
 	const zone_node_t *prev = NULL;
 	const zone_node_t *node = NULL;
 
-	int match = zone_contents_find_nsec3_for_name(zone, name, &node, &prev);
+	server_t *server = qdata->params->server;
+	nsec3_cache_t *cache = (server != NULL) ?
+	                       nsec3_caches_get(&server->nsec3_caches, qdata->params->thread_id) : NULL;
+
+	int match = zone_contents_find_nsec3_for_name(zone, name, cache, &node, &prev);
 	if (match < 0) {
 		// ignore if missing
 		return KNOT_EOK;
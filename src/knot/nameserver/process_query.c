@@ -438,6 +438,7 @@ static int prepare_answer(knot_pkt_t *query, knot_pkt_t *resp, knot_layer_t *ctx
 	/* Find zone for QNAME. */
 	qdata->extra->zone = answer_zone_find(query, server->zone_db);
 	if (qdata->extra->zone != NULL && qdata->extra->contents == NULL) {
+		zone_cold_touch(qdata->extra->zone);
 		qdata->extra->contents = qdata->extra->zone->contents;
 	}
 
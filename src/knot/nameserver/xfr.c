@@ -72,6 +72,91 @@ int xfr_process_list(knot_pkt_t *pkt, xfr_put_cb put, knotd_qdata_t *qdata)
 	return ret;
 }
 
+int xfr_render(xfr_cache_entry_t *entry, const knot_dname_t *zone, uint16_t qtype,
+               const knot_rrset_t *soa_rr, xfr_put_cb put, struct xfr_proc *xfer)
+{
+	if (entry == NULL || zone == NULL || soa_rr == NULL || put == NULL || xfer == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	knot_pkt_t *pkt = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	if (pkt == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	do {
+		knot_pkt_clear(pkt);
+		ret = knot_pkt_put_question(pkt, zone, KNOT_CLASS_IN, qtype);
+		if (ret == KNOT_EOK) {
+			ret = knot_pkt_reserve(pkt, XFR_CACHE_RESERVE);
+		}
+
+		/* Same message layout as in xfr_process_list(). */
+		if (ret == KNOT_EOK && entry->count == 0) {
+			ret = knot_pkt_put(pkt, 0, soa_rr, KNOT_PF_NOTRUNC);
+		}
+		while (ret == KNOT_EOK && !EMPTY_LIST(xfer->nodes)) {
+			ptrnode_t *head = HEAD(xfer->nodes);
+			ret = put(pkt, head->d, xfer);
+			if (ret == KNOT_EOK) {
+				rem_node((node_t *)head);
+				free(head);
+			}
+		}
+		if (ret == KNOT_EOK) {
+			ret = knot_pkt_put(pkt, 0, soa_rr, KNOT_PF_NOTRUNC);
+		}
+		if (ret == KNOT_ESPACE && pkt->rrset_count < 1) {
+			ret = KNOT_ENOXFR;
+		}
+
+		if (ret == KNOT_EOK || ret == KNOT_ESPACE) {
+			int add_ret = xfr_cache_entry_add(entry, pkt);
+			if (add_ret != KNOT_EOK) {
+				ret = add_ret;
+				break;
+			}
+		}
+	} while (ret == KNOT_ESPACE);
+
+	knot_pkt_free(pkt);
+
+	return ret;
+}
+
+bool xfr_cached_usable(const xfr_cache_entry_t *entry, const knot_pkt_t *pkt,
+                       knotd_qdata_t *qdata)
+{
+	if (entry == NULL || (qdata->params->flags & KNOTD_QUERY_FLAG_LIMIT_SIZE) ||
+	    qdata->params->xdp_msg != NULL || entry->qname_size != pkt->qname_size) {
+		return false;
+	}
+
+	size_t avail = pkt->max_size - pkt->size - pkt->reserved;
+	return entry->max_size + knot_tsig_wire_size(&qdata->sign.tsig_key) <= avail;
+}
+
+int xfr_process_cached(knot_pkt_t *pkt, const xfr_cache_entry_t *entry, size_t *next,
+                       knotd_qdata_t *qdata)
+{
+	if (pkt == NULL || next == NULL || qdata == NULL || qdata->extra->ext == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	struct xfr_proc *xfer = qdata->extra->ext;
+
+	int ret = xfr_cache_entry_write(entry, (*next)++, pkt);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Update counters. */
+	xfr_stats_add(&xfer->stats, pkt->size + knot_rrset_size(&qdata->opt_rr));
+
+	return (*next < entry->count) ? KNOT_ESPACE : KNOT_EOK;
+}
+
 void xfr_stats_begin(struct xfr_stats *stats)
 {
 	assert(stats);
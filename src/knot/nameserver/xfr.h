@@ -20,6 +20,7 @@
 #include "contrib/ucw/lists.h"
 #include "knot/nameserver/log.h"
 #include "knot/nameserver/process_query.h"
+#include "knot/nameserver/xfr_cache.h"
 #include "knot/zone/contents.h"
 #include "libknot/packet/pkt.h"
 
@@ -67,3 +68,43 @@ typedef int (*xfr_put_cb)(knot_pkt_t *pkt, const void *item, struct xfr_proc *xf
  * \note qdata->extra->ext points to struct xfr_proc* (this is xfer-specific context)
  */
 int xfr_process_list(knot_pkt_t *pkt, xfr_put_cb put, knotd_qdata_t *qdata);
+
+/*!
+ * \brief Render the whole transfer from xfr_proc.nodes into a cache entry.
+ *
+ * The messages are rendered without OPT and TSIG, processed items are
+ * removed from the list (allocated without a memory context).
+ *
+ * \param entry   Entry to be filled.
+ * \param zone    Zone name used as QNAME.
+ * \param qtype   Transfer query type.
+ * \param soa_rr  Zone SOA prepended and appended to the transfer.
+ * \param put     Callback putting the items into a message.
+ * \param xfer    Transfer-specific context.
+ *
+ * \return KNOT_EOK or an error (KNOT_ESPACE if too large to be cached).
+ */
+int xfr_render(xfr_cache_entry_t *entry, const knot_dname_t *zone, uint16_t qtype,
+               const knot_rrset_t *soa_rr, xfr_put_cb put, struct xfr_proc *xfer);
+
+/*!
+ * \brief Check if rendered messages can be sent as the answer.
+ *
+ * Only full-size TCP answers are eligible, the messages must fit together
+ * with the requester's OPT and TSIG.
+ */
+bool xfr_cached_usable(const xfr_cache_entry_t *entry, const knot_pkt_t *pkt,
+                       knotd_qdata_t *qdata);
+
+/*!
+ * \brief Put the next rendered message into the answer.
+ *
+ * \param pkt    Answer with the question only.
+ * \param entry  Rendered transfer.
+ * \param next   Index of the message to be sent, incremented.
+ * \param qdata  Query data, qdata->extra->ext points to struct xfr_proc*.
+ *
+ * \return KNOT_ESPACE if more messages follow, KNOT_EOK after the last one or an error.
+ */
+int xfr_process_cached(knot_pkt_t *pkt, const xfr_cache_entry_t *entry, size_t *next,
+                       knotd_qdata_t *qdata);
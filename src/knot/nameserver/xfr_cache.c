@@ -0,0 +1,300 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/nameserver/xfr_cache.h"
+#include "libknot/errcode.h"
+#include "libknot/packet/wire.h"
+
+#ifdef HAVE_ATOMIC
+#define ATOMIC_INC(dst)     __atomic_add_fetch(&(dst), 1, __ATOMIC_RELAXED)
+#define ATOMIC_DEC(dst)     __atomic_sub_fetch(&(dst), 1, __ATOMIC_ACQ_REL)
+#else
+#define ATOMIC_INC(dst)     __sync_add_and_fetch(&(dst), 1)
+#define ATOMIC_DEC(dst)     __sync_sub_and_fetch(&(dst), 1)
+#endif
+
+/*! \brief Size of the header and question of a transfer message. */
+#define MSG_PREFIX(qname_size) (KNOT_WIRE_HEADER_SIZE + (qname_size) + 2 * sizeof(uint16_t))
+
+static void entry_free(xfr_cache_entry_t *entry)
+{
+	for (size_t i = 0; i < entry->count; i++) {
+		free(entry->msgs[i].wire);
+	}
+	free(entry->msgs);
+	free(entry);
+}
+
+/*! \brief Remove an entry from the cache, the cache must be locked. */
+static void cache_evict(xfr_cache_t *cache, size_t index)
+{
+	xfr_cache_entry_t *entry = cache->entries[index];
+	assert(entry != NULL);
+
+	cache->bytes -= entry->bytes;
+	cache->entries[index] = NULL;
+	xfr_cache_entry_unref(entry);
+}
+
+xfr_cache_t *xfr_cache_new(void)
+{
+	xfr_cache_t *cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&cache->lock, NULL);
+	pthread_mutex_init(&cache->build, NULL);
+
+	return cache;
+}
+
+void xfr_cache_free(xfr_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	xfr_cache_clear(cache);
+	pthread_mutex_destroy(&cache->build);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+void xfr_cache_clear(xfr_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	for (size_t i = 0; i < XFR_CACHE_ENTRIES; i++) {
+		if (cache->entries[i] != NULL) {
+			cache_evict(cache, i);
+		}
+	}
+	cache->epoch++;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+uint64_t xfr_cache_epoch(xfr_cache_t *cache)
+{
+	pthread_mutex_lock(&cache->lock);
+	uint64_t epoch = cache->epoch;
+	pthread_mutex_unlock(&cache->lock);
+
+	return epoch;
+}
+
+xfr_cache_entry_t *xfr_cache_get(xfr_cache_t *cache, uint32_t serial_from,
+                                 uint32_t serial_to)
+{
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	xfr_cache_entry_t *found = NULL;
+
+	pthread_mutex_lock(&cache->lock);
+	for (size_t i = 0; i < XFR_CACHE_ENTRIES; i++) {
+		xfr_cache_entry_t *entry = cache->entries[i];
+		if (entry != NULL && entry->serial_from == serial_from &&
+		    entry->serial_to == serial_to) {
+			entry->used = ++cache->clock;
+			ATOMIC_INC(entry->refs);
+			found = entry;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	return found;
+}
+
+int xfr_cache_insert(xfr_cache_t *cache, xfr_cache_entry_t *entry, uint64_t epoch)
+{
+	if (cache == NULL || entry == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (entry->bytes > XFR_CACHE_MAX_BYTES) {
+		return KNOT_ESPACE;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	if (cache->epoch != epoch) {
+		pthread_mutex_unlock(&cache->lock);
+		return KNOT_EAGAIN;
+	}
+
+	while (true) {
+		size_t free_slot = XFR_CACHE_ENTRIES, lru = XFR_CACHE_ENTRIES;
+		for (size_t i = 0; i < XFR_CACHE_ENTRIES; i++) {
+			xfr_cache_entry_t *cur = cache->entries[i];
+			if (cur == NULL) {
+				free_slot = i;
+			} else if (lru == XFR_CACHE_ENTRIES ||
+			           cur->used < cache->entries[lru]->used) {
+				lru = i;
+			}
+		}
+
+		if (free_slot < XFR_CACHE_ENTRIES &&
+		    cache->bytes + entry->bytes <= XFR_CACHE_MAX_BYTES) {
+			entry->used = ++cache->clock;
+			ATOMIC_INC(entry->refs);
+			cache->entries[free_slot] = entry;
+			cache->bytes += entry->bytes;
+			break;
+		}
+
+		assert(lru < XFR_CACHE_ENTRIES);
+		cache_evict(cache, lru);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	return KNOT_EOK;
+}
+
+xfr_cache_entry_t *xfr_cache_render_once(xfr_cache_t *cache,
+                                         xfr_cache_entry_t **rendered,
+                                         bool *failed, uint32_t serial,
+                                         xfr_cache_render_t render, void *ctx)
+{
+	if (cache == NULL || rendered == NULL || failed == NULL || render == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_lock(&cache->build);
+	if (*rendered == NULL && !*failed) {
+		xfr_cache_entry_t *entry = xfr_cache_entry_new(serial, serial);
+		if (entry != NULL && render(entry, ctx) != KNOT_EOK) {
+			xfr_cache_entry_unref(entry);
+			entry = NULL;
+		}
+		*rendered = entry;
+		*failed = (entry == NULL);
+	}
+	xfr_cache_entry_t *entry = *rendered;
+	xfr_cache_entry_ref(entry);
+	pthread_mutex_unlock(&cache->build);
+
+	return entry;
+}
+
+xfr_cache_entry_t *xfr_cache_entry_new(uint32_t serial_from, uint32_t serial_to)
+{
+	xfr_cache_entry_t *entry = calloc(1, sizeof(*entry));
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	entry->serial_from = serial_from;
+	entry->serial_to = serial_to;
+	entry->refs = 1;
+
+	return entry;
+}
+
+void xfr_cache_entry_ref(xfr_cache_entry_t *entry)
+{
+	if (entry != NULL) {
+		ATOMIC_INC(entry->refs);
+	}
+}
+
+void xfr_cache_entry_unref(xfr_cache_entry_t *entry)
+{
+	if (entry != NULL && ATOMIC_DEC(entry->refs) == 0) {
+		entry_free(entry);
+	}
+}
+
+int xfr_cache_entry_add(xfr_cache_entry_t *entry, const knot_pkt_t *pkt)
+{
+	if (entry == NULL || pkt == NULL || pkt->size < MSG_PREFIX(pkt->qname_size)) {
+		return KNOT_EINVAL;
+	}
+
+	if (entry->count > 0 && entry->qname_size != pkt->qname_size) {
+		return KNOT_EINVAL;
+	}
+
+	uint16_t size = pkt->size - MSG_PREFIX(pkt->qname_size);
+	if (entry->bytes + size > XFR_CACHE_MAX_BYTES) {
+		return KNOT_ESPACE;
+	}
+
+	if (entry->count == entry->capacity) {
+		size_t capacity = (entry->capacity == 0) ? 16 : 2 * entry->capacity;
+		xfr_msg_t *msgs = realloc(entry->msgs, capacity * sizeof(*msgs));
+		if (msgs == NULL) {
+			return KNOT_ENOMEM;
+		}
+		entry->msgs = msgs;
+		entry->capacity = capacity;
+	}
+
+	xfr_msg_t *msg = &entry->msgs[entry->count];
+	msg->wire = malloc(size > 0 ? size : 1);
+	if (msg->wire == NULL) {
+		return KNOT_ENOMEM;
+	}
+	memcpy(msg->wire, pkt->wire + MSG_PREFIX(pkt->qname_size), size);
+	msg->size = size;
+	msg->ancount = knot_wire_get_ancount(pkt->wire);
+
+	entry->qname_size = pkt->qname_size;
+	if (size > entry->max_size) {
+		entry->max_size = size;
+	}
+	entry->bytes += size;
+	entry->count++;
+
+	return KNOT_EOK;
+}
+
+int xfr_cache_entry_write(const xfr_cache_entry_t *entry, size_t index,
+                          knot_pkt_t *pkt)
+{
+	if (entry == NULL || pkt == NULL || index >= entry->count) {
+		return KNOT_EINVAL;
+	}
+
+	/* The compression pointers require the same question layout. */
+	if (pkt->qname_size != entry->qname_size ||
+	    pkt->size != MSG_PREFIX(entry->qname_size)) {
+		return KNOT_EINVAL;
+	}
+
+	const xfr_msg_t *msg = &entry->msgs[index];
+	if (pkt->size + pkt->reserved + msg->size > pkt->max_size) {
+		return KNOT_ESPACE;
+	}
+
+	memcpy(pkt->wire + pkt->size, msg->wire, msg->size);
+	pkt->size += msg->size;
+	knot_wire_add_ancount(pkt->wire, msg->ancount);
+
+	return KNOT_EOK;
+}
@@ -0,0 +1,172 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libknot/packet/pkt.h"
+
+/*! \brief Maximum number of cached transfers per zone. */
+#define XFR_CACHE_ENTRIES	8
+
+/*! \brief Maximum size of the cached messages per zone. */
+#define XFR_CACHE_MAX_BYTES	(64 * 1024 * 1024)
+
+/*! \brief Space left in the rendered messages for OPT and TSIG. */
+#define XFR_CACHE_RESERVE	1024
+
+/*! \brief One rendered transfer message, without the header and question. */
+typedef struct {
+	uint8_t *wire;
+	uint16_t size;
+	uint16_t ancount;
+} xfr_msg_t;
+
+/*!
+ * \brief Rendered message sequence of a transfer.
+ *
+ * The messages are independent of the TSIG key and EDNS of the requester,
+ * they are finished with OPT and TSIG per message when sent. The compression
+ * pointers refer to the question, which has the same size for any query
+ * of the zone (the compression is case insensitive).
+ */
+typedef struct xfr_cache_entry {
+	uint32_t serial_from;
+	uint32_t serial_to;
+	uint16_t qname_size;  /*!< Question name size the messages were rendered with. */
+	uint16_t max_size;    /*!< Largest message size. */
+	size_t bytes;         /*!< Size of all the messages. */
+	size_t count;
+	size_t capacity;
+	xfr_msg_t *msgs;
+	unsigned refs;        /*!< References (atomic). */
+	uint64_t used;        /*!< Last use for LRU eviction, under the cache lock. */
+} xfr_cache_entry_t;
+
+/*!
+ * \brief Cache of rendered outgoing transfers of a zone.
+ *
+ * The entries are shared by concurrent transfers and reference counted, so
+ * an entry may be evicted while it's still being sent.
+ */
+typedef struct xfr_cache {
+	pthread_mutex_t lock;     /*!< Protects the entries. */
+	pthread_mutex_t build;    /*!< Serializes rendering of the missing entries. */
+	xfr_cache_entry_t *entries[XFR_CACHE_ENTRIES];
+	size_t bytes;
+	uint64_t clock;
+	uint64_t epoch;           /*!< Incremented when the cache is cleared. */
+} xfr_cache_t;
+
+/*!
+ * \brief Create an empty cache.
+ */
+xfr_cache_t *xfr_cache_new(void);
+
+/*!
+ * \brief Free the cache, the entries in use are freed when released.
+ */
+void xfr_cache_free(xfr_cache_t *cache);
+
+/*!
+ * \brief Evict all entries, e.g. due to a journal change.
+ */
+void xfr_cache_clear(xfr_cache_t *cache);
+
+/*!
+ * \brief Get the current cache epoch to be passed to xfr_cache_insert().
+ */
+uint64_t xfr_cache_epoch(xfr_cache_t *cache);
+
+/*!
+ * \brief Find an entry and take a reference to it.
+ *
+ * \return Entry to be released with xfr_cache_entry_unref() or NULL.
+ */
+xfr_cache_entry_t *xfr_cache_get(xfr_cache_t *cache, uint32_t serial_from,
+                                 uint32_t serial_to);
+
+/*!
+ * \brief Insert an entry unless the cache was cleared since 'epoch'.
+ *
+ * The caller's reference to the entry is kept. The least recently used
+ * entries are evicted to make room.
+ *
+ * \return KNOT_EOK, KNOT_ESPACE if too large, KNOT_EAGAIN if cleared.
+ */
+int xfr_cache_insert(xfr_cache_t *cache, xfr_cache_entry_t *entry, uint64_t epoch);
+
+/*! \brief Callback rendering the messages of a transfer into an entry. */
+typedef int (*xfr_cache_render_t)(xfr_cache_entry_t *entry, void *ctx);
+
+/*!
+ * \brief Get the rendered transfer of a zone version, render it on first use.
+ *
+ * Concurrent callers wait for one rendering. A failed rendering (e.g. over
+ * the cache size limit) is remembered and not retried for the same version.
+ *
+ * \param cache      Cache of the zone, its build lock is used.
+ * \param rendered   Rendered entry of the version, NULL if not rendered yet.
+ * \param failed     The rendering of the version failed.
+ * \param serial     Serial of the version.
+ * \param render     Rendering callback.
+ * \param ctx        Rendering callback context.
+ *
+ * \return Entry to be released with xfr_cache_entry_unref() or NULL.
+ */
+xfr_cache_entry_t *xfr_cache_render_once(xfr_cache_t *cache,
+                                         xfr_cache_entry_t **rendered,
+                                         bool *failed, uint32_t serial,
+                                         xfr_cache_render_t render, void *ctx);
+
+/*!
+ * \brief Create a new entry with one reference.
+ */
+xfr_cache_entry_t *xfr_cache_entry_new(uint32_t serial_from, uint32_t serial_to);
+
+/*!
+ * \brief Take another reference to the entry.
+ */
+void xfr_cache_entry_ref(xfr_cache_entry_t *entry);
+
+/*!
+ * \brief Release a reference to the entry.
+ */
+void xfr_cache_entry_unref(xfr_cache_entry_t *entry);
+
+/*!
+ * \brief Append the answer section of a rendered message to the entry.
+ *
+ * \param entry  Entry being rendered.
+ * \param pkt    Message with the question and answer section only.
+ *
+ * \return KNOT_EOK, KNOT_ESPACE if the entry would exceed the cache size.
+ */
+int xfr_cache_entry_add(xfr_cache_entry_t *entry, const knot_pkt_t *pkt);
+
+/*!
+ * \brief Write a cached message into the answer after the question.
+ *
+ * \param entry  Cached entry.
+ * \param index  Message index.
+ * \param pkt    Answer with the question only.
+ */
+int xfr_cache_entry_write(const xfr_cache_entry_t *entry, size_t index,
+                          knot_pkt_t *pkt);
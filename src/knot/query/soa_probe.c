@@ -0,0 +1,709 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <urcu.h>
+
+#include "knot/query/soa_probe.h"
+#include "knot/nameserver/tsig_ctx.h"
+#include "contrib/macros.h"
+#include "contrib/net.h"
+#include "contrib/sockaddr.h"
+#include "contrib/time.h"
+#include "contrib/ucw/lists.h"
+#include "libknot/libknot.h"
+
+#define PROBE_SOCKETS_MAX	64     // address families, source addresses, batches
+#define PROBE_BATCH		64     // messages per system call
+#define PROBE_BUF_SIZE		4096   // enough for a SOA response
+#define PROBE_INFLIGHT_MAX	16384
+#define PROBE_PENDING_MAX	65536
+#define PROBE_BUCKETS		(UINT16_MAX + 1) // in-flight probes by message ID
+#define PROBE_TIMEOUT_DEFAULT	5000   // if the remote I/O timeout is infinite
+
+#ifdef HAVE_ATOMIC
+#define ATOMIC_ADD(dst, val) __atomic_add_fetch(&(dst), (val), __ATOMIC_RELAXED)
+#define ATOMIC_GET(src)      __atomic_load_n(&(src), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_ADD(dst, val) __sync_add_and_fetch(&(dst), (val))
+#define ATOMIC_GET(src)      __sync_fetch_and_or(&(src), 0)
+#endif
+
+#ifdef ENABLE_RECVMMSG
+typedef struct mmsghdr probe_msg_t;
+#else
+typedef struct {
+	struct msghdr msg_hdr;
+	unsigned msg_len;
+} probe_msg_t;
+#endif
+
+typedef struct {
+	struct sockaddr_storage via;  // AF_UNSPEC if not bound
+	int family;
+	int fd;
+	size_t inflight;              // in-flight probes sent via this socket
+	bool retired;                 // not used for new batches
+} probe_sock_t;
+
+typedef struct probe_req {
+	node_t n;                     // in the pending or in-flight list
+	struct probe_req *id_next;    // next in-flight probe in the ID bucket
+	knot_dname_t *zone;
+	struct sockaddr_storage remote;
+	struct sockaddr_storage via;
+	knot_tsig_key_t *key;
+	tsig_ctx_t tsig;
+	struct query_edns_data edns;
+	bool use_edns;
+	uint16_t id;
+	probe_sock_t *sock;
+	struct timespec deadline;
+} probe_req_t;
+
+/*! \brief Message buffers of the probing thread. */
+typedef struct {
+	uint8_t buf[PROBE_BATCH][PROBE_BUF_SIZE];
+	struct iovec iov[PROBE_BATCH];
+	struct sockaddr_storage addr[PROBE_BATCH];
+	probe_msg_t msgs[PROBE_BATCH];
+	probe_req_t *reqs[PROBE_BATCH];
+} probe_io_t;
+
+struct soa_probe {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	int wake[2];                  // pipe waking up the thread
+	soa_probe_cb_t cb;
+	void *cb_ctx;
+
+	// Protected by the lock.
+	list_t pending;
+	size_t pending_count;
+	struct timespec pending_since; // submission of the oldest pending probe
+	unsigned window_ms;
+	unsigned timeout_ms;
+	bool stop;
+
+	// Owned by the thread.
+	list_t inflight;              // in the order of deadlines
+	size_t inflight_count;
+	probe_req_t **buckets;
+	probe_sock_t *socks[PROBE_SOCKETS_MAX];
+	size_t nsocks;
+	probe_io_t *io;
+
+	uint64_t queries;
+	uint64_t batches;
+};
+
+static void req_free(probe_req_t *req)
+{
+	tsig_cleanup(&req->tsig);
+	if (req->key != NULL) {
+		knot_tsig_key_deinit(req->key);
+		free(req->key);
+	}
+	knot_dname_free(req->zone, NULL);
+	free(req);
+}
+
+static void req_finish(soa_probe_t *probe, probe_req_t *req, int ret, uint32_t serial)
+{
+	soa_probe_result_t result = {
+		.ret = ret,
+		.serial = serial,
+		.remote = req->remote,
+	};
+	probe->cb(req->zone, &result, probe->cb_ctx);
+	req_free(req);
+}
+
+static void inflight_add(soa_probe_t *probe, probe_req_t *req)
+{
+	add_tail(&probe->inflight, &req->n);
+	req->id_next = probe->buckets[req->id];
+	probe->buckets[req->id] = req;
+	probe->inflight_count++;
+	req->sock->inflight++;
+}
+
+static void inflight_remove(soa_probe_t *probe, probe_req_t *req)
+{
+	probe_req_t **it = &probe->buckets[req->id];
+	while (*it != req) {
+		it = &(*it)->id_next;
+	}
+	*it = req->id_next;
+	rem_node(&req->n);
+	probe->inflight_count--;
+	req->sock->inflight--;
+}
+
+static void wake_up(soa_probe_t *probe)
+{
+	uint8_t byte = 0;
+	(void)write(probe->wake[1], &byte, sizeof(byte));
+}
+
+/*!
+ * \brief Get a socket of the current batch for the probe.
+ *
+ * Each batch gets new sockets, hence a new random source port, so that
+ * a spoofed response has to guess the port too, not only the message ID.
+ * If there are too many sockets with probes in flight, the most recent
+ * suitable one is reused.
+ */
+static probe_sock_t *get_sock(soa_probe_t *probe, const probe_req_t *req)
+{
+	int family = req->remote.ss_family;
+	probe_sock_t *reuse = NULL;
+	for (size_t i = 0; i < probe->nsocks; i++) {
+		probe_sock_t *sock = probe->socks[i];
+		if (sock->family == family && sockaddr_cmp(&sock->via, &req->via, false) == 0) {
+			if (!sock->retired) {
+				return sock;
+			}
+			reuse = sock;
+		}
+	}
+
+	if (probe->nsocks == PROBE_SOCKETS_MAX) {
+		return reuse;
+	}
+
+	probe_sock_t *sock = calloc(1, sizeof(*sock));
+	if (sock == NULL) {
+		return reuse;
+	}
+	sock->fd = (req->via.ss_family != AF_UNSPEC) ?
+	           net_bound_socket(SOCK_DGRAM, &req->via, 0) :
+	           net_unbound_socket(SOCK_DGRAM, &req->remote);
+	if (sock->fd < 0) {
+		free(sock);
+		return reuse;
+	}
+	sock->via = req->via;
+	sock->family = family;
+
+	probe->socks[probe->nsocks++] = sock;
+	return sock;
+}
+
+/*! \brief Close the sockets of the previous batches without probes in flight. */
+static void close_socks(soa_probe_t *probe, bool all)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < probe->nsocks; i++) {
+		probe_sock_t *sock = probe->socks[i];
+		if (all || (sock->retired && sock->inflight == 0)) {
+			close(sock->fd);
+			free(sock);
+		} else {
+			probe->socks[kept++] = sock;
+		}
+	}
+	probe->nsocks = kept;
+}
+
+static int make_query(probe_req_t *req, uint8_t *wire, size_t *size)
+{
+	knot_pkt_t *pkt = knot_pkt_new(wire, PROBE_BUF_SIZE, NULL);
+	if (pkt == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	query_init_pkt(pkt);
+	int ret = knot_pkt_put_question(pkt, req->zone, KNOT_CLASS_IN, KNOT_RRTYPE_SOA);
+	if (ret == KNOT_EOK && req->use_edns) {
+		ret = query_put_edns(pkt, &req->edns);
+	}
+	if (ret == KNOT_EOK) {
+		ret = tsig_sign_packet(&req->tsig, pkt);
+	}
+
+	req->id = knot_wire_get_id(pkt->wire);
+	*size = pkt->size;
+	knot_pkt_free(pkt);
+
+	return ret;
+}
+
+static int send_msgs(int fd, probe_msg_t *msgs, unsigned count)
+{
+#ifdef ENABLE_RECVMMSG
+	return sendmmsg(fd, msgs, count, 0);
+#else
+	unsigned sent = 0;
+	for ( ; sent < count; sent++) {
+		if (sendmsg(fd, &msgs[sent].msg_hdr, 0) < 0) {
+			break;
+		}
+	}
+	return (sent > 0) ? sent : -1;
+#endif
+}
+
+static int recv_msgs(int fd, probe_msg_t *msgs, unsigned count)
+{
+#ifdef ENABLE_RECVMMSG
+	return recvmmsg(fd, msgs, count, MSG_DONTWAIT, NULL);
+#else
+	ssize_t len = recvmsg(fd, &msgs[0].msg_hdr, MSG_DONTWAIT);
+	if (len < 0) {
+		return -1;
+	}
+	msgs[0].msg_len = len;
+	return 1;
+#endif
+}
+
+static void prepare_msg(probe_io_t *io, unsigned i, const struct sockaddr_storage *remote,
+                        size_t size)
+{
+	io->iov[i].iov_base = io->buf[i];
+	io->iov[i].iov_len = size;
+
+	struct msghdr *hdr = &io->msgs[i].msg_hdr;
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->msg_iov = &io->iov[i];
+	hdr->msg_iovlen = 1;
+	if (remote != NULL) {
+		hdr->msg_name = (void *)remote;
+		hdr->msg_namelen = sockaddr_len(remote);
+	} else {
+		hdr->msg_name = &io->addr[i];
+		hdr->msg_namelen = sizeof(io->addr[i]);
+	}
+}
+
+/*! \brief Send the prepared queries via one socket. */
+static void send_group(soa_probe_t *probe, probe_sock_t *sock, unsigned count,
+                       unsigned timeout_ms)
+{
+	probe_io_t *io = probe->io;
+
+	unsigned sent = 0;
+	int err = KNOT_EOK;
+	while (sent < count) {
+		int ret = send_msgs(sock->fd, io->msgs + sent, count - sent);
+		if (ret >= 0) {
+			sent += ret;
+			continue;
+		}
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			struct pollfd pfd = { .fd = sock->fd, .events = POLLOUT };
+			if (poll(&pfd, 1, timeout_ms) > 0) {
+				continue;
+			}
+		}
+		err = knot_map_errno();
+		break;
+	}
+	if (sent > 0) {
+		ATOMIC_ADD(probe->queries, sent);
+		ATOMIC_ADD(probe->batches, 1);
+	}
+
+	struct timespec now = time_now();
+	for (unsigned i = 0; i < count; i++) {
+		probe_req_t *req = io->reqs[i];
+		if (i < sent) {
+			req->deadline.tv_sec = now.tv_sec + timeout_ms / 1000;
+			req->deadline.tv_nsec = now.tv_nsec + (timeout_ms % 1000) * 1000000L;
+			if (req->deadline.tv_nsec >= 1000000000L) {
+				req->deadline.tv_sec++;
+				req->deadline.tv_nsec -= 1000000000L;
+			}
+			inflight_add(probe, req);
+		} else {
+			req_finish(probe, req, err, 0);
+		}
+	}
+}
+
+/*! \brief Send the batch grouping the queries by socket. */
+static void send_batch(soa_probe_t *probe, list_t *batch, unsigned timeout_ms)
+{
+	probe_io_t *io = probe->io;
+	probe_sock_t *group = NULL;
+	unsigned count = 0;
+
+	if (EMPTY_LIST(*batch)) {
+		return;
+	}
+	for (size_t i = 0; i < probe->nsocks; i++) {
+		probe->socks[i]->retired = true;
+	}
+
+	probe_req_t *req, *nxt;
+	WALK_LIST_DELSAFE(req, nxt, *batch) {
+		rem_node(&req->n);
+
+		req->sock = get_sock(probe, req);
+		if (req->sock == NULL) {
+			req_finish(probe, req, KNOT_ECONN, 0);
+			continue;
+		}
+		if (count > 0 && (req->sock != group || count == PROBE_BATCH)) {
+			send_group(probe, group, count, timeout_ms);
+			count = 0;
+		}
+		group = req->sock;
+
+		size_t size = 0;
+		int ret = make_query(req, io->buf[count], &size);
+		if (ret != KNOT_EOK) {
+			req_finish(probe, req, ret, 0);
+			continue;
+		}
+		prepare_msg(io, count, &req->remote, size);
+		io->reqs[count++] = req;
+	}
+	if (count > 0) {
+		send_group(probe, group, count, timeout_ms);
+	}
+}
+
+static probe_req_t *match_response(soa_probe_t *probe, probe_sock_t *sock,
+                                   const struct sockaddr_storage *from, knot_pkt_t *pkt)
+{
+	const knot_dname_t *qname = knot_pkt_qname(pkt);
+	if (!knot_wire_get_qr(pkt->wire) || qname == NULL ||
+	    knot_pkt_qtype(pkt) != KNOT_RRTYPE_SOA) {
+		return NULL;
+	}
+
+	for (probe_req_t *req = probe->buckets[knot_wire_get_id(pkt->wire)];
+	     req != NULL; req = req->id_next) {
+		if (req->sock == sock && sockaddr_cmp(&req->remote, from, false) == 0 &&
+		    knot_dname_is_case_equal(qname, req->zone)) {
+			return req;
+		}
+	}
+	return NULL;
+}
+
+static void process_response(soa_probe_t *probe, probe_sock_t *sock, uint8_t *wire,
+                             size_t size, const struct sockaddr_storage *from,
+                             bool truncated)
+{
+	knot_pkt_t *pkt = knot_pkt_new(wire, size, NULL);
+	if (pkt == NULL) {
+		return;
+	}
+	probe_req_t *req = NULL;
+	if (knot_pkt_parse(pkt, 0) == KNOT_EOK) {
+		req = match_response(probe, sock, from, pkt);
+	}
+	if (req == NULL) {
+		knot_pkt_free(pkt); // not ours, or junk
+		return;
+	}
+	inflight_remove(probe, req);
+
+	uint32_t serial = 0;
+	int ret = tsig_verify_packet(&req->tsig, pkt);
+	if (ret == KNOT_EOK && tsig_unsigned_count(&req->tsig) != 0) {
+		ret = KNOT_EMALF;
+	}
+	if (ret == KNOT_EOK && (truncated || knot_wire_get_tc(pkt->wire))) {
+		ret = KNOT_ESPACE;
+	}
+	if (ret == KNOT_EOK && knot_pkt_ext_rcode(pkt) != KNOT_RCODE_NOERROR) {
+		ret = KNOT_EDENIED;
+	}
+	if (ret == KNOT_EOK) {
+		const knot_pktsection_t *answer = knot_pkt_section(pkt, KNOT_ANSWER);
+		const knot_rrset_t *rr = answer->count == 1 ? knot_pkt_rr(answer, 0) : NULL;
+		if (rr == NULL || rr->type != KNOT_RRTYPE_SOA || rr->rrs.count != 1) {
+			ret = KNOT_EMALF;
+		} else {
+			serial = knot_soa_serial(rr->rrs.rdata);
+		}
+	}
+	knot_pkt_free(pkt);
+
+	req_finish(probe, req, ret, serial);
+}
+
+static void receive(soa_probe_t *probe, probe_sock_t *sock)
+{
+	probe_io_t *io = probe->io;
+
+	int count;
+	do {
+		for (unsigned i = 0; i < PROBE_BATCH; i++) {
+			prepare_msg(io, i, NULL, PROBE_BUF_SIZE);
+		}
+		count = recv_msgs(sock->fd, io->msgs, PROBE_BATCH);
+		for (int i = 0; i < count; i++) {
+			bool truncated = io->msgs[i].msg_hdr.msg_flags & MSG_TRUNC;
+			process_response(probe, sock, io->buf[i], io->msgs[i].msg_len,
+			                 &io->addr[i], truncated);
+		}
+	} while (count == PROBE_BATCH);
+}
+
+static void expire(soa_probe_t *probe, const struct timespec *now)
+{
+	probe_req_t *req, *nxt;
+	WALK_LIST_DELSAFE(req, nxt, probe->inflight) {
+		if (time_diff_ms(now, &req->deadline) > 0) {
+			break;
+		}
+		inflight_remove(probe, req);
+		req_finish(probe, req, KNOT_ETIMEOUT, 0);
+	}
+}
+
+static void *probe_thread(void *data)
+{
+	soa_probe_t *probe = data;
+
+	rcu_register_thread();
+
+	while (true) {
+		list_t batch;
+		init_list(&batch);
+		int wait_ms = -1;
+
+		pthread_mutex_lock(&probe->lock);
+		if (probe->stop) {
+			pthread_mutex_unlock(&probe->lock);
+			break;
+		}
+		struct timespec now = time_now();
+		if (probe->pending_count > 0 && probe->inflight_count < PROBE_INFLIGHT_MAX) {
+			double waited = time_diff_ms(&probe->pending_since, &now);
+			if (waited >= probe->window_ms) {
+				size_t take = PROBE_INFLIGHT_MAX - probe->inflight_count;
+				probe_req_t *req, *nxt;
+				WALK_LIST_DELSAFE(req, nxt, probe->pending) {
+					if (take-- == 0) {
+						break;
+					}
+					rem_node(&req->n);
+					add_tail(&batch, &req->n);
+					probe->pending_count--;
+				}
+			} else {
+				wait_ms = ceil(probe->window_ms - waited);
+			}
+		}
+		unsigned timeout_ms = probe->timeout_ms;
+		pthread_mutex_unlock(&probe->lock);
+
+		send_batch(probe, &batch, timeout_ms);
+
+		now = time_now();
+		expire(probe, &now);
+		close_socks(probe, false);
+		if (!EMPTY_LIST(probe->inflight)) {
+			probe_req_t *first = HEAD(probe->inflight);
+			int left = MAX(0, ceil(time_diff_ms(&now, &first->deadline)));
+			wait_ms = (wait_ms < 0) ? left : MIN(wait_ms, left);
+		}
+
+		struct pollfd fds[1 + PROBE_SOCKETS_MAX] = {
+			{ .fd = probe->wake[0], .events = POLLIN }
+		};
+		for (size_t i = 0; i < probe->nsocks; i++) {
+			fds[1 + i].fd = probe->socks[i]->fd;
+			fds[1 + i].events = POLLIN;
+		}
+		if (poll(fds, 1 + probe->nsocks, wait_ms) <= 0) {
+			continue;
+		}
+		if (fds[0].revents != 0) {
+			uint8_t drain[64];
+			while (read(probe->wake[0], drain, sizeof(drain)) > 0);
+		}
+		for (size_t i = 0; i < probe->nsocks; i++) {
+			if (fds[1 + i].revents != 0) {
+				receive(probe, probe->socks[i]);
+			}
+		}
+	}
+
+	rcu_unregister_thread();
+
+	return NULL;
+}
+
+static void probe_free(soa_probe_t *probe)
+{
+	probe_req_t *req, *nxt;
+	WALK_LIST_DELSAFE(req, nxt, probe->pending) {
+		req_free(req);
+	}
+	WALK_LIST_DELSAFE(req, nxt, probe->inflight) {
+		req_free(req);
+	}
+	close_socks(probe, true);
+	for (int i = 0; i < 2; i++) {
+		if (probe->wake[i] >= 0) {
+			close(probe->wake[i]);
+		}
+	}
+	pthread_mutex_destroy(&probe->lock);
+	free(probe->buckets);
+	free(probe->io);
+	free(probe);
+}
+
+int soa_probe_new(soa_probe_cb_t cb, void *ctx, soa_probe_t **probe)
+{
+	if (cb == NULL || probe == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	soa_probe_t *new_probe = calloc(1, sizeof(*new_probe));
+	if (new_probe == NULL) {
+		return KNOT_ENOMEM;
+	}
+	new_probe->cb = cb;
+	new_probe->cb_ctx = ctx;
+	new_probe->timeout_ms = PROBE_TIMEOUT_DEFAULT;
+	new_probe->wake[0] = new_probe->wake[1] = -1;
+	init_list(&new_probe->pending);
+	init_list(&new_probe->inflight);
+	pthread_mutex_init(&new_probe->lock, NULL);
+
+	new_probe->buckets = calloc(PROBE_BUCKETS, sizeof(*new_probe->buckets));
+	new_probe->io = malloc(sizeof(*new_probe->io));
+	if (new_probe->buckets == NULL || new_probe->io == NULL) {
+		probe_free(new_probe);
+		return KNOT_ENOMEM;
+	}
+
+	if (pipe(new_probe->wake) != 0) {
+		int ret = knot_map_errno();
+		new_probe->wake[0] = new_probe->wake[1] = -1;
+		probe_free(new_probe);
+		return ret;
+	}
+	for (int i = 0; i < 2; i++) {
+		(void)fcntl(new_probe->wake[i], F_SETFL, O_NONBLOCK);
+	}
+
+	int ret = pthread_create(&new_probe->thread, NULL, probe_thread, new_probe);
+	if (ret != 0) {
+		probe_free(new_probe);
+		return knot_map_errno_code(ret);
+	}
+
+	*probe = new_probe;
+	return KNOT_EOK;
+}
+
+void soa_probe_set(soa_probe_t *probe, unsigned window_ms, unsigned timeout_ms)
+{
+	if (probe == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&probe->lock);
+	probe->window_ms = window_ms;
+	probe->timeout_ms = (timeout_ms > 0) ? timeout_ms : PROBE_TIMEOUT_DEFAULT;
+	pthread_mutex_unlock(&probe->lock);
+
+	wake_up(probe);
+}
+
+int soa_probe_submit(soa_probe_t *probe, const knot_dname_t *zone,
+                     const conf_remote_t *remote, const struct query_edns_data *edns)
+{
+	if (probe == NULL || zone == NULL || remote == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	probe_req_t *req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		return KNOT_ENOMEM;
+	}
+	req->zone = knot_dname_copy(zone, NULL);
+	req->remote = remote->addr;
+	req->via = remote->via;
+	if (remote->key.algorithm != DNSSEC_TSIG_UNKNOWN) {
+		req->key = calloc(1, sizeof(*req->key));
+		if (req->key == NULL || knot_tsig_key_copy(req->key, &remote->key) != KNOT_EOK) {
+			free(req->key);
+			req->key = NULL;
+			knot_dname_free(req->zone, NULL);
+			free(req);
+			return KNOT_ENOMEM;
+		}
+	}
+	tsig_init(&req->tsig, req->key);
+	if (edns != NULL) {
+		req->edns = *edns;
+		req->use_edns = true;
+	}
+	if (req->zone == NULL) {
+		req_free(req);
+		return KNOT_ENOMEM;
+	}
+
+	pthread_mutex_lock(&probe->lock);
+	if (probe->pending_count >= PROBE_PENDING_MAX) {
+		pthread_mutex_unlock(&probe->lock);
+		req_free(req);
+		return KNOT_EBUSY;
+	}
+	bool first = (probe->pending_count == 0);
+	if (first) {
+		probe->pending_since = time_now();
+	}
+	add_tail(&probe->pending, &req->n);
+	probe->pending_count++;
+	pthread_mutex_unlock(&probe->lock);
+
+	if (first) {
+		wake_up(probe);
+	}
+
+	return KNOT_EOK;
+}
+
+void soa_probe_stats(soa_probe_t *probe, uint64_t *queries, uint64_t *batches)
+{
+	*queries = (probe != NULL) ? ATOMIC_GET(probe->queries) : 0;
+	*batches = (probe != NULL) ? ATOMIC_GET(probe->batches) : 0;
+}
+
+void soa_probe_free(soa_probe_t *probe)
+{
+	if (probe == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&probe->lock);
+	probe->stop = true;
+	pthread_mutex_unlock(&probe->lock);
+	wake_up(probe);
+
+	pthread_join(probe->thread, NULL);
+
+	probe_free(probe);
+}
@@ -0,0 +1,91 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "knot/conf/conf.h"
+#include "knot/query/query.h"
+
+/*!
+ * \brief Batched SOA queries to the masters.
+ *
+ * The probes submitted within a batching window are sent together over
+ * one UDP socket per address family and source address, opened anew for
+ * each batch to randomize the source port. A single thread matches the
+ * responses to the probes by the socket, the message ID, the remote
+ * address and the question, and reports the results via a callback.
+ */
+typedef struct soa_probe soa_probe_t;
+
+/*! \brief Result of a probe. */
+typedef struct {
+	int ret;                        //!< KNOT_EOK if the remote serial is known.
+	uint32_t serial;                //!< Remote SOA serial.
+	struct sockaddr_storage remote; //!< Probed remote.
+} soa_probe_result_t;
+
+/*!
+ * \brief Probe result callback, called from the probing thread.
+ */
+typedef void (*soa_probe_cb_t)(const knot_dname_t *zone,
+                               const soa_probe_result_t *result, void *ctx);
+
+/*!
+ * \brief Create the probing context and start its thread.
+ *
+ * \param cb      Result callback.
+ * \param ctx     Callback context.
+ * \param probe   Output: new probing context.
+ *
+ * \return KNOT_E*
+ */
+int soa_probe_new(soa_probe_cb_t cb, void *ctx, soa_probe_t **probe);
+
+/*!
+ * \brief Set the batching window and the response timeout.
+ */
+void soa_probe_set(soa_probe_t *probe, unsigned window_ms, unsigned timeout_ms);
+
+/*!
+ * \brief Submit a SOA query for a zone.
+ *
+ * \param probe    Probing context.
+ * \param zone     Zone name.
+ * \param remote   Master to query.
+ * \param edns     EDNS parameters (NULL to not use EDNS).
+ *
+ * \retval KNOT_EOK    The result will be reported via the callback.
+ * \retval KNOT_EBUSY  Too many probes pending, query the master directly.
+ * \return KNOT_E*
+ */
+int soa_probe_submit(soa_probe_t *probe, const knot_dname_t *zone,
+                     const conf_remote_t *remote, const struct query_edns_data *edns);
+
+/*!
+ * \brief Get the probing statistics.
+ *
+ * \param probe     Probing context.
+ * \param queries   Output: number of sent queries.
+ * \param batches   Output: number of sent batches.
+ */
+void soa_probe_stats(soa_probe_t *probe, uint64_t *queries, uint64_t *batches);
+
+/*!
+ * \brief Stop the probing thread and free the context.
+ *
+ * \note The results of unfinished probes are not reported.
+ */
+void soa_probe_free(soa_probe_t *probe);
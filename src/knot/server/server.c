@@ -20,6 +20,7 @@
 #include <sys/types.h>   // OpenBSD
 #include <netinet/tcp.h> // TCP_FASTOPEN
 #include <sys/resource.h>
+#include <urcu.h>
 
 #include "libknot/libknot.h"
 #include "libknot/yparser/ypschema.h"
@@ -31,6 +32,7 @@
 #include "knot/conf/migration.h"
 #include "knot/conf/module.h"
 #include "knot/dnssec/kasp/kasp_db.h"
+#include "knot/events/handlers.h"
 #include "knot/journal/journal_basic.h"
 #include "knot/server/server.h"
 #include "knot/server/udp-handler.h"
@@ -39,6 +41,7 @@
 #include "knot/zone/zonedb-load.h"
 #include "knot/worker/pool.h"
 #include "contrib/conn_pool.h"
+#include "contrib/macros.h"
 #include "contrib/net.h"
 #include "contrib/openbsd/strlcat.h"
 #include "contrib/os.h"
@@ -631,6 +634,8 @@ int server_init(server_t *server, int bg_workers)
 	}
 
 	zone_backups_init(&server->backup_ctxs);
+	cold_zones_init(&server->cold_zones);
+	load_plan_init(&server->load_plan);
 
 	char *catalog_dir = conf_db(conf(), C_CATALOG_DB);
 	conf_val_t catalog_size = conf_db_param(conf(), C_CATALOG_DB_MAX_SIZE);
@@ -641,7 +646,11 @@ int server_init(server_t *server, int bg_workers)
 	char *journal_dir = conf_db(conf(), C_JOURNAL_DB);
 	conf_val_t journal_size = conf_db_param(conf(), C_JOURNAL_DB_MAX_SIZE);
 	conf_val_t journal_mode = conf_db_param(conf(), C_JOURNAL_DB_MODE);
-	knot_lmdb_init(&server->journaldb, journal_dir, conf_int(&journal_size), journal_env_flags(conf_opt(&journal_mode), false), NULL);
+	conf_val_t journal_shards = conf_db_param(conf(), C_JOURNAL_DB_SHARDS);
+	journal_shards_init(&server->journaldb, journal_dir, conf_int(&journal_shards),
+	                    conf_int(&journal_size), journal_env_flags(conf_opt(&journal_mode), false));
+	conf_val_t journal_window = conf_db_param(conf(), C_JOURNAL_DB_GROUP_WINDOW);
+	journal_shards_set_group_window(&server->journaldb, conf_int(&journal_window));
 	free(journal_dir);
 
 	kasp_db_ensure_init(&server->kaspdb, conf());
@@ -677,9 +686,13 @@ void server_deinit(server_t *server)
 
 	/* Free threads and event handlers. */
 	worker_pool_destroy(server->workers);
+	soa_probe_free(server->soa_probe);
 
 	/* Free zone database. */
 	knot_zonedb_deep_free(&server->zone_db, true);
+	cold_zones_deinit(&server->cold_zones);
+	load_plan_deinit(&server->load_plan);
+	nsec3_caches_deinit(&server->nsec3_caches);
 
 	/* Free remaining events. */
 	evsched_deinit(&server->sched);
@@ -696,7 +709,7 @@ void server_deinit(server_t *server)
 	knot_lmdb_deinit(&server->kaspdb);
 
 	/* Close journal database if open. */
-	knot_lmdb_deinit(&server->journaldb);
+	journal_shards_deinit(&server->journaldb);
 
 	/* Close and deinit connection pool. */
 	conn_pool_deinit(global_conn_pool);
@@ -749,8 +762,10 @@ static void server_free_handler(iohandler_t *h)
 	free(h->thread_id);
 }
 
-static void worker_wait_cb(worker_pool_t *pool)
+static void worker_wait_cb(worker_pool_t *pool, void *ctx)
 {
+	server_t *server = ctx;
+
 	systemd_zone_load_timeout_notify();
 
 	static uint64_t last_ns = 0;
@@ -758,9 +773,17 @@ static void worker_wait_cb(worker_pool_t *pool)
 	uint64_t now_ns = 1000000000 * now.tv_sec + now.tv_nsec;
 	/* Too frequent worker_pool_status() call with many zones is expensive. */
 	if (now_ns - last_ns > 1000000000) {
-		int running, queued;
-		worker_pool_status(pool, true, &running, &queued);
-		systemd_tasks_status_notify(running + queued);
+		load_progress_t progress;
+		load_plan_progress(&server->load_plan, &progress);
+		if (progress.zones_done < progress.zones_total) {
+			systemd_loading_status_notify(progress.zones_done,
+			                              progress.zones_total,
+			                              progress.eta);
+		} else {
+			int running, queued;
+			worker_pool_status(pool, true, &running, &queued);
+			systemd_tasks_status_notify(running + queued);
+		}
 		last_ns = now_ns;
 	}
 }
@@ -776,7 +799,7 @@ int server_start(server_t *server, bool async)
 
 	/* Wait for enqueued events if not asynchronous. */
 	if (!async) {
-		worker_pool_wait_cb(server->workers, worker_wait_cb);
+		worker_pool_wait_cb(server->workers, worker_wait_cb, server);
 		systemd_tasks_status_notify(0);
 	}
 
@@ -1106,7 +1129,14 @@ static int configure_threads(conf_t *conf, server_t *server)
 		}
 	}
 
-	return set_handler(server, IO_TCP, conf->cache.srv_tcp_threads, tcp_master);
+	ret = set_handler(server, IO_TCP, conf->cache.srv_tcp_threads, tcp_master);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	unsigned threads = conf->cache.srv_udp_threads + conf->cache.srv_xdp_threads +
+	                   conf->cache.srv_tcp_threads;
+	return nsec3_caches_init(&server->nsec3_caches, threads);
 }
 
 static int reconfigure_journal_db(conf_t *conf, server_t *server)
@@ -1114,13 +1144,30 @@ static int reconfigure_journal_db(conf_t *conf, server_t *server)
 	char *journal_dir = conf_db(conf, C_JOURNAL_DB);
 	conf_val_t journal_size = conf_db_param(conf, C_JOURNAL_DB_MAX_SIZE);
 	conf_val_t journal_mode = conf_db_param(conf, C_JOURNAL_DB_MODE);
-	int ret = knot_lmdb_reinit(&server->journaldb, journal_dir, conf_int(&journal_size),
-	                           journal_env_flags(conf_opt(&journal_mode), false));
+	conf_val_t journal_shards = conf_db_param(conf, C_JOURNAL_DB_SHARDS);
+	int ret = journal_shards_reinit(&server->journaldb, journal_dir, conf_int(&journal_shards),
+	                                conf_int(&journal_size),
+	                                journal_env_flags(conf_opt(&journal_mode), false));
 	if (ret != KNOT_EOK) {
 		log_warning("ignored reconfiguration of journal DB (%s)", knot_strerror(ret));
 	}
 	free(journal_dir);
 
+	conf_val_t journal_window = conf_db_param(conf, C_JOURNAL_DB_GROUP_WINDOW);
+	journal_shards_set_group_window(&server->journaldb, conf_int(&journal_window));
+
+	/* Move the zone journals if the number of shards has changed. */
+	if (!(server->state & ServerRunning)) {
+		size_t moved = 0;
+		ret = journal_shards_migrate(&server->journaldb, &moved);
+		if (ret != KNOT_EOK) {
+			log_error("failed to migrate journal DB shards (%s)", knot_strerror(ret));
+		} else if (moved > 0) {
+			log_info("journal DB, migrated %zu zones to %u shards",
+			         moved, server->journaldb.count);
+		}
+	}
+
 	return KNOT_EOK; // not "ret"
 }
 
@@ -1165,6 +1212,39 @@ static int reconfigure_remote_pool(conf_t *conf)
 	return KNOT_EOK;
 }
 
+static void soa_probe_done(const knot_dname_t *zone_name,
+                           const soa_probe_result_t *result, void *ctx)
+{
+	server_t *server = ctx;
+
+	rcu_read_lock();
+	zone_t *zone = knot_zonedb_find(server->zone_db, zone_name);
+	if (zone != NULL) {
+		event_refresh_probed(zone, result);
+	}
+	rcu_read_unlock();
+}
+
+static int reconfigure_soa_probe(conf_t *conf, server_t *server)
+{
+	int window = conf->cache.srv_rmt_probe_window;
+	if (server->soa_probe == NULL) {
+		if (window == 0) {
+			return KNOT_EOK;
+		}
+		int ret = soa_probe_new(soa_probe_done, server, &server->soa_probe);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	// The thread is kept once started, refreshes stop using it if disabled.
+	int timeout = conf->cache.srv_tcp_remote_io_timeout;
+	soa_probe_set(server->soa_probe, window, MAX(timeout, 0));
+
+	return KNOT_EOK;
+}
+
 int server_reconfigure(conf_t *conf, server_t *server)
 {
 	if (conf == NULL || server == NULL) {
@@ -1227,6 +1307,12 @@ int server_reconfigure(conf_t *conf, server_t *server)
 		          knot_strerror(ret));
 	}
 
+	/* Reconfigure SOA probing. */
+	if ((ret = reconfigure_soa_probe(conf, server)) != KNOT_EOK) {
+		log_error("failed to reconfigure SOA probing (%s)",
+		          knot_strerror(ret));
+	}
+
 	return KNOT_EOK;
 }
 
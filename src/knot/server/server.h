@@ -20,10 +20,15 @@
 #include "knot/catalog/catalog_update.h"
 #include "knot/common/evsched.h"
 #include "knot/common/fdset.h"
+#include "knot/dnssec/nsec3-cache.h"
+#include "knot/journal/journal_shards.h"
 #include "knot/journal/knot_lmdb.h"
+#include "knot/query/soa_probe.h"
 #include "knot/server/dthreads.h"
 #include "knot/worker/pool.h"
 #include "knot/zone/backup.h"
+#include "knot/zone/cold.h"
+#include "knot/zone/load-plan.h"
 #include "knot/zone/zonedb.h"
 
 struct server;
@@ -82,7 +87,7 @@ typedef struct server {
 
 	knot_zonedb_t *zone_db;
 	knot_lmdb_db_t timerdb;
-	knot_lmdb_db_t journaldb;
+	journal_shards_t journaldb;
 	knot_lmdb_db_t kaspdb;
 	catalog_t catalog;
 
@@ -107,6 +112,18 @@ typedef struct server {
 
 	/*! \brief Context of pending zones' backup. */
 	zone_backup_ctxs_t backup_ctxs;
+
+	/*! \brief Loaded contents of cold zones. */
+	cold_zones_t cold_zones;
+
+	/*! \brief Initial loading of new zones. */
+	load_plan_t load_plan;
+
+	/*! \brief Per-thread caches of NSEC3 hashes for negative answers. */
+	nsec3_caches_t nsec3_caches;
+
+	/*! \brief Batched SOA queries of zone refreshes (NULL unless enabled). */
+	soa_probe_t *soa_probe;
 } server_t;
 
 /*!
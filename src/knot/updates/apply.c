@@ -17,6 +17,7 @@
 #include <assert.h>
 
 #include "knot/common/log.h"
+#include "knot/nameserver/xfr_cache.h"
 #include "knot/updates/apply.h"
 #include "libknot/libknot.h"
 #include "contrib/macros.h"
@@ -51,8 +52,9 @@ static int replace_rdataset_with_copy(zone_node_t *node, uint16_t type)
 
 	memcpy(copy, rrs->rdata, rrs->size);
 
-	// Store new data into node RRS.
+	// Store new data into node RRS, the interned data stay with the counterpart.
 	rrs->rdata = copy;
+	data->interned = false;
 
 	return KNOT_EOK;
 }
@@ -60,9 +62,12 @@ static int replace_rdataset_with_copy(zone_node_t *node, uint16_t type)
 /*! \brief Frees RR dataset. For use when a copy was made. */
 static void clear_new_rrs(zone_node_t *node, uint16_t type)
 {
-	knot_rdataset_t *new_rrs = node_rdataset(node, type);
-	if (new_rrs) {
-		knot_rdataset_clear(new_rrs, NULL);
+	for (uint16_t i = 0; i < node->rrset_count; ++i) {
+		struct rr_data *data = &node->rrs[i];
+		if (data->type == type && !data->interned) {
+			knot_rdataset_clear(&data->rrs, NULL);
+			return;
+		}
 	}
 }
 
@@ -349,6 +354,7 @@ void apply_rollback(apply_ctx_t *ctx)
 	free(ctx->contents->nsec3_nodes);
 
 	dnssec_nsec3_params_free(&ctx->contents->nsec3_params);
+	rdata_store_unref(ctx->contents->rdata_store);
 
 	free(ctx->contents);
 
@@ -374,6 +380,8 @@ void update_free_zone(zone_contents_t *contents)
 	free(contents->nsec3_nodes);
 
 	dnssec_nsec3_params_free(&contents->nsec3_params);
+	rdata_store_unref(contents->rdata_store);
+	xfr_cache_entry_unref(contents->axfr_wire);
 
 	free(contents);
 }
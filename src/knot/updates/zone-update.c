@@ -16,6 +16,7 @@
 
 #include "knot/catalog/interpret.h"
 #include "knot/common/log.h"
+#include "knot/dnssec/rrsig-index.h"
 #include "knot/dnssec/zone-events.h"
 #include "knot/updates/zone-update.h"
 #include "knot/zone/adds_tree.h"
@@ -24,6 +25,7 @@
 #include "knot/zone/serial.h"
 #include "knot/zone/zone-diff.h"
 #include "knot/zone/zonefile.h"
+#include "contrib/time.h"
 #include "contrib/trim.h"
 #include "contrib/ucw/lists.h"
 
@@ -400,6 +402,7 @@ void zone_update_clear(zone_update_t *update)
 	}
 
 	free(update->a_ctx);
+	zone_digest_cache_free(update->digest_cache);
 	memset(update, 0, sizeof(*update));
 }
 
@@ -844,7 +847,7 @@ int zone_update_semcheck(zone_update_t *update)
 	};
 
 	ret = sem_checks_process(update->new_cont, SEMCHECK_MANDATORY_ONLY,
-	                         &handler, time(NULL));
+	                         &handler, time(NULL), 1);
 	if (ret != KNOT_EOK) {
 		// error is logged by the error handler
 		return ret;
@@ -860,7 +863,14 @@ int zone_update_verify_digest(conf_t *conf, zone_update_t *update)
 		return KNOT_EOK;
 	}
 
-	int ret = zone_contents_digest_verify(update->new_cont);
+	conf_val_t thr = conf_zone_get(conf, C_ADJUST_THR, update->zone->name);
+	struct timespec begin = time_now();
+	int ret = zone_contents_digest_verify(update->new_cont, conf_int(&thr));
+	struct timespec end = time_now();
+	if (ret != KNOT_ENOENT && ret != KNOT_ENOTSUP) {
+		update->zone->digest.duration = time_diff_ms(&begin, &end);
+		update->zone->digest.computed = true;
+	}
 	if (ret != KNOT_EOK) {
 		log_zone_error(update->zone->name, "ZONEMD, verification failed (%s)",
 		               knot_strerror(ret));
@@ -871,6 +881,26 @@ int zone_update_verify_digest(conf_t *conf, zone_update_t *update)
 	return ret;
 }
 
+static void update_rrsig_index(zone_update_t *update, zone_contents_t *contents)
+{
+	rrsig_index_t *index = update->zone->rrsig_index;
+	if (index == NULL) {
+		return;
+	}
+
+	int ret;
+	if ((update->flags & (UPDATE_FULL | UPDATE_HYBRID)) || update->rrsig_index_id != 0) {
+		ret = rrsig_index_update(index, contents, NULL, NULL, update->rrsig_index_id);
+	} else {
+		ret = rrsig_index_update(index, contents, update->a_ctx->node_ptrs,
+		                         update->a_ctx->nsec3_ptrs, 0);
+	}
+	if (ret != KNOT_EOK) {
+		log_zone_warning(update->zone->name, "DNSSEC, failed to update "
+		                 "RRSIG index (%s)", knot_strerror(ret));
+	}
+}
+
 int zone_update_commit(conf_t *conf, zone_update_t *update)
 {
 	if (conf == NULL || update == NULL) {
@@ -880,6 +910,9 @@ int zone_update_commit(conf_t *conf, zone_update_t *update)
 	int ret = KNOT_EOK;
 
 	if ((update->flags & UPDATE_INCREMENTAL) && changeset_empty(&update->change)) {
+		if (update->rrsig_index_id != 0) {
+			update_rrsig_index(update, update->zone->contents);
+		}
 		zone_update_clear(update);
 		return KNOT_EOK;
 	}
@@ -896,6 +929,16 @@ int zone_update_commit(conf_t *conf, zone_update_t *update)
 	conf_val_t val = conf_zone_get(conf, C_DNSSEC_SIGNING, update->zone->name);
 	bool dnssec = conf_bool(&val);
 
+	val = conf_zone_get(conf, C_RDATA_DEDUP, update->zone->name);
+	if (conf_bool(&val)) {
+		zone_tree_t *changed = (update->flags & (UPDATE_HYBRID | UPDATE_FULL)) ?
+		                       NULL : update->a_ctx->node_ptrs;
+		ret = zone_contents_intern_rdata(update->new_cont, changed);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
 	conf_val_t thr = conf_zone_get(conf, C_ADJUST_THR, update->zone->name);
 	if ((update->flags & (UPDATE_HYBRID | UPDATE_FULL))) {
 		ret = zone_adjust_full(update->new_cont, conf_int(&thr));
@@ -961,10 +1004,22 @@ int zone_update_commit(conf_t *conf, zone_update_t *update)
 		}
 	}
 
+	update_rrsig_index(update, update->new_cont);
+
+	/* Relayout the new full contents for lookups, it's optional. */
+	if (update->flags & UPDATE_FULL) {
+		(void)zone_contents_freeze(update->new_cont);
+	}
+
 	/* Switch zone contents. */
 	zone_contents_t *old_contents;
 	old_contents = zone_switch_contents(update->zone, update->new_cont);
 
+	/* Keep the page hashes of the new contents, drop the outdated ones. */
+	zone_digest_cache_free(update->zone->digest.cache);
+	update->zone->digest.cache = update->digest_cache;
+	update->digest_cache = NULL;
+
 	if (update->flags & (UPDATE_INCREMENTAL | UPDATE_HYBRID)) {
 		changeset_clear(&update->change);
 		changeset_clear(&update->extra_ch);
@@ -38,6 +38,9 @@ typedef struct zone_update {
 	apply_ctx_t *a_ctx;          /*!< Context for applying changesets. */
 	uint32_t flags;              /*!< Zone update flags. */
 	dnssec_validation_hint_t validation_hint;
+	uint64_t rrsig_index_id;     /*!< Signing setup ID if the whole zone was signed. */
+	struct zone_digest_cache *digest_cache; /*!< Page hashes of the new contents (Merkle ZONEMD). */
+	sign_stats_t *sign_stats;    /*!< Statistics of the signing in progress or NULL. */
 } zone_update_t;
 
 typedef struct {
@@ -23,7 +23,7 @@
 struct worker_pool;
 typedef struct worker_pool worker_pool_t;
 
-typedef void(*wait_callback_t)(worker_pool_t *);
+typedef void(*wait_callback_t)(worker_pool_t *, void *);
 
 /*!
  * \brief Initialize worker pool.
@@ -71,9 +71,9 @@ void worker_pool_wait(worker_pool_t *pool);
 
 /*!
  * \brief Wait till the number of pending tasks is zero. Callback emitted on
- *  thread wakeup can be specified.
+ *  thread wakeup can be specified, together with its context.
  */
-void worker_pool_wait_cb(worker_pool_t *pool, wait_callback_t cb);
+void worker_pool_wait_cb(worker_pool_t *pool, wait_callback_t cb, void *ctx);
 
 /*!
  * \brief Assign a task to be performed by a worker in the pool.
@@ -34,6 +34,7 @@
 #include "knot/dnssec/kasp/kasp_zone.h"
 #include "knot/dnssec/kasp/keystore.h"
 #include "knot/journal/journal_metadata.h"
+#include "knot/nameserver/xfr_cache.h"
 #include "knot/zone/backup_dir.h"
 #include "knot/zone/zonefile.h"
 #include "libdnssec/error.h"
@@ -321,7 +322,7 @@ static int backup_keystore(conf_t *conf, zone_t *zone, zone_backup_ctx_t *ctx)
 	conf_val_t policy_id = get_zone_policy(conf, zone->name);
 
 	unsigned backend_type = 0;
-	int ret = zone_init_keystore(conf, &policy_id, &from, &backend_type);
+	int ret = zone_init_keystore(conf, &policy_id, &from, &backend_type, NULL);
 	if (ret != KNOT_EOK) {
 		LOG_FAIL("keystore init");
 		return ret;
@@ -412,6 +413,7 @@ int zone_backup(conf_t *conf, zone_t *zone)
 
 		ret = journal_copy_with_md(j_from, j_to, zone->name);
 	} else if (ctx->restore_mode) {
+		xfr_cache_clear(zone->xfr_cache);
 		ret = journal_scrape_with_md(zone_journal(zone), true);
 	}
 	if (ret != KNOT_EOK) {
@@ -0,0 +1,250 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "knot/zone/cold.h"
+#include "knot/server/server.h"
+#include "knot/zone/zone.h"
+
+#ifdef HAVE_ATOMIC
+#define ATOMIC_SET(dst, val)  __atomic_store_n(&(dst), (val), __ATOMIC_RELAXED)
+#define ATOMIC_GET(src)       __atomic_load_n(&(src), __ATOMIC_RELAXED)
+#define ATOMIC_XCHG(dst, val) __atomic_exchange_n(&(dst), (val), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_SET(dst, val)  ((dst) = (val))
+#define ATOMIC_GET(src)       (src)
+#define ATOMIC_XCHG(dst, val) __sync_lock_test_and_set(&(dst), (val))
+#endif
+
+static zone_t *cold_zone(node_t *n)
+{
+	return (zone_t *)((uint8_t *)n - offsetof(zone_t, cold.n));
+}
+
+static void account(cold_zones_t *cold, zone_t *zone)
+{
+	assert(zone->contents != NULL);
+
+	if (zone->cold.accounted) {
+		cold->size -= zone->cold.size;
+	} else {
+		add_tail(&cold->zones, &zone->cold.n);
+		cold->count++;
+		zone->cold.accounted = true;
+		ATOMIC_SET(zone->cold.referenced, false);
+	}
+
+	zone->cold.size = zone->contents->size;
+	cold->size += zone->cold.size;
+}
+
+static void unaccount(cold_zones_t *cold, zone_t *zone)
+{
+	if (!zone->cold.accounted) {
+		return;
+	}
+
+	rem_node(&zone->cold.n);
+	cold->count--;
+	cold->size -= zone->cold.size;
+	zone->cold.size = 0;
+	zone->cold.accounted = false;
+}
+
+void cold_zones_init(cold_zones_t *cold)
+{
+	init_list(&cold->zones);
+	cold->count = 0;
+	cold->size = 0;
+	pthread_mutex_init(&cold->mutex, NULL);
+}
+
+void cold_zones_deinit(cold_zones_t *cold)
+{
+	assert(EMPTY_LIST(cold->zones));
+	pthread_mutex_destroy(&cold->mutex);
+}
+
+bool zone_cold_configured(conf_t *conf, const knot_dname_t *zone_name)
+{
+	conf_val_t val = conf_zone_get(conf, C_COLD_LOAD, zone_name);
+	if (!conf_bool(&val)) {
+		return false;
+	}
+
+	// Catalog zones must be loaded to be interpreted or generated.
+	val = conf_zone_get(conf, C_CATALOG_ROLE, zone_name);
+	unsigned role = conf_opt(&val);
+	return (role != CATALOG_ROLE_INTERPRET && role != CATALOG_ROLE_GENERATE);
+}
+
+void zone_cold_mark_evicted(zone_t *zone)
+{
+	ATOMIC_SET(zone->cold.load_planned, false);
+	ATOMIC_SET(zone->cold.evicted, true);
+}
+
+void zone_cold_touch(const zone_t *const_zone)
+{
+	if (!const_zone->cold.enabled) {
+		return;
+	}
+
+	// Only the access flags are modified and the load planned.
+	zone_t *zone = (zone_t *)const_zone;
+
+	if (!ATOMIC_GET(zone->cold.referenced)) {
+		ATOMIC_SET(zone->cold.referenced, true);
+	}
+
+	// The query gets SERVFAIL until the contents are loaded. Only the first
+	// query takes the events lock to plan the load.
+	if (ATOMIC_GET(zone->cold.evicted) && !ATOMIC_GET(zone->cold.load_planned) &&
+	    !ATOMIC_XCHG(zone->cold.load_planned, true)) {
+		zone_events_schedule_now(zone, ZONE_EVENT_LOAD);
+	}
+}
+
+bool zone_cold_load_needed(zone_t *zone, zone_event_type_t type)
+{
+	if (!zone->cold.enabled || !ATOMIC_GET(zone->cold.evicted)) {
+		return false;
+	}
+
+	switch (type) {
+	case ZONE_EVENT_FLUSH:
+	case ZONE_EVENT_UFREEZE:
+	case ZONE_EVENT_UTHAW:
+	case ZONE_EVENT_EVICT:
+		return false;
+	case ZONE_EVENT_EXPIRE: // Don't resurrect expired contents.
+		ATOMIC_SET(zone->cold.evicted, false);
+		return false;
+	case ZONE_EVENT_LOAD:
+		return false;
+	default:
+		return true;
+	}
+}
+
+void zone_cold_update(conf_t *conf, zone_t *zone, bool evict)
+{
+	if (!zone->cold.enabled) {
+		return;
+	}
+
+	// Still evicted if the load failed, the next query plans it again.
+	if (zone->contents != NULL) {
+		ATOMIC_SET(zone->cold.evicted, false);
+	} else if (ATOMIC_GET(zone->cold.evicted)) {
+		ATOMIC_SET(zone->cold.load_planned, false);
+	}
+
+	if (zone->server == NULL) {
+		return;
+	}
+
+	cold_zones_t *cold = &zone->server->cold_zones;
+
+	conf_val_t val = conf_get(conf, C_SRV, C_COLD_ZONES_MAX_SIZE);
+	size_t max_size = conf_int(&val);
+
+	pthread_mutex_lock(&cold->mutex);
+
+	if (zone->contents == NULL) {
+		unaccount(cold, zone);
+		pthread_mutex_unlock(&cold->mutex);
+		return;
+	}
+
+	account(cold, zone);
+
+	// Every zone gets a second chance if referenced since the last scan.
+	size_t limit = 2 * cold->count;
+	while (evict && cold->size > max_size && limit-- > 0) {
+		zone_t *victim = cold_zone(HEAD(cold->zones));
+		if (victim == zone || ATOMIC_GET(victim->cold.referenced)) {
+			ATOMIC_SET(victim->cold.referenced, false);
+			rem_node(&victim->cold.n);
+			add_tail(&cold->zones, &victim->cold.n);
+			continue;
+		}
+
+		// Accounted again after the event if the eviction isn't possible.
+		unaccount(cold, victim);
+		zone_events_schedule_now(victim, ZONE_EVENT_EVICT);
+	}
+
+	pthread_mutex_unlock(&cold->mutex);
+}
+
+void zone_cold_takeover(zone_t *zone, zone_t *old_zone)
+{
+	if (zone->server == NULL) {
+		return;
+	}
+
+	cold_zones_t *cold = &zone->server->cold_zones;
+
+	pthread_mutex_lock(&cold->mutex);
+	unaccount(cold, old_zone);
+	if (zone->cold.enabled && zone->contents != NULL) {
+		account(cold, zone);
+	}
+	pthread_mutex_unlock(&cold->mutex);
+}
+
+void zone_cold_forget(zone_t *zone)
+{
+	if (zone->server == NULL) {
+		return;
+	}
+
+	cold_zones_t *cold = &zone->server->cold_zones;
+
+	pthread_mutex_lock(&cold->mutex);
+	unaccount(cold, zone);
+	pthread_mutex_unlock(&cold->mutex);
+}
+
+bool zone_cold_evictable(conf_t *conf, zone_t *zone)
+{
+	if (zone->contents == NULL || zone->control_update != NULL ||
+	    zone->backup_ctx != NULL || zone->ddns_queue_size > 0 ||
+	    zone_get_flag(zone, ZONE_IS_CATALOG, false)) {
+		return false;
+	}
+
+	conf_val_t val = conf_zone_get(conf, C_JOURNAL_CONTENT, zone->name);
+	unsigned journal_content = conf_opt(&val);
+	val = conf_zone_get(conf, C_ZONEFILE_LOAD, zone->name);
+	unsigned zf_from = conf_opt(&val);
+
+	// Complete zone is loaded from zone-in-journal.
+	if (journal_content == JOURNAL_CONTENT_ALL && zf_from != ZONEFILE_LOAD_WHOLE) {
+		return true;
+	}
+
+	// Otherwise the zone file is needed, possibly with journal changes.
+	if (zf_from == ZONEFILE_LOAD_NONE || !zone->zonefile.exists) {
+		return false;
+	}
+
+	return (journal_content != JOURNAL_CONTENT_NONE ||
+	        zone->zonefile.serial == zone_contents_serial(zone->contents));
+}
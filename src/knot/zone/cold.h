@@ -0,0 +1,103 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include "contrib/ucw/lists.h"
+#include "knot/conf/conf.h"
+#include "knot/events/events.h"
+
+struct zone;
+
+/*!
+ * \brief Loaded contents of cold zones.
+ *
+ * Cold zones are registered in the zone database without contents, which are
+ * loaded on the first query or zone event. Loaded cold zones are kept in
+ * a list ordered by the time of loading and, when their total size exceeds
+ * the configured limit, the least recently used ones are evicted again
+ * (second-chance approximation of LRU).
+ */
+typedef struct {
+	list_t zones;          /*!< Loaded cold zones. */
+	size_t count;          /*!< Number of the loaded cold zones. */
+	size_t size;           /*!< Total size of the loaded cold zones contents. */
+	pthread_mutex_t mutex;
+} cold_zones_t;
+
+void cold_zones_init(cold_zones_t *cold);
+void cold_zones_deinit(cold_zones_t *cold);
+
+/*!
+ * \brief Check if the zone is to be configured as cold.
+ */
+bool zone_cold_configured(conf_t *conf, const knot_dname_t *zone_name);
+
+/*!
+ * \brief Mark cold zone contents as not loaded, to be loaded on demand.
+ */
+void zone_cold_mark_evicted(struct zone *zone);
+
+/*!
+ * \brief Note an access to the zone by a query, plan zone load if evicted.
+ *
+ * \note Called from query processing, doesn't block. Only the first query
+ *       after eviction (or after a failed load) takes the zone events lock.
+ */
+void zone_cold_touch(const struct zone *zone);
+
+/*!
+ * \brief Check if evicted contents must be loaded before running the event.
+ *
+ * \param zone  Zone the event is to be run for.
+ * \param type  Type of the event.
+ *
+ * \retval true   if the contents must be loaded first.
+ */
+bool zone_cold_load_needed(struct zone *zone, zone_event_type_t type);
+
+/*!
+ * \brief Update accounting of cold zone contents after a zone event.
+ *
+ * The zone stays marked as evicted until its contents are loaded.
+ *
+ * If the total size of loaded cold zones exceeds the configured limit,
+ * eviction of least recently used zones (not this one) is planned.
+ *
+ * \param conf   Configuration.
+ * \param zone   Zone after the event.
+ * \param evict  Allow planning of eviction of other zones.
+ */
+void zone_cold_update(conf_t *conf, struct zone *zone, bool evict);
+
+/*!
+ * \brief Move accounting of shared contents from the old zone to the new one.
+ */
+void zone_cold_takeover(struct zone *zone, struct zone *old_zone);
+
+/*!
+ * \brief Remove the zone from the accounting (before eviction or zone free).
+ */
+void zone_cold_forget(struct zone *zone);
+
+/*!
+ * \brief Check if the zone contents can be dropped and loaded again later.
+ *
+ * The zone must be restorable without loss from the zone file and/or journal.
+ */
+bool zone_cold_evictable(conf_t *conf, struct zone *zone);
@@ -21,7 +21,9 @@
 #include "knot/zone/adjust.h"
 #include "knot/zone/contents.h"
 #include "knot/common/log.h"
+#include "knot/dnssec/nsec3-cache.h"
 #include "knot/dnssec/zone-nsec.h"
+#include "knot/nameserver/xfr_cache.h"
 #include "libknot/libknot.h"
 #include "contrib/qp-trie/trie.h"
 
@@ -206,11 +208,54 @@ zone_tree_t *zone_contents_tree_for_rr(zone_contents_t *contents, const knot_rrs
 			return NULL;
 		}
 		contents->nsec3_nodes->flags = contents->nodes->flags;
+		if (contents->nodes->bulk != NULL) {
+			(void)zone_tree_bulk_begin(contents->nsec3_nodes);
+		}
 	}
 
 	return nsec3rel ? contents->nsec3_nodes : contents->nodes;
 }
 
+int zone_contents_bulk_begin(zone_contents_t *z)
+{
+	if (z == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = zone_tree_bulk_begin(z->nodes);
+	if (ret == KNOT_EOK && z->nsec3_nodes != NULL) {
+		ret = zone_tree_bulk_begin(z->nsec3_nodes);
+	}
+
+	return ret;
+}
+
+int zone_contents_bulk_end(zone_contents_t *z)
+{
+	if (z == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = zone_tree_bulk_end(z->nodes);
+	int ret_nsec3 = zone_tree_bulk_end(z->nsec3_nodes);
+
+	return (ret != KNOT_EOK) ? ret : ret_nsec3;
+}
+
+int zone_contents_freeze(zone_contents_t *z)
+{
+	if (z == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = zone_tree_freeze(z->nodes);
+	if (ret == KNOT_EOK && z->nsec3_nodes != NULL) {
+		ret = zone_tree_freeze(z->nsec3_nodes);
+	}
+
+	return ret;
+}
+
 int zone_contents_add_rr(zone_contents_t *z, const knot_rrset_t *rr, zone_node_t **n)
 {
 	if (rr == NULL || n == NULL) {
@@ -347,6 +392,7 @@ const zone_node_t *zone_contents_find_nsec3_node(const zone_contents_t *zone,
 
 int zone_contents_find_nsec3_for_name(const zone_contents_t *zone,
                                       const knot_dname_t *name,
+                                      struct nsec3_cache *cache,
                                       const zone_node_t **nsec3_node,
                                       const zone_node_t **nsec3_previous)
 {
@@ -367,8 +413,8 @@ int zone_contents_find_nsec3_for_name(const zone_contents_t *zone,
 	}
 
 	knot_dname_storage_t nsec3_name;
-	int ret = knot_create_nsec3_owner(nsec3_name, sizeof(nsec3_name),
-	                                  name, zone->apex->owner, &zone->nsec3_params);
+	int ret = nsec3_cache_owner(cache, nsec3_name, name, zone->apex->owner,
+	                            &zone->nsec3_params);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
@@ -494,6 +540,7 @@ int zone_contents_cow(zone_contents_t *from, zone_contents_t **to)
 	}
 	contents->adds_tree = from->adds_tree;
 	from->adds_tree = NULL;
+	contents->rdata_store = rdata_store_ref(from->rdata_store);
 	contents->size = from->size;
 	contents->max_ttl = from->max_ttl;
 
@@ -501,6 +548,29 @@ int zone_contents_cow(zone_contents_t *from, zone_contents_t **to)
 	return KNOT_EOK;
 }
 
+static int intern_node_cb(zone_node_t *node, void *data)
+{
+	return node_intern_rrsets(node, data);
+}
+
+int zone_contents_intern_rdata(zone_contents_t *contents, zone_tree_t *nodes)
+{
+	if (contents == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (contents->rdata_store == NULL) {
+		contents->rdata_store = rdata_store_new();
+		if (contents->rdata_store == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	// NSEC3 nodes hold only unique data, not worth sharing.
+	return zone_tree_apply(nodes != NULL ? nodes : contents->nodes,
+	                       intern_node_cb, contents->rdata_store);
+}
+
 void zone_contents_free(zone_contents_t *contents)
 {
 	if (contents == NULL) {
@@ -513,6 +583,8 @@ void zone_contents_free(zone_contents_t *contents)
 
 	dnssec_nsec3_params_free(&contents->nsec3_params);
 	additionals_tree_free(contents->adds_tree);
+	rdata_store_unref(contents->rdata_store);
+	xfr_cache_entry_unref(contents->axfr_wire);
 
 	free(contents);
 }
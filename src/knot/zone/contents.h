@@ -21,6 +21,9 @@
 #include "knot/zone/node.h"
 #include "knot/zone/zone-tree.h"
 
+struct nsec3_cache;
+struct xfr_cache_entry;
+
 enum zone_contents_find_dname_result {
 	ZONE_NAME_NOT_FOUND = 0,
 	ZONE_NAME_FOUND     = 1
@@ -33,6 +36,9 @@ typedef struct zone_contents {
 	zone_tree_t *nsec3_nodes;
 
 	trie_t *adds_tree; // "additionals tree" for reverse lookup of nodes affected by additionals
+	rdata_store_t *rdata_store; // shared rdatasets, NULL if deduplication not used
+	struct xfr_cache_entry *axfr_wire; // rendered AXFR of this version, built on first transfer
+	bool axfr_wire_failed; // rendering of the AXFR failed, not to be retried
 
 	dnssec_nsec3_params_t nsec3_params;
 	size_t size;
@@ -55,6 +61,40 @@ zone_contents_t *zone_contents_new(const knot_dname_t *apex_name, bool use_binod
  */
 zone_tree_t *zone_contents_tree_for_rr(zone_contents_t *contents, const knot_rrset_t *rr);
 
+/*!
+ * \brief Start loading of the contents with records in canonical order.
+ *
+ * Loading of sorted records (e.g. zone file dumped by the server, zone-in-journal,
+ * AXFR from most servers) is faster, otherwise it continues as usual.
+ *
+ * \see zone_tree_bulk_begin()
+ *
+ * \param z  Contents to be loaded.
+ *
+ * \return KNOT_E*
+ */
+int zone_contents_bulk_begin(zone_contents_t *z);
+
+/*!
+ * \brief Finish loading of the contents started by zone_contents_bulk_begin().
+ *
+ * \param z  Loaded contents.
+ *
+ * \return KNOT_E*
+ */
+int zone_contents_bulk_end(zone_contents_t *z);
+
+/*!
+ * \brief Relayout the contents trees for faster lookups before publishing.
+ *
+ * \see zone_tree_freeze()
+ *
+ * \param z  Complete contents, not published yet.
+ *
+ * \return KNOT_E*
+ */
+int zone_contents_freeze(zone_contents_t *z);
+
 /*!
  * \brief Add an RR to contents.
  *
@@ -154,6 +194,7 @@ const zone_node_t *zone_contents_find_nsec3_node(const zone_contents_t *contents
  *
  * \param[in] contents Zone to search in.
  * \param[in] name Domain name to get the corresponding NSEC3 nodes for.
+ * \param[in] cache Optional cache of NSEC3 hashes.
  * \param[out] nsec3_node NSEC3 node corresponding to \a name (if found,
  *                        otherwise this may be an arbitrary NSEC3 node).
  * \param[out] nsec3_previous The NSEC3 node immediately preceding hashed domain
@@ -169,6 +210,7 @@ const zone_node_t *zone_contents_find_nsec3_node(const zone_contents_t *contents
  */
 int zone_contents_find_nsec3_for_name(const zone_contents_t *contents,
                                       const knot_dname_t *name,
+                                      struct nsec3_cache *cache,
                                       const zone_node_t **nsec3_node,
                                       const zone_node_t **nsec3_previous);
 
@@ -247,6 +289,18 @@ int zone_contents_nsec3_apply(zone_contents_t *contents,
  */
 int zone_contents_cow(zone_contents_t *from, zone_contents_t **to);
 
+/*!
+ * \brief Shares identical rdatasets among zone nodes through the rdata store.
+ *
+ * The rdata store is created if the contents don't have any yet.
+ *
+ * \param contents  Zone contents.
+ * \param nodes     Tree of nodes to be processed, all zone nodes if NULL.
+ *
+ * \return KNOT_E*
+ */
+int zone_contents_intern_rdata(zone_contents_t *contents, zone_tree_t *nodes);
+
 /*!
  * \brief Deallocate directly owned data of zone contents.
  *
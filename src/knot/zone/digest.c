@@ -16,27 +16,37 @@
 
 #include <stdio.h>
 
+#include <pthread.h>
+
 #include "knot/zone/digest.h"
+#include "knot/conf/conf.h"
 #include "knot/dnssec/rrset-sign.h"
 #include "knot/updates/zone-update.h"
+#include "contrib/macros.h"
+#include "contrib/openbsd/siphash.h"
+#include "contrib/time.h"
 #include "contrib/wire_ctx.h"
 #include "libdnssec/digest.h"
 #include "libknot/libknot.h"
 
 #define DIGEST_BUF_MIN 4096
-#define DIGEST_BUF_MAX (40 * 1024 * 1024)
+
+#define DIGEST_CHUNK_NODES 512 // maximum nodes serialized into one chunk
+#define DIGEST_CHUNKS_PER_THREAD 2 // chunks in flight per serializing thread
 
 typedef struct {
 	size_t buf_size;
+	size_t len;
 	uint8_t *buf;
-	struct dnssec_digest_ctx *digest_ctx;
 	const zone_node_t *apex;
 } contents_digest_ctx_t;
 
-static int digest_rrset(knot_rrset_t *rrset, const zone_node_t *node, void *vctx)
+/*!
+ * \brief Append canonical wire format of the RRSet into the buffer.
+ */
+static int serialize_rrset(knot_rrset_t *rrset, const zone_node_t *node,
+                           contents_digest_ctx_t *ctx)
 {
-	contents_digest_ctx_t *ctx = vctx;
-
 	// ignore apex ZONEMD
 	if (node == ctx->apex && rrset->type == KNOT_RRTYPE_ZONEMD) {
 		return KNOT_EOK;
@@ -61,17 +71,22 @@ static int digest_rrset(knot_rrset_t *rrset, const zone_node_t *node, void *vctx
 		}
 	}
 
-	// serialize RRSet, expand buf as needed
-	int ret = knot_rrset_to_wire_extra(rrset, ctx->buf, ctx->buf_size, 0,
+	// serialize RRSet, expand buf as needed (RRSet wire size fits in 16 bits)
+	size_t avail = ctx->buf_size - ctx->len;
+	int ret = knot_rrset_to_wire_extra(rrset, ctx->buf + ctx->len,
+	                                   MIN(avail, UINT16_MAX), 0,
 	                                   NULL, KNOT_PF_ORIGTTL);
-	while (ret == KNOT_ESPACE && ctx->buf_size < DIGEST_BUF_MAX) {
-		free(ctx->buf);
-		ctx->buf_size *= 2;
-		ctx->buf = malloc(ctx->buf_size);
-		if (ctx->buf == NULL) {
-			return KNOT_ENOMEM;
+	while (ret == KNOT_ESPACE && avail < UINT16_MAX) {
+		uint8_t *buf = realloc(ctx->buf, ctx->buf_size * 2);
+		if (buf == NULL) {
+			ret = KNOT_ENOMEM;
+			break;
 		}
-		ret = knot_rrset_to_wire_extra(rrset, ctx->buf, ctx->buf_size, 0,
+		ctx->buf = buf;
+		ctx->buf_size *= 2;
+		avail = ctx->buf_size - ctx->len;
+		ret = knot_rrset_to_wire_extra(rrset, ctx->buf + ctx->len,
+		                               MIN(avail, UINT16_MAX), 0,
 		                               NULL, KNOT_PF_ORIGTTL);
 	}
 
@@ -84,23 +99,241 @@ static int digest_rrset(knot_rrset_t *rrset, const zone_node_t *node, void *vctx
 		return ret;
 	}
 
-	// digest serialized RRSet
-	dnssec_binary_t bufbin = { ret, ctx->buf };
-	return dnssec_digest(ctx->digest_ctx, &bufbin);
+	ctx->len += ret;
+	return KNOT_EOK;
 }
 
-static int digest_node(zone_node_t *node, void *ctx)
+static int serialize_node(const zone_node_t *node, contents_digest_ctx_t *ctx)
+{
+	int i = 0, ret = KNOT_EOK;
+	for ( ; i < node->rrset_count && ret == KNOT_EOK; i++) {
+		knot_rrset_t rrset = node_rrset_at(node, i);
+		ret = serialize_rrset(&rrset, node, ctx);
+	}
+	return ret;
+}
+
+typedef struct {
+	contents_digest_ctx_t ctx;
+	struct dnssec_digest_ctx *digest_ctx;
+} serial_digest_ctx_t;
+
+static int digest_node(zone_node_t *node, void *data)
 {
+	serial_digest_ctx_t *sctx = data;
+
 	int i = 0, ret = KNOT_EOK;
 	for ( ; i < node->rrset_count && ret == KNOT_EOK; i++) {
 		knot_rrset_t rrset = node_rrset_at(node, i);
-		ret = digest_rrset(&rrset, node, ctx);
+		sctx->ctx.len = 0;
+		ret = serialize_rrset(&rrset, node, &sctx->ctx);
+		if (ret == KNOT_EOK && sctx->ctx.len > 0) {
+			dnssec_binary_t bufbin = { sctx->ctx.len, sctx->ctx.buf };
+			ret = dnssec_digest(sctx->digest_ctx, &bufbin);
+		}
+	}
+	return ret;
+}
+
+static int digest_serial(zone_tree_t *tree, const zone_node_t *apex,
+                         struct dnssec_digest_ctx *digest_ctx)
+{
+	serial_digest_ctx_t sctx = {
+		.ctx = {
+			.buf_size = DIGEST_BUF_MIN,
+			.buf = malloc(DIGEST_BUF_MIN),
+			.apex = apex,
+		},
+		.digest_ctx = digest_ctx,
+	};
+	if (sctx.ctx.buf == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = zone_tree_apply(tree, digest_node, &sctx);
+	free(sctx.ctx.buf);
+	return ret;
+}
+
+/*
+ * Pipelined digest: serializing threads produce the canonical wire format of
+ * consecutive chunks of nodes into a ring of slots, the calling thread feeds
+ * the slots into the hash in the order of the chunks.
+ */
+
+typedef struct {
+	contents_digest_ctx_t ctx;
+	size_t chunk;  // index of the chunk in the slot
+	bool ready;    // the chunk is serialized, waiting for the hasher
+	int ret;
+} digest_slot_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	zone_node_t **nodes;
+	size_t count;
+	size_t chunk_nodes;
+	size_t chunks;
+	size_t next_chunk;
+	size_t consumed;  // chunks already hashed, their slots are free
+	digest_slot_t *slots;
+	size_t nslots;
+	bool stop;
+} digest_pipeline_t;
+
+static int collect_node(zone_node_t *node, void *data)
+{
+	digest_pipeline_t *pipe = data;
+	pipe->nodes[pipe->count++] = node;
+	return KNOT_EOK;
+}
+
+static void *serialize_thread(void *data)
+{
+	digest_pipeline_t *pipe = data;
+
+	pthread_mutex_lock(&pipe->lock);
+	while (!pipe->stop && pipe->next_chunk < pipe->chunks) {
+		size_t chunk = pipe->next_chunk++;
+		digest_slot_t *slot = &pipe->slots[chunk % pipe->nslots];
+		// The slot is free once the chunk nslots before is hashed.
+		while (chunk >= pipe->consumed + pipe->nslots && !pipe->stop) {
+			pthread_cond_wait(&pipe->cond, &pipe->lock);
+		}
+		if (pipe->stop) {
+			break;
+		}
+		slot->chunk = chunk;
+		pthread_mutex_unlock(&pipe->lock);
+
+		size_t first = chunk * pipe->chunk_nodes;
+		size_t last = MIN(first + pipe->chunk_nodes, pipe->count);
+		int ret = KNOT_EOK;
+		slot->ctx.len = 0;
+		for (size_t i = first; i < last && ret == KNOT_EOK; i++) {
+			ret = serialize_node(pipe->nodes[i], &slot->ctx);
+		}
+
+		pthread_mutex_lock(&pipe->lock);
+		slot->ret = ret;
+		slot->ready = true;
+		pthread_cond_broadcast(&pipe->cond);
+	}
+	pthread_mutex_unlock(&pipe->lock);
+
+	return NULL;
+}
+
+static int digest_chunks(digest_pipeline_t *pipe, struct dnssec_digest_ctx *digest_ctx)
+{
+	int ret = KNOT_EOK;
+
+	for (size_t chunk = 0; chunk < pipe->chunks && ret == KNOT_EOK; chunk++) {
+		digest_slot_t *slot = &pipe->slots[chunk % pipe->nslots];
+
+		pthread_mutex_lock(&pipe->lock);
+		while (!(slot->ready && slot->chunk == chunk) && !pipe->stop) {
+			pthread_cond_wait(&pipe->cond, &pipe->lock);
+		}
+		ret = pipe->stop ? KNOT_ERROR : slot->ret;
+		pthread_mutex_unlock(&pipe->lock);
+
+		if (ret == KNOT_EOK && slot->ctx.len > 0) {
+			dnssec_binary_t bufbin = { slot->ctx.len, slot->ctx.buf };
+			ret = dnssec_digest(digest_ctx, &bufbin);
+		}
+
+		pthread_mutex_lock(&pipe->lock);
+		slot->ready = false;
+		pipe->consumed++;
+		if (ret != KNOT_EOK) {
+			pipe->stop = true;
+		}
+		pthread_cond_broadcast(&pipe->cond);
+		pthread_mutex_unlock(&pipe->lock);
 	}
+
+	return ret;
+}
+
+static int digest_parallel(zone_tree_t *tree, const zone_node_t *apex,
+                           struct dnssec_digest_ctx *digest_ctx, unsigned threads)
+{
+	size_t count = zone_tree_count(tree);
+	if (count == 0) {
+		return KNOT_EOK;
+	}
+
+	digest_pipeline_t pipe = {
+		.nodes = malloc(count * sizeof(*pipe.nodes)),
+		.nslots = threads * DIGEST_CHUNKS_PER_THREAD,
+	};
+	pipe.slots = calloc(pipe.nslots, sizeof(*pipe.slots));
+	if (pipe.nodes == NULL || pipe.slots == NULL) {
+		free(pipe.nodes);
+		free(pipe.slots);
+		return KNOT_ENOMEM;
+	}
+
+	int ret = zone_tree_apply(tree, collect_node, &pipe);
+	assert(ret != KNOT_EOK || pipe.count == count);
+
+	// smaller chunks for small zones to keep all the threads busy
+	pipe.chunk_nodes = MIN(DIGEST_CHUNK_NODES, count / pipe.nslots);
+	pipe.chunk_nodes = MAX(1, pipe.chunk_nodes);
+	pipe.chunks = (count + pipe.chunk_nodes - 1) / pipe.chunk_nodes;
+
+	for (size_t i = 0; i < pipe.nslots && ret == KNOT_EOK; i++) {
+		pipe.slots[i].ctx.apex = apex;
+		pipe.slots[i].ctx.buf_size = DIGEST_BUF_MIN;
+		pipe.slots[i].ctx.buf = malloc(DIGEST_BUF_MIN);
+		if (pipe.slots[i].ctx.buf == NULL) {
+			ret = KNOT_ENOMEM;
+		}
+	}
+
+	pthread_t thread_ids[threads];
+	unsigned started = 0;
+	if (ret == KNOT_EOK) {
+		pthread_mutex_init(&pipe.lock, NULL);
+		pthread_cond_init(&pipe.cond, NULL);
+
+		for ( ; started < threads; started++) {
+			int err = pthread_create(&thread_ids[started], NULL,
+			                         serialize_thread, &pipe);
+			if (err != 0) {
+				ret = knot_map_errno_code(err);
+				break;
+			}
+		}
+
+		if (started > 0) {
+			int digest_ret = digest_chunks(&pipe, digest_ctx);
+			if (ret == KNOT_EOK) {
+				ret = digest_ret;
+			}
+		}
+
+		for (unsigned i = 0; i < started; i++) {
+			pthread_join(thread_ids[i], NULL);
+		}
+
+		pthread_cond_destroy(&pipe.cond);
+		pthread_mutex_destroy(&pipe.lock);
+	}
+
+	for (size_t i = 0; i < pipe.nslots; i++) {
+		free(pipe.slots[i].ctx.buf);
+	}
+	free(pipe.slots);
+	free(pipe.nodes);
+
 	return ret;
 }
 
 int zone_contents_digest(const zone_contents_t *contents, int algorithm,
-                         uint8_t **out_digest, size_t *out_size)
+                         unsigned threads, uint8_t **out_digest, size_t *out_size)
 {
 	if (out_digest == NULL || out_size == NULL) {
 		return KNOT_EINVAL;
@@ -110,18 +343,9 @@ int zone_contents_digest(const zone_contents_t *contents, int algorithm,
 		return KNOT_EEMPTYZONE;
 	}
 
-	contents_digest_ctx_t ctx = {
-		.buf_size = DIGEST_BUF_MIN,
-		.buf = malloc(DIGEST_BUF_MIN),
-		.apex = contents->apex,
-	};
-	if (ctx.buf == NULL) {
-		return KNOT_ENOMEM;
-	}
-
-	int ret = dnssec_digest_init(algorithm, &ctx.digest_ctx);
+	struct dnssec_digest_ctx *digest_ctx = NULL;
+	int ret = dnssec_digest_init(algorithm, &digest_ctx);
 	if (ret != DNSSEC_EOK) {
-		free(ctx.buf);
 		return knot_error_from_libdnssec(ret);
 	}
 
@@ -137,7 +361,11 @@ int zone_contents_digest(const zone_contents_t *contents, int algorithm,
 	}
 
 	if (ret == KNOT_EOK) {
-		ret = zone_tree_apply(conts, digest_node, &ctx);
+		if (threads > 1) {
+			ret = digest_parallel(conts, contents->apex, digest_ctx, threads);
+		} else {
+			ret = digest_serial(conts, contents->apex, digest_ctx);
+		}
 	}
 
 	if (conts != contents->nodes) {
@@ -145,21 +373,481 @@ int zone_contents_digest(const zone_contents_t *contents, int algorithm,
 	}
 
 	dnssec_binary_t res = { 0 };
+	int fin_ret = dnssec_digest_finish(digest_ctx, &res); // frees the context
 	if (ret == KNOT_EOK) {
-		ret = dnssec_digest_finish(ctx.digest_ctx, &res);
+		ret = fin_ret;
+	} else {
+		dnssec_binary_free(&res);
+	}
+	*out_digest = res.data;
+	*out_size = res.size;
+	return ret;
+}
+
+/*
+ * Private Merkle scheme: the nodes of each tree are split into pages, a page
+ * ends with a boundary node, which is a node with data whose owner hashes to
+ * zero modulo DIGEST_PAGE_NODES. The digest is the hash of the page hashes in
+ * canonical order. As the boundaries depend only on the owners, the page
+ * hashes of the previous contents are kept and an incremental update only
+ * rehashes the pages with changed nodes.
+ */
+
+#define DIGEST_PAGE_NODES 64 // average number of nodes in one page
+#define DIGEST_HASH_MAX   64 // SHA512
+
+typedef struct {
+	uint8_t hash[DIGEST_HASH_MAX];
+} digest_page_t;
+
+struct zone_digest_cache {
+	int algorithm;
+	size_t hash_size;
+	trie_t *pages[2];        // page hashes keyed by the boundary, nodes and NSEC3 nodes
+	digest_page_t *tail[2];  // hash of the nodes after the last boundary, if any
+};
+
+typedef struct {
+	uint8_t data[KNOT_DNAME_MAXLEN + 1];
+	size_t len;
+	bool set;
+} page_key_t;
+
+static bool page_boundary(const zone_node_t *node)
+{
+	if (node->rrset_count == 0) {
+		return false;
+	}
+
+	knot_dname_storage_t lower;
+	size_t size = knot_dname_size(node->owner);
+	memcpy(lower, node->owner, size);
+	knot_dname_to_lower(lower);
+
+	const SIPHASH_KEY key = { 0 };
+	return SipHash24(&key, lower, size) % DIGEST_PAGE_NODES == 0;
+}
+
+static int key_cmp(const uint8_t *a, size_t a_len, const uint8_t *b, size_t b_len)
+{
+	int ret = memcmp(a, b, MIN(a_len, b_len));
+	return ret != 0 ? ret : (a_len > b_len) - (a_len < b_len);
+}
+
+static void key_store(page_key_t *dst, trie_it_t *it)
+{
+	const trie_key_t *key = trie_it_key(it, &dst->len);
+	memcpy(dst->data, key, dst->len);
+	dst->set = true;
+}
+
+static int page_free(trie_val_t *val, void *null)
+{
+	free(*val);
+	return KNOT_EOK;
+}
+
+static trie_val_t page_dup(const trie_val_t val, knot_mm_t *mm)
+{
+	digest_page_t *page = malloc(sizeof(*page));
+	if (page != NULL) {
+		memcpy(page, val, sizeof(*page));
+	}
+	return page;
+}
+
+static void pages_clear(zone_digest_cache_t *cache, int tree_id)
+{
+	(void)trie_apply(cache->pages[tree_id], page_free, NULL);
+	trie_clear(cache->pages[tree_id]);
+	free(cache->tail[tree_id]);
+	cache->tail[tree_id] = NULL;
+}
+
+void zone_digest_cache_free(zone_digest_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		if (cache->pages[i] != NULL) {
+			pages_clear(cache, i);
+			trie_free(cache->pages[i]);
+		}
+	}
+	free(cache);
+}
+
+static zone_digest_cache_t *cache_new(int algorithm, const zone_digest_cache_t *from)
+{
+	zone_digest_cache_t *cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+	cache->algorithm = algorithm;
+
+	for (int i = 0; i < 2; i++) {
+		if (from == NULL) {
+			cache->pages[i] = trie_create(NULL);
+		} else {
+			cache->pages[i] = trie_dup(from->pages[i], page_dup, NULL);
+			if (from->tail[i] != NULL) {
+				cache->tail[i] = page_dup(from->tail[i], NULL);
+				if (cache->tail[i] == NULL) {
+					zone_digest_cache_free(cache);
+					return NULL;
+				}
+			}
+		}
+		if (cache->pages[i] == NULL) {
+			zone_digest_cache_free(cache);
+			return NULL;
+		}
+	}
+	if (from != NULL) {
+		cache->hash_size = from->hash_size;
+	}
+
+	return cache;
+}
+
+/*!
+ * \brief Hash the serialized page and store it under the boundary key (NULL for tail).
+ */
+static int page_set(zone_digest_cache_t *cache, int tree_id, const uint8_t *key,
+                    size_t key_len, contents_digest_ctx_t *ctx)
+{
+	struct dnssec_digest_ctx *digest_ctx = NULL;
+	int ret = dnssec_digest_init(cache->algorithm, &digest_ctx);
+	if (ret != DNSSEC_EOK) {
+		return knot_error_from_libdnssec(ret);
+	}
+
+	if (ctx->len > 0) {
+		dnssec_binary_t bufbin = { ctx->len, ctx->buf };
+		ret = dnssec_digest(digest_ctx, &bufbin);
+	}
+	ctx->len = 0;
+
+	dnssec_binary_t res = { 0 };
+	int fin_ret = dnssec_digest_finish(digest_ctx, &res); // frees the context
+	if (ret == KNOT_EOK) {
+		ret = fin_ret;
+	}
+	if (ret == KNOT_EOK && res.size > DIGEST_HASH_MAX) {
+		ret = KNOT_ENOTSUP;
+	}
+
+	digest_page_t *page = malloc(sizeof(*page));
+	if (ret == KNOT_EOK && page == NULL) {
+		ret = KNOT_ENOMEM;
+	}
+	if (ret != KNOT_EOK) {
+		dnssec_binary_free(&res);
+		free(page);
+		return ret;
+	}
+	memcpy(page->hash, res.data, res.size);
+	cache->hash_size = res.size;
+	dnssec_binary_free(&res);
+
+	if (key == NULL) {
+		free(cache->tail[tree_id]);
+		cache->tail[tree_id] = page;
+		return KNOT_EOK;
+	}
+
+	trie_val_t *val = trie_get_ins(cache->pages[tree_id], key, key_len);
+	if (val == NULL) {
+		free(page);
+		return KNOT_ENOMEM;
+	}
+	free(*val);
+	*val = page;
+
+	return KNOT_EOK;
+}
+
+static int pages_build(zone_digest_cache_t *cache, int tree_id, zone_tree_t *tree,
+                       contents_digest_ctx_t *ctx)
+{
+	if (zone_tree_is_empty(tree)) {
+		return KNOT_EOK;
+	}
+
+	trie_it_t *it = trie_it_begin(tree->trie);
+	if (it == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	ctx->len = 0;
+	for ( ; !trie_it_finished(it) && ret == KNOT_EOK; trie_it_next(it)) {
+		zone_node_t *node = zone_tree_fix_get(*trie_it_val(it), tree);
+		ret = serialize_node(node, ctx);
+		if (ret == KNOT_EOK && page_boundary(node)) {
+			size_t len;
+			const trie_key_t *key = trie_it_key(it, &len);
+			ret = page_set(cache, tree_id, key, len, ctx);
+		}
+	}
+	trie_it_free(it);
+
+	if (ret == KNOT_EOK && ctx->len > 0) {
+		ret = page_set(cache, tree_id, NULL, 0, ctx);
+	}
+
+	return ret;
+}
+
+/*!
+ * \brief Remove the page hashes with boundaries in (from, to].
+ */
+static int pages_remove(zone_digest_cache_t *cache, int tree_id,
+                        const page_key_t *from, const page_key_t *to)
+{
+	trie_t *pages = cache->pages[tree_id];
+
+	while (trie_weight(pages) > 0) {
+		trie_it_t *it = trie_it_begin(pages);
+		if (it == NULL) {
+			return KNOT_ENOMEM;
+		}
+
+		int ret = trie_it_get_leq(it, to->data, to->len);
+		if (ret != KNOT_EOK && ret != 1) {
+			trie_it_free(it);
+			return ret == KNOT_ENOENT ? KNOT_EOK : ret;
+		}
+
+		page_key_t found;
+		key_store(&found, it);
+		trie_it_free(it);
+		if (from->set && key_cmp(found.data, found.len, from->data, from->len) <= 0) {
+			break;
+		}
+
+		trie_val_t val = NULL;
+		(void)trie_del(pages, found.data, found.len, &val);
+		free(val);
+	}
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Rehash the page containing the changed name, output its boundary (unset for tail).
+ */
+static int page_update(zone_digest_cache_t *cache, int tree_id, zone_tree_t *tree,
+                       const trie_key_t *key, size_t key_len,
+                       contents_digest_ctx_t *ctx, page_key_t *end)
+{
+	trie_it_t *it = trie_it_begin(tree->trie);
+	if (it == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	// find the boundary preceding the changed name
+	int ret = trie_it_get_leq(it, key, key_len);
+	if (ret == KNOT_EOK) {
+		trie_it_prev(it);
+	} else if (ret != 1 && ret != KNOT_ENOENT) {
+		trie_it_free(it);
+		return ret;
+	}
+	while (!trie_it_finished(it) &&
+	       !page_boundary(zone_tree_fix_get(*trie_it_val(it), tree))) {
+		trie_it_prev(it);
+	}
+
+	page_key_t start = { 0 };
+	if (trie_it_finished(it)) {
+		trie_it_free(it);
+		it = trie_it_begin(tree->trie);
+		if (it == NULL) {
+			return KNOT_ENOMEM;
+		}
+	} else {
+		key_store(&start, it);
+		trie_it_next(it);
+	}
+
+	// serialize the page up to the following boundary
+	ret = KNOT_EOK;
+	ctx->len = 0;
+	end->set = false;
+	for ( ; !trie_it_finished(it) && ret == KNOT_EOK; trie_it_next(it)) {
+		zone_node_t *node = zone_tree_fix_get(*trie_it_val(it), tree);
+		ret = serialize_node(node, ctx);
+		if (ret == KNOT_EOK && page_boundary(node)) {
+			key_store(end, it);
+			break;
+		}
+	}
+	trie_it_free(it);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	// replace the old pages overlapping with the new one
+	if (end->set) {
+		ret = pages_remove(cache, tree_id, &start, end);
+	} else {
+		page_key_t last = { .len = sizeof(last.data), .set = true };
+		memset(last.data, 0xff, sizeof(last.data));
+		ret = pages_remove(cache, tree_id, &start, &last);
+		free(cache->tail[tree_id]);
+		cache->tail[tree_id] = NULL;
+	}
+	if (ret == KNOT_EOK && (end->set || ctx->len > 0)) {
+		ret = page_set(cache, tree_id, end->set ? end->data : NULL, end->len, ctx);
+	}
+
+	return ret;
+}
+
+static int pages_update(zone_digest_cache_t *cache, int tree_id, zone_tree_t *tree,
+                        zone_tree_t *changed, contents_digest_ctx_t *ctx)
+{
+	if (zone_tree_is_empty(changed)) {
+		return KNOT_EOK;
+	}
+	if (zone_tree_is_empty(tree)) {
+		pages_clear(cache, tree_id);
+		return KNOT_EOK;
+	}
+
+	trie_it_t *it = trie_it_begin(changed->trie);
+	if (it == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	page_key_t end = { 0 };
+	for ( ; !trie_it_finished(it) && ret == KNOT_EOK; trie_it_next(it)) {
+		size_t len;
+		const trie_key_t *key = trie_it_key(it, &len);
+		if (end.set && key_cmp(key, len, end.data, end.len) <= 0) {
+			continue; // the page has been rehashed already
+		}
+		ret = page_update(cache, tree_id, tree, key, len, ctx, &end);
+		if (!end.set) {
+			break; // the rest of the tree has been rehashed as the tail
+		}
+	}
+	trie_it_free(it);
+
+	return ret;
+}
+
+typedef struct {
+	struct dnssec_digest_ctx *digest_ctx;
+	size_t hash_size;
+} pages_digest_ctx_t;
+
+static int digest_page(trie_val_t *val, void *data)
+{
+	pages_digest_ctx_t *pctx = data;
+	digest_page_t *page = *val;
+
+	dnssec_binary_t bufbin = { pctx->hash_size, page->hash };
+	return dnssec_digest(pctx->digest_ctx, &bufbin);
+}
+
+static int digest_pages(const zone_digest_cache_t *cache, uint8_t **out_digest,
+                        size_t *out_size)
+{
+	pages_digest_ctx_t pctx = { .hash_size = cache->hash_size };
+	int ret = dnssec_digest_init(cache->algorithm, &pctx.digest_ctx);
+	if (ret != DNSSEC_EOK) {
+		return knot_error_from_libdnssec(ret);
+	}
+
+	for (int i = 0; i < 2 && ret == KNOT_EOK; i++) {
+		ret = trie_apply(cache->pages[i], digest_page, &pctx);
+		if (ret == KNOT_EOK && cache->tail[i] != NULL) {
+			trie_val_t tail = cache->tail[i];
+			ret = digest_page(&tail, &pctx);
+		}
+	}
+
+	dnssec_binary_t res = { 0 };
+	int fin_ret = dnssec_digest_finish(pctx.digest_ctx, &res); // frees the context
+	if (ret == KNOT_EOK) {
+		ret = fin_ret;
+	} else {
+		dnssec_binary_free(&res);
 	}
-	free(ctx.buf);
 	*out_digest = res.data;
 	*out_size = res.size;
 	return ret;
 }
 
-static int verify_zonemd(const knot_rdata_t *zonemd, const zone_contents_t *contents)
+int zone_contents_digest_merkle(const zone_contents_t *contents, int algorithm,
+                                const zone_digest_cache_t *prev,
+                                zone_tree_t *changed, zone_tree_t *changed_nsec3,
+                                zone_digest_cache_t **out_cache,
+                                uint8_t **out_digest, size_t *out_size)
+{
+	if (out_digest == NULL || out_size == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (contents == NULL) {
+		return KNOT_EEMPTYZONE;
+	}
+
+	bool incremental = (prev != NULL && prev->algorithm == algorithm);
+	zone_digest_cache_t *cache = cache_new(algorithm, incremental ? prev : NULL);
+	if (cache == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	contents_digest_ctx_t ctx = {
+		.buf_size = DIGEST_BUF_MIN,
+		.buf = malloc(DIGEST_BUF_MIN),
+		.apex = contents->apex,
+	};
+	int ret = (ctx.buf == NULL) ? KNOT_ENOMEM : KNOT_EOK;
+
+	zone_tree_t *trees[2] = { contents->nodes, contents->nsec3_nodes };
+	zone_tree_t *changes[2] = { changed, changed_nsec3 };
+	for (int i = 0; i < 2 && ret == KNOT_EOK; i++) {
+		if (incremental) {
+			ret = pages_update(cache, i, trees[i], changes[i], &ctx);
+		} else {
+			ret = pages_build(cache, i, trees[i], &ctx);
+		}
+	}
+	free(ctx.buf);
+
+	if (ret == KNOT_EOK) {
+		ret = digest_pages(cache, out_digest, out_size);
+	}
+
+	if (ret == KNOT_EOK && out_cache != NULL) {
+		*out_cache = cache;
+	} else {
+		zone_digest_cache_free(cache);
+	}
+	return ret;
+}
+
+static int verify_zonemd(const knot_rdata_t *zonemd, const zone_contents_t *contents,
+                         unsigned threads)
 {
 	uint8_t *computed = NULL;
 	size_t comp_size = 0;
-	int ret = zone_contents_digest(contents, knot_zonemd_algorithm(zonemd),
-	                               &computed, &comp_size);
+	int ret;
+	if (knot_zonemd_scheme(zonemd) == ZONE_DIGEST_SCHEME_MERKLE) {
+		ret = zone_contents_digest_merkle(contents, knot_zonemd_algorithm(zonemd),
+		                                  NULL, NULL, NULL, NULL,
+		                                  &computed, &comp_size);
+	} else {
+		ret = zone_contents_digest(contents, knot_zonemd_algorithm(zonemd), threads,
+		                           &computed, &comp_size);
+	}
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
@@ -173,7 +861,8 @@ static int verify_zonemd(const knot_rdata_t *zonemd, const zone_contents_t *cont
 	return ret;
 }
 
-bool zone_contents_digest_exists(const zone_contents_t *contents, int alg, bool no_verify)
+bool zone_contents_digest_exists(const zone_contents_t *contents, int alg, int scheme,
+                                 bool no_verify)
 {
 	if (alg == 0) {
 		return true;
@@ -185,7 +874,8 @@ bool zone_contents_digest_exists(const zone_contents_t *contents, int alg, bool
 		return (zonemd == NULL || zonemd->count == 0);
 	}
 
-	if (zonemd == NULL || zonemd->count != 1 || knot_zonemd_algorithm(zonemd->rdata) != alg) {
+	if (zonemd == NULL || zonemd->count != 1 || knot_zonemd_algorithm(zonemd->rdata) != alg ||
+	    knot_zonemd_scheme(zonemd->rdata) != scheme) {
 		return false;
 	}
 
@@ -193,7 +883,7 @@ bool zone_contents_digest_exists(const zone_contents_t *contents, int alg, bool
 		return true;
 	}
 
-	return verify_zonemd(zonemd->rdata, contents) == KNOT_EOK;
+	return verify_zonemd(zonemd->rdata, contents, 1) == KNOT_EOK;
 }
 
 static bool check_duplicate_schalg(const knot_rdataset_t *zonemd, int check_upto,
@@ -211,7 +901,7 @@ static bool check_duplicate_schalg(const knot_rdataset_t *zonemd, int check_upto
 	return true;
 }
 
-int zone_contents_digest_verify(const zone_contents_t *contents)
+int zone_contents_digest_verify(const zone_contents_t *contents, unsigned threads)
 {
 	if (contents == NULL) {
 		return KNOT_EEMPTYZONE;
@@ -226,7 +916,8 @@ int zone_contents_digest_verify(const zone_contents_t *contents)
 
 	knot_rdata_t *rr = zonemd->rdata, *supported = NULL;
 	for (int i = 0; i < zonemd->count; i++) {
-		if (knot_zonemd_scheme(rr) == KNOT_ZONEMD_SCHEME_SIMPLE &&
+		if ((knot_zonemd_scheme(rr) == KNOT_ZONEMD_SCHEME_SIMPLE ||
+		     knot_zonemd_scheme(rr) == ZONE_DIGEST_SCHEME_MERKLE) &&
 		    knot_zonemd_digest_size(rr) > 0 &&
 		    knot_zonemd_soa_serial(rr) == soa_serial) {
 			supported = rr;
@@ -238,7 +929,7 @@ int zone_contents_digest_verify(const zone_contents_t *contents)
 		rr = knot_rdataset_next(rr);
 	}
 
-	return supported == NULL ? KNOT_ENOTSUP : verify_zonemd(supported, contents);
+	return supported == NULL ? KNOT_ENOTSUP : verify_zonemd(supported, contents, threads);
 }
 
 static ptrdiff_t zonemd_hash_offs(void)
@@ -260,17 +951,43 @@ int zone_update_add_digest(struct zone_update *update, int algorithm, bool place
 	if (algorithm == ZONE_DIGEST_REMOVE) {
 		return zone_update_remove(update, &exists);
 	}
+
+	conf_val_t val = conf_zone_get(conf(), C_ZONEMD_SCHEME, update->zone->name);
+	int scheme = conf_opt(&val);
+
 	if (placeholder) {
 		if (!knot_rrset_empty(&exists) &&
 		    !check_duplicate_schalg(&exists.rrs, exists.rrs.count,
-		                            KNOT_ZONEMD_SCHEME_SIMPLE, algorithm)) {
+		                            scheme, algorithm)) {
 			return KNOT_EOK;
 		}
 	} else {
-		int ret = zone_contents_digest(update->new_cont, algorithm, &digest, &dsize);
+		struct timespec begin = time_now();
+		int ret;
+		if (scheme == ZONE_DIGEST_SCHEME_MERKLE) {
+			// reuse the page hashes of the current contents if incremental
+			const zone_digest_cache_t *prev = NULL;
+			if ((update->flags & UPDATE_INCREMENTAL) && update->zone->contents != NULL) {
+				prev = update->zone->digest.cache;
+			}
+			zone_digest_cache_free(update->digest_cache);
+			update->digest_cache = NULL;
+			ret = zone_contents_digest_merkle(update->new_cont, algorithm, prev,
+			                                  update->a_ctx->node_ptrs,
+			                                  update->a_ctx->nsec3_ptrs,
+			                                  &update->digest_cache,
+			                                  &digest, &dsize);
+		} else {
+			val = conf_zone_get(conf(), C_ADJUST_THR, update->zone->name);
+			ret = zone_contents_digest(update->new_cont, algorithm, conf_int(&val),
+			                           &digest, &dsize);
+		}
 		if (ret != KNOT_EOK) {
 			return ret;
 		}
+		struct timespec end = time_now();
+		update->zone->digest.duration = time_diff_ms(&begin, &end);
+		update->zone->digest.computed = true;
 
 		ret = zone_update_remove(update, &exists);
 		if (ret != KNOT_EOK && ret != KNOT_ENOENT) {
@@ -284,7 +1001,7 @@ int zone_update_add_digest(struct zone_update *update, int algorithm, bool place
 	uint8_t rdata[zonemd_hash_offs() + dsize];
 	wire_ctx_t wire = wire_ctx_init(rdata, sizeof(rdata));
 	wire_ctx_write_u32(&wire, knot_soa_serial(soa.rrs.rdata));
-	wire_ctx_write_u8(&wire, KNOT_ZONEMD_SCHEME_SIMPLE);
+	wire_ctx_write_u8(&wire, scheme);
 	wire_ctx_write_u8(&wire, algorithm);
 	wire_ctx_write(&wire, digest, dsize);
 	assert(wire.error == KNOT_EOK && wire_ctx_available(&wire) == 0);
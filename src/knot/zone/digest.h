@@ -23,13 +23,48 @@
  *
  * \param contents     Zone contents to digest.
  * \param algorithm    Algorithm to use.
+ * \param threads      Number of threads serializing the zone for the hash.
  * \param out_digest   Output: buffer with computed hash (to be freed).
  * \param out_size     Output: size of the resulting hash.
  *
  * \return KNOT_E*
  */
 int zone_contents_digest(const zone_contents_t *contents, int algorithm,
-                         uint8_t **out_digest, size_t *out_size);
+                         unsigned threads, uint8_t **out_digest, size_t *out_size);
+
+/*!
+ * \brief Page hashes of zone contents for the private Merkle ZONEMD scheme.
+ */
+typedef struct zone_digest_cache zone_digest_cache_t;
+
+/*!
+ * \brief Compute hash over whole zone using the private Merkle scheme.
+ *
+ * The nodes are split into pages by boundary owner names, the result is the hash
+ * of the page hashes. With the page hashes of the previous contents, only the pages
+ * containing a changed node are hashed again.
+ *
+ * \param contents       Zone contents to digest.
+ * \param algorithm      Algorithm to use.
+ * \param prev           Optional: page hashes of the contents before the changes.
+ * \param changed        Nodes changed since prev (ignored without prev).
+ * \param changed_nsec3  NSEC3 nodes changed since prev (ignored without prev).
+ * \param out_cache      Optional output: page hashes of the contents (to be freed).
+ * \param out_digest     Output: buffer with computed hash (to be freed).
+ * \param out_size       Output: size of the resulting hash.
+ *
+ * \return KNOT_E*
+ */
+int zone_contents_digest_merkle(const zone_contents_t *contents, int algorithm,
+                                const zone_digest_cache_t *prev,
+                                zone_tree_t *changed, zone_tree_t *changed_nsec3,
+                                zone_digest_cache_t **out_cache,
+                                uint8_t **out_digest, size_t *out_size);
+
+/*!
+ * \brief Free the page hashes.
+ */
+void zone_digest_cache_free(zone_digest_cache_t *cache);
 
 /*!
  * \brief Check whether exactly one ZONEMD exists in the zone, is valid and matches given algorithm.
@@ -38,14 +73,17 @@ int zone_contents_digest(const zone_contents_t *contents, int algorithm,
  *
  * \param contents   Zone contents to be verified.
  * \param alg        Required algorithm of the ZONEMD.
+ * \param scheme     Required scheme of the ZONEMD.
  * \param no_verify  Don't verify the validness of the digest in ZONEMD.
  */
-bool zone_contents_digest_exists(const zone_contents_t *contents, int alg, bool no_verify);
+bool zone_contents_digest_exists(const zone_contents_t *contents, int alg, int scheme,
+                                 bool no_verify);
 
 /*!
  * \brief Verify zone dgest in ZONEMD record.
  *
  * \param contents   Zone contents ot be verified.
+ * \param threads    Number of threads serializing the zone for the hash.
  *
  * \retval KNOT_EEMPTYZONE  The zone is empty.
  * \retval KNOT_ENOENT      There is no ZONEMD in contents' apex.
@@ -55,7 +93,7 @@ bool zone_contents_digest_exists(const zone_contents_t *contents, int alg, bool
  * \retval KNOT_EMALF       The computed hash differs from ZONEMD.
  * \return KNOT_E*
  */
-int zone_contents_digest_verify(const zone_contents_t *contents);
+int zone_contents_digest_verify(const zone_contents_t *contents, unsigned threads);
 
 struct zone_update;
 /*!
@@ -66,6 +104,9 @@ struct zone_update;
  * \param placeholder   Don't calculate, just put placeholder (if ZONEMD not yet present).
  *
  * \note Special value 255 of algorithm means to remove ZONEMD.
+ * \note The scheme is configured for the zone. With the private Merkle scheme,
+ *       the page hashes are kept in the update and used for the next digest
+ *       once the update is committed.
  *
  * \return KNOT_E*
  */
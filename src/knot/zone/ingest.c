@@ -0,0 +1,218 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "knot/zone/ingest.h"
+#include "knot/zone/zonefile.h"
+#include "contrib/mempattern.h"
+#include "contrib/ucw/mempool.h"
+#include "libknot/errcode.h"
+
+#define INGEST_SLOTS 8 // batches in flight, usually one per received message
+#define INGEST_RRS_MIN 64
+
+typedef struct {
+	knot_mm_t mm;         // records of the batch
+	knot_rrset_t **rrs;
+	size_t count;
+	size_t max;
+	bool ready;           // the batch is waiting for insertion
+} ingest_slot_t;
+
+struct zone_ingest {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	zcreator_t zc;
+	ingest_slot_t slots[INGEST_SLOTS];
+	size_t head;          // batch being filled by the caller
+	size_t tail;          // batch being inserted by the thread
+	bool finish;          // no more batches will come
+	bool stop;            // stop inserting
+	int ret;
+};
+
+static void *ingest_thread(void *data)
+{
+	zone_ingest_t *ingest = data;
+
+	pthread_mutex_lock(&ingest->lock);
+	while (true) {
+		ingest_slot_t *slot = &ingest->slots[ingest->tail % INGEST_SLOTS];
+		while (!slot->ready && !ingest->finish && !ingest->stop) {
+			pthread_cond_wait(&ingest->cond, &ingest->lock);
+		}
+		if (!slot->ready || ingest->stop) {
+			break;
+		}
+		pthread_mutex_unlock(&ingest->lock);
+
+		int ret = KNOT_EOK;
+		for (size_t i = 0; i < slot->count && ret == KNOT_EOK; i++) {
+			ret = zcreator_step(&ingest->zc, slot->rrs[i]);
+		}
+		mp_flush(slot->mm.ctx);
+		slot->count = 0;
+
+		pthread_mutex_lock(&ingest->lock);
+		slot->ready = false;
+		ingest->tail++;
+		if (ret != KNOT_EOK) {
+			ingest->ret = ret;
+			ingest->stop = true;
+		}
+		pthread_cond_broadcast(&ingest->cond);
+	}
+	pthread_mutex_unlock(&ingest->lock);
+
+	return NULL;
+}
+
+static void ingest_free(zone_ingest_t *ingest)
+{
+	for (size_t i = 0; i < INGEST_SLOTS; i++) {
+		if (ingest->slots[i].mm.ctx != NULL) {
+			mp_delete(ingest->slots[i].mm.ctx);
+		}
+		free(ingest->slots[i].rrs);
+	}
+	pthread_cond_destroy(&ingest->cond);
+	pthread_mutex_destroy(&ingest->lock);
+	free(ingest);
+}
+
+int zone_ingest_start(zone_contents_t *contents, zone_ingest_t **ingest)
+{
+	if (contents == NULL || ingest == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	zone_ingest_t *new_ingest = calloc(1, sizeof(*new_ingest));
+	if (new_ingest == NULL) {
+		return KNOT_ENOMEM;
+	}
+	pthread_mutex_init(&new_ingest->lock, NULL);
+	pthread_cond_init(&new_ingest->cond, NULL);
+	new_ingest->zc.z = contents;
+	new_ingest->zc.ret = KNOT_EOK;
+
+	for (size_t i = 0; i < INGEST_SLOTS; i++) {
+		mm_ctx_mempool(&new_ingest->slots[i].mm, MM_DEFAULT_BLKSIZE);
+		if (new_ingest->slots[i].mm.ctx == NULL) {
+			ingest_free(new_ingest);
+			return KNOT_ENOMEM;
+		}
+	}
+
+	int ret = pthread_create(&new_ingest->thread, NULL, ingest_thread, new_ingest);
+	if (ret != 0) {
+		ingest_free(new_ingest);
+		return knot_map_errno_code(ret);
+	}
+
+	*ingest = new_ingest;
+	return KNOT_EOK;
+}
+
+int zone_ingest_add(zone_ingest_t *ingest, const knot_rrset_t *rr)
+{
+	if (ingest == NULL || rr == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	// Not ready, thus owned by the caller, see zone_ingest_flush().
+	ingest_slot_t *slot = &ingest->slots[ingest->head % INGEST_SLOTS];
+	if (slot->count == slot->max) {
+		size_t new_max = (slot->max == 0) ? INGEST_RRS_MIN : 2 * slot->max;
+		knot_rrset_t **new_rrs = realloc(slot->rrs, new_max * sizeof(*new_rrs));
+		if (new_rrs == NULL) {
+			return KNOT_ENOMEM;
+		}
+		slot->rrs = new_rrs;
+		slot->max = new_max;
+	}
+
+	knot_rrset_t *copy = knot_rrset_copy(rr, &slot->mm);
+	if (copy == NULL) {
+		return KNOT_ENOMEM;
+	}
+	slot->rrs[slot->count++] = copy;
+
+	return KNOT_EOK;
+}
+
+int zone_ingest_flush(zone_ingest_t *ingest)
+{
+	if (ingest == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	pthread_mutex_lock(&ingest->lock);
+	ingest_slot_t *slot = &ingest->slots[ingest->head % INGEST_SLOTS];
+	if (slot->count > 0) {
+		slot->ready = true;
+		ingest->head++;
+		pthread_cond_broadcast(&ingest->cond);
+	}
+
+	// Wait for a free batch to fill.
+	slot = &ingest->slots[ingest->head % INGEST_SLOTS];
+	while (slot->ready && !ingest->stop) {
+		pthread_cond_wait(&ingest->cond, &ingest->lock);
+	}
+	int ret = ingest->ret;
+	pthread_mutex_unlock(&ingest->lock);
+
+	return ret;
+}
+
+int zone_ingest_finish(zone_ingest_t *ingest)
+{
+	if (ingest == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	(void)zone_ingest_flush(ingest);
+
+	pthread_mutex_lock(&ingest->lock);
+	ingest->finish = true;
+	pthread_cond_broadcast(&ingest->cond);
+	pthread_mutex_unlock(&ingest->lock);
+
+	pthread_join(ingest->thread, NULL);
+
+	int ret = ingest->ret;
+	ingest_free(ingest);
+	return ret;
+}
+
+void zone_ingest_abort(zone_ingest_t *ingest)
+{
+	if (ingest == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&ingest->lock);
+	ingest->stop = true;
+	pthread_cond_broadcast(&ingest->cond);
+	pthread_mutex_unlock(&ingest->lock);
+
+	pthread_join(ingest->thread, NULL);
+
+	ingest_free(ingest);
+}
@@ -0,0 +1,67 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "knot/zone/contents.h"
+
+/*!
+ * \brief Pipelined insertion of records into new zone contents.
+ *
+ * The caller (e.g. an incoming transfer) copies the records into batches,
+ * a helper thread inserts the finished batches into the contents in their
+ * order. Until zone_ingest_finish() or zone_ingest_abort(), the contents
+ * must not be accessed by the caller.
+ */
+typedef struct zone_ingest zone_ingest_t;
+
+/*!
+ * \brief Start the inserting thread.
+ *
+ * \param contents  Contents to insert the records into.
+ * \param ingest    Output: started ingest.
+ *
+ * \return KNOT_E*
+ */
+int zone_ingest_start(zone_contents_t *contents, zone_ingest_t **ingest);
+
+/*!
+ * \brief Copy a record into the current batch.
+ *
+ * \return KNOT_E*
+ */
+int zone_ingest_add(zone_ingest_t *ingest, const knot_rrset_t *rr);
+
+/*!
+ * \brief Pass the current batch to the inserting thread.
+ *
+ * Blocks while all the batches are waiting for insertion.
+ *
+ * \return KNOT_EOK, or the error of an insertion done so far.
+ */
+int zone_ingest_flush(zone_ingest_t *ingest);
+
+/*!
+ * \brief Insert the remaining batches and stop the inserting thread.
+ *
+ * \return KNOT_EOK, or the error of any of the insertions.
+ */
+int zone_ingest_finish(zone_ingest_t *ingest);
+
+/*!
+ * \brief Stop the inserting thread without inserting the remaining batches.
+ */
+void zone_ingest_abort(zone_ingest_t *ingest);
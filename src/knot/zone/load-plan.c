@@ -0,0 +1,190 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "knot/journal/journal_metadata.h"
+#include "knot/zone/load-plan.h"
+#include "knot/zone/zone.h"
+#include "contrib/time.h"
+
+struct load_plan_item {
+	zone_t *zone;
+	uint64_t cost;
+};
+
+/*! \brief Size of the journal data to be loaded or replayed. */
+static uint64_t journal_cost(conf_t *conf, zone_t *zone)
+{
+	conf_val_t val = conf_zone_get(conf, C_JOURNAL_CONTENT, zone->name);
+	if (conf_opt(&val) == JOURNAL_CONTENT_NONE || zone->server == NULL) {
+		return 0;
+	}
+
+	bool exists = false;
+	uint64_t occupied = 0;
+	int ret = journal_info(zone_journal(zone), &exists, NULL, NULL, NULL,
+	                       NULL, NULL, &occupied, NULL);
+	return (ret == KNOT_EOK && exists) ? occupied : 0;
+}
+
+/*!
+ * \brief Expected cost of the zone load, approximated by the zone file size
+ *        and the journal occupation.
+ */
+static uint64_t load_cost(conf_t *conf, zone_t *zone)
+{
+	uint64_t cost = journal_cost(conf, zone);
+
+	conf_val_t val = conf_zone_get(conf, C_ZONEFILE_LOAD, zone->name);
+	if (conf_opt(&val) == ZONEFILE_LOAD_NONE) {
+		return cost;
+	}
+
+	char *filename = conf_zonefile(conf, zone->name);
+	if (filename == NULL) {
+		return cost;
+	}
+
+	struct stat st;
+	if (stat(filename, &st) == 0) {
+		cost += st.st_size;
+	}
+	free(filename);
+
+	return cost;
+}
+
+static int cost_cmp(const void *a, const void *b)
+{
+	const struct load_plan_item *item_a = a, *item_b = b;
+
+	if (item_a->cost > item_b->cost) {
+		return -1;
+	} else if (item_a->cost < item_b->cost) {
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
+void load_plan_init(load_plan_t *plan)
+{
+	memset(plan, 0, sizeof(*plan));
+	pthread_mutex_init(&plan->mutex, NULL);
+}
+
+void load_plan_deinit(load_plan_t *plan)
+{
+	free(plan->pending);
+	pthread_mutex_destroy(&plan->mutex);
+}
+
+int load_plan_add(load_plan_t *plan, conf_t *conf, zone_t *zone)
+{
+	if (plan->pending_count == plan->pending_max) {
+		size_t new_max = (plan->pending_max == 0) ? 64 : 2 * plan->pending_max;
+		struct load_plan_item *new_pending =
+			realloc(plan->pending, new_max * sizeof(*new_pending));
+		if (new_pending == NULL) {
+			return KNOT_ENOMEM;
+		}
+		plan->pending = new_pending;
+		plan->pending_max = new_max;
+	}
+
+	struct load_plan_item *item = &plan->pending[plan->pending_count++];
+	item->zone = zone;
+	item->cost = load_cost(conf, zone);
+
+	return KNOT_EOK;
+}
+
+void load_plan_run(load_plan_t *plan)
+{
+	if (plan->pending_count == 0) {
+		return;
+	}
+
+	qsort(plan->pending, plan->pending_count, sizeof(*plan->pending), cost_cmp);
+
+	pthread_mutex_lock(&plan->mutex);
+	// Start a new progress if the previous loading is finished.
+	if (plan->zones_done == plan->zones_total) {
+		plan->zones_total = 0;
+		plan->zones_done = 0;
+		plan->bytes_total = 0;
+		plan->bytes_done = 0;
+		plan->started = time_now();
+	}
+	for (size_t i = 0; i < plan->pending_count; i++) {
+		struct load_plan_item *item = &plan->pending[i];
+		item->zone->load_plan.cost = item->cost;
+		item->zone->load_plan.planned = true;
+		plan->zones_total++;
+		plan->bytes_total += item->cost;
+	}
+	pthread_mutex_unlock(&plan->mutex);
+
+	for (size_t i = 0; i < plan->pending_count; i++) {
+		// enqueue directly, make first load waitable
+		// other events will cascade from load
+		zone_events_enqueue(plan->pending[i].zone, ZONE_EVENT_LOAD);
+	}
+
+	plan->pending_count = 0;
+}
+
+void load_plan_done(load_plan_t *plan, zone_t *zone)
+{
+	pthread_mutex_lock(&plan->mutex);
+	if (zone->load_plan.planned) {
+		zone->load_plan.planned = false;
+		plan->zones_done++;
+		plan->bytes_done += zone->load_plan.cost;
+	}
+	pthread_mutex_unlock(&plan->mutex);
+}
+
+void load_plan_progress(load_plan_t *plan, load_progress_t *progress)
+{
+	pthread_mutex_lock(&plan->mutex);
+	progress->zones_total = plan->zones_total;
+	progress->zones_done = plan->zones_done;
+	progress->bytes_total = plan->bytes_total;
+	progress->bytes_done = plan->bytes_done;
+	struct timespec started = plan->started;
+	pthread_mutex_unlock(&plan->mutex);
+
+	// Estimate by the loaded data size, or by the zone count if no zone files.
+	double total = progress->bytes_total, done = progress->bytes_done;
+	if (progress->bytes_total == 0) {
+		total = progress->zones_total;
+		done = progress->zones_done;
+	}
+
+	if (done >= total) {
+		progress->eta = 0;
+	} else if (done == 0) {
+		progress->eta = -1;
+	} else {
+		struct timespec now = time_now();
+		double elapsed = time_diff_ms(&started, &now) / 1000.0;
+		progress->eta = elapsed * (total - done) / done;
+	}
+}
@@ -0,0 +1,85 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "knot/conf/conf.h"
+
+struct zone;
+
+/*!
+ * \brief Initial loading of new zones.
+ *
+ * The loads are enqueued to the background workers ordered by their expected
+ * cost (zone file size and journal occupation), the most expensive first,
+ * so that huge zones don't delay the loading of small ones at the end and
+ * the workers are utilized evenly. The progress of the loading is tracked.
+ */
+typedef struct {
+	pthread_mutex_t mutex;
+
+	struct load_plan_item *pending; /*!< Zones to be enqueued for loading. */
+	size_t pending_count;
+	size_t pending_max;
+
+	size_t zones_total;    /*!< Number of zones planned for loading. */
+	size_t zones_done;     /*!< Number of zones finished loading. */
+	uint64_t bytes_total;  /*!< Expected size of data to be loaded. */
+	uint64_t bytes_done;   /*!< Size of data of zones finished loading. */
+	struct timespec started;
+} load_plan_t;
+
+/*! \brief Snapshot of the loading progress. */
+typedef struct {
+	size_t zones_total;
+	size_t zones_done;
+	uint64_t bytes_total;
+	uint64_t bytes_done;
+	int64_t eta;           /*!< Estimated remaining time in seconds, -1 if unknown. */
+} load_progress_t;
+
+void load_plan_init(load_plan_t *plan);
+void load_plan_deinit(load_plan_t *plan);
+
+/*!
+ * \brief Add a new zone, its load will be enqueued by load_plan_run().
+ *
+ * \param plan  Load plan.
+ * \param conf  Configuration.
+ * \param zone  Zone to be loaded.
+ *
+ * \return KNOT_E*
+ */
+int load_plan_add(load_plan_t *plan, conf_t *conf, struct zone *zone);
+
+/*!
+ * \brief Enqueue loads of the pending zones, the most expensive first.
+ */
+void load_plan_run(load_plan_t *plan);
+
+/*!
+ * \brief Account finished load of the zone (if planned).
+ */
+void load_plan_done(load_plan_t *plan, struct zone *zone);
+
+/*!
+ * \brief Get the loading progress.
+ */
+void load_plan_progress(load_plan_t *plan, load_progress_t *progress);
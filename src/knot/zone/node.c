@@ -45,7 +45,11 @@ bool additional_equal(additional_t *a, additional_t *b)
 /*! \brief Clears allocated data in RRSet entry. */
 static void rr_data_clear(struct rr_data *data, knot_mm_t *mm)
 {
-	knot_rdataset_clear(&data->rrs, mm);
+	if (data->interned) {
+		rdata_store_release(&data->rrs);
+	} else {
+		knot_rdataset_clear(&data->rrs, mm);
+	}
 	memset(data, 0, sizeof(*data));
 }
 
@@ -58,11 +62,35 @@ static int rr_data_from(const knot_rrset_t *rrset, struct rr_data *data, knot_mm
 	}
 	data->ttl = rrset->ttl;
 	data->type = rrset->type;
+	data->interned = false;
 	data->additional = NULL;
 
 	return KNOT_EOK;
 }
 
+/*! \brief Replaces interned data in RRSet entry with a private copy. */
+static int rr_data_unshare(zone_node_t *node, struct rr_data *data, knot_mm_t *mm)
+{
+	if (!data->interned) {
+		return KNOT_EOK;
+	}
+
+	knot_rdataset_t copy;
+	int ret = knot_rdataset_copy(&copy, &data->rrs, mm);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	// The bi-node counterpart keeps its reference.
+	if (!binode_rdata_shared(node, data->type)) {
+		rdata_store_release(&data->rrs);
+	}
+	data->rrs = copy;
+	data->interned = false;
+
+	return KNOT_EOK;
+}
+
 /*! \brief Adds RRSet to node directly. */
 static int add_rrset_no_merge(zone_node_t *node, const knot_rrset_t *rrset,
                               knot_mm_t *mm)
@@ -316,13 +344,17 @@ int node_add_rrset(zone_node_t *node, const knot_rrset_t *rrset, knot_mm_t *mm)
 	for (uint16_t i = 0; i < node->rrset_count; ++i) {
 		if (node->rrs[i].type == rrset->type) {
 			struct rr_data *node_data = &node->rrs[i];
+			int ret = rr_data_unshare(node, node_data, mm);
+			if (ret != KNOT_EOK) {
+				return ret;
+			}
+
 			const bool ttl_change = ttl_changed(node_data, rrset);
 			if (ttl_change) {
 				node_data->ttl = rrset->ttl;
 			}
 
-			int ret = knot_rdataset_merge(&node_data->rrs,
-			                              &rrset->rrs, mm);
+			ret = knot_rdataset_merge(&node_data->rrs, &rrset->rrs, mm);
 			if (ret != KNOT_EOK) {
 				return ret;
 			} else {
@@ -335,6 +367,40 @@ int node_add_rrset(zone_node_t *node, const knot_rrset_t *rrset, knot_mm_t *mm)
 	return add_rrset_no_merge(node, rrset, mm);
 }
 
+int node_intern_rrsets(zone_node_t *node, rdata_store_t *store)
+{
+	if (node == NULL || store == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	for (uint16_t i = 0; i < node->rrset_count; ++i) {
+		struct rr_data *data = &node->rrs[i];
+		if (data->interned || data->rrs.count == 0 ||
+		    !rdata_store_candidate(data->type) ||
+		    binode_rdata_shared(node, data->type)) {
+			continue;
+		}
+
+		knot_rdataset_t shared;
+		int ret = rdata_store_intern(store, &data->rrs, &shared);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		knot_rdataset_clear(&data->rrs, NULL);
+		data->rrs = shared;
+		data->interned = true;
+
+		// Changed back to the counterpart's data, which now become shared
+		// with it and thus are released only once, see binode_rdata_shared().
+		if (binode_rdata_shared(node, data->type)) {
+			rdata_store_release(&shared);
+		}
+	}
+
+	return KNOT_EOK;
+}
+
 void node_remove_rdataset(zone_node_t *node, uint16_t type)
 {
 	if (node == NULL) {
@@ -365,14 +431,26 @@ int node_remove_rrset(zone_node_t *node, const knot_rrset_t *rrset, knot_mm_t *m
 		return KNOT_EINVAL;
 	}
 
-	knot_rdataset_t *node_rrs = node_rdataset(node, rrset->type);
-	if (node_rrs == NULL) {
+	struct rr_data *node_data = NULL;
+	for (uint16_t i = 0; i < node->rrset_count; ++i) {
+		if (node->rrs[i].type == rrset->type) {
+			node_data = &node->rrs[i];
+			break;
+		}
+	}
+	if (node_data == NULL) {
 		return KNOT_ENOENT;
 	}
 
 	node->flags &= ~NODE_FLAGS_RRSIGS_VALID;
 
-	int ret = knot_rdataset_subtract(node_rrs, &rrset->rrs, mm);
+	int ret = rr_data_unshare(node, node_data, mm);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_rdataset_t *node_rrs = &node_data->rrs;
+	ret = knot_rdataset_subtract(node_rrs, &rrset->rrs, mm);
 	if (ret != KNOT_EOK) {
 		return ret;
 	}
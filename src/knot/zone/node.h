@@ -18,6 +18,7 @@
 
 #include "contrib/macros.h"
 #include "contrib/mempattern.h"
+#include "knot/zone/rdata_store.h"
 #include "libknot/descriptor.h"
 #include "libknot/dname.h"
 #include "libknot/rrset.h"
@@ -70,6 +71,7 @@ typedef struct {
 struct rr_data {
 	uint32_t ttl; /*!< RRSet TTL. */
 	uint16_t type; /*!< RR type of data. */
+	bool interned; /*!< Data are shared through rdata store, copy on write. */
 	knot_rdataset_t rrs; /*!< Data of given type. */
 	additional_t *additional; /*!< Additional nodes with glues. */
 };
@@ -231,6 +233,19 @@ void node_free(zone_node_t *node, knot_mm_t *mm);
  */
 int node_add_rrset(zone_node_t *node, const knot_rrset_t *rrset, knot_mm_t *mm);
 
+/*!
+ * \brief Replaces private rdatasets of the node with shared ones from the store.
+ *
+ * Rdatasets shared with the bi-node counterpart are skipped as they might be
+ * in use by readers of the previous zone version.
+ *
+ * \param node   Node to process.
+ * \param store  Rdata store.
+ *
+ * \return KNOT_E*
+ */
+int node_intern_rrsets(zone_node_t *node, rdata_store_t *store);
+
 /*!
  * \brief Removes data for given RR type from node.
  *
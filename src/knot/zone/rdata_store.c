@@ -0,0 +1,265 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "knot/zone/rdata_store.h"
+#include "contrib/openbsd/siphash.h"
+#include "libdnssec/random.h"
+#include "libknot/descriptor.h"
+#include "libknot/errcode.h"
+
+#define INIT_BUCKETS 1024
+
+/*! \brief Shared rdata with hidden header. */
+typedef struct rdata_shared {
+	struct rdata_shared *next; /*!< Next entry in the hash bucket. */
+	rdata_store_t *store;      /*!< Store the entry belongs to. */
+	uint32_t hash;             /*!< Hash of the rdata. */
+	uint32_t refcount;         /*!< Number of rdatasets referencing the entry. */
+	uint32_t size;             /*!< Size of the rdata. */
+	uint16_t count;            /*!< Number of RRs in the rdata. */
+	uint8_t rdata[] __attribute__((aligned(8)));
+} rdata_shared_t;
+
+struct rdata_store {
+	pthread_mutex_t lock;
+	SIPHASH_KEY key;
+	rdata_shared_t **buckets;
+	size_t bucket_count;
+	size_t refs;
+	rdata_store_stats_t stats;
+};
+
+static rdata_shared_t *shared_header(const knot_rdata_t *rdata)
+{
+	return (rdata_shared_t *)((uint8_t *)rdata - offsetof(rdata_shared_t, rdata));
+}
+
+static uint32_t rdata_hash(const rdata_store_t *store, const knot_rdataset_t *rrs)
+{
+	return SipHash24(&store->key, rrs->rdata, rrs->size);
+}
+
+static void store_free(rdata_store_t *store)
+{
+	assert(store->stats.entries == 0);
+	pthread_mutex_destroy(&store->lock);
+	free(store->buckets);
+	free(store);
+}
+
+rdata_store_t *rdata_store_new(void)
+{
+	rdata_store_t *store = calloc(1, sizeof(*store));
+	if (store == NULL) {
+		return NULL;
+	}
+
+	store->buckets = calloc(INIT_BUCKETS, sizeof(*store->buckets));
+	if (store->buckets == NULL) {
+		free(store);
+		return NULL;
+	}
+	store->bucket_count = INIT_BUCKETS;
+	store->refs = 1;
+
+	int ret = dnssec_random_buffer((uint8_t *)&store->key, sizeof(store->key));
+	if (ret != KNOT_EOK) {
+		free(store->buckets);
+		free(store);
+		return NULL;
+	}
+
+	pthread_mutex_init(&store->lock, NULL);
+
+	return store;
+}
+
+rdata_store_t *rdata_store_ref(rdata_store_t *store)
+{
+	if (store != NULL) {
+		pthread_mutex_lock(&store->lock);
+		store->refs++;
+		pthread_mutex_unlock(&store->lock);
+	}
+	return store;
+}
+
+void rdata_store_unref(rdata_store_t *store)
+{
+	if (store == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&store->lock);
+	assert(store->refs > 0);
+	bool last = (--store->refs == 0);
+	pthread_mutex_unlock(&store->lock);
+
+	if (last) {
+		store_free(store);
+	}
+}
+
+bool rdata_store_candidate(uint16_t type)
+{
+	switch (type) {
+	case KNOT_RRTYPE_SOA:
+	case KNOT_RRTYPE_RRSIG:
+	case KNOT_RRTYPE_NSEC:
+	case KNOT_RRTYPE_NSEC3:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/*! \brief Double the bucket count, fails silently if out of memory. */
+static void store_grow(rdata_store_t *store)
+{
+	size_t new_count = store->bucket_count * 2;
+	rdata_shared_t **new_buckets = calloc(new_count, sizeof(*new_buckets));
+	if (new_buckets == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < store->bucket_count; i++) {
+		rdata_shared_t *entry = store->buckets[i];
+		while (entry != NULL) {
+			rdata_shared_t *next = entry->next;
+			size_t pos = entry->hash & (new_count - 1);
+			entry->next = new_buckets[pos];
+			new_buckets[pos] = entry;
+			entry = next;
+		}
+	}
+
+	free(store->buckets);
+	store->buckets = new_buckets;
+	store->bucket_count = new_count;
+}
+
+int rdata_store_intern(rdata_store_t *store, const knot_rdataset_t *src,
+                       knot_rdataset_t *dst)
+{
+	if (store == NULL || src == NULL || dst == NULL || src->count == 0) {
+		return KNOT_EINVAL;
+	}
+
+	uint32_t hash = rdata_hash(store, src);
+
+	pthread_mutex_lock(&store->lock);
+
+	rdata_shared_t **bucket = &store->buckets[hash & (store->bucket_count - 1)];
+	rdata_shared_t *entry = *bucket;
+	while (entry != NULL) {
+		if (entry->hash == hash && entry->size == src->size &&
+		    entry->count == src->count &&
+		    memcmp(entry->rdata, src->rdata, src->size) == 0) {
+			break;
+		}
+		entry = entry->next;
+	}
+
+	if (entry == NULL) {
+		entry = malloc(sizeof(*entry) + src->size);
+		if (entry == NULL) {
+			pthread_mutex_unlock(&store->lock);
+			return KNOT_ENOMEM;
+		}
+		entry->store = store;
+		entry->hash = hash;
+		entry->refcount = 0;
+		entry->size = src->size;
+		entry->count = src->count;
+		memcpy(entry->rdata, src->rdata, src->size);
+		entry->next = *bucket;
+		*bucket = entry;
+
+		store->refs++; // Each entry holds a reference to the store.
+		store->stats.entries++;
+		store->stats.bytes += src->size;
+		if (store->stats.entries > store->bucket_count) {
+			store_grow(store);
+		}
+	}
+
+	entry->refcount++;
+	store->stats.refs++;
+	store->stats.ref_bytes += src->size;
+
+	pthread_mutex_unlock(&store->lock);
+
+	dst->count = entry->count;
+	dst->size = entry->size;
+	dst->rdata = (knot_rdata_t *)entry->rdata;
+
+	return KNOT_EOK;
+}
+
+void rdata_store_release(knot_rdataset_t *rrs)
+{
+	if (rrs == NULL || rrs->rdata == NULL) {
+		return;
+	}
+
+	rdata_shared_t *entry = shared_header(rrs->rdata);
+	rdata_store_t *store = entry->store;
+
+	pthread_mutex_lock(&store->lock);
+
+	assert(entry->refcount > 0);
+	store->stats.refs--;
+	store->stats.ref_bytes -= entry->size;
+
+	bool unused = (--entry->refcount == 0);
+	if (unused) {
+		rdata_shared_t **it = &store->buckets[entry->hash & (store->bucket_count - 1)];
+		while (*it != entry) {
+			assert(*it != NULL);
+			it = &(*it)->next;
+		}
+		*it = entry->next;
+
+		store->stats.entries--;
+		store->stats.bytes -= entry->size;
+	}
+
+	pthread_mutex_unlock(&store->lock);
+
+	if (unused) {
+		free(entry);
+		rdata_store_unref(store);
+	}
+
+	knot_rdataset_init(rrs);
+}
+
+void rdata_store_stats(rdata_store_t *store, rdata_store_stats_t *stats)
+{
+	if (store == NULL) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	pthread_mutex_lock(&store->lock);
+	*stats = store->stats;
+	pthread_mutex_unlock(&store->lock);
+}
@@ -0,0 +1,89 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libknot/rdataset.h"
+
+/*!
+ * \brief Content-addressed store of rdatasets shared among zone nodes.
+ *
+ * Interned rdata are preceded by a hidden header with a reference count,
+ * thus they must never be reallocated or freed directly. Modify a private
+ * copy instead and release the interned one (copy on write).
+ */
+typedef struct rdata_store rdata_store_t;
+
+/*! \brief Rdata store statistics. */
+typedef struct {
+	size_t entries;   /*!< Number of distinct interned rdatasets. */
+	size_t refs;      /*!< Number of references to interned rdatasets. */
+	size_t bytes;     /*!< Size of interned rdata. */
+	size_t ref_bytes; /*!< Size of rdata referenced, i.e. allocated without sharing. */
+} rdata_store_stats_t;
+
+/*!
+ * \brief Create a new rdata store.
+ *
+ * \return Store with one reference, or NULL if error.
+ */
+rdata_store_t *rdata_store_new(void);
+
+/*!
+ * \brief Take another reference to the store.
+ */
+rdata_store_t *rdata_store_ref(rdata_store_t *store);
+
+/*!
+ * \brief Drop a reference to the store, free it when no longer used.
+ *
+ * \note Interned rdatasets hold a reference to the store themselves.
+ */
+void rdata_store_unref(rdata_store_t *store);
+
+/*!
+ * \brief Check if rdatasets of given type are worth interning.
+ *
+ * Types with per-owner unique data (SOA, RRSIG, NSEC, NSEC3) are excluded,
+ * SOA also because its serial is modified in place.
+ */
+bool rdata_store_candidate(uint16_t type);
+
+/*!
+ * \brief Get a shared rdataset identical to the given one.
+ *
+ * \param store  Rdata store.
+ * \param src    Rdataset to be interned (it's not modified).
+ * \param dst    Out: rdataset pointing to the shared rdata.
+ *
+ * \return KNOT_E*
+ */
+int rdata_store_intern(rdata_store_t *store, const knot_rdataset_t *src,
+                       knot_rdataset_t *dst);
+
+/*!
+ * \brief Release a reference to interned rdata and re-initialize the rdataset.
+ */
+void rdata_store_release(knot_rdataset_t *rrs);
+
+/*!
+ * \brief Get current statistics of the store.
+ */
+void rdata_store_stats(rdata_store_t *store, rdata_store_stats_t *stats);
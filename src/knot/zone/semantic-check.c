@@ -14,6 +14,7 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -22,7 +23,9 @@
 
 #include "libdnssec/error.h"
 #include "contrib/base32hex.h"
+#include "contrib/macros.h"
 #include "contrib/string.h"
+#include "libknot/dynarray.h"
 #include "libknot/libknot.h"
 #include "knot/zone/semantic-check.h"
 #include "knot/dnssec/rrset-sign.h"
@@ -174,6 +177,7 @@ static int check_nsec3_presence(const zone_node_t *node, semchecks_data_t *data)
 struct check_function {
 	int (*function)(const zone_node_t *, semchecks_data_t *);
 	check_level_t level;
+	bool sequential; // depends on the previously checked nodes
 };
 
 /* List of function callbacks for defined check_level */
@@ -187,7 +191,7 @@ static const struct check_function CHECK_FUNCTIONS[] = {
 	{ check_rrsig,          NSEC | NSEC3 },
 	{ check_rrsig_signed,   NSEC | NSEC3 },
 	{ check_nsec_bitmap,    NSEC | NSEC3 },
-	{ check_nsec,           NSEC },
+	{ check_nsec,           NSEC, true },
 	{ check_nsec3,          NSEC3 },
 	{ check_nsec3_presence, NSEC3 },
 	{ check_nsec3_opt_out,  NSEC3 },
@@ -882,7 +886,7 @@ static int check_nsec3_opt_out(const zone_node_t *node, semchecks_data_t *data)
 
 	const zone_node_t *nsec3_previous = NULL;
 	const zone_node_t *nsec3_node;
-	zone_contents_find_nsec3_for_name(data->zone, node->owner, &nsec3_node,
+	zone_contents_find_nsec3_for_name(data->zone, node->owner, NULL, &nsec3_node,
 	                                  &nsec3_previous);
 
 	if (nsec3_previous == NULL) {
@@ -1179,6 +1183,185 @@ static int do_checks_in_tree(zone_node_t *node, void *data)
 	return ret;
 }
 
+/*!
+ * \brief Error found by a parallel check or a postponed sequential check.
+ */
+typedef struct {
+	const zone_node_t *node;
+	sem_error_t error;
+	bool fatal;     // the handler error flag was set
+	int postponed;  // index of a postponed sequential check, or -1
+	char *data;
+} sem_event_t;
+
+knot_dynarray_declare(sem_event, sem_event_t, DYNARRAY_VISIBILITY_STATIC, 16)
+knot_dynarray_define(sem_event, sem_event_t, DYNARRAY_VISIBILITY_STATIC)
+
+typedef struct {
+	sem_handler_t handler;       // must be first, recording handler
+	semchecks_data_t data;
+	sem_event_dynarray_t events;
+	zone_node_t **nodes;         // nodes to check
+	size_t count;
+	bool nomem;
+	bool started;
+	pthread_t thread;
+	int ret;
+} sem_worker_t;
+
+static void add_event(sem_worker_t *worker, const sem_event_t *event)
+{
+	if (sem_event_dynarray_add(&worker->events, event) == NULL) {
+		free(event->data);
+		worker->nomem = true;
+	}
+}
+
+static void record_error(sem_handler_t *handler, _unused_ const zone_contents_t *zone,
+                         const zone_node_t *node, sem_error_t error, const char *data)
+{
+	sem_worker_t *worker = (sem_worker_t *)handler;
+
+	sem_event_t event = {
+		.node = node,
+		.error = error,
+		.fatal = handler->error,
+		.postponed = -1,
+		.data = (data != NULL) ? strdup(data) : NULL
+	};
+	if (data != NULL && event.data == NULL) {
+		worker->nomem = true;
+		return;
+	}
+	handler->error = false;
+
+	add_event(worker, &event);
+}
+
+static int do_checks_recorded(zone_node_t *node, sem_worker_t *worker)
+{
+	int ret = KNOT_EOK;
+
+	for (int i = 0; ret == KNOT_EOK && i < CHECK_FUNCTIONS_LEN; ++i) {
+		if (!(CHECK_FUNCTIONS[i].level & worker->data.level)) {
+			continue;
+		}
+		if (CHECK_FUNCTIONS[i].sequential) {
+			sem_event_t event = { .node = node, .postponed = i };
+			add_event(worker, &event);
+		} else {
+			ret = CHECK_FUNCTIONS[i].function(node, &worker->data);
+		}
+	}
+
+	return worker->nomem ? KNOT_ENOMEM : ret;
+}
+
+static void *checks_thread(void *ctx)
+{
+	sem_worker_t *worker = ctx;
+
+	int ret = KNOT_EOK;
+	for (size_t i = 0; ret == KNOT_EOK && i < worker->count; i++) {
+		ret = do_checks_recorded(worker->nodes[i], worker);
+	}
+	worker->ret = ret;
+
+	return NULL;
+}
+
+/*!
+ * \brief Report the recorded errors and run the postponed checks in the order
+ *        of the nodes.
+ */
+static int replay_events(sem_worker_t *worker, semchecks_data_t *data)
+{
+	int ret = KNOT_EOK;
+
+	knot_dynarray_foreach(sem_event, sem_event_t, event, worker->events) {
+		if (ret != KNOT_EOK) {
+			break;
+		}
+		if (event->postponed >= 0) {
+			ret = CHECK_FUNCTIONS[event->postponed].function(event->node, data);
+			continue;
+		}
+		if (event->fatal) {
+			data->handler->error = true;
+		}
+		data->handler->cb(data->handler, data->zone, event->node,
+		                  event->error, event->data);
+	}
+
+	return ret;
+}
+
+/*!
+ * \brief Run the node checks in parallel over contiguous ranges of nodes.
+ *
+ * The errors are reported in the same order as if checked in one thread.
+ */
+static int collect_node(zone_node_t *node, void *data)
+{
+	zone_node_t ***next = data;
+	*(*next)++ = node;
+	return KNOT_EOK;
+}
+
+static int do_checks_parallel(semchecks_data_t *data, unsigned threads)
+{
+	size_t count = zone_tree_count(data->zone->nodes);
+
+	// Split the nodes once, each worker checks only its range.
+	zone_node_t **nodes = malloc(MAX(count, 1) * sizeof(*nodes));
+	if (nodes == NULL) {
+		return KNOT_ENOMEM;
+	}
+	zone_node_t **next = nodes;
+	(void)zone_tree_apply(data->zone->nodes, collect_node, &next);
+	assert(next - nodes == count);
+
+	sem_worker_t workers[threads];
+	memset(workers, 0, sizeof(workers));
+
+	for (unsigned i = 0; i < threads; i++) {
+		workers[i].handler.cb = record_error;
+		workers[i].data = *data;
+		workers[i].data.handler = &workers[i].handler;
+		workers[i].nodes = nodes + count * i / threads;
+		workers[i].count = count * (i + 1) / threads - count * i / threads;
+		int err = pthread_create(&workers[i].thread, NULL, checks_thread, &workers[i]);
+		if (err == 0) {
+			workers[i].started = true;
+		} else {
+			workers[i].ret = knot_map_errno_code(err);
+		}
+	}
+
+	for (unsigned i = 0; i < threads; i++) {
+		if (workers[i].started) {
+			(void)pthread_join(workers[i].thread, NULL);
+		}
+	}
+
+	int ret = KNOT_EOK;
+	for (unsigned i = 0; i < threads; i++) {
+		if (ret == KNOT_EOK) {
+			ret = replay_events(&workers[i], data);
+		}
+		if (ret == KNOT_EOK) {
+			ret = workers[i].ret;
+		}
+		knot_dynarray_foreach(sem_event, sem_event_t, event, workers[i].events) {
+			free(event->data);
+		}
+		sem_event_dynarray_free(&workers[i].events);
+	}
+	free(nodes);
+
+	return ret;
+}
+
 static void check_nsec3param(knot_rdataset_t *nsec3param, zone_contents_t *zone,
                              sem_handler_t *handler, semchecks_data_t *data)
 {
@@ -1254,7 +1437,7 @@ static int unmark_nsec3_optout(zone_node_t *node, _unused_ void *ctx)
 }
 
 int sem_checks_process(zone_contents_t *zone, semcheck_optional_t optional, sem_handler_t *handler,
-                       time_t time)
+                       time_t time, unsigned threads)
 {
 	if (handler == NULL) {
 		return KNOT_EINVAL;
@@ -1294,7 +1477,12 @@ int sem_checks_process(zone_contents_t *zone, semcheck_optional_t optional, sem_
 			return ret;
 		}
 	}
-	int ret = zone_contents_apply(zone, do_checks_in_tree, &data);
+	int ret;
+	if (threads > 1) {
+		ret = do_checks_parallel(&data, threads);
+	} else {
+		ret = zone_contents_apply(zone, do_checks_in_tree, &data);
+	}
 	if (data.level & NSEC3) {
 		(void)zone_tree_apply(zone->nodes, unmark_nsec3_optout, NULL);
 	}
@@ -48,6 +48,8 @@ int zone_load_contents(conf_t *conf, const knot_dname_t *zone_name,
 
 	zl.err_handler = &handler;
 	zl.creator->master = !zone_load_can_bootstrap(conf, zone_name);
+	val = conf_zone_get(conf, C_ADJUST_THR, zone_name);
+	zl.threads = conf_int(&val);
 
 	*contents = zonefile_load(&zl);
 	zonefile_close(&zl);
@@ -78,6 +80,38 @@ static int apply_one_cb(bool remove, const knot_rrset_t *rr, void *ctx)
 	}
 }
 
+static int add_one_cb(bool remove, const knot_rrset_t *rr, void *ctx)
+{
+	(void)remove;
+	zone_node_t *unused = NULL;
+	return zone_contents_add_rr(ctx, rr, &unused);
+}
+
+/*! \brief Minimal journal occupation to read it ahead on a helper thread. */
+#define JOURNAL_PREFETCH_MIN	(1024 * 1024)
+
+static bool journal_prefetch(zone_t *zone)
+{
+	bool exists = false;
+	uint64_t occupied = 0;
+	int ret = journal_info(zone_journal(zone), &exists, NULL, NULL, NULL,
+	                       NULL, NULL, &occupied, NULL);
+	return ret == KNOT_EOK && exists && occupied >= JOURNAL_PREFETCH_MIN;
+}
+
+/*! \brief Apply the journal changes, closes the reading context. */
+static int apply_changes(journal_read_t *read, zone_contents_t *contents, bool prefetch)
+{
+	if (!prefetch) {
+		return journal_read_rrsets(read, apply_one_cb, contents);
+	}
+
+	// the next changes are read while the current ones are applied
+	int ret = journal_read_rrsets_prefetch(read, true, apply_one_cb, contents);
+	journal_read_end(read);
+	return ret;
+}
+
 int zone_load_journal(conf_t *conf, zone_t *zone, zone_contents_t *contents)
 {
 	if (conf == NULL || zone == NULL) {
@@ -89,6 +123,7 @@ int zone_load_journal(conf_t *conf, zone_t *zone, zone_contents_t *contents)
 		return KNOT_EOK;
 	}
 	uint32_t serial = zone_contents_serial(contents);
+	bool prefetch = journal_prefetch(zone);
 
 	journal_read_t *read = NULL;
 	int ret = journal_read_begin(zone_journal(zone), false, serial, &read);
@@ -101,7 +136,7 @@ int zone_load_journal(conf_t *conf, zone_t *zone, zone_contents_t *contents)
 		return ret;
 	}
 
-	ret = journal_read_rrsets(read, apply_one_cb, contents);
+	ret = apply_changes(read, contents, prefetch);
 	if (ret == KNOT_EOK) {
 		log_zone_info(zone->name, "changes from journal applied, serial %u -> %u",
 		              serial, zone_contents_serial(contents));
@@ -125,6 +160,8 @@ int zone_load_from_journal(conf_t *conf, zone_t *zone, zone_contents_t **content
 		return KNOT_ENOMEM;
 	}
 
+	bool prefetch = journal_prefetch(zone);
+
 	journal_read_t *read = NULL;
 	int ret = journal_read_begin(zone_journal(zone), true, 0, &read);
 	if (ret == KNOT_ENOENT) {
@@ -133,15 +170,26 @@ int zone_load_from_journal(conf_t *conf, zone_t *zone, zone_contents_t **content
 		return ret;
 	}
 
-	knot_rrset_t rr = { 0 };
-	while (ret == KNOT_EOK && journal_read_rrset(read, &rr, false)) {
-		zone_node_t *unused = NULL;
-		ret = zone_contents_add_rr(*contents, &rr, &unused);
-		journal_read_clear_rrset(&rr);
+	// The zone-in-journal is stored sorted.
+	if (ret == KNOT_EOK) {
+		ret = zone_contents_bulk_begin(*contents);
+	}
+
+	if (ret == KNOT_EOK && prefetch) {
+		ret = journal_read_rrsets_prefetch(read, false, add_one_cb, *contents);
+	} else {
+		knot_rrset_t rr = { 0 };
+		while (ret == KNOT_EOK && journal_read_rrset_borrowed(read, &rr, false)) {
+			ret = add_one_cb(false, &rr, *contents);
+		}
+	}
+
+	if (ret == KNOT_EOK) {
+		ret = zone_contents_bulk_end(*contents);
 	}
 
 	if (ret == KNOT_EOK) {
-		ret = journal_read_rrsets(read, apply_one_cb, *contents);
+		ret = apply_changes(read, *contents, prefetch);
 	} else {
 		journal_read_end(read);
 	}
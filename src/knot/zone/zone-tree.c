@@ -16,8 +16,10 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "knot/zone/zone-tree.h"
+#include "contrib/macros.h"
 #include "libknot/consts.h"
 #include "libknot/errcode.h"
 #include "libknot/packet/wire.h"
@@ -36,6 +38,14 @@ static int tree_apply_cb(trie_val_t *node, void *data)
 	return f->func(n, f->data);
 }
 
+/*! \brief Finish the bulk loading before any other operation with the tree. */
+static void bulk_flush(zone_tree_t *tree)
+{
+	if (tree != NULL && tree->bulk != NULL) {
+		(void)zone_tree_bulk_end(tree);
+	}
+}
+
 zone_tree_t *zone_tree_create(bool use_binodes)
 {
 	zone_tree_t *t = calloc(1, sizeof(*t));
@@ -58,6 +68,7 @@ zone_tree_t *zone_tree_cow(zone_tree_t *from)
 	if (to == NULL) {
 		return to;
 	}
+	bulk_flush(from);
 	to->flags = from->flags ^ ZONE_TREE_BINO_SECOND;
 	from->cow = trie_cow(from->trie, NULL, NULL);
 	to->cow = from->cow;
@@ -80,6 +91,7 @@ zone_tree_t *zone_tree_shallow_copy(zone_tree_t *from)
 	if (to == NULL) {
 		return to;
 	}
+	bulk_flush(from);
 	to->flags = from->flags;
 	to->trie = trie_dup(from->trie, nocopy, NULL);
 	if (to->trie == NULL) {
@@ -89,12 +101,133 @@ zone_tree_t *zone_tree_shallow_copy(zone_tree_t *from)
 	return to;
 }
 
+static int bulk_push(zone_tree_bulk_t *bulk, zone_node_t *node)
+{
+	if (bulk->count == bulk->max) {
+		size_t new_max = (bulk->max == 0) ? 64 : 2 * bulk->max;
+		zone_node_t **new_nodes = realloc(bulk->nodes, new_max * sizeof(*new_nodes));
+		if (new_nodes == NULL) {
+			return KNOT_ENOMEM;
+		}
+		bulk->nodes = new_nodes;
+		bulk->max = new_max;
+	}
+	bulk->nodes[bulk->count++] = node;
+	return KNOT_EOK;
+}
+
+int zone_tree_bulk_begin(zone_tree_t *tree)
+{
+	if (tree == NULL || tree->cow != NULL) {
+		return KNOT_EINVAL;
+	} else if (tree->bulk != NULL) {
+		return KNOT_EOK;
+	}
+
+	zone_tree_bulk_t *bulk = calloc(1, sizeof(*bulk));
+	if (bulk == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	// Move the already present nodes (typically apex) to the bulk, they are sorted.
+	trie_it_t *it = trie_it_begin(tree->trie);
+	if (it == NULL) {
+		free(bulk);
+		return KNOT_ENOMEM;
+	}
+	for (; !trie_it_finished(it); trie_it_next(it)) {
+		if (bulk_push(bulk, *trie_it_val(it)) != KNOT_EOK) {
+			trie_it_free(it);
+			free(bulk->nodes);
+			free(bulk);
+			return KNOT_ENOMEM;
+		}
+		size_t len;
+		const trie_key_t *key = trie_it_key(it, &len);
+		bulk->last_lf[0] = len;
+		memcpy(bulk->last_lf + 1, key, len);
+	}
+	trie_it_free(it);
+
+	trie_clear(tree->trie);
+	tree->bulk = bulk;
+
+	return KNOT_EOK;
+}
+
+typedef struct {
+	zone_tree_bulk_t *bulk;
+	size_t pos;
+	knot_dname_storage_t lf_storage;
+} bulk_build_ctx_t;
+
+static int bulk_build_cb(const trie_key_t **key, uint32_t *len, trie_val_t *val, void *d)
+{
+	bulk_build_ctx_t *ctx = d;
+	if (ctx->pos >= ctx->bulk->count) {
+		return KNOT_ENOENT;
+	}
+
+	zone_node_t *node = ctx->bulk->nodes[ctx->pos++];
+	uint8_t *lf = knot_dname_lf(node->owner, ctx->lf_storage);
+	assert(lf);
+
+	*key = lf + 1;
+	*len = *lf;
+	*val = node;
+	return KNOT_EOK;
+}
+
+int zone_tree_bulk_end(zone_tree_t *tree)
+{
+	if (tree == NULL || tree->bulk == NULL) {
+		return KNOT_EOK;
+	}
+
+	zone_tree_bulk_t *bulk = tree->bulk;
+	tree->bulk = NULL;
+
+	bulk_build_ctx_t ctx = { .bulk = bulk };
+	int ret = trie_bulk_build(tree->trie, bulk_build_cb, &ctx);
+	if (ret != KNOT_EOK) {
+		// Fall back to the insertion one by one.
+		for (size_t i = 0; i < bulk->count; i++) {
+			uint8_t *lf = knot_dname_lf(bulk->nodes[i]->owner, ctx.lf_storage);
+			trie_val_t *val = trie_get_ins(tree->trie, lf + 1, *lf);
+			if (val == NULL) {
+				ret = KNOT_ENOMEM;
+				break;
+			}
+			*val = bulk->nodes[i];
+			ret = KNOT_EOK;
+		}
+	}
+
+	free(bulk->nodes);
+	free(bulk);
+
+	return ret;
+}
+
+int zone_tree_freeze(zone_tree_t *tree)
+{
+	if (tree == NULL || tree->cow != NULL) {
+		return KNOT_EINVAL;
+	}
+
+	bulk_flush(tree);
+
+	return trie_freeze(tree->trie);
+}
+
 int zone_tree_insert(zone_tree_t *tree, zone_node_t **node)
 {
 	if (tree == NULL || node == NULL || *node == NULL) {
 		return KNOT_EINVAL;
 	}
 
+	bulk_flush(tree);
+
 	assert((*node)->owner);
 	knot_dname_storage_t lf_storage;
 	uint8_t *lf = knot_dname_lf((*node)->owner, lf_storage);
@@ -127,6 +260,8 @@ zone_node_t *zone_tree_get(zone_tree_t *tree, const knot_dname_t *owner)
 		return NULL;
 	}
 
+	bulk_flush(tree);
+
 	if (zone_tree_is_empty(tree)) {
 		return NULL;
 	}
@@ -152,6 +287,8 @@ int zone_tree_get_less_or_equal(zone_tree_t *tree,
 		return KNOT_EINVAL;
 	}
 
+	bulk_flush(tree);
+
 	if (zone_tree_is_empty(tree)) {
 		return KNOT_ENONODE;
 	}
@@ -200,6 +337,8 @@ int zone_tree_get_less_or_equal(zone_tree_t *tree,
 /*! \brief Removes node with the given owner from the zone tree. */
 void zone_tree_remove_node(zone_tree_t *tree, const knot_dname_t *owner)
 {
+	bulk_flush(tree);
+
 	if (zone_tree_is_empty(tree) || owner == NULL) {
 		return;
 	}
@@ -218,6 +357,73 @@ void zone_tree_remove_node(zone_tree_t *tree, const knot_dname_t *owner)
 	}
 }
 
+static int bulk_add_node(zone_tree_t *tree, zone_node_t *apex, const knot_dname_t *dname,
+                         zone_tree_new_node_cb_t new_cb, void *new_cb_ctx, zone_node_t **new_node)
+{
+	zone_tree_bulk_t *bulk = tree->bulk;
+
+	knot_dname_storage_t lf_storage;
+	uint8_t *lf = knot_dname_lf(dname, lf_storage);
+	assert(lf);
+
+	zone_node_t *parent = apex;
+	if (bulk->count > 0) {
+		zone_node_t *last = zone_tree_fix_get(bulk->nodes[bulk->count - 1], tree);
+		int cmp = memcmp(lf + 1, bulk->last_lf + 1, MIN(*lf, *bulk->last_lf));
+		if (cmp == 0) {
+			cmp = (int)*lf - (int)*bulk->last_lf;
+		}
+		if (cmp == 0) {
+			*new_node = last;
+			return KNOT_EOK;
+		} else if (cmp < 0) {
+			return KNOT_EAGAIN; // Out of order.
+		}
+
+		// With sorted nodes, the closest existing ancestor is an ancestor
+		// of the last node (or the last node itself).
+		for (parent = last; parent != NULL; parent = node_parent(parent)) {
+			if (knot_dname_in_bailiwick(dname, parent->owner) > 0) {
+				break;
+			}
+		}
+		if (parent == NULL) {
+			parent = apex;
+		}
+	}
+
+	// Create the missing nodes from the top, so that they are sorted.
+	const knot_dname_t *names[KNOT_DNAME_MAXLABELS];
+	int missing = knot_dname_in_bailiwick(dname, parent->owner);
+	assert(missing > 0);
+	names[0] = dname;
+	for (int i = 1; i < missing; i++) {
+		names[i] = knot_wire_next_label(names[i - 1], NULL);
+	}
+	for (int i = missing - 1; i >= 0; i--) {
+		zone_node_t *node = new_cb(names[i], new_cb_ctx);
+		if (node == NULL) {
+			return KNOT_ENOMEM;
+		}
+		int ret = bulk_push(bulk, binode_first(node));
+		if (ret != KNOT_EOK) {
+			node_free(node, NULL);
+			return ret;
+		}
+		node = zone_tree_fix_get(node, tree);
+		node->parent = parent;
+		parent->children++;
+		if (knot_dname_is_wildcard(names[i])) {
+			parent->flags |= NODE_FLAGS_WILDCARD_CHILD;
+		}
+		parent = node;
+	}
+	memcpy(bulk->last_lf, lf, *lf + 1);
+
+	*new_node = parent;
+	return KNOT_EOK;
+}
+
 int zone_tree_add_node(zone_tree_t *tree, zone_node_t *apex, const knot_dname_t *dname,
                        zone_tree_new_node_cb_t new_cb, void *new_cb_ctx, zone_node_t **new_node)
 {
@@ -229,6 +435,18 @@ int zone_tree_add_node(zone_tree_t *tree, zone_node_t *apex, const knot_dname_t
 		return KNOT_EOUTOFZONE;
 	}
 
+	if (tree->bulk != NULL) {
+		int ret = bulk_add_node(tree, apex, dname, new_cb, new_cb_ctx, new_node);
+		if (ret != KNOT_EAGAIN) {
+			return ret;
+		}
+		// Not sorted, continue without the bulk loading.
+		ret = zone_tree_bulk_end(tree);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
 	*new_node = zone_tree_get(tree, dname);
 	if (*new_node == NULL) {
 		*new_node = new_cb(dname, new_cb_ctx);
@@ -289,6 +507,8 @@ int zone_tree_apply(zone_tree_t *tree, zone_tree_apply_cb_t function, void *data
 		return KNOT_EINVAL;
 	}
 
+	bulk_flush(tree);
+
 	if (zone_tree_is_empty(tree)) {
 		return KNOT_EOK;
 	}
@@ -347,6 +567,8 @@ int zone_tree_it_sub_begin(zone_tree_t *tree, const knot_dname_t *sub_root,
 int zone_tree_it_double_begin(zone_tree_t *first, zone_tree_t *second, zone_tree_it_t *it)
 {
 	if (it->tree == NULL) {
+		bulk_flush(first);
+		bulk_flush(second);
 		it->it = trie_it_begin(first->trie);
 		if (it->it == NULL) {
 			return KNOT_ENOMEM;
@@ -499,6 +721,10 @@ void zone_tree_free(zone_tree_t **tree)
 		return;
 	}
 
+	if ((*tree)->bulk != NULL) {
+		free((*tree)->bulk->nodes);
+		free((*tree)->bulk);
+	}
 	trie_free((*tree)->trie);
 	free(*tree);
 	*tree = NULL;
@@ -27,9 +27,23 @@ enum {
 	ZONE_TREE_BINO_SECOND = (1 << 1),
 };
 
+/*!
+ * \brief Nodes of a zone tree being loaded in canonical order.
+ *
+ * The nodes are collected in an array and the trie is built at once
+ * by zone_tree_bulk_end().
+ */
+typedef struct {
+	zone_node_t **nodes;
+	size_t count;
+	size_t max;
+	knot_dname_storage_t last_lf; // lookup format of the last node owner
+} zone_tree_bulk_t;
+
 typedef struct {
 	trie_t *trie;
 	trie_cow_t *cow; // non-NULL only during zone update
+	zone_tree_bulk_t *bulk; // non-NULL only during bulk loading
 	uint16_t flags;
 } zone_tree_t;
 
@@ -90,7 +104,7 @@ inline static size_t zone_tree_count(const zone_tree_t *tree)
 		return 0;
 	}
 
-	return trie_weight(tree->trie);
+	return trie_weight(tree->trie) + (tree->bulk != NULL ? tree->bulk->count : 0);
 }
 
 /*!
@@ -118,6 +132,47 @@ inline static zone_node_t *node_new_for_tree(const knot_dname_t *owner, const zo
 	return node_new(owner, (tree->flags & ZONE_TREE_USE_BINODES), (tree->flags & ZONE_TREE_BINO_SECOND), mm);
 }
 
+/*!
+ * \brief Start loading of the zone tree with nodes in canonical order.
+ *
+ * Until zone_tree_bulk_end(), new nodes added by zone_tree_add_node() are only
+ * collected and the trie is built at once in the end, which is much faster
+ * than inserting the nodes one by one. If a node out of order is added, the
+ * bulk loading is ended and the tree continues as usual.
+ *
+ * \note Any other operation with the tree ends the bulk loading too.
+ *
+ * \param tree  Zone tree, not in COW mode.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int zone_tree_bulk_begin(zone_tree_t *tree);
+
+/*!
+ * \brief Build the trie of the zone tree from the collected nodes.
+ *
+ * \param tree  Zone tree.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_ENOMEM
+ */
+int zone_tree_bulk_end(zone_tree_t *tree);
+
+/*!
+ * \brief Relayout the tree for faster lookups, see trie_freeze().
+ *
+ * \note To be used on a complete tree which isn't published yet.
+ *
+ * \param tree  Zone tree, not in COW mode.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int zone_tree_freeze(zone_tree_t *tree);
+
 /*!
  * \brief Inserts the given node into the zone tree.
  *
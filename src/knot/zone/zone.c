@@ -22,14 +22,18 @@
 #include "knot/common/log.h"
 #include "knot/conf/module.h"
 #include "knot/dnssec/kasp/kasp_db.h"
+#include "knot/dnssec/rrsig-index.h"
 #include "knot/events/replan.h"
 #include "knot/journal/journal_read.h"
 #include "knot/journal/journal_write.h"
 #include "knot/nameserver/process_query.h"
+#include "knot/nameserver/xfr_cache.h"
 #include "knot/query/requestor.h"
 #include "knot/updates/zone-update.h"
 #include "knot/server/server.h"
+#include "knot/zone/cold.h"
 #include "knot/zone/contents.h"
+#include "knot/zone/digest.h"
 #include "knot/zone/serial.h"
 #include "knot/zone/zone.h"
 #include "knot/zone/zonefile.h"
@@ -170,6 +174,13 @@ zone_t* zone_new(const knot_dname_t *name)
 		return NULL;
 	}
 
+	zone->xfr_cache = xfr_cache_new();
+	if (zone->xfr_cache == NULL) {
+		knot_dname_free(zone->name, NULL);
+		free(zone);
+		return NULL;
+	}
+
 	// DDNS
 	pthread_mutex_init(&zone->ddns_lock, NULL);
 	zone->ddns_queue_size = 0;
@@ -210,6 +221,11 @@ void zone_free(zone_t **zone_ptr)
 
 	zone_events_deinit(zone);
 
+	zone_cold_forget(zone);
+	if (zone->server != NULL) {
+		load_plan_done(&zone->server->load_plan, zone);
+	}
+
 	knot_dname_free(zone->name, NULL);
 
 	free_ddns_queue(zone);
@@ -223,6 +239,10 @@ void zone_free(zone_t **zone_ptr)
 	free(zone->catalog_gen);
 	catalog_update_free(zone->cat_members);
 
+	rrsig_index_free(zone->rrsig_index);
+	zone_digest_cache_free(zone->digest.cache);
+	xfr_cache_free(zone->xfr_cache);
+
 	/* Free preferred master. */
 	pthread_mutex_destroy(&zone->preferred_lock);
 	free(zone->preferred_master);
@@ -254,7 +274,7 @@ void zone_reset(conf_t *conf, zone_t *zone)
 
 knot_lmdb_db_t *zone_journaldb(const zone_t *zone)
 {
-	return &zone->server->journaldb;
+	return journal_shard(&zone->server->journaldb, zone->name);
 }
 
 knot_lmdb_db_t *zone_kaspdb(const zone_t *zone)
@@ -290,6 +310,7 @@ int zone_change_store(conf_t *conf, zone_t *zone, changeset_t *change, changeset
 			ret = journal_insert(j, change, extra);
 		}
 	}
+	xfr_cache_clear(zone->xfr_cache);
 
 	return ret;
 }
@@ -300,6 +321,8 @@ int zone_changes_clear(conf_t *conf, zone_t *zone)
 		return KNOT_EINVAL;
 	}
 
+	xfr_cache_clear(zone->xfr_cache);
+
 	return journal_scrape_with_md(zone_journal(zone), true);
 }
 
@@ -316,6 +339,7 @@ int zone_in_journal_store(conf_t *conf, zone_t *zone, zone_contents_t *new_conte
 	zone_journal_t j = { zone_journaldb(zone), zone->name, conf };
 
 	int ret = journal_insert_zone(j, new_contents);
+	xfr_cache_clear(zone->xfr_cache);
 	if (ret == KNOT_EOK) {
 		log_zone_info(zone->name, "zone stored to journal, serial %u",
 		              zone_contents_serial(new_contents));
@@ -17,9 +17,11 @@
 #pragma once
 
 #include "contrib/semaphore.h"
+#include "contrib/ucw/lists.h"
 #include "knot/catalog/catalog_update.h"
 #include "knot/conf/conf.h"
 #include "knot/conf/confio.h"
+#include "knot/dnssec/sign-stats.h"
 #include "knot/journal/journal_basic.h"
 #include "knot/events/events.h"
 #include "knot/updates/changesets.h"
@@ -30,6 +32,9 @@
 
 struct zone_update;
 struct zone_backup_ctx;
+struct rrsig_index;
+struct zone_digest_cache;
+struct xfr_cache;
 
 /*!
  * \brief Zone flags.
@@ -44,6 +49,15 @@ typedef enum {
 	ZONE_IS_CAT_MEMBER  = 1 << 6, /*!< This zone exists according to a catalog. */
 } zone_flag_t;
 
+/*!
+ * \brief State of the batched SOA query of a zone refresh.
+ */
+typedef enum {
+	ZONE_PROBE_NONE = 0,
+	ZONE_PROBE_PENDING, /*!< Query submitted, its result will resume the refresh. */
+	ZONE_PROBE_DONE,    /*!< Result waiting for the refresh. */
+} zone_probe_state_t;
+
 /*!
  * \brief Structure for holding DNS zone.
  */
@@ -84,6 +98,42 @@ typedef struct zone
 	/*! \brief Pointer on running server with e.g. KASP db, journal DB, catalog... */
 	struct server *server;
 
+	/*! \brief Cold zone state, contents loaded on demand and evicted if unused. */
+	struct {
+		node_t n;          //!< Node in the list of loaded cold zones.
+		size_t size;       //!< Accounted size of the zone contents.
+		bool enabled;      //!< The zone is configured as cold.
+		bool accounted;    //!< The zone is in the list of loaded cold zones.
+		bool evicted;      //!< Contents not loaded yet, load on demand.
+		bool load_planned; //!< Load of the evicted contents planned by a query.
+		bool referenced;   //!< Zone accessed since the last eviction scan.
+	} cold;
+
+	/*! \brief Expected cost of the planned initial load, see load_plan_t. */
+	struct {
+		uint64_t cost;
+		bool planned;
+	} load_plan;
+
+	/*! \brief Last ZONEMD computation, either generation or verification. */
+	struct {
+		double duration;   //!< Duration in milliseconds.
+		bool computed;     //!< The digest has been computed at least once.
+		struct zone_digest_cache *cache; //!< Page hashes of the contents (Merkle scheme).
+	} digest;
+
+	/*! \brief Statistics of the last successful DNSSEC signing. */
+	struct {
+		sign_stats_t last;
+		bool collected;    //!< The zone has been signed at least once.
+	} signing;
+
+	/*! \brief Rendered outgoing IXFRs, evicted on journal changes. */
+	struct xfr_cache *xfr_cache;
+
+	/*! \brief Index of RRSIG expirations (NULL unless enabled in policy). */
+	struct rrsig_index *rrsig_index;
+
 	/*! \brief Zone backup context (NULL unless backup pending). */
 	struct zone_backup_ctx *backup_ctx;
 
@@ -96,6 +146,13 @@ typedef struct zone
 	pthread_mutex_t preferred_lock;
 	/*! \brief Preferred master for remote operation. */
 	struct sockaddr_storage *preferred_master;
+	/*! \brief Batched SOA query of the refresh, protected by preferred_lock. */
+	struct {
+		zone_probe_state_t state;
+		int ret;
+		uint32_t serial;
+		struct sockaddr_storage remote;
+	} probe;
 
 	/*! \brief Query modules. */
 	list_t query_modules;
@@ -23,6 +23,7 @@
 #include "knot/conf/module.h"
 #include "knot/events/replan.h"
 #include "knot/journal/journal_metadata.h"
+#include "knot/zone/cold.h"
 #include "knot/zone/digest.h"
 #include "knot/zone/timers.h"
 #include "knot/zone/zone-load.h"
@@ -64,7 +65,8 @@ static void zone_get_catalog_group(conf_t *conf, zone_t *zone)
 	}
 }
 
-static zone_t *create_zone_from(const knot_dname_t *name, server_t *server)
+static zone_t *create_zone_from(conf_t *conf, const knot_dname_t *name,
+                                server_t *server)
 {
 	zone_t *zone = zone_new(name);
 	if (!zone) {
@@ -72,6 +74,7 @@ static zone_t *create_zone_from(const knot_dname_t *name, server_t *server)
 	}
 
 	zone->server = server;
+	zone->cold.enabled = zone_cold_configured(conf, name);
 
 	int result = zone_events_setup(zone, server->workers, &server->sched);
 	if (result != KNOT_EOK) {
@@ -85,12 +88,13 @@ static zone_t *create_zone_from(const knot_dname_t *name, server_t *server)
 static zone_t *create_zone_reload(conf_t *conf, const knot_dname_t *name,
                                   server_t *server, zone_t *old_zone)
 {
-	zone_t *zone = create_zone_from(name, server);
+	zone_t *zone = create_zone_from(conf, name, server);
 	if (!zone) {
 		return NULL;
 	}
 
 	zone->contents = old_zone->contents;
+	zone_cold_takeover(zone, old_zone);
 	zone_set_flag(zone, zone_get_flag(old_zone, ZONE_IS_CATALOG | ZONE_IS_CAT_MEMBER, false));
 
 	zone->timers = old_zone->timers;
@@ -99,11 +103,16 @@ static zone_t *create_zone_reload(conf_t *conf, const knot_dname_t *name,
 	bool conf_updated = (old_zone->change_type & CONF_IO_TRELOAD);
 
 	conf_val_t digest = conf_zone_get(conf, C_ZONEMD_GENERATE, name);
-	if (zone->contents != NULL && !zone_contents_digest_exists(zone->contents, conf_opt(&digest), true)) {
+	conf_val_t scheme = conf_zone_get(conf, C_ZONEMD_SCHEME, name);
+	if (zone->contents != NULL && !zone_contents_digest_exists(zone->contents, conf_opt(&digest),
+	                                                           conf_opt(&scheme), true)) {
 		conf_updated = true;
 	}
 
-	if ((zone_file_updated(conf, old_zone, name) || conf_updated) && !zone_expired(zone)) {
+	if (zone->contents == NULL && zone->cold.enabled && !zone_expired(zone)) {
+		zone->zonefile = old_zone->zonefile;
+		replan_load_cold(conf, zone, old_zone);
+	} else if ((zone_file_updated(conf, old_zone, name) || conf_updated) && !zone_expired(zone)) {
 		replan_load_updated(zone, old_zone);
 	} else {
 		zone->zonefile = old_zone->zonefile;
@@ -121,13 +130,21 @@ static zone_t *create_zone_reload(conf_t *conf, const knot_dname_t *name,
 	zone->catalog_gen = old_zone->catalog_gen;
 	old_zone->catalog_gen = NULL;
 
+	zone->rrsig_index = old_zone->rrsig_index;
+	old_zone->rrsig_index = NULL;
+
+	zone->digest.cache = old_zone->digest.cache;
+	old_zone->digest.cache = NULL;
+
+	zone->signing = old_zone->signing;
+
 	return zone;
 }
 
 static zone_t *create_zone_new(conf_t *conf, const knot_dname_t *name,
                                server_t *server)
 {
-	zone_t *zone = create_zone_from(name, server);
+	zone_t *zone = create_zone_from(conf, name, server);
 	if (!zone) {
 		return NULL;
 	}
@@ -176,9 +193,15 @@ static zone_t *create_zone_new(conf_t *conf, const knot_dname_t *name,
 		log_zone_info(zone->name, "zone will be bootstrapped");
 		assert(zone_is_slave(conf, zone));
 		replan_load_bootstrap(conf, zone);
+	} else if (zone->cold.enabled) {
+		log_zone_info(zone->name, "zone will be loaded on demand");
+		replan_load_cold(conf, zone, NULL);
 	} else {
 		log_zone_info(zone->name, "zone will be loaded");
-		replan_load_new(zone); // if load fails, fallback to bootstrap
+		// if load fails, fallback to bootstrap
+		if (load_plan_add(&server->load_plan, conf, zone) != KNOT_EOK) {
+			replan_load_new(zone);
+		}
 	}
 
 	return zone;
@@ -563,8 +586,14 @@ void zonedb_reload(conf_t *conf, server_t *server)
 		return;
 	}
 
+	/* Enqueue initial loads of new zones, the biggest first. */
+	load_plan_run(&server->load_plan);
+
 	catalogs_generate(db_new, server->zone_db);
 
+	/* Relayout the new zone DB for lookups, it's optional. */
+	(void)knot_zonedb_freeze(db_new);
+
 	/* Switch the databases. */
 	knot_zonedb_t **db_current = &server->zone_db;
 	knot_zonedb_t *db_old = rcu_xchg_pointer(db_current, db_new);
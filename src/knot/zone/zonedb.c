@@ -166,12 +166,22 @@ size_t knot_zonedb_size(const knot_zonedb_t *db)
 	return trie_weight(db->trie);
 }
 
+int knot_zonedb_freeze(knot_zonedb_t *db)
+{
+	if (db == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	return trie_freeze(db->trie);
+}
+
 void knot_zonedb_free(knot_zonedb_t **db)
 {
 	if (db == NULL || *db == NULL) {
 		return;
 	}
 
+	trie_free((*db)->trie); // releases the frozen block, the rest is in the pool
 	mp_delete((*db)->mm.ctx);
 	free(*db);
 	*db = NULL;
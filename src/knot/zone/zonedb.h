@@ -118,6 +118,19 @@ zone_t *knot_zonedb_find_suffix(knot_zonedb_t *db, const knot_dname_t *zone_name
 
 size_t knot_zonedb_size(const knot_zonedb_t *db);
 
+/*!
+ * \brief Relayout the zone database for faster lookups, see trie_freeze().
+ *
+ * \note To be used before the database is published.
+ *
+ * \param db  Zone database.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int knot_zonedb_freeze(knot_zonedb_t *db);
+
 /*!
  * \brief Destroys and deallocates the zone database structure (but not the
  *        zones within).
@@ -158,7 +158,8 @@ int zonefile_open(zloader_t *loader, const char *source,
 	memset(zc, 0, sizeof(zcreator_t));
 
 	zc->z = zone_contents_new(origin, true);
-	if (zc->z == NULL) {
+	if (zc->z == NULL || zone_contents_bulk_begin(zc->z) != KNOT_EOK) {
+		zone_contents_deep_free(zc->z);
 		free(zc);
 		return KNOT_ENOMEM;
 	}
@@ -186,6 +187,7 @@ int zonefile_open(zloader_t *loader, const char *source,
 	loader->creator = zc;
 	loader->semantic_checks = semantic_checks;
 	loader->time = time;
+	loader->threads = 1;
 
 	return KNOT_EOK;
 }
@@ -219,6 +221,13 @@ zone_contents_t *zonefile_load(zloader_t *loader)
 		goto fail;
 	}
 
+	ret = zone_contents_bulk_end(zc->z);
+	if (ret != KNOT_EOK) {
+		ERROR(zname, "failed to load zone, file '%s' (%s)",
+		      loader->source, knot_strerror(ret));
+		goto fail;
+	}
+
 	if (!node_rrtype_exists(loader->creator->z->apex, KNOT_RRTYPE_SOA)) {
 		loader->err_handler->error = true;
 		loader->err_handler->cb(loader->err_handler, zc->z, NULL,
@@ -235,7 +244,7 @@ zone_contents_t *zonefile_load(zloader_t *loader)
 	}
 
 	ret = sem_checks_process(zc->z, loader->semantic_checks,
-	                         loader->err_handler, loader->time);
+	                         loader->err_handler, loader->time, loader->threads);
 
 	if (ret != KNOT_EOK) {
 		ERROR(zname, "failed to load zone, file '%s' (%s)",
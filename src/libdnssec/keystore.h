@@ -33,6 +33,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <libdnssec/binary.h>
 #include <libdnssec/key.h>
 
@@ -151,4 +153,66 @@ int dnssec_keystore_get_private(dnssec_keystore_t *store, const char *id,
  */
 int dnssec_keystore_set_private(dnssec_keystore_t *store, dnssec_key_t *key);
 
+/*!
+ * Key store session.
+ *
+ * A session owns private key handles independent of other sessions. With
+ * PKCS #11, each handle keeps its own logged-in token session, so signing
+ * operations with handles of different sessions can run in parallel.
+ */
+typedef struct dnssec_keystore_session dnssec_keystore_session_t;
+
+/*!
+ * Set the size of the session pool of the key store.
+ *
+ * \note The size cannot be changed while any session is checked out.
+ *
+ * \param store  Key store.
+ * \param count  Maximal number of sessions, zero disables the pool.
+ *
+ * \return Error code, DNSSEC_EOK if successful.
+ */
+int dnssec_keystore_set_sessions(dnssec_keystore_t *store, unsigned count);
+
+/*!
+ * Check out a session from the pool, wait until some is available.
+ *
+ * \param[in]  store        Key store.
+ * \param[out] session_ptr  Checked out session.
+ * \param[out] wait_ns      Optional: time spent waiting for the session.
+ *
+ * \return Error code, DNSSEC_EOK if successful.
+ */
+int dnssec_keystore_session_get(dnssec_keystore_t *store,
+				dnssec_keystore_session_t **session_ptr,
+				uint64_t *wait_ns);
+
+/*!
+ * Return a session to the pool.
+ *
+ * \param store    Key store.
+ * \param session  Session checked out from the key store.
+ */
+void dnssec_keystore_session_put(dnssec_keystore_t *store,
+				 dnssec_keystore_session_t *session);
+
+/*!
+ * Get a DNSSEC key with the private key handle owned by the session.
+ *
+ * The handle is opened on the first use and kept in the session.
+ *
+ * \param[in]  store    Key store.
+ * \param[in]  session  Checked out session.
+ * \param[in]  id       ID of the private key.
+ * \param[in]  key      DNSSEC key with the public key.
+ * \param[out] key_ptr  Key owned by the session, valid until the key store
+ *                      is deinitialized.
+ *
+ * \return Error code, DNSSEC_EOK if successful.
+ */
+int dnssec_keystore_session_key(dnssec_keystore_t *store,
+				dnssec_keystore_session_t *session,
+				const char *id, const dnssec_key_t *key,
+				const dnssec_key_t **key_ptr);
+
 /*! @} */
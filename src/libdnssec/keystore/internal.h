@@ -18,6 +18,7 @@
 
 #include <gnutls/gnutls.h>
 #include <gnutls/abstract.h>
+#include <pthread.h>
 
 #include "libdnssec/binary.h"
 #include "libdnssec/key.h"
@@ -44,6 +45,13 @@ typedef struct keystore_functions {
 struct dnssec_keystore {
 	const keystore_functions_t *functions;
 	void *ctx;
+
+	// pool of sessions with own private key handles
+	pthread_mutex_t sessions_lock;
+	pthread_cond_t sessions_cond;
+	dnssec_keystore_session_t *sessions_free;  // idle sessions
+	unsigned sessions_max;                     // pool size, 0 if disabled
+	unsigned sessions_open;                    // created sessions
 };
 
 int keystore_create(dnssec_keystore_t **store_ptr,
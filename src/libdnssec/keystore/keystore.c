@@ -16,6 +16,8 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "libdnssec/error.h"
 #include "libdnssec/key.h"
@@ -49,10 +51,43 @@ int keystore_create(dnssec_keystore_t **store_ptr,
 		return DNSSEC_ENOMEM;
 	}
 
+	pthread_mutex_init(&store->sessions_lock, NULL);
+	pthread_cond_init(&store->sessions_cond, NULL);
+
 	*store_ptr = store;
 	return DNSSEC_EOK;
 }
 
+/* -- session pool --------------------------------------------------------- */
+
+typedef struct {
+	char *id;
+	dnssec_key_t *key;
+} session_key_t;
+
+struct dnssec_keystore_session {
+	dnssec_keystore_session_t *next;  //!< Next idle session.
+	session_key_t *keys;              //!< Keys with private key handles.
+	size_t count;
+};
+
+static void session_free(dnssec_keystore_session_t *session)
+{
+	for (size_t i = 0; i < session->count; i++) {
+		free(session->keys[i].id);
+		dnssec_key_free(session->keys[i].key);
+	}
+	free(session->keys);
+	free(session);
+}
+
+static uint64_t time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 /* -- public API ----------------------------------------------------------- */
 
 _public_
@@ -65,6 +100,14 @@ int dnssec_keystore_deinit(dnssec_keystore_t *store)
 	dnssec_keystore_close(store);
 	store->functions->ctx_free(store->ctx);
 
+	while (store->sessions_free != NULL) {
+		dnssec_keystore_session_t *next = store->sessions_free->next;
+		session_free(store->sessions_free);
+		store->sessions_free = next;
+	}
+	pthread_cond_destroy(&store->sessions_cond);
+	pthread_mutex_destroy(&store->sessions_lock);
+
 	free(store);
 
 	return DNSSEC_EOK;
@@ -184,3 +227,125 @@ int dnssec_keystore_set_private(dnssec_keystore_t *store, dnssec_key_t *key)
 
 	return store->functions->set_private(store->ctx, key->private_key);
 }
+
+_public_
+int dnssec_keystore_set_sessions(dnssec_keystore_t *store, unsigned count)
+{
+	if (!store) {
+		return DNSSEC_EINVAL;
+	}
+
+	pthread_mutex_lock(&store->sessions_lock);
+	store->sessions_max = count;
+	pthread_mutex_unlock(&store->sessions_lock);
+
+	return DNSSEC_EOK;
+}
+
+_public_
+int dnssec_keystore_session_get(dnssec_keystore_t *store,
+				dnssec_keystore_session_t **session_ptr,
+				uint64_t *wait_ns)
+{
+	if (!store || !session_ptr) {
+		return DNSSEC_EINVAL;
+	}
+
+	uint64_t wait_start = 0;
+
+	pthread_mutex_lock(&store->sessions_lock);
+	if (store->sessions_max == 0) {
+		pthread_mutex_unlock(&store->sessions_lock);
+		return DNSSEC_EINVAL;
+	}
+	while (store->sessions_free == NULL &&
+	       store->sessions_open >= store->sessions_max) {
+		if (wait_start == 0) {
+			wait_start = time_ns();
+		}
+		pthread_cond_wait(&store->sessions_cond, &store->sessions_lock);
+	}
+
+	dnssec_keystore_session_t *session = store->sessions_free;
+	if (session != NULL) {
+		store->sessions_free = session->next;
+		session->next = NULL;
+	} else {
+		session = calloc(1, sizeof(*session));
+		if (session == NULL) {
+			pthread_mutex_unlock(&store->sessions_lock);
+			return DNSSEC_ENOMEM;
+		}
+		store->sessions_open++;
+	}
+	pthread_mutex_unlock(&store->sessions_lock);
+
+	if (wait_ns != NULL) {
+		*wait_ns = (wait_start != 0) ? time_ns() - wait_start : 0;
+	}
+
+	*session_ptr = session;
+	return DNSSEC_EOK;
+}
+
+_public_
+void dnssec_keystore_session_put(dnssec_keystore_t *store,
+				 dnssec_keystore_session_t *session)
+{
+	if (!store || !session) {
+		return;
+	}
+
+	pthread_mutex_lock(&store->sessions_lock);
+	session->next = store->sessions_free;
+	store->sessions_free = session;
+	pthread_cond_signal(&store->sessions_cond);
+	pthread_mutex_unlock(&store->sessions_lock);
+}
+
+_public_
+int dnssec_keystore_session_key(dnssec_keystore_t *store,
+				dnssec_keystore_session_t *session,
+				const char *id, const dnssec_key_t *key,
+				const dnssec_key_t **key_ptr)
+{
+	if (!store || !session || !id || !key || !key_ptr) {
+		return DNSSEC_EINVAL;
+	}
+
+	for (size_t i = 0; i < session->count; i++) {
+		if (strcmp(session->keys[i].id, id) == 0) {
+			*key_ptr = session->keys[i].key;
+			return DNSSEC_EOK;
+		}
+	}
+
+	session_key_t *keys = realloc(session->keys, (session->count + 1) * sizeof(*keys));
+	if (keys == NULL) {
+		return DNSSEC_ENOMEM;
+	}
+	session->keys = keys;
+
+	dnssec_key_t *copy = dnssec_key_dup(key);
+	char *id_copy = strdup(id);
+	if (copy == NULL || id_copy == NULL) {
+		dnssec_key_free(copy);
+		free(id_copy);
+		return DNSSEC_ENOMEM;
+	}
+
+	// A new private key handle, the token session is opened on import.
+	int r = dnssec_keystore_get_private(store, id, copy);
+	if (r != DNSSEC_EOK) {
+		dnssec_key_free(copy);
+		free(id_copy);
+		return r;
+	}
+
+	keys[session->count].id = id_copy;
+	keys[session->count].key = copy;
+	session->count++;
+
+	*key_ptr = copy;
+	return DNSSEC_EOK;
+}
@@ -19,10 +19,24 @@
 #include <gnutls/crypto.h>
 #include <string.h>
 
+#include "contrib/macros.h"
 #include "libdnssec/error.h"
 #include "libdnssec/nsec.h"
+#include "libdnssec/nsec/sha1_mb.h"
 #include "libdnssec/shared/shared.h"
 
+/*!
+ * Maximal number of blocks of the first hashed message (data and salt)
+ * processed in the SIMD lanes, longer messages are hashed separately.
+ */
+#define LANE_BLOCKS 9
+
+/*!
+ * Minimal number of hashes to use the SIMD lanes, fewer ones are faster
+ * hashed one by one.
+ */
+#define LANES_MIN (SHA1_MB_LANES / 2)
+
 /*!
  * Compute NSEC3 hash for given data and algorithm.
  *
@@ -77,6 +91,69 @@ static int nsec3_hash(gnutls_digest_algorithm_t algorithm, int iterations,
 	return DNSSEC_EOK;
 }
 
+/*!
+ * Compute one NSEC3 hash into a buffer of the hash length.
+ */
+static int nsec3_hash_to(gnutls_digest_algorithm_t algorithm, int iterations,
+                         const dnssec_binary_t *salt, const dnssec_binary_t *data,
+                         uint8_t *out)
+{
+	dnssec_binary_t hash = { 0 };
+	int ret = nsec3_hash(algorithm, iterations, salt, data, &hash);
+	if (ret == DNSSEC_EOK) {
+		memcpy(out, hash.data, hash.size);
+	}
+	dnssec_binary_free(&hash);
+
+	return ret;
+}
+
+static bool fits_lane(const dnssec_binary_t *data, const dnssec_binary_t *salt)
+{
+	return sha1_mb_blocks(data->size + salt->size) <= LANE_BLOCKS;
+}
+
+/*!
+ * Compute NSEC3 SHA-1 hashes of up to SHA1_MB_LANES data at once.
+ *
+ * Except for the first one, all iterations hash messages of the same
+ * length, so the lanes run in lockstep.
+ */
+static void nsec3_hash_sha1_lanes(int iterations, const dnssec_binary_t *salt,
+                                  const dnssec_binary_t *data[], size_t count,
+                                  uint8_t *hashes[])
+{
+	assert(count <= SHA1_MB_LANES);
+
+	sha1_mb_block_t blocks[LANE_BLOCKS] = { 0 };
+	size_t nblocks[SHA1_MB_LANES] = { 0 };
+	uint8_t msg[LANE_BLOCKS * SHA1_MB_BLOCK_SIZE];
+	sha1_mb_t ctx;
+
+	for (size_t l = 0; l < count; l++) {
+		assert(fits_lane(data[l], salt));
+		memcpy(msg, data[l]->data, data[l]->size);
+		memcpy(msg + data[l]->size, salt->data, salt->size);
+		nblocks[l] = sha1_mb_load(blocks, l, msg, data[l]->size + salt->size);
+	}
+	sha1_mb_hash(&ctx, blocks, nblocks);
+
+	if (iterations > 0) {
+		// Digest placeholder followed by the salt, the same in all lanes.
+		memset(msg, 0, SHA1_MB_DIGEST_SIZE);
+		memcpy(msg + SHA1_MB_DIGEST_SIZE, salt->data, salt->size);
+		size_t iter_blocks = 0;
+		for (size_t l = 0; l < SHA1_MB_LANES; l++) {
+			iter_blocks = sha1_mb_load(blocks, l, msg, SHA1_MB_DIGEST_SIZE + salt->size);
+		}
+		sha1_mb_rehash(&ctx, blocks, iter_blocks, iterations);
+	}
+
+	for (size_t l = 0; l < count; l++) {
+		sha1_mb_digest(&ctx, l, hashes[l]);
+	}
+}
+
 /*!
  * Get GnuTLS digest algorithm from DNSSEC algorithm number.
  */
@@ -110,6 +187,67 @@ int dnssec_nsec3_hash(const dnssec_binary_t *data,
 	return nsec3_hash(algorithm, params->iterations, &params->salt, data, hash);
 }
 
+/*!
+ * Compute NSEC3 hashes for multiple data at once.
+ */
+_public_
+int dnssec_nsec3_hash_batch(const dnssec_binary_t *data, size_t count,
+			    const dnssec_nsec3_params_t *params,
+			    uint8_t *hashes)
+{
+	if ((!data && count > 0) || !params || (!hashes && count > 0)) {
+		return DNSSEC_EINVAL;
+	}
+
+	// The SIMD lanes implement SHA-1, the only NSEC3 algorithm defined.
+	gnutls_digest_algorithm_t algorithm = algorithm_d2g(params->algorithm);
+	if (algorithm != GNUTLS_DIG_SHA1) {
+		return DNSSEC_INVALID_NSEC3_ALGORITHM;
+	}
+
+	const dnssec_binary_t *salt = &params->salt;
+
+	const dnssec_binary_t *lane_data[SHA1_MB_LANES];
+	uint8_t *lane_hashes[SHA1_MB_LANES];
+	size_t lanes = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		uint8_t *out = hashes + i * SHA1_MB_DIGEST_SIZE;
+		if (!fits_lane(&data[i], salt)) {
+			int ret = nsec3_hash_to(algorithm, params->iterations, salt,
+			                        &data[i], out);
+			if (ret != DNSSEC_EOK) {
+				return ret;
+			}
+			continue;
+		}
+
+		lane_data[lanes] = &data[i];
+		lane_hashes[lanes] = out;
+		if (++lanes == SHA1_MB_LANES) {
+			nsec3_hash_sha1_lanes(params->iterations, salt,
+			                      lane_data, lanes, lane_hashes);
+			lanes = 0;
+		}
+	}
+
+	if (lanes >= LANES_MIN) {
+		nsec3_hash_sha1_lanes(params->iterations, salt,
+		                      lane_data, lanes, lane_hashes);
+		return DNSSEC_EOK;
+	}
+
+	for (size_t l = 0; l < lanes; l++) {
+		int ret = nsec3_hash_to(algorithm, params->iterations, salt,
+		                        lane_data[l], lane_hashes[l]);
+		if (ret != DNSSEC_EOK) {
+			return ret;
+		}
+	}
+
+	return DNSSEC_EOK;
+}
+
 /*!
  * Get length of raw NSEC3 hash for a given algorithm.
  */
@@ -0,0 +1,195 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "contrib/macros.h"
+#include "libdnssec/nsec/sha1_mb.h"
+
+/*
+ * SHA-1 (FIPS 180-4) computed in SHA1_MB_LANES independent lanes, each
+ * lane in one element of a vector. The vector type maps to AVX2 registers
+ * on Haswell and later, to pairs of SSE2 registers otherwise.
+ */
+
+#if defined(HAVE_TARGET_CLONES) && defined(__x86_64__)
+#define HW_DISPATCH __attribute__((target_clones("arch=haswell", "default")))
+#else
+#define HW_DISPATCH
+#endif
+
+typedef uint32_t lanes_t __attribute__((vector_size(SHA1_MB_LANES * sizeof(uint32_t))));
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define CH(b, c, d)     ((d) ^ ((b) & ((c) ^ (d))))
+#define PARITY(b, c, d) ((b) ^ (c) ^ (d))
+#define MAJ(b, c, d)    (((b) & (c)) | ((d) & ((b) | (c))))
+
+#define W(t) ((t) < 16 ? w[(t)] : (w[(t) & 15] = ROTL(w[((t) - 3) & 15] ^ w[((t) - 8) & 15] ^ \
+                                                     w[((t) - 14) & 15] ^ w[(t) & 15], 1)))
+
+#define ROUND(a, b, c, d, e, f, k, t) { \
+	e += ROTL(a, 5) + f(b, c, d) + (k) + W(t); \
+	b = ROTL(b, 30); \
+}
+
+#define ROUNDS5(f, k, t) { \
+	ROUND(a, b, c, d, e, f, k, (t)); \
+	ROUND(e, a, b, c, d, f, k, (t) + 1); \
+	ROUND(d, e, a, b, c, f, k, (t) + 2); \
+	ROUND(c, d, e, a, b, f, k, (t) + 3); \
+	ROUND(b, c, d, e, a, f, k, (t) + 4); \
+}
+
+static const uint32_t INIT[5] = {
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+static uint32_t read_be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+/*!
+ * Process one block in all lanes, lanes not in the mask are kept intact.
+ */
+static inline __attribute__((always_inline))
+void compress(lanes_t h[5], const lanes_t in[16], const lanes_t *mask)
+{
+	lanes_t w[16];
+	memcpy(w, in, sizeof(w));
+
+	lanes_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+	#pragma GCC unroll 4
+	for (int t = 0; t < 20; t += 5) {
+		ROUNDS5(CH, 0x5a827999, t);
+	}
+	#pragma GCC unroll 4
+	for (int t = 20; t < 40; t += 5) {
+		ROUNDS5(PARITY, 0x6ed9eba1, t);
+	}
+	#pragma GCC unroll 4
+	for (int t = 40; t < 60; t += 5) {
+		ROUNDS5(MAJ, 0x8f1bbcdc, t);
+	}
+	#pragma GCC unroll 4
+	for (int t = 60; t < 80; t += 5) {
+		ROUNDS5(PARITY, 0xca62c1d6, t);
+	}
+
+	if (mask != NULL) {
+		a &= *mask; b &= *mask; c &= *mask; d &= *mask; e &= *mask;
+	}
+	h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+static inline void init(lanes_t h[5])
+{
+	for (int i = 0; i < 5; i++) {
+		for (int l = 0; l < SHA1_MB_LANES; l++) {
+			h[i][l] = INIT[i];
+		}
+	}
+}
+
+size_t sha1_mb_load(sha1_mb_block_t *blocks, unsigned lane,
+                    const uint8_t *msg, size_t len)
+{
+	size_t nblocks = sha1_mb_blocks(len);
+
+	for (size_t i = 0; i < nblocks; i++) {
+		uint8_t block[SHA1_MB_BLOCK_SIZE] = { 0 };
+		size_t offset = i * SHA1_MB_BLOCK_SIZE;
+		if (offset < len) {
+			memcpy(block, msg + offset, MIN(len - offset, SHA1_MB_BLOCK_SIZE));
+		}
+		if (len >= offset && len < offset + SHA1_MB_BLOCK_SIZE) {
+			block[len - offset] = 0x80;
+		}
+		if (i == nblocks - 1) {
+			uint64_t bits = (uint64_t)len * 8;
+			for (int j = 0; j < 8; j++) {
+				block[SHA1_MB_BLOCK_SIZE - 1 - j] = bits >> (8 * j);
+			}
+		}
+		for (int t = 0; t < 16; t++) {
+			blocks[i][t][lane] = read_be32(block + 4 * t);
+		}
+	}
+
+	return nblocks;
+}
+
+HW_DISPATCH
+void sha1_mb_hash(sha1_mb_t *ctx, const sha1_mb_block_t *blocks,
+                  const size_t nblocks[SHA1_MB_LANES])
+{
+	size_t max_blocks = 0;
+	for (int l = 0; l < SHA1_MB_LANES; l++) {
+		max_blocks = MAX(max_blocks, nblocks[l]);
+	}
+
+	lanes_t h[5];
+	init(h);
+
+	for (size_t i = 0; i < max_blocks; i++) {
+		lanes_t mask;
+		for (int l = 0; l < SHA1_MB_LANES; l++) {
+			mask[l] = (i < nblocks[l]) ? UINT32_MAX : 0;
+		}
+		lanes_t w[16];
+		memcpy(w, blocks[i], sizeof(w));
+		compress(h, w, &mask);
+	}
+
+	memcpy(ctx->h, h, sizeof(h));
+}
+
+HW_DISPATCH
+void sha1_mb_rehash(sha1_mb_t *ctx, const sha1_mb_block_t *blocks, size_t nblocks,
+                    unsigned rounds)
+{
+	lanes_t h[5];
+	memcpy(h, ctx->h, sizeof(h));
+
+	lanes_t w[16];
+	for (unsigned r = 0; r < rounds; r++) {
+		memcpy(w, blocks[0], sizeof(w));
+		memcpy(w, h, sizeof(h));
+		init(h);
+		compress(h, w, NULL);
+		for (size_t i = 1; i < nblocks; i++) {
+			memcpy(w, blocks[i], sizeof(w));
+			compress(h, w, NULL);
+		}
+	}
+
+	memcpy(ctx->h, h, sizeof(h));
+}
+
+void sha1_mb_digest(const sha1_mb_t *ctx, unsigned lane,
+                    uint8_t digest[SHA1_MB_DIGEST_SIZE])
+{
+	for (int i = 0; i < 5; i++) {
+		uint32_t v = ctx->h[i][lane];
+		digest[4 * i]     = v >> 24;
+		digest[4 * i + 1] = v >> 16;
+		digest[4 * i + 2] = v >> 8;
+		digest[4 * i + 3] = v;
+	}
+}
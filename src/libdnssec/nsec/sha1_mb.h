@@ -0,0 +1,92 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * Number of messages hashed at once, one per SIMD lane.
+ */
+#define SHA1_MB_LANES 8
+
+#define SHA1_MB_BLOCK_SIZE 64
+#define SHA1_MB_DIGEST_SIZE 20
+
+/*!
+ * Multi-buffer SHA-1 state, one independent hash per lane.
+ */
+typedef struct {
+	uint32_t h[5][SHA1_MB_LANES];
+} sha1_mb_t;
+
+/*!
+ * Message block words of all lanes, word-major (transposed).
+ */
+typedef uint32_t sha1_mb_block_t[16][SHA1_MB_LANES];
+
+/*!
+ * Get number of blocks of a padded message.
+ */
+static inline size_t sha1_mb_blocks(size_t len)
+{
+	return (len + 1 + 8 + SHA1_MB_BLOCK_SIZE - 1) / SHA1_MB_BLOCK_SIZE;
+}
+
+/*!
+ * Pad a message and store it into one lane of the message blocks.
+ *
+ * \param blocks  Message blocks, at least \ref sha1_mb_blocks of the length.
+ * \param lane    Lane to store the message into.
+ * \param msg     Message.
+ * \param len     Message length.
+ *
+ * \return Number of blocks of the padded message.
+ */
+size_t sha1_mb_load(sha1_mb_block_t *blocks, unsigned lane,
+                    const uint8_t *msg, size_t len);
+
+/*!
+ * Hash the messages in all lanes.
+ *
+ * \param ctx      State, initialized by the function.
+ * \param blocks   Message blocks.
+ * \param nblocks  Number of blocks of each lane, zero for an unused lane.
+ */
+void sha1_mb_hash(sha1_mb_t *ctx, const sha1_mb_block_t *blocks,
+                  const size_t nblocks[SHA1_MB_LANES]);
+
+/*!
+ * Repeatedly hash the digest of the previous hash followed by a suffix.
+ *
+ * In each round, the first five words of the message are replaced by the
+ * digest of the previous round, the rest (the suffix and the padding) is
+ * taken from the message blocks.
+ *
+ * \param ctx      State with the previous digests, updated.
+ * \param blocks   Message blocks with the loaded suffix.
+ * \param nblocks  Number of blocks, the same for all lanes.
+ * \param rounds   Number of hash rounds.
+ */
+void sha1_mb_rehash(sha1_mb_t *ctx, const sha1_mb_block_t *blocks, size_t nblocks,
+                    unsigned rounds);
+
+/*!
+ * Write the digest of one lane.
+ */
+void sha1_mb_digest(const sha1_mb_t *ctx, unsigned lane,
+                    uint8_t digest[SHA1_MB_DIGEST_SIZE]);
@@ -96,6 +96,38 @@ int dnssec_sign_add(dnssec_sign_ctx_t *ctx, const dnssec_binary_t *data);
 int dnssec_sign_write(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags,
                       dnssec_binary_t *signature);
 
+/*!
+ * Get the maximal size of a signature created with the signing context.
+ *
+ * \param ctx  Signing context.
+ *
+ * \return Size of the signature in DNSSEC format, zero on error.
+ */
+size_t dnssec_sign_max_size(dnssec_sign_ctx_t *ctx);
+
+/*!
+ * Write down DNSSEC signatures of multiple independent data blocks.
+ *
+ * All signatures are created with the key of the signing context, the data
+ * added with \ref dnssec_sign_add are neither used nor modified. The
+ * signatures are written into buffers supplied by the caller, so that no
+ * memory is allocated for them.
+ *
+ * \param ctx         Signing context.
+ * \param flags       Additional flags to be used for signing.
+ * \param data        Data blocks to be signed.
+ * \param count       Number of data blocks.
+ * \param signatures  Preallocated signature buffers, one per data block. The
+ *                    size is the buffer capacity on input (\ref
+ *                    dnssec_sign_max_size is always sufficient) and the
+ *                    signature length on output.
+ *
+ * \return Error code, DNSSEC_EOK if successful.
+ */
+int dnssec_sign_batch(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags,
+                      const dnssec_binary_t *data, size_t count,
+                      dnssec_binary_t *signatures);
+
 /*!
  * Verify DNSSEC signature.
  *
@@ -44,12 +44,26 @@ typedef int (*signature_convert_cb)(dnssec_sign_ctx_t *ctx,
 				    const dnssec_binary_t *from,
 				    dnssec_binary_t *to);
 
+/*!
+ * Signature format conversion callback writing into a preallocated buffer.
+ *
+ * \param ctx   DNSSEC signing context.
+ * \param from  Data in source format.
+ * \param to    Buffer for data in target format, the size is the capacity
+ *              on input and the length of the written data on output.
+ *
+ * \return Error code, DNSSEC_EOK if successful.
+ */
+typedef int (*signature_write_cb)(dnssec_sign_ctx_t *ctx,
+				  const dnssec_binary_t *from,
+				  dnssec_binary_t *to);
+
 /*!
  * Algorithm specific callbacks.
  */
 typedef struct algorithm_functions {
 	//! Convert X.509 signature to DNSSEC format.
-	signature_convert_cb x509_to_dnssec;
+	signature_write_cb x509_to_dnssec;
 	//! Convert DNSSEC signature to X.509 format.
 	signature_convert_cb dnssec_to_x509;
 } algorithm_functions_t;
@@ -90,8 +104,26 @@ static int rsa_copy_signature(dnssec_sign_ctx_t *ctx,
 	return dnssec_binary_dup(from, to);
 }
 
+static int rsa_write_signature(dnssec_sign_ctx_t *ctx,
+			       const dnssec_binary_t *from,
+			       dnssec_binary_t *to)
+{
+	assert(ctx);
+	assert(from);
+	assert(to);
+
+	if (from->size > to->size) {
+		return DNSSEC_SIGN_ERROR;
+	}
+
+	memcpy(to->data, from->data, from->size);
+	to->size = from->size;
+
+	return DNSSEC_EOK;
+}
+
 static const algorithm_functions_t rsa_functions = {
-	.x509_to_dnssec = rsa_copy_signature,
+	.x509_to_dnssec = rsa_write_signature,
 	.dnssec_to_x509 = rsa_copy_signature,
 };
 
@@ -109,6 +141,8 @@ static size_t ecdsa_sign_integer_size(dnssec_sign_ctx_t *ctx)
 /*!
  * Convert ECDSA signature to DNSSEC format.
  *
+ * The 'r' and 's' values are written directly into the output buffer.
+ *
  * \note Described in RFC 6605.
  */
 static int ecdsa_x509_to_dnssec(dnssec_sign_ctx_t *ctx,
@@ -135,10 +169,10 @@ static int ecdsa_x509_to_dnssec(dnssec_sign_ctx_t *ctx,
 		return DNSSEC_MALFORMED_DATA;
 	}
 
-	result = dnssec_binary_alloc(dnssec, 2 * int_size);
-	if (result != DNSSEC_EOK) {
-		return result;
+	if (dnssec->size < 2 * int_size) {
+		return DNSSEC_SIGN_ERROR;
 	}
+	dnssec->size = 2 * int_size;
 
 	wire_ctx_t wire = binary_init(dnssec);
 	bignum_write(&wire, int_size, &value_r);
@@ -174,8 +208,9 @@ static const algorithm_functions_t ecdsa_functions = {
 };
 
 #define eddsa_copy_signature rsa_copy_signature
+#define eddsa_write_signature rsa_write_signature
 static const algorithm_functions_t eddsa_functions = {
-	.x509_to_dnssec = eddsa_copy_signature,
+	.x509_to_dnssec = eddsa_write_signature,
 	.dnssec_to_x509 = eddsa_copy_signature,
 };
 
@@ -257,6 +292,60 @@ static gnutls_sign_algorithm_t algo_dnssec2gnutls(dnssec_key_algorithm_t algorit
 	}
 }
 
+/*!
+ * Get maximal size of a signature in DNSSEC format.
+ */
+static size_t signature_max_size(dnssec_sign_ctx_t *ctx)
+{
+	size_t key_bytes = (dnssec_key_get_size(ctx->key) + 7) / 8;
+
+	if (ctx->functions == &rsa_functions) {
+		return key_bytes;
+	} else {
+		return 2 * key_bytes; // (r, s) or (R, S)
+	}
+}
+
+/*!
+ * Sign the data and write the signature in DNSSEC format.
+ *
+ * \param ctx        Signing context.
+ * \param flags      Signing flags.
+ * \param data       Data to be signed.
+ * \param signature  Preallocated buffer, the size is the capacity on input
+ *                   and the signature length on output.
+ */
+static int sign_data(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags,
+		     const gnutls_datum_t *data, dnssec_binary_t *signature)
+{
+	unsigned gnutls_flags = 0;
+#ifdef HAVE_GNUTLS_REPRODUCIBLE
+	if (flags & DNSSEC_SIGN_REPRODUCIBLE) {
+		gnutls_flags |= GNUTLS_PRIVKEY_FLAG_REPRODUCIBLE;
+	}
+#endif
+
+	assert(ctx->key->private_key);
+	_cleanup_datum_ gnutls_datum_t raw = { 0 };
+#ifdef HAVE_SIGN_DATA2
+	int result = gnutls_privkey_sign_data2(ctx->key->private_key,
+					       ctx->sign_algorithm,
+					       gnutls_flags, data, &raw);
+#else
+	gnutls_digest_algorithm_t digest_algorithm = get_digest_algorithm(ctx->key);
+	int result = gnutls_privkey_sign_data(ctx->key->private_key,
+					      digest_algorithm,
+					      gnutls_flags, data, &raw);
+#endif
+	if (result < 0) {
+		return DNSSEC_SIGN_ERROR;
+	}
+
+	dnssec_binary_t bin_raw = binary_from_datum(&raw);
+
+	return ctx->functions->x509_to_dnssec(ctx, &bin_raw, signature);
+}
+
 /* -- public API ---------------------------------------------------------- */
 
 _public_
@@ -355,32 +444,55 @@ int dnssec_sign_write(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags, dnssec_
 		.size = vpool_get_length(&ctx->buffer)
 	};
 
-	unsigned gnutls_flags = 0;
-#ifdef HAVE_GNUTLS_REPRODUCIBLE
-	if (flags & DNSSEC_SIGN_REPRODUCIBLE) {
-		gnutls_flags |= GNUTLS_PRIVKEY_FLAG_REPRODUCIBLE;
+	int result = dnssec_binary_alloc(signature, signature_max_size(ctx));
+	if (result != DNSSEC_EOK) {
+		return result;
 	}
-#endif
 
-	assert(ctx->key->private_key);
-	_cleanup_datum_ gnutls_datum_t raw = { 0 };
-#ifdef HAVE_SIGN_DATA2
-	int result = gnutls_privkey_sign_data2(ctx->key->private_key,
-					       ctx->sign_algorithm,
-					       gnutls_flags, &data, &raw);
-#else
-	gnutls_digest_algorithm_t digest_algorithm = get_digest_algorithm(ctx->key);
-	int result = gnutls_privkey_sign_data(ctx->key->private_key,
-					      digest_algorithm,
-					      gnutls_flags, &data, &raw);
-#endif
-	if (result < 0) {
-		return DNSSEC_SIGN_ERROR;
+	result = sign_data(ctx, flags, &data, signature);
+	if (result != DNSSEC_EOK) {
+		dnssec_binary_free(signature);
 	}
 
-	dnssec_binary_t bin_raw = binary_from_datum(&raw);
+	return result;
+}
 
-	return ctx->functions->x509_to_dnssec(ctx, &bin_raw, signature);
+_public_
+size_t dnssec_sign_max_size(dnssec_sign_ctx_t *ctx)
+{
+	if (!ctx) {
+		return 0;
+	}
+
+	return signature_max_size(ctx);
+}
+
+_public_
+int dnssec_sign_batch(dnssec_sign_ctx_t *ctx, dnssec_sign_flags_t flags,
+		      const dnssec_binary_t *data, size_t count,
+		      dnssec_binary_t *signatures)
+{
+	if (!ctx || (count > 0 && (!data || !signatures))) {
+		return DNSSEC_EINVAL;
+	}
+
+	if (!dnssec_key_can_sign(ctx->key)) {
+		return DNSSEC_NO_PRIVATE_KEY;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (!data[i].data || !signatures[i].data) {
+			return DNSSEC_EINVAL;
+		}
+
+		gnutls_datum_t datum = binary_to_datum(&data[i]);
+		int result = sign_data(ctx, flags, &datum, &signatures[i]);
+		if (result != DNSSEC_EOK) {
+			return result;
+		}
+	}
+
+	return DNSSEC_EOK;
 }
 
 _public_
@@ -23,6 +23,7 @@
 #include "knot/journal/journal_basic.h"
 #include "knot/journal/journal_metadata.h"
 #include "knot/journal/journal_read.h"
+#include "knot/journal/journal_shards.h"
 #include "knot/journal/serialization.h"
 #include "knot/zone/zone-dump.h"
 #include "utils/common/msg.h"
@@ -177,28 +178,58 @@ static int print_changeset_cb(bool special, const changeset_t *ch, void *ctx)
 	return KNOT_EOK;
 }
 
+/*! \brief Initialise a journal DB shard, the first one even if it doesn't exist. */
+static bool shard_init(knot_lmdb_db_t *jdb, const char *path, unsigned index)
+{
+	char *shard_path = journal_shard_path(path, index);
+	if (shard_path == NULL) {
+		return false;
+	}
+	knot_lmdb_init(jdb, shard_path, 0, journal_env_flags(JOURNAL_MODE_ROBUST, true), NULL);
+	free(shard_path);
+
+	if (index > 0 && knot_lmdb_exists(jdb) != KNOT_EOK) {
+		knot_lmdb_deinit(jdb);
+		return false;
+	}
+	return true;
+}
+
 int print_journal(char *path, knot_dname_t *name, print_params_t *params)
 {
 	knot_lmdb_db_t jdb = { 0 };
 	zone_journal_t j = { &jdb, name };
-	bool exists;
+	bool exists = false, db_exists = false;
 	uint64_t occupied, occupied_all;
 
-	knot_lmdb_init(&jdb, path, 0, journal_env_flags(JOURNAL_MODE_ROBUST, true), NULL);
-	int ret = knot_lmdb_exists(&jdb);
-	if (ret == KNOT_EOK) {
-		ret = knot_lmdb_open(&jdb);
-	}
-	if (ret != KNOT_EOK) {
+	// Any shard is searched as the number of shards may differ from the configuration.
+	int ret = KNOT_EOK;
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		if (!shard_init(&jdb, path, i)) {
+			continue;
+		}
+		ret = knot_lmdb_exists(&jdb);
+		if (ret == KNOT_EOK) {
+			ret = knot_lmdb_open(&jdb);
+		}
+		if (ret == KNOT_EOK) {
+			db_exists = true;
+			ret = journal_info(j, &exists, NULL, NULL, NULL, NULL, NULL, &occupied, &occupied_all);
+		}
+		if (ret == KNOT_EOK && exists) {
+			break;
+		}
 		knot_lmdb_deinit(&jdb);
-		return ret;
+		if (ret != KNOT_EOK && ret != KNOT_ENODB) {
+			ERR2("zone not exists in the journal DB %s\n", path);
+			return ret;
+		}
 	}
-
-	ret = journal_info(j, &exists, NULL, NULL, NULL, NULL, NULL, &occupied, &occupied_all);
-	if (ret != KNOT_EOK || !exists) {
+	if (!db_exists) {
+		return KNOT_ENODB;
+	} else if (!exists) {
 		ERR2("zone not exists in the journal DB %s\n", path);
-		knot_lmdb_deinit(&jdb);
-		return ret == KNOT_EOK ? KNOT_ENOENT : ret;
+		return KNOT_ENOENT;
 	}
 
 	if (params->check) {
@@ -274,27 +305,46 @@ static int list_zone(const knot_dname_t *zone, bool detailed, knot_lmdb_db_t *jd
 	return KNOT_EOK;
 }
 
-int list_zones(char *path, bool detailed)
+static int list_shard_zones(knot_lmdb_db_t *jdb, bool detailed, uint64_t *occupied_all)
 {
-	knot_lmdb_db_t jdb = { 0 };
-	knot_lmdb_init(&jdb, path, 0, journal_env_flags(JOURNAL_MODE_ROBUST, true), NULL);
-
 	list_t zones;
 	init_list(&zones);
 	ptrnode_t *zone;
-	uint64_t occupied_all = 0;
+	uint64_t occupied_shard = 0;
 
-	int ret = journals_walk(&jdb, add_zone_to_list, &zones);
+	int ret = journals_walk(jdb, add_zone_to_list, &zones);
 	WALK_LIST(zone, zones) {
 		if (ret != KNOT_EOK) {
 			break;
 		}
-		ret = list_zone(zone->d, detailed, &jdb, &occupied_all);
+		ret = list_zone(zone->d, detailed, jdb, &occupied_shard);
 	}
-
-	knot_lmdb_deinit(&jdb);
 	ptrlist_deep_free(&zones, NULL);
 
+	*occupied_all += occupied_shard;
+	return ret;
+}
+
+int list_zones(char *path, bool detailed)
+{
+	uint64_t occupied_all = 0;
+
+	int ret = KNOT_ENODB;
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		knot_lmdb_db_t jdb = { 0 };
+		if (!shard_init(&jdb, path, i)) {
+			continue;
+		}
+		int shard_ret = list_shard_zones(&jdb, detailed, &occupied_all);
+		knot_lmdb_deinit(&jdb);
+		if (shard_ret == KNOT_ENODB) {
+			continue;
+		} else if (shard_ret != KNOT_EOK) {
+			return shard_ret;
+		}
+		ret = KNOT_EOK;
+	}
+
 	if (detailed && ret == KNOT_EOK) {
 		printf("Occupied all zones together: %"PRIu64" KiB\n", occupied_all / 1024);
 	}
@@ -668,6 +668,8 @@ const filter_desc_t zone_status_filters[MAX_FILTERS] = {
 	{ "+transaction", CTL_FILTER_STATUS_TRANSACTION },
 	{ "+freeze",      CTL_FILTER_STATUS_FREEZE },
 	{ "+events",      CTL_FILTER_STATUS_EVENTS },
+	{ "+digest",      CTL_FILTER_STATUS_DIGEST },
+	{ "+signing",     CTL_FILTER_STATUS_SIGNING },
 };
 
 const filter_desc_t zone_purge_filters[MAX_FILTERS] = {
@@ -18,9 +18,11 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "contrib/base32hex.h"
+#include "contrib/macros.h"
 #include "contrib/string.h"
 #include "contrib/strtonum.h"
 #include "libdnssec/error.h"
@@ -37,7 +39,7 @@
  */
 static void print_help(void)
 {
-	printf("Usage:   " PROGRAM_NAME " <salt> <algorithm> <iterations> <domain-name>\n");
+	printf("Usage:   " PROGRAM_NAME " <salt> <algorithm> <iterations> <domain-name>...\n");
 	printf("Example: " PROGRAM_NAME " c01dcafe 1 10 knot-dns.cz\n");
 }
 
@@ -122,8 +124,8 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	// knsec3hash <salt> <algorithm> <iterations> <domain>
-	if (argc != 5) {
+	// knsec3hash <salt> <algorithm> <iterations> <domain>...
+	if (argc < 5) {
 		print_help();
 		return EXIT_FAILURE;
 	}
@@ -131,45 +133,68 @@ int main(int argc, char *argv[])
 	int exit_code = EXIT_FAILURE;
 	dnssec_nsec3_params_t nsec3_params = { 0 };
 
-	dnssec_binary_t dname = { 0 };
-	dnssec_binary_t digest = { 0 };
+	size_t count = argc - 4;
+	dnssec_binary_t *dnames = calloc(count, sizeof(*dnames));
+	uint8_t *digests = NULL;
 	dnssec_binary_t digest_print = { 0 };
 
+	if (dnames == NULL) {
+		error("Not enough memory.");
+		goto fail;
+	}
+
 	if (!parse_nsec3_params(&nsec3_params, argv[1], argv[2], argv[3])) {
 		goto fail;
 	}
 
-	dname.data = knot_dname_from_str_alloc(argv[4]);
-	if (dname.data == NULL) {
-		error("Cannot parse domain name.");
+	for (size_t i = 0; i < count; i++) {
+		dnames[i].data = knot_dname_from_str_alloc(argv[4 + i]);
+		if (dnames[i].data == NULL) {
+			error("Cannot parse domain name '%s'.", argv[4 + i]);
+			goto fail;
+		}
+		knot_dname_to_lower(dnames[i].data);
+		dnames[i].size = knot_dname_size(dnames[i].data);
+	}
+
+	size_t digest_size = dnssec_nsec3_hash_length(nsec3_params.algorithm);
+	digests = malloc(count * MAX(digest_size, 1));
+	if (digests == NULL) {
+		error("Not enough memory.");
 		goto fail;
 	}
-	knot_dname_to_lower(dname.data);
-	dname.size = knot_dname_size(dname.data);
 
-	int r = dnssec_nsec3_hash(&dname, &nsec3_params, &digest);
+	int r = dnssec_nsec3_hash_batch(dnames, count, &nsec3_params, digests);
 	if (r != DNSSEC_EOK) {
 		error("Cannot compute NSEC3 hash, %s.", knot_strerror(r));
 		goto fail;
 	}
 
-	r = knot_base32hex_encode_alloc(digest.data, digest.size, &digest_print.data);
-	if (r < 0) {
-		error("Cannot encode computed hash, %s.", knot_strerror(r));
-		goto fail;
+	for (size_t i = 0; i < count; i++) {
+		r = knot_base32hex_encode_alloc(digests + i * digest_size, digest_size,
+		                                &digest_print.data);
+		if (r < 0) {
+			error("Cannot encode computed hash, %s.", knot_strerror(r));
+			goto fail;
+		}
+		digest_print.size = r;
+
+		printf("%.*s (salt=%s, hash=%d, iterations=%d)\n", (int)digest_print.size,
+		       digest_print.data, argv[1], nsec3_params.algorithm,
+		       nsec3_params.iterations);
+
+		dnssec_binary_free(&digest_print);
 	}
-	digest_print.size = r;
 
 	exit_code = EXIT_SUCCESS;
 
-	printf("%.*s (salt=%s, hash=%d, iterations=%d)\n", (int)digest_print.size,
-	       digest_print.data, argv[1], nsec3_params.algorithm,
-	       nsec3_params.iterations);
-
 fail:
 	dnssec_nsec3_params_free(&nsec3_params);
-	dnssec_binary_free(&dname);
-	dnssec_binary_free(&digest);
+	for (size_t i = 0; dnames != NULL && i < count; i++) {
+		dnssec_binary_free(&dnames[i]);
+	}
+	free(dnames);
+	free(digests);
 	dnssec_binary_free(&digest_print);
 
 	return exit_code;
@@ -18,6 +18,7 @@
 #include <libgen.h>
 #include <stdio.h>
 
+#include "contrib/strtonum.h"
 #include "contrib/time.h"
 #include "contrib/tolower.h"
 #include "libknot/libknot.h"
@@ -41,6 +42,8 @@ static void print_help(void)
 	       " -d, --dnssec <on|off>       Also check DNSSEC-related records.\n"
 	       " -t, --time <timestamp>      Current time specification.\n"
 	       "                              (default current UNIX time)\n"
+	       " -j, --jobs <num>            Number of threads checking the zone.\n"
+	       "                              (default 1)\n"
 	       " -v, --verbose               Enable debug output.\n"
 	       " -h, --help                  Print the program help.\n"
 	       " -V, --version               Print the program version.\n"
@@ -68,12 +71,14 @@ int main(int argc, char *argv[])
 	bool verbose = false;
 	semcheck_optional_t optional = SEMCHECK_AUTO_DNSSEC; // default value for --dnssec
 	knot_time_t check_time = (knot_time_t)time(NULL);
+	uint32_t threads = 1;
 
 	/* Long options. */
 	struct option opts[] = {
 		{ "origin",  required_argument, NULL, 'o' },
 		{ "time",    required_argument, NULL, 't' },
 		{ "dnssec",  required_argument, NULL, 'd' },
+		{ "jobs",    required_argument, NULL, 'j' },
 		{ "verbose", no_argument,       NULL, 'v' },
 		{ "help",    no_argument,       NULL, 'h' },
 		{ "version", no_argument,       NULL, 'V' },
@@ -85,7 +90,7 @@ int main(int argc, char *argv[])
 
 	/* Parse command line arguments */
 	int opt = 0;
-	while ((opt = getopt_long(argc, argv, "o:t:d:vVh", opts, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, "o:t:d:j:vVh", opts, NULL)) != -1) {
 		switch (opt) {
 		case 'o':
 			origin = optarg;
@@ -109,6 +114,12 @@ int main(int argc, char *argv[])
 				return EXIT_FAILURE;
 			}
 			break;
+		case 'j':
+			if (str_to_u32(optarg, &threads) != KNOT_EOK || threads == 0) {
+				fprintf(stderr, "Invalid number of jobs\n");
+				return EXIT_FAILURE;
+			}
+			break;
 		default:
 			print_help();
 			return EXIT_FAILURE;
@@ -153,7 +164,8 @@ int main(int argc, char *argv[])
 	knot_dname_t *dname = knot_dname_from_str_alloc(zonename);
 	knot_dname_to_lower(dname);
 	free(zonename);
-	int ret = zone_check(filename, dname, stdout, optional, (time_t)check_time);
+	int ret = zone_check(filename, dname, stdout, optional, (time_t)check_time,
+	                     threads);
 	knot_dname_free(dname, NULL);
 
 	log_close();
@@ -20,4 +20,5 @@
 #include "libknot/libknot.h"
 
 int zone_check(const char *zone_file, const knot_dname_t *zone_name,
-               FILE *outfile, semcheck_optional_t optional, time_t time);
+               FILE *outfile, semcheck_optional_t optional, time_t time,
+               unsigned threads);
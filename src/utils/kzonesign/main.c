@@ -15,6 +15,7 @@
  */
 
 #include <getopt.h>
+#include <signal.h>
 #include <stdlib.h>
 
 #include "knot/dnssec/zone-events.h"
@@ -101,6 +102,20 @@ static int zonesign(sign_params_t *params)
 	kasp_db_ensure_init(&fake_server.kaspdb, conf());
 	zone_struct->server = &fake_server;
 
+	// Helper threads for parallel signing, the calling thread signs too.
+	val = conf_zone_get(conf(), C_DNSSEC_POLICY, params->zone_name);
+	conf_id_fix_default(&val);
+	val = conf_id_get(conf(), C_POLICY, C_SIGNING_THREADS, &val);
+	if (conf_int(&val) > 1) {
+		// Stopped worker threads get SIGALRM, which mustn't terminate us.
+		struct sigaction sa = { .sa_handler = SIG_IGN };
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGALRM, &sa, NULL);
+
+		fake_server.workers = worker_pool_create(conf_int(&val) - 1);
+		worker_pool_start(fake_server.workers);
+	}
+
 	ret = knot_dnssec_zone_sign(&up, conf(), 0, params->rollover,
 	                            params->timestamp, &next_sign);
 	if (ret == KNOT_DNSSEC_ENOKEY) { // exception: allow generating initial keys
@@ -148,6 +163,12 @@ static int zonesign(sign_params_t *params)
 	}
 
 fail:
+	if (fake_server.workers != NULL) {
+		worker_pool_wait(fake_server.workers);
+		worker_pool_stop(fake_server.workers);
+		worker_pool_join(fake_server.workers);
+		worker_pool_destroy(fake_server.workers);
+	}
 	if (fake_server.kaspdb.path != NULL) {
 		knot_lmdb_deinit(&fake_server.kaspdb);
 	}
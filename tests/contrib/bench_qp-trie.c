@@ -0,0 +1,243 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "contrib/qp-trie/trie.h"
+#include "contrib/time.h"
+#include "libknot/dname.h"
+#include "libknot/error.h"
+
+#define DEFAULT_COUNT	1000000
+#define DEFAULT_ROUNDS	5
+#define DEFAULT_LOOKUPS	5000000
+
+typedef struct {
+	uint8_t len;
+	uint8_t key[KNOT_DNAME_MAXLEN];
+} bench_key_t;
+
+typedef struct {
+	bench_key_t *keys;
+	size_t count;
+	size_t pos;
+} bench_ctx_t;
+
+static int key_cmp(const void *a, const void *b)
+{
+	const bench_key_t *ka = a, *kb = b;
+	int ret = memcmp(ka->key, kb->key, ka->len < kb->len ? ka->len : kb->len);
+	return (ret != 0) ? ret : (int)ka->len - (int)kb->len;
+}
+
+/*! \brief Generate keys in lookup format of random names under a zone. */
+static size_t gen_keys(bench_key_t *keys, size_t count)
+{
+	static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789-";
+
+	for (size_t i = 0; i < count; i++) {
+		char name[64];
+		int len = 0, labels = 1 + rand() % 3;
+		for (int l = 0; l < labels; l++) {
+			int label_len = 1 + rand() % 12;
+			for (int c = 0; c < label_len; c++) {
+				name[len++] = alphabet[rand() % (sizeof(alphabet) - 1)];
+			}
+			name[len++] = '.';
+		}
+		memcpy(name + len, "example.com.", sizeof("example.com."));
+
+		knot_dname_storage_t dname, lf_storage;
+		knot_dname_from_str(dname, name, sizeof(dname));
+		uint8_t *lf = knot_dname_lf(dname, lf_storage);
+		keys[i].len = *lf;
+		memcpy(keys[i].key, lf + 1, *lf);
+	}
+
+	qsort(keys, count, sizeof(*keys), key_cmp);
+
+	// Remove duplicates.
+	size_t unique = (count > 0) ? 1 : 0;
+	for (size_t i = 1; i < count; i++) {
+		if (key_cmp(&keys[unique - 1], &keys[i]) != 0) {
+			keys[unique++] = keys[i];
+		}
+	}
+
+	return unique;
+}
+
+static int bulk_cb(const trie_key_t **key, uint32_t *len, trie_val_t *val, void *d)
+{
+	bench_ctx_t *ctx = d;
+	if (ctx->pos >= ctx->count) {
+		return KNOT_ENOENT;
+	}
+
+	bench_key_t *k = &ctx->keys[ctx->pos++];
+	*key = k->key;
+	*len = k->len;
+	*val = k;
+	return KNOT_EOK;
+}
+
+static double bench_incremental(bench_key_t *keys, size_t count)
+{
+	trie_t *trie = trie_create(NULL);
+
+	struct timespec begin = time_now();
+	for (size_t i = 0; i < count; i++) {
+		*trie_get_ins(trie, keys[i].key, keys[i].len) = &keys[i];
+	}
+	struct timespec end = time_now();
+
+	trie_free(trie);
+	return time_diff_ms(&begin, &end);
+}
+
+static double bench_bulk(bench_key_t *keys, size_t count)
+{
+	trie_t *trie = trie_create(NULL);
+	bench_ctx_t ctx = { keys, count, 0 };
+
+	struct timespec begin = time_now();
+	int ret = trie_bulk_build(trie, bulk_cb, &ctx);
+	struct timespec end = time_now();
+
+	if (ret != KNOT_EOK || trie_weight(trie) != count) {
+		fprintf(stderr, "bulk build failed (%s)\n", knot_strerror(ret));
+	}
+
+	trie_free(trie);
+	return time_diff_ms(&begin, &end);
+}
+
+/*! \brief Look up random keys, return the average time per lookup in ns. */
+static double bench_lookup(trie_t *trie, bench_key_t *keys, size_t count,
+                           size_t lookups)
+{
+	size_t *order = malloc(lookups * sizeof(*order));
+	if (order == NULL || count == 0) {
+		free(order);
+		return 0;
+	}
+	for (size_t i = 0; i < lookups; i++) {
+		order[i] = ((size_t)rand() * RAND_MAX + rand()) % count;
+	}
+
+	size_t found = 0;
+	struct timespec begin = time_now();
+	for (size_t i = 0; i < lookups; i++) {
+		bench_key_t *k = &keys[order[i]];
+		found += (trie_get_try(trie, k->key, k->len) != NULL);
+	}
+	struct timespec end = time_now();
+
+	if (found != lookups) {
+		fprintf(stderr, "lookup failed (%zu/%zu found)\n", found, lookups);
+	}
+
+	free(order);
+	return time_diff_ms(&begin, &end) * 1000000.0 / lookups;
+}
+
+static void bench_lookups(bench_key_t *keys, size_t count, size_t lookups,
+                          double *mutable, double *frozen)
+{
+	trie_t *trie = trie_create(NULL);
+	bench_ctx_t ctx = { keys, count, 0 };
+	if (trie_bulk_build(trie, bulk_cb, &ctx) != KNOT_EOK) {
+		fprintf(stderr, "bulk build failed\n");
+	}
+
+	*mutable += bench_lookup(trie, keys, count, lookups);
+
+	int ret = trie_freeze(trie);
+	if (ret != KNOT_EOK) {
+		fprintf(stderr, "freeze failed (%s)\n", knot_strerror(ret));
+	}
+
+	*frozen += bench_lookup(trie, keys, count, lookups);
+
+	trie_free(trie);
+}
+
+static void help(void)
+{
+	printf("\nQP-trie construction and lookup benchmark.\n"
+	       "Usage: bench_qp-trie [parameters]\n"
+	       "\n"
+	       "Parameters:\n"
+	       " -n <num>     Number of keys (default %u).\n"
+	       " -l <num>     Number of lookups per round (default %u).\n"
+	       " -r <num>     Number of rounds (default %u).\n"
+	       " -h           Print this help.\n",
+	       DEFAULT_COUNT, DEFAULT_LOOKUPS, DEFAULT_ROUNDS);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t count = DEFAULT_COUNT;
+	size_t lookups = DEFAULT_LOOKUPS;
+	unsigned rounds = DEFAULT_ROUNDS;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:l:r:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = strtoul(optarg, NULL, 10);
+			break;
+		case 'l':
+			lookups = strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			rounds = strtoul(optarg, NULL, 10);
+			break;
+		case 'h':
+			help();
+			return EXIT_SUCCESS;
+		default:
+			help();
+			return EXIT_FAILURE;
+		}
+	}
+
+	bench_key_t *keys = malloc(count * sizeof(*keys));
+	if (keys == NULL) {
+		return EXIT_FAILURE;
+	}
+	srand(1);
+	count = gen_keys(keys, count);
+
+	double incremental = 0, bulk = 0, mutable = 0, frozen = 0;
+	for (unsigned i = 0; i < rounds; i++) {
+		incremental += bench_incremental(keys, count);
+		bulk += bench_bulk(keys, count);
+		bench_lookups(keys, count, lookups, &mutable, &frozen);
+	}
+
+	printf("keys: %zu, rounds: %u\n", count, rounds);
+	printf("incremental insertion: %10.2f ms\n", incremental / rounds);
+	printf("bulk build:            %10.2f ms\n", bulk / rounds);
+	printf("lookup (mutable):      %10.2f ns\n", mutable / rounds);
+	printf("lookup (frozen):       %10.2f ns\n", frozen / rounds);
+
+	free(keys);
+	return EXIT_SUCCESS;
+}
@@ -103,6 +103,176 @@ static bool str_key_get_leq(trie_t *trie, char **keys, size_t i, size_t size)
 
 }
 
+typedef struct {
+	char **keys;
+	size_t count;
+	size_t pos;
+} bulk_ctx_t;
+
+/* Provide sorted keys, skipping duplicates. */
+static int bulk_next(const trie_key_t **key, uint32_t *len, trie_val_t *val, void *d)
+{
+	bulk_ctx_t *ctx = d;
+	while (ctx->pos > 0 && ctx->pos < ctx->count &&
+	       strcmp(ctx->keys[ctx->pos - 1], ctx->keys[ctx->pos]) == 0) {
+		ctx->pos++;
+	}
+	if (ctx->pos >= ctx->count) {
+		return KNOT_ENOENT;
+	}
+	*key = (uint8_t *)ctx->keys[ctx->pos];
+	*len = strlen(ctx->keys[ctx->pos]) + 1;
+	*val = ctx->keys[ctx->pos];
+	ctx->pos++;
+	return KNOT_EOK;
+}
+
+static void test_bulk_build(char **keys, size_t key_count, trie_t *expected)
+{
+	trie_t *trie = trie_create(NULL);
+
+	bulk_ctx_t ctx = { keys, key_count, 0 };
+	int ret = trie_bulk_build(trie, bulk_next, &ctx);
+	ok(ret == KNOT_EOK, "trie: bulk build");
+	is_int(trie_weight(expected), trie_weight(trie), "trie: bulk build weight");
+
+	/* Same order and values as the incrementally built trie. */
+	bool passed = true;
+	trie_it_t *it = trie_it_begin(trie);
+	trie_it_t *it_exp = trie_it_begin(expected);
+	while (!trie_it_finished(it) && !trie_it_finished(it_exp)) {
+		if (*trie_it_val(it) != *trie_it_val(it_exp) &&
+		    strcmp(*trie_it_val(it), *trie_it_val(it_exp)) != 0) {
+			passed = false;
+			break;
+		}
+		trie_it_next(it);
+		trie_it_next(it_exp);
+	}
+	passed = passed && trie_it_finished(it) && trie_it_finished(it_exp);
+	trie_it_free(it);
+	trie_it_free(it_exp);
+	ok(passed, "trie: bulk build iteration");
+
+	passed = true;
+	for (size_t i = 0; i < key_count; ++i) {
+		trie_val_t *val = trie_get_try(trie, (uint8_t *)keys[i], strlen(keys[i]) + 1);
+		if (val == NULL || strcmp(*val, keys[i]) != 0) {
+			passed = false;
+			break;
+		}
+	}
+	ok(passed, "trie: bulk build lookup all keys");
+
+	ret = trie_bulk_build(trie, bulk_next, &ctx);
+	ok(ret == KNOT_EINVAL, "trie: bulk build into non-empty trie");
+	trie_free(trie);
+
+	/* Unsorted input is refused. */
+	char *unsorted[] = { "a", "c", "b" };
+	trie = trie_create(NULL);
+	ctx = (bulk_ctx_t){ unsorted, 3, 0 };
+	ret = trie_bulk_build(trie, bulk_next, &ctx);
+	ok(ret == KNOT_EINVAL && trie_weight(trie) == 0, "trie: bulk build unsorted");
+
+	/* Prefix keys and empty input. */
+	char *prefixed[] = { "", "a", "aa", "ab", "b" };
+	ctx = (bulk_ctx_t){ prefixed, 5, 0 };
+	ret = trie_bulk_build(trie, bulk_next, &ctx);
+	ok(ret == KNOT_EOK && trie_weight(trie) == 5, "trie: bulk build prefixes");
+	it = trie_it_begin(trie);
+	passed = true;
+	for (size_t i = 0; i < 5; ++i, trie_it_next(it)) {
+		if (trie_it_finished(it) || *trie_it_val(it) != prefixed[i]) {
+			passed = false;
+			break;
+		}
+	}
+	trie_it_free(it);
+	ok(passed, "trie: bulk build prefixes order");
+	trie_clear(trie);
+	ctx = (bulk_ctx_t){ prefixed, 0, 0 };
+	ret = trie_bulk_build(trie, bulk_next, &ctx);
+	ok(ret == KNOT_EOK && trie_weight(trie) == 0, "trie: bulk build empty");
+	trie_free(trie);
+}
+
+static bool lookup_keys(trie_t *trie, char **keys, size_t key_count, size_t step)
+{
+	for (size_t i = 0; i < key_count; i += step) {
+		trie_val_t *val = trie_get_try(trie, (uint8_t *)keys[i], strlen(keys[i]) + 1);
+		if (val == NULL || strcmp(*val, keys[i]) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void test_freeze(char **sorted_keys, size_t sorted_count)
+{
+	/* Unique keys, so that deleted and remaining keys don't overlap. */
+	char **keys = malloc(sizeof(char *) * sorted_count);
+	size_t key_count = 0;
+	for (size_t i = 0; i < sorted_count; ++i) {
+		if (key_count == 0 || strcmp(keys[key_count - 1], sorted_keys[i]) != 0) {
+			keys[key_count++] = sorted_keys[i];
+		}
+	}
+
+	trie_t *trie = trie_create(NULL);
+	bulk_ctx_t ctx = { keys, key_count, 0 };
+	(void)trie_bulk_build(trie, bulk_next, &ctx);
+	size_t weight = trie_weight(trie);
+
+	int ret = trie_freeze(trie);
+	ok(ret == KNOT_EOK && trie_weight(trie) == weight, "trie: freeze");
+	ok(lookup_keys(trie, keys, key_count, 1), "trie: freeze lookup all keys");
+
+	bool passed = true;
+	for (size_t i = 0; i < key_count; ++i) {
+		if (!str_key_get_leq(trie, keys, i, key_count)) {
+			passed = false;
+			break;
+		}
+	}
+	ok(passed, "trie: freeze find lesser or equal for all keys");
+
+	/* Copy-on-write transaction shares the frozen block. */
+	trie_cow_t *cow = trie_cow(trie, NULL, NULL);
+	ok(trie_freeze(trie) == KNOT_EBUSY, "trie: freeze in COW transaction");
+	trie_t *new = trie_cow_new(cow);
+	passed = true;
+	for (size_t i = 0; i < key_count; i += 2) {
+		ret = trie_del_cow(cow, (uint8_t *)keys[i], strlen(keys[i]) + 1, NULL);
+		passed = passed && (ret == KNOT_EOK || ret == KNOT_ENOENT);
+	}
+	ok(passed && lookup_keys(trie, keys, key_count, 1), "trie: freeze COW delete");
+	trie = trie_cow_commit(cow, NULL, NULL);
+	ok(trie == new && lookup_keys(trie, keys + 1, key_count - 1, 2),
+	   "trie: freeze COW commit");
+
+	/* Direct modifications move the objects out of the frozen block. */
+	passed = true;
+	for (size_t i = 0; i < key_count; i += 2) {
+		trie_val_t *val = trie_get_ins(trie, (uint8_t *)keys[i], strlen(keys[i]) + 1);
+		if (val == NULL) {
+			passed = false;
+			break;
+		}
+		*val = keys[i];
+	}
+	for (size_t i = 1; i < key_count; i += 4) {
+		(void)trie_del(trie, (uint8_t *)keys[i], strlen(keys[i]) + 1, NULL);
+	}
+	ok(passed && lookup_keys(trie, keys, key_count, 2), "trie: freeze modify");
+
+	ret = trie_freeze(trie);
+	ok(ret == KNOT_EOK && lookup_keys(trie, keys, key_count, 2), "trie: freeze again");
+
+	trie_free(trie);
+	free(keys);
+}
+
 static void test_wildcards(void)
 {
 	/* Test zone. */
@@ -270,6 +440,12 @@ int main(int argc, char *argv[])
 	is_int(inserted, iterated, "trie: sorted iteration");
 	trie_it_free(it);
 
+	/* Bulk build from the sorted keys. */
+	test_bulk_build(keys, key_count, trie);
+
+	/* Frozen layout. */
+	test_freeze(keys, key_count);
+
 	/* Cleanup */
 	for (unsigned i = 0; i < key_count; ++i) {
 		free(keys[i]);
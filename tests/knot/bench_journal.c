@@ -0,0 +1,297 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/files.h>
+
+#include "contrib/time.h"
+#include "knot/journal/journal_basic.h"
+#include "knot/journal/journal_read.h"
+#include "knot/journal/journal_write.h"
+#include "libknot/libknot.h"
+#include "test_conf.h"
+
+#define DEFAULT_CHANGESETS	1000
+#define DEFAULT_RECORDS		100
+#define MAPSIZE			(4096LLU * 1024 * 1024)
+
+static const char *apex_str = "example.";
+
+static knot_rrset_t *gen_soa(const knot_dname_t *apex, uint32_t serial)
+{
+	uint8_t rdata[2 * KNOT_DNAME_MAXLEN + 20];
+	knot_dname_storage_t ns;
+	size_t ns_len = knot_dname_from_str(ns, "ns.example.", sizeof(ns)) == NULL ?
+	                0 : knot_dname_size(ns);
+
+	memcpy(rdata, ns, ns_len);
+	memcpy(rdata + ns_len, ns, ns_len);
+	uint8_t *times = rdata + 2 * ns_len;
+	knot_wire_write_u32(times, serial);
+	knot_wire_write_u32(times + 4, 3600);
+	knot_wire_write_u32(times + 8, 600);
+	knot_wire_write_u32(times + 12, 86400);
+	knot_wire_write_u32(times + 16, 300);
+
+	knot_rrset_t *soa = knot_rrset_new(apex, KNOT_RRTYPE_SOA, KNOT_CLASS_IN, 3600, NULL);
+	if (soa != NULL &&
+	    knot_rrset_add_rdata(soa, rdata, 2 * ns_len + 20, NULL) != KNOT_EOK) {
+		knot_rrset_free(soa, NULL);
+		return NULL;
+	}
+	return soa;
+}
+
+static int add_records(changeset_t *ch, uint32_t serial, size_t records, bool remove)
+{
+	static const char txt[] = "\x1b""v=spf1 ip4:192.0.2.0/24 -all";
+
+	for (size_t i = 0; i < records; i++) {
+		char name[64];
+		(void)snprintf(name, sizeof(name), "host%zu.%s",
+		               serial * records + i, apex_str);
+		knot_dname_storage_t owner;
+		if (knot_dname_from_str(owner, name, sizeof(owner)) == NULL) {
+			return KNOT_EINVAL;
+		}
+
+		knot_rrset_t rr;
+		knot_rrset_init(&rr, owner, KNOT_RRTYPE_A, KNOT_CLASS_IN, 3600);
+		uint8_t a[4] = { 192, 0, (i >> 8) & 0xff, i & 0xff };
+		if (i % 4 == 0) {
+			rr.type = KNOT_RRTYPE_TXT;
+			(void)knot_rrset_add_rdata(&rr, (const uint8_t *)txt, sizeof(txt) - 1, NULL);
+		} else {
+			(void)knot_rrset_add_rdata(&rr, a, sizeof(a), NULL);
+		}
+
+		int ret = remove ? changeset_add_removal(ch, &rr, 0) :
+		                   changeset_add_addition(ch, &rr, 0);
+		knot_rdataset_clear(&rr.rrs, NULL);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Generate a changeset replacing the records of the previous one.
+ */
+static changeset_t *gen_changeset(const knot_dname_t *apex, uint32_t serial,
+                                  size_t records)
+{
+	changeset_t *ch = changeset_new(apex);
+	if (ch == NULL) {
+		return NULL;
+	}
+
+	ch->soa_from = gen_soa(apex, serial);
+	ch->soa_to = gen_soa(apex, serial + 1);
+	if (ch->soa_from == NULL || ch->soa_to == NULL ||
+	    add_records(ch, serial - 1, records / 2, true) != KNOT_EOK ||
+	    add_records(ch, serial, records / 2, false) != KNOT_EOK) {
+		changeset_free(ch);
+		return NULL;
+	}
+
+	return ch;
+}
+
+typedef struct {
+	double insert_ms;
+	double read_ms;
+	size_t rrsets;
+	size_t raw_bytes;
+	size_t stored_bytes;
+} bench_result_t;
+
+/*! \brief Sum the sizes of the stored chunks and of their uncompressed data. */
+static void count_bytes(knot_lmdb_db_t *db, const knot_dname_t *apex, size_t count,
+                        bench_result_t *res)
+{
+	knot_lmdb_txn_t txn = { 0 };
+	knot_lmdb_begin(db, &txn, false);
+	for (uint32_t serial = 1; serial <= count; serial++) {
+		MDB_val prefix = journal_changeset_id_to_key(false, serial, apex);
+		knot_lmdb_foreach(&txn, &prefix) {
+			uint32_t raw_size = 0;
+			if (journal_chunk_compression(&txn.cur_val, &raw_size) == JOURNAL_COMPRESSION_NONE) {
+				raw_size = txn.cur_val.mv_size - JOURNAL_HEADER_SIZE;
+			}
+			res->raw_bytes += raw_size;
+			res->stored_bytes += txn.cur_val.mv_size - JOURNAL_HEADER_SIZE;
+		}
+		free(prefix.mv_data);
+	}
+	knot_lmdb_abort(&txn);
+}
+
+static int count_rrset(bool remove, const knot_rrset_t *rr, void *ctx)
+{
+	(*(size_t *)ctx)++;
+	return KNOT_EOK;
+}
+
+static int bench_run(const knot_dname_t *apex, const char *compression,
+                     changeset_t **changesets, size_t count, bench_result_t *res)
+{
+	char conf_str[256];
+	(void)snprintf(conf_str, sizeof(conf_str),
+	               "template:\n"
+	               " - id: default\n"
+	               "   journal-max-usage: %llu\n"
+	               "   journal-max-depth: %zu\n"
+	               "   journal-compression: %s\n",
+	               MAPSIZE / 2, count + 1, compression);
+	int ret = test_conf(conf_str, NULL);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	char *dir = test_mkdtemp();
+	if (dir == NULL) {
+		test_conf_free();
+		return KNOT_ENOMEM;
+	}
+
+	knot_lmdb_db_t db = { 0 };
+	knot_lmdb_init(&db, dir, MAPSIZE, journal_env_flags(JOURNAL_MODE_ASYNC, false), NULL);
+	zone_journal_t j = { &db, apex, conf() };
+
+	struct timespec begin = time_now();
+	for (size_t i = 0; i < count && ret == KNOT_EOK; i++) {
+		ret = journal_insert(j, changesets[i], NULL);
+	}
+	struct timespec end = time_now();
+	res->insert_ms = time_diff_ms(&begin, &end);
+
+	if (ret == KNOT_EOK) {
+		journal_read_t *read = NULL;
+		begin = time_now();
+		ret = journal_read_begin(j, false, 1, &read);
+		if (ret == KNOT_EOK) {
+			ret = journal_read_rrsets(read, count_rrset, &res->rrsets);
+		}
+		end = time_now();
+		res->read_ms = time_diff_ms(&begin, &end);
+		count_bytes(&db, apex, count, res);
+	}
+
+	knot_lmdb_deinit(&db);
+	test_rm_rf(dir);
+	free(dir);
+	test_conf_free();
+
+	return ret;
+}
+
+static void help(void)
+{
+	printf("\nJournal changeset compression benchmark.\n"
+	       "Usage: bench_journal [parameters]\n"
+	       "\n"
+	       "Parameters:\n"
+	       " -n <num>     Number of changesets (default %u).\n"
+	       " -s <num>     Number of records per changeset (default %u).\n"
+	       " -c <codec>   Compression to test: none, zlib (default both).\n"
+	       " -h           Print this help.\n"
+	       "\n"
+	       "The journal is used in the asynchronous mode to measure\n"
+	       "the processing overhead rather than the disk synchronization.\n",
+	       DEFAULT_CHANGESETS, DEFAULT_RECORDS);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t count = DEFAULT_CHANGESETS;
+	size_t records = DEFAULT_RECORDS;
+	const char *codecs[] = { "none", "zlib", NULL };
+	const char *codec = NULL;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:c:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			records = strtoul(optarg, NULL, 10);
+			break;
+		case 'c':
+			codec = optarg;
+			break;
+		case 'h':
+			help();
+			return EXIT_SUCCESS;
+		default:
+			help();
+			return EXIT_FAILURE;
+		}
+	}
+	if (count < 1 || records < 2) {
+		help();
+		return EXIT_FAILURE;
+	}
+	if (codec != NULL) {
+		codecs[0] = codec;
+		codecs[1] = NULL;
+	}
+
+	knot_dname_t *apex = knot_dname_from_str_alloc(apex_str);
+	changeset_t **changesets = calloc(count, sizeof(*changesets));
+	if (apex == NULL || changesets == NULL) {
+		return EXIT_FAILURE;
+	}
+	for (size_t i = 0; i < count; i++) {
+		changesets[i] = gen_changeset(apex, i + 1, records);
+		if (changesets[i] == NULL) {
+			fprintf(stderr, "failed to generate changesets\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("changesets: %zu, records: %zu\n", count, records);
+	printf("codec   insert ms  changesets/s    read ms     RRsets/s"
+	       "    raw bytes  stored bytes  ratio\n");
+
+	int ret = KNOT_EOK;
+	for (const char **c = codecs; *c != NULL && ret == KNOT_EOK; c++) {
+		bench_result_t res = { 0 };
+		ret = bench_run(apex, *c, changesets, count, &res);
+		if (ret != KNOT_EOK) {
+			fprintf(stderr, "%s: benchmark failed (%s)\n", *c, knot_strerror(ret));
+			break;
+		}
+		printf("%-6s %10.2f %13.0f %10.2f %12.0f %12zu %13zu %6.2f\n", *c,
+		       res.insert_ms, res.insert_ms > 0 ? count * 1000.0 / res.insert_ms : 0,
+		       res.read_ms, res.read_ms > 0 ? res.rrsets * 1000.0 / res.read_ms : 0,
+		       res.raw_bytes, res.stored_bytes,
+		       res.stored_bytes > 0 ? (double)res.raw_bytes / res.stored_bytes : 0);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		changeset_free(changesets[i]);
+	}
+	free(changesets);
+	knot_dname_free(apex, NULL);
+
+	return (ret == KNOT_EOK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
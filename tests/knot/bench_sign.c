@@ -0,0 +1,367 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/files.h>
+
+#include "contrib/time.h"
+#include "libdnssec/crypto.h"
+#include "libdnssec/key.h"
+#include "libdnssec/keystore.h"
+#include "libknot/libknot.h"
+#include "knot/dnssec/sign-stats.h"
+#include "knot/dnssec/zone-nsec.h"
+#include "knot/dnssec/zone-sign.h"
+#include "knot/server/server.h"
+#include "knot/zone/adjust.h"
+#include "knot/zone/zone.h"
+
+#define DEFAULT_NODES	100000
+#define DEFAULT_ALG	DNSSEC_KEY_ALGORITHM_ECDSA_P256_SHA256
+#define DEFAULT_THREADS	1
+#define DEFAULT_ROUNDS	3
+
+static const char *apex_str = "example.";
+
+static void add_rr(zone_contents_t *contents, const knot_dname_t *owner,
+                   uint16_t type, const uint8_t *data, uint16_t len)
+{
+	knot_rrset_t rrset;
+	knot_rrset_init(&rrset, (knot_dname_t *)owner, type, KNOT_CLASS_IN, 3600);
+	zone_node_t *node = NULL;
+	if (knot_rrset_add_rdata(&rrset, data, len, NULL) != KNOT_EOK ||
+	    zone_contents_add_rr(contents, &rrset, &node) != KNOT_EOK) {
+		fprintf(stderr, "failed to create zone contents\n");
+		exit(EXIT_FAILURE);
+	}
+	knot_rdataset_clear(&rrset.rrs, NULL);
+}
+
+/*!
+ * \brief Generate an unsigned zone with the given number of nodes.
+ *
+ * Each node has an A record, every fourth one a TXT and every sixteenth
+ * node is a delegation instead.
+ */
+static zone_contents_t *gen_zone(const knot_dname_t *apex, size_t nodes,
+                                 zone_key_t *key)
+{
+	zone_contents_t *contents = zone_contents_new(apex, false);
+	if (contents == NULL) {
+		return NULL;
+	}
+
+	uint8_t rdata[KNOT_DNAME_MAXLEN + 20] = { 0 };
+	knot_dname_storage_t ns;
+	size_t ns_len = knot_dname_from_str(ns, "ns.example.", sizeof(ns)) == NULL ?
+	                0 : knot_dname_size(ns);
+
+	// SOA: mname, rname, serial, refresh, retry, expire, minimum
+	memcpy(rdata, ns, ns_len);
+	memcpy(rdata + ns_len, ns, ns_len);
+	uint8_t *times = rdata + 2 * ns_len;
+	knot_wire_write_u32(times, 1);
+	knot_wire_write_u32(times + 4, 3600);
+	knot_wire_write_u32(times + 8, 600);
+	knot_wire_write_u32(times + 12, 86400);
+	knot_wire_write_u32(times + 16, 300);
+	add_rr(contents, apex, KNOT_RRTYPE_SOA, rdata, 2 * ns_len + 20);
+	add_rr(contents, apex, KNOT_RRTYPE_NS, ns, ns_len);
+
+	knot_rrset_t dnskey;
+	knot_rrset_init(&dnskey, (knot_dname_t *)apex, KNOT_RRTYPE_DNSKEY, KNOT_CLASS_IN, 3600);
+	zone_node_t *node = NULL;
+	if (rrset_add_zone_key(&dnskey, key) != KNOT_EOK ||
+	    zone_contents_add_rr(contents, &dnskey, &node) != KNOT_EOK) {
+		knot_rdataset_clear(&dnskey.rrs, NULL);
+		zone_contents_deep_free(contents);
+		return NULL;
+	}
+	knot_rdataset_clear(&dnskey.rrs, NULL);
+
+	for (size_t i = 0; i < nodes; i++) {
+		char name[64];
+		(void)snprintf(name, sizeof(name), "n%zu.%s", i, apex_str);
+		knot_dname_storage_t owner;
+		if (knot_dname_from_str(owner, name, sizeof(owner)) == NULL) {
+			zone_contents_deep_free(contents);
+			return NULL;
+		}
+
+		if (i % 16 == 15) {
+			add_rr(contents, owner, KNOT_RRTYPE_NS, ns, ns_len);
+			continue;
+		}
+
+		uint8_t a[4] = { 192, 0, (i >> 8) & 0xff, i & 0xff };
+		add_rr(contents, owner, KNOT_RRTYPE_A, a, sizeof(a));
+		if (i % 4 == 0) {
+			uint8_t txt[] = { 9, 'b', 'e', 'n', 'c', 'h', 'm', 'a', 'r', 'k' };
+			add_rr(contents, owner, KNOT_RRTYPE_TXT, txt, sizeof(txt));
+		}
+	}
+
+	return contents;
+}
+
+/*! \brief Generate a combined signing key in a temporary PKCS #8 keystore. */
+static int gen_key(const char *dir, const knot_dname_t *apex,
+                   dnssec_key_algorithm_t alg, unsigned bits, zone_key_t *key)
+{
+	dnssec_keystore_t *store = NULL;
+	int ret = dnssec_keystore_init_pkcs8(&store);
+	if (ret == KNOT_EOK) {
+		ret = dnssec_keystore_init(store, dir);
+	}
+	if (ret == KNOT_EOK) {
+		ret = dnssec_keystore_open(store, dir);
+	}
+
+	char *id = NULL;
+	if (ret == KNOT_EOK) {
+		ret = dnssec_keystore_generate(store, alg, bits, &id);
+	}
+	if (ret == KNOT_EOK) {
+		ret = dnssec_key_new(&key->key);
+	}
+	if (ret == KNOT_EOK) {
+		ret = dnssec_key_set_dname(key->key, apex);
+	}
+	if (ret == KNOT_EOK) {
+		dnssec_key_set_flags(key->key, dnskey_flags(true));
+		dnssec_key_set_algorithm(key->key, alg);
+		ret = dnssec_keystore_get_private(store, id, key->key);
+	}
+
+	key->id = id;
+	key->is_ksk = true;
+	key->is_zsk = true;
+	key->is_active = true;
+	key->is_public = true;
+
+	dnssec_keystore_deinit(store);
+	return ret;
+}
+
+typedef struct {
+	zone_t *zone;
+	zone_keyset_t *keyset;
+	kdnssec_ctx_t *ctx;
+	size_t nodes;
+	zone_key_t *key;
+} bench_t;
+
+/*! \brief Sign a fresh zone the same way as a complete signing does. */
+static int bench_round(bench_t *bench, sign_stats_t *stats, double *total)
+{
+	zone_contents_t *contents = gen_zone(bench->zone->name, bench->nodes, bench->key);
+	if (contents == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	zone_update_t update;
+	int ret = zone_update_from_contents(&update, bench->zone, contents, UPDATE_FULL);
+	if (ret != KNOT_EOK) {
+		zone_contents_deep_free(contents);
+		return ret;
+	}
+	update.sign_stats = stats;
+
+	struct timespec begin = time_now(), phase = begin;
+	ret = zone_adjust_contents(update.new_cont, adjust_cb_flags, NULL,
+	                           false, false, 1, update.a_ctx->node_ptrs);
+	sign_stats_phase(stats, SIGN_PHASE_ADJUST, &phase);
+	if (ret == KNOT_EOK) {
+		ret = knot_zone_create_nsec_chain(&update, bench->ctx);
+		sign_stats_phase(stats, SIGN_PHASE_NSEC, &phase);
+	}
+	if (ret == KNOT_EOK) {
+		knot_time_t expire = 0;
+		ret = knot_zone_sign(&update, bench->keyset, bench->ctx, &expire);
+		sign_stats_phase(stats, SIGN_PHASE_RRSIG, &phase);
+	}
+	*total += time_diff_ms(&begin, &phase);
+
+	update.sign_stats = NULL;
+	zone_update_clear(&update);
+	return ret;
+}
+
+static void interrupt_handle(int s)
+{
+}
+
+static void help(void)
+{
+	printf("\nDNSSEC zone signing benchmark.\n"
+	       "Usage: bench_sign [parameters]\n"
+	       "\n"
+	       "Parameters:\n"
+	       " -n <num>     Number of zone nodes (default %u).\n"
+	       " -a <num>     DNSSEC algorithm number (default %u).\n"
+	       " -b <num>     Key size in bits (default for the algorithm).\n"
+	       " -t <num>     Number of signing threads (default %u).\n"
+	       " -r <num>     Number of rounds (default %u).\n"
+	       " -3           Use NSEC3 instead of NSEC.\n"
+	       " -h           Print this help.\n",
+	       DEFAULT_NODES, DEFAULT_ALG, DEFAULT_THREADS, DEFAULT_ROUNDS);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nodes = DEFAULT_NODES;
+	unsigned alg = DEFAULT_ALG;
+	unsigned bits = 0;
+	unsigned threads = DEFAULT_THREADS;
+	unsigned rounds = DEFAULT_ROUNDS;
+	bool nsec3 = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:a:b:t:r:3h")) != -1) {
+		switch (opt) {
+		case 'n':
+			nodes = strtoul(optarg, NULL, 10);
+			break;
+		case 'a':
+			alg = strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			bits = strtoul(optarg, NULL, 10);
+			break;
+		case 't':
+			threads = strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			rounds = strtoul(optarg, NULL, 10);
+			break;
+		case '3':
+			nsec3 = true;
+			break;
+		case 'h':
+			help();
+			return EXIT_SUCCESS;
+		default:
+			help();
+			return EXIT_FAILURE;
+		}
+	}
+	if (threads < 1 || rounds < 1) {
+		help();
+		return EXIT_FAILURE;
+	}
+	if (bits == 0) {
+		int size = dnssec_algorithm_key_size_default(alg);
+		bits = (size > 0) ? size : 0;
+	}
+
+	dnssec_crypto_init();
+
+	knot_dname_t *apex = knot_dname_from_str_alloc(apex_str);
+	char *dir = test_mkdtemp();
+	zone_key_t key = { 0 };
+	int ret = (apex != NULL && dir != NULL) ? gen_key(dir, apex, alg, bits, &key) : KNOT_ENOMEM;
+	if (ret != KNOT_EOK) {
+		fprintf(stderr, "failed to generate key (%s)\n", knot_strerror(ret));
+		if (dir != NULL) {
+			test_rm_rf(dir);
+		}
+		return EXIT_FAILURE;
+	}
+	zone_keyset_t keyset = { .count = 1, .keys = &key };
+
+	knot_kasp_policy_t policy = {
+		.algorithm = alg,
+		.rrsig_lifetime = 14 * 24 * 3600,
+		.rrsig_refresh_before = 7 * 24 * 3600,
+		.nsec3_enabled = nsec3,
+		.signing_threads = threads,
+	};
+	knot_kasp_zone_t kasp_zone = { .dname = apex };
+	kdnssec_ctx_t ctx = {
+		.now = knot_time(),
+		.zone = &kasp_zone,
+		.policy = &policy,
+	};
+
+	// The parallel signing uses the background workers of the server.
+	server_t server = { 0 };
+	zone_t *zone = zone_new(apex);
+	if (zone == NULL) {
+		return EXIT_FAILURE;
+	}
+	if (threads > 1) {
+		struct sigaction sa = { .sa_handler = interrupt_handle };
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGALRM, &sa, NULL); // Worker pool thread interrupts
+
+		server.workers = worker_pool_create(threads - 1);
+		if (server.workers == NULL) {
+			return EXIT_FAILURE;
+		}
+		worker_pool_start(server.workers);
+		zone->server = &server;
+	}
+
+	bench_t bench = {
+		.zone = zone,
+		.keyset = &keyset,
+		.ctx = &ctx,
+		.nodes = nodes,
+		.key = &key,
+	};
+
+	sign_stats_t stats = { 0 };
+	double total = 0;
+	for (unsigned i = 0; i < rounds && ret == KNOT_EOK; i++) {
+		ret = bench_round(&bench, &stats, &total);
+	}
+	if (ret != KNOT_EOK) {
+		fprintf(stderr, "signing failed (%s)\n", knot_strerror(ret));
+	} else {
+		printf("nodes: %zu, algorithm: %u, bits: %u, threads: %u, rounds: %u, %s\n",
+		       nodes, alg, bits, threads, rounds, nsec3 ? "NSEC3" : "NSEC");
+		printf("adjust:        %10.2f ms\n", stats.phase_ms[SIGN_PHASE_ADJUST] / rounds);
+		printf("NSEC chain:    %10.2f ms\n", stats.phase_ms[SIGN_PHASE_NSEC] / rounds);
+		printf("RRSIG:         %10.2f ms\n", stats.phase_ms[SIGN_PHASE_RRSIG] / rounds);
+		printf("apply:         %10.2f ms\n", stats.phase_ms[SIGN_PHASE_APPLY] / rounds);
+		printf("total:         %10.2f ms\n", total / rounds);
+		printf("RRSIGs:        %10"PRIu64"\n", stats.rrsigs_created / rounds);
+		printf("NSEC3 hashes:  %10"PRIu64"\n", stats.nsec3_hashes / rounds);
+		printf("RRSIGs/s:      %10.0f\n", total > 0 ?
+		       stats.rrsigs_created * 1000.0 / total : 0);
+	}
+
+	if (server.workers != NULL) {
+		worker_pool_stop(server.workers);
+		worker_pool_join(server.workers);
+		worker_pool_destroy(server.workers);
+	}
+	zone->server = NULL;
+	zone_free(&zone);
+	dnssec_key_free(key.key);
+	free((char *)key.id);
+	test_rm_rf(dir);
+	free(dir);
+	knot_dname_free(apex, NULL);
+	dnssec_crypto_cleanup();
+
+	return (ret == KNOT_EOK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
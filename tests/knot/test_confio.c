@@ -918,7 +918,8 @@ static void test_conf_io_list(void)
 	      "server.udp-max-payload-ipv4\n"
 	      "server.udp-max-payload-ipv6\n"
 	      "server.edns-client-subnet\n"
-	      "server.answer-rotation";
+	      "server.answer-rotation\n"
+	      "server.remote-probe-window";
 	ok(strcmp(ref, out) == 0, "compare result");
 }
 
@@ -941,6 +942,7 @@ static const yp_item_t desc_server[] = {
 	{ C_UDP_MAX_PAYLOAD_IPV6, YP_TINT,  YP_VNONE },
 	{ C_ECS,                  YP_TBOOL, YP_VNONE },
 	{ C_ANS_ROTATION,         YP_TBOOL, YP_VNONE },
+	{ C_RMT_PROBE_WINDOW,     YP_TINT,  YP_VNONE },
 	{ NULL }
 };
 
@@ -20,6 +20,7 @@
 #include <tap/basic.h>
 
 #include "knot/zone/zonefile.h"
+#include "libdnssec/digest.h"
 #include "libzscanner/scanner.h"
 
 // copy-pasted from knot/zone/zonefile.c
@@ -88,10 +89,10 @@ static zone_contents_t *str2contents(const char *zone_str)
 	return cont;
 }
 
-static int check_contents(const char *zone_str)
+static int check_contents(const char *zone_str, unsigned threads)
 {
 	zone_contents_t *cont = str2contents(zone_str);
-	int ret = zone_contents_digest_verify(cont);
+	int ret = zone_contents_digest_verify(cont, threads);
 	zone_contents_deep_free(cont);
 	return ret;
 }
@@ -438,37 +439,187 @@ example.      86400  IN  SOA     ns1 admin 2018031900 (  \n\
 ns1           3600   IN  A       203.0.113.63            \n\
 ns2           3600   IN  AAAA    2001:db8::63";
 
+static void check_large_zone(void)
+{
+	// Many more chunks than slots of the serializing threads.
+	const int nodes = 20000, node_len = 256;
+	char *zone_str = malloc(nodes * node_len + 100);
+	assert(zone_str != NULL);
+	int len = sprintf(zone_str, "example. 3600 IN SOA ns1 admin 1 1800 900 604800 86400\n");
+	for (int i = 0; i < nodes; i++) {
+		len += sprintf(zone_str + len, "node%d 3600 IN TXT \"%0200d\"\n", i, i);
+	}
+
+	zone_contents_t *cont = str2contents(zone_str);
+	free(zone_str);
+
+	uint8_t *serial = NULL, *parallel = NULL;
+	size_t serial_size = 0, parallel_size = 0;
+	int ret = zone_contents_digest(cont, DNSSEC_DIGEST_SHA384, 1, &serial, &serial_size);
+	is_int(KNOT_EOK, ret, "large zone, serial digest");
+	for (unsigned threads = 2; threads <= 8; threads *= 2) {
+		ret = zone_contents_digest(cont, DNSSEC_DIGEST_SHA384, threads,
+		                           &parallel, &parallel_size);
+		is_int(KNOT_EOK, ret, "large zone, parallel digest, threads %u", threads);
+		ok(serial_size == parallel_size && serial_size > 0 &&
+		   memcmp(serial, parallel, serial_size) == 0,
+		   "large zone, equal digests, threads %u", threads);
+		free(parallel);
+		parallel = NULL;
+	}
+
+	free(serial);
+	zone_contents_deep_free(cont);
+}
+
+#define MERKLE_NODES 3000
+
+// version 0: all nodes, 1: a few changes, 2: many nodes removed and added
+static bool merkle_node(int i, int version, bool *changed, int *data)
+{
+	*changed = false;
+	*data = i;
+	if (version >= 1 && i % 89 == 0) {
+		*data = i + 1;
+		*changed = (version == 1);
+	}
+	if (version >= 1 && i % 97 == 0) {
+		*changed = (version == 1);
+		return false;
+	}
+	if (version >= 2 && i % 7 == 3) {
+		*changed = true;
+		return false;
+	}
+	if (i >= MERKLE_NODES) {
+		// added nodes
+		*changed = (version == 1 && i < MERKLE_NODES + 40) ||
+		           (version == 2 && i >= MERKLE_NODES + 40);
+		return (version == 1 && i < MERKLE_NODES + 40) || version == 2;
+	}
+	return true;
+}
+
+static int free_changed(zone_node_t *node, void *data)
+{
+	node_free(node, NULL);
+	return KNOT_EOK;
+}
+
+static zone_contents_t *merkle_contents(int version, zone_tree_t *changed)
+{
+	char *zone_str = malloc((MERKLE_NODES + 100) * 64 + 100);
+	assert(zone_str != NULL);
+	int len = sprintf(zone_str, "example. 3600 IN SOA ns1 admin %d 1800 900 604800 86400\n", version);
+	for (int i = 0; i < MERKLE_NODES + 100; i++) {
+		bool node_changed;
+		int data;
+		if (merkle_node(i, version, &node_changed, &data)) {
+			len += sprintf(zone_str + len, "node%d 3600 IN TXT \"%d\"\n", i, data);
+		}
+		if (node_changed) {
+			char name[32];
+			(void)snprintf(name, sizeof(name), "node%d.example.", i);
+			knot_dname_t *owner = knot_dname_from_str_alloc(name);
+			zone_node_t *node = node_new(owner, false, false, NULL);
+			assert(node != NULL);
+			knot_dname_free(owner, NULL);
+			(void)zone_tree_insert(changed, &node);
+		}
+	}
+
+	zone_contents_t *cont = str2contents(zone_str);
+	free(zone_str);
+
+	zone_node_t *apex = node_new(cont->apex->owner, false, false, NULL); // SOA serial
+	assert(apex != NULL);
+	(void)zone_tree_insert(changed, &apex);
+
+	return cont;
+}
+
+static void check_merkle(void)
+{
+	zone_digest_cache_t *cache = NULL;
+	uint8_t *full = NULL, *incr = NULL;
+	size_t full_size = 0, incr_size = 0;
+
+	zone_tree_t *changed = zone_tree_create(false);
+	assert(changed != NULL);
+	zone_contents_t *cont = merkle_contents(0, changed);
+	int ret = zone_contents_digest_merkle(cont, DNSSEC_DIGEST_SHA384, NULL, NULL, NULL,
+	                                      &cache, &full, &full_size);
+	is_int(KNOT_EOK, ret, "merkle, full digest");
+	free(full);
+	zone_contents_deep_free(cont);
+
+	for (int version = 1; version <= 2; version++) {
+		zone_tree_apply(changed, free_changed, NULL);
+		zone_tree_free(&changed);
+		changed = zone_tree_create(false);
+		assert(changed != NULL);
+		cont = merkle_contents(version, changed);
+
+		zone_digest_cache_t *next = NULL;
+		ret = zone_contents_digest_merkle(cont, DNSSEC_DIGEST_SHA384, NULL, NULL, NULL,
+		                                  NULL, &full, &full_size);
+		is_int(KNOT_EOK, ret, "merkle, version %d, full digest", version);
+		ret = zone_contents_digest_merkle(cont, DNSSEC_DIGEST_SHA384, cache, changed, NULL,
+		                                  &next, &incr, &incr_size);
+		is_int(KNOT_EOK, ret, "merkle, version %d, incremental digest", version);
+		ok(full_size == incr_size && full_size > 0 &&
+		   memcmp(full, incr, full_size) == 0, "merkle, version %d, equal digests", version);
+
+		zone_digest_cache_free(cache);
+		cache = next;
+		free(full);
+		free(incr);
+		zone_contents_deep_free(cont);
+	}
+
+	zone_tree_apply(changed, free_changed, NULL);
+	zone_tree_free(&changed);
+	zone_digest_cache_free(cache);
+}
+
 int main(int argc, char *argv[])
 {
 	plan_lazy();
 
-	int ret = check_contents(simple_zone);
-	is_int(KNOT_EOK, ret, "simple zone");
+	for (unsigned threads = 1; threads <= 4; threads += 3) {
+		diag("threads %u", threads);
+
+		int ret = check_contents(simple_zone, threads);
+		is_int(KNOT_EOK, ret, "simple zone");
 
-	ret = check_contents(complex_zone);
-	is_int(KNOT_EOK, ret, "complex zone");
+		ret = check_contents(complex_zone, threads);
+		is_int(KNOT_EOK, ret, "complex zone");
 
-	ret = check_contents(multiple_digests);
-	is_int(KNOT_EOK, ret, "multiple digests");
+		ret = check_contents(multiple_digests, threads);
+		is_int(KNOT_EOK, ret, "multiple digests");
 
-	ret = check_contents(signed_zone);
-	is_int(KNOT_EOK, ret, "signed zone");
+		ret = check_contents(signed_zone, threads);
+		is_int(KNOT_EOK, ret, "signed zone");
 
-	ret = check_contents(nsec3_zone);
-	is_int(KNOT_EOK, ret, "nsec3 zone");
+		ret = check_contents(nsec3_zone, threads);
+		is_int(KNOT_EOK, ret, "nsec3 zone");
 
-	ret = check_contents(no_zonemd);
-	is_int(KNOT_ENOENT, ret, "no zonemd");
+		ret = check_contents(no_zonemd, threads);
+		is_int(KNOT_ENOENT, ret, "no zonemd");
 
-	ret = check_contents(wrong_soa);
-	is_int(KNOT_ENOTSUP, ret, "wrong SOA serial");
-	// TODO tests for different scheme / algorithm ?
+		ret = check_contents(wrong_soa, threads);
+		is_int(KNOT_ENOTSUP, ret, "wrong SOA serial");
+		// TODO tests for different scheme / algorithm ?
 
-	ret = check_contents(duplicate_schemalg);
-	is_int(KNOT_ESEMCHECK, ret, "duplicate scheme+algorithm pair");
+		ret = check_contents(duplicate_schemalg, threads);
+		is_int(KNOT_ESEMCHECK, ret, "duplicate scheme+algorithm pair");
+
+		ret = check_contents(wrong_hash, threads);
+		is_int(KNOT_EMALF, ret, "wrong hash");
+	}
 
-	ret = check_contents(wrong_hash);
-	is_int(KNOT_EMALF, ret, "wrong hash");
+	check_large_zone();
+	check_merkle();
 
 	return 0;
 }
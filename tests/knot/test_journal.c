@@ -18,12 +18,15 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <tap/basic.h>
 #include <tap/files.h>
 
+#include "contrib/string.h"
 #include "knot/journal/journal_read.h"
 #include "knot/journal/journal_write.h"
 
@@ -54,22 +57,29 @@ static unsigned lmdb_page_size(knot_lmdb_db_t *db)
 	return st.ms_psize;
 }
 
-static void set_conf(int zonefile_sync, size_t journal_usage, const knot_dname_t *apex)
+static void set_conf_compression(int zonefile_sync, size_t journal_usage,
+                                 const char *compression)
 {
-	(void)apex;
 	char conf_str[512];
 	snprintf(conf_str, sizeof(conf_str),
 	         "template:\n"
 	         " - id: default\n"
 	         "   zonefile-sync: %d\n"
 	         "   journal-max-usage: %zu\n"
-	         "   journal-max-depth: 1000\n",
-	         zonefile_sync, journal_usage);
+	         "   journal-max-depth: 1000\n"
+	         "   journal-compression: %s\n",
+	         zonefile_sync, journal_usage, compression);
 	_unused_ int ret = test_conf(conf_str, NULL);
 	assert(ret == KNOT_EOK);
 	jj.conf = conf();
 }
 
+static void set_conf(int zonefile_sync, size_t journal_usage, const knot_dname_t *apex)
+{
+	(void)apex;
+	set_conf_compression(zonefile_sync, journal_usage, "none");
+}
+
 static void unset_conf(void)
 {
 	conf_update(NULL, CONF_UPD_FNONE);
@@ -798,6 +808,364 @@ static void test_merge(const knot_dname_t *apex)
 	unset_conf();
 }
 
+/*! \brief Test reading with the transaction released in between. */
+static void test_suspend(const knot_dname_t *apex)
+{
+	set_conf(1000, 512 * 1024, apex);
+
+	int ret = journal_scrape_with_md(jj, true);
+	is_int(KNOT_EOK, ret, "journal: scrape before suspend (%s)", knot_strerror(ret));
+
+	changeset_t *ch1 = changeset_new(apex), *ch2 = changeset_new(apex);
+	init_random_changeset(ch1, 1, 2, 300, apex, false);
+	init_random_changeset(ch2, 2, 3, 300, apex, false);
+	ret = journal_insert(jj, ch1, NULL);
+	if (ret == KNOT_EOK) {
+		ret = journal_insert(jj, ch2, NULL);
+	}
+	is_int(KNOT_EOK, ret, "journal: insert before suspend (%s)", knot_strerror(ret));
+
+	journal_read_t *read = NULL, *ref = NULL;
+	ret = journal_read_begin(jj, false, 1, &read);
+	if (ret == KNOT_EOK) {
+		ret = journal_read_begin(jj, false, 1, &ref);
+	}
+	is_int(KNOT_EOK, ret, "journal: begin reading (%s)", knot_strerror(ret));
+	usleep(2000);
+	ok(journal_read_oldest_age() >= 1, "journal: oldest reader age");
+
+	knot_rrset_t rr = { 0 }, ref_rr = { 0 };
+	bool equal = true;
+	size_t count = 0;
+	while (journal_read_rrset(ref, &ref_rr, true)) {
+		if (count % 7 == 0) {
+			ret = journal_read_suspend(read);
+			equal &= (ret == KNOT_EOK);
+		}
+		equal &= journal_read_rrset(read, &rr, true) && knot_rrset_equal(&rr, &ref_rr, true);
+		journal_read_clear_rrset(&rr);
+		journal_read_clear_rrset(&ref_rr);
+		count++;
+	}
+	equal &= !journal_read_rrset(read, &rr, true);
+	ok(equal && count > 600, "journal: same data read with suspends (%zu RRsets)", count);
+	ret = journal_read_get_error(read, KNOT_EOK);
+	is_int(KNOT_EOK, ret, "journal: no error after suspends (%s)", knot_strerror(ret));
+	journal_read_end(read);
+	journal_read_end(ref);
+	ok(journal_read_oldest_age() == 0, "journal: no reader after end");
+
+	ret = journal_read_begin(jj, false, 1, &read);
+	for (int i = 0; ret == KNOT_EOK && i < 3; i++) {
+		ret = journal_read_rrset(read, &rr, true) ? KNOT_EOK : KNOT_ERROR;
+		journal_read_clear_rrset(&rr);
+	}
+	if (ret == KNOT_EOK) {
+		ret = journal_read_suspend(read);
+	}
+	ok(ret == KNOT_EOK && journal_read_oldest_age() == 0, "journal: suspended reader released");
+	(void)journal_scrape_with_md(jj, true);
+	while (journal_read_rrset(read, &rr, true)) {
+		journal_read_clear_rrset(&rr);
+	}
+	ret = journal_read_get_error(read, KNOT_EOK);
+	is_int(KNOT_ENOENT, ret, "journal: resume after removal (%s)", knot_strerror(ret));
+	journal_read_end(read);
+
+	changeset_free(ch1);
+	changeset_free(ch2);
+	unset_conf();
+}
+
+/*! \brief Count the stored chunks of a changeset and the compressed ones. */
+static size_t count_chunks(uint32_t serial, const knot_dname_t *apex, size_t *compressed)
+{
+	size_t count = 0;
+	*compressed = 0;
+	knot_lmdb_txn_t txn = { 0 };
+	knot_lmdb_begin(&jdb, &txn, false);
+	MDB_val prefix = journal_changeset_id_to_key(false, serial, apex);
+	knot_lmdb_foreach(&txn, &prefix) {
+		uint32_t raw_size = 0;
+		if (journal_chunk_compression(&txn.cur_val, &raw_size) != JOURNAL_COMPRESSION_NONE &&
+		    raw_size > txn.cur_val.mv_size - JOURNAL_HEADER_SIZE) {
+			(*compressed)++;
+		}
+		count++;
+	}
+	free(prefix.mv_data);
+	knot_lmdb_abort(&txn);
+	return count;
+}
+
+/*! \brief Test storing compressed changesets and reading mixed chunks. */
+static void test_compression(const knot_dname_t *apex)
+{
+	set_conf_compression(1000, 512 * 1024, "zlib");
+
+	int ret = journal_scrape_with_md(jj, true);
+	is_int(KNOT_EOK, ret, "journal: scrape before compression (%s)", knot_strerror(ret));
+
+	changeset_t *ch1 = changeset_new(apex), *ch2 = changeset_new(apex);
+	init_random_changeset(ch1, 1, 2, 1000, apex, false);
+	init_random_changeset(ch2, 2, 3, 1000, apex, false);
+	ret = journal_insert(jj, ch1, NULL);
+	is_int(KNOT_EOK, ret, "journal: insert compressed (%s)", knot_strerror(ret));
+
+	size_t compressed = 0, chunks = count_chunks(1, apex, &compressed);
+#ifdef ENABLE_JOURNAL_COMPRESSION
+	ok(chunks > 1 && compressed == chunks, "journal: chunks compressed (%zu)", chunks);
+#else
+	ok(chunks > 1 && compressed == 0, "journal: chunks not compressed without zlib");
+#endif
+
+	// the following changeset is stored uncompressed
+	unset_conf();
+	set_conf(1000, 512 * 1024, apex);
+	ret = journal_insert(jj, ch2, NULL);
+	is_int(KNOT_EOK, ret, "journal: insert uncompressed (%s)", knot_strerror(ret));
+	chunks = count_chunks(2, apex, &compressed);
+	ok(chunks > 1 && compressed == 0, "journal: chunks not compressed");
+
+	list_t l;
+	journal_read_t *read = NULL;
+	ret = load_j_list(&jj, false, 1, &read, &l);
+	is_int(KNOT_EOK, ret, "journal: read mixed chunks (%s)", knot_strerror(ret));
+	ok(list_size(&l) == 2 && changesets_eq(ch1, HEAD(l)) && changesets_eq(ch2, TAIL(l)),
+	   "journal: changesets equal after read");
+	changesets_free(&l);
+	journal_read_end(read);
+
+	ret = journal_sem_check(jj);
+	is_int(KNOT_EOK, ret, "journal: check after compression (%s)", knot_strerror(ret));
+
+	changeset_free(ch1);
+	changeset_free(ch2);
+	unset_conf();
+}
+
+/*! \brief Test that borrowed RRsets equal the copied ones, also across suspends. */
+static void test_borrowed(void)
+{
+	set_conf(1000, 512 * 1024, NULL);
+
+	journal_read_t *read = NULL, *read_borrowed = NULL;
+	int ret = journal_read_begin(jj, false, 1, &read);
+	if (ret == KNOT_EOK) {
+		ret = journal_read_begin(jj, false, 1, &read_borrowed);
+	}
+	is_int(KNOT_EOK, ret, "journal: begin borrowed reading (%s)", knot_strerror(ret));
+
+	size_t count = 0;
+	bool equal = true;
+	knot_rrset_t rr = { 0 }, borrowed;
+	while (ret == KNOT_EOK && journal_read_rrset(read, &rr, true)) {
+		if (!journal_read_rrset_borrowed(read_borrowed, &borrowed, true) ||
+		    !knot_rrset_equal(&rr, &borrowed, true)) {
+			equal = false;
+		}
+		journal_read_clear_rrset(&rr);
+		if (++count % 100 == 0) {
+			ret = journal_read_suspend(read_borrowed);
+		}
+	}
+	equal &= !journal_read_rrset_borrowed(read_borrowed, &borrowed, true);
+	ret = journal_read_get_error(read_borrowed, journal_read_get_error(read, ret));
+	ok(ret == KNOT_EOK && equal && count > 100, "journal: borrowed RRsets equal (%zu)", count);
+
+	journal_read_end(read);
+	journal_read_end(read_borrowed);
+	unset_conf();
+}
+
+typedef struct {
+	knot_rrset_t *rrsets;
+	bool *removals;
+	size_t count;
+	size_t pos;
+	size_t fail_at;
+	bool equal;
+} prefetch_check_t;
+
+static int prefetch_cb(bool remove, const knot_rrset_t *rr, void *ctx)
+{
+	prefetch_check_t *check = ctx;
+	if (check->pos == check->fail_at) {
+		return KNOT_EEXIST;
+	}
+	if (check->pos >= check->count || check->removals[check->pos] != remove ||
+	    !knot_rrset_equal(&check->rrsets[check->pos], rr, true)) {
+		check->equal = false;
+	}
+	check->pos++;
+	return KNOT_EOK;
+}
+
+static int collect_cb(bool remove, const knot_rrset_t *rr, void *ctx)
+{
+	prefetch_check_t *check = ctx;
+	knot_rrset_t *copy = knot_rrset_copy(rr, NULL);
+	if (copy == NULL) {
+		return KNOT_ENOMEM;
+	}
+	check->rrsets[check->count] = *copy;
+	check->removals[check->count++] = remove;
+	free(copy);
+	return KNOT_EOK;
+}
+
+/*! \brief Test reading the RRsets ahead on a helper thread. */
+static void test_prefetch(void)
+{
+	set_conf(1000, 512 * 1024, NULL);
+
+	prefetch_check_t check = {
+		.rrsets = calloc(4096, sizeof(knot_rrset_t)),
+		.removals = calloc(4096, sizeof(bool)),
+		.fail_at = SIZE_MAX,
+		.equal = true,
+	};
+	journal_read_t *read = NULL;
+	int ret = journal_read_begin(jj, false, 1, &read);
+	if (ret == KNOT_EOK) {
+		ret = journal_read_rrsets(read, collect_cb, &check);
+	}
+	ok(ret == KNOT_EOK && check.count > 1024, "journal: read RRsets to compare (%zu)", check.count);
+
+	ret = journal_read_begin(jj, false, 1, &read);
+	if (ret == KNOT_EOK) {
+		ret = journal_read_rrsets_prefetch(read, true, prefetch_cb, &check);
+		journal_read_end(read);
+	}
+	ok(ret == KNOT_EOK && check.equal && check.pos == check.count,
+	   "journal: prefetched RRsets equal (%s)", knot_strerror(ret));
+
+	check.pos = 0;
+	ret = journal_read_begin(jj, false, 1, &read);
+	if (ret == KNOT_EOK) {
+		ret = journal_read_rrsets_prefetch(read, false, prefetch_cb, &check);
+	}
+	size_t first = check.pos;
+	if (ret == KNOT_EOK) {
+		ret = journal_read_rrsets(read, prefetch_cb, &check);
+	}
+	ok(ret == KNOT_EOK && check.equal && first > 0 && first < check.count &&
+	   check.pos == check.count, "journal: prefetched one changeset, then the rest");
+
+	check.pos = 0;
+	check.fail_at = 1500;
+	ret = journal_read_begin(jj, false, 1, &read);
+	if (ret == KNOT_EOK) {
+		ret = journal_read_rrsets_prefetch(read, true, prefetch_cb, &check);
+		journal_read_end(read);
+	}
+	ok(ret == KNOT_EEXIST && check.pos == check.fail_at, "journal: prefetch stopped by callback");
+
+	for (size_t i = 0; i < check.count; i++) {
+		knot_rrset_clear(&check.rrsets[i], NULL);
+	}
+	free(check.rrsets);
+	free(check.removals);
+	unset_conf();
+}
+
+#define GROUP_ZONES 8
+
+typedef struct {
+	zone_journal_t j;
+	changeset_t *ch;
+	changeset_t *extra;
+	pthread_barrier_t *barrier;
+	int ret;
+} group_insert_t;
+
+static void *group_insert_thread(void *arg)
+{
+	group_insert_t *ins = arg;
+	pthread_barrier_wait(ins->barrier);
+	ins->ret = journal_insert(ins->j, ins->ch, ins->extra);
+	return NULL;
+}
+
+/*! \brief Test concurrent insertions into several zones committed together. */
+static void test_group_commit(void)
+{
+	set_conf(1000, 512 * 1024, NULL);
+
+	char *group_dir = sprintf_alloc("%s/group", test_dir_name);
+	knot_lmdb_db_t gdb = { 0 };
+	knot_lmdb_init(&gdb, group_dir, 4096 * 1024, journal_env_flags(JOURNAL_MODE_ROBUST, false), NULL);
+	gdb.group_window_ms = 200;
+	int ret = knot_lmdb_open(&gdb);
+	is_int(KNOT_EOK, ret, "journal: open group commit db (%s)", knot_strerror(ret));
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, GROUP_ZONES);
+	pthread_t threads[GROUP_ZONES];
+	group_insert_t ins[GROUP_ZONES] = { { { 0 } } };
+	for (int i = 0; i < GROUP_ZONES; i++) {
+		char name[16];
+		(void)snprintf(name, sizeof(name), "zone%d.", i);
+		knot_dname_t *zone = knot_dname_from_str_alloc(name);
+		ins[i].j = (zone_journal_t){ &gdb, zone, conf() };
+		ins[i].ch = changeset_new(zone);
+		ins[i].barrier = &barrier;
+	}
+
+	// the last zone fails the insertion of the extra changeset due to zone-in-journal
+	group_insert_t *fail = &ins[GROUP_ZONES - 1];
+	zone_contents_t *z = tm2_zone(fail->j.zone);
+	ret = journal_insert_zone(fail->j, z);
+	is_int(KNOT_EOK, ret, "journal: insert zone before group (%s)", knot_strerror(ret));
+	zone_contents_deep_free(z);
+	fail->extra = changeset_new(fail->j.zone);
+	init_random_changeset(fail->extra, 2, 3, 10, fail->j.zone, false);
+
+	for (int i = 0; i < GROUP_ZONES; i++) {
+		init_random_changeset(ins[i].ch, 1, 3, 100, ins[i].j.zone, false);
+		pthread_create(&threads[i], NULL, group_insert_thread, &ins[i]);
+	}
+	bool inserted = true;
+	for (int i = 0; i < GROUP_ZONES; i++) {
+		pthread_join(threads[i], NULL);
+		if (i < GROUP_ZONES - 1) {
+			inserted &= (ins[i].ret == KNOT_EOK);
+		}
+	}
+	ok(inserted, "journal: concurrent insertions");
+	is_int(KNOT_ESEMCHECK, fail->ret, "journal: failed insertion in a group");
+
+	uint64_t commits = 0, writes = 0, max = 0;
+	knot_lmdb_group_stats(&gdb, &commits, &writes, &max);
+	ok(writes == GROUP_ZONES && commits < GROUP_ZONES && max > 1,
+	   "journal: insertions grouped (%"PRIu64" commits, max %"PRIu64")", commits, max);
+
+	bool stored = true;
+	for (int i = 0; i < GROUP_ZONES - 1; i++) {
+		list_t l;
+		journal_read_t *read = NULL;
+		ret = load_j_list(&ins[i].j, false, 1, &read, &l);
+		stored &= (ret == KNOT_EOK && list_size(&l) == 1 && changesets_eq(ins[i].ch, HEAD(l)));
+		changesets_free(&l);
+		journal_read_end(read);
+	}
+	ok(stored, "journal: grouped changesets stored");
+	bool exists = true;
+	uint32_t serial_to = 0;
+	ret = journal_info(fail->j, &exists, NULL, NULL, &serial_to, NULL, NULL, NULL, NULL);
+	ok(ret == KNOT_EOK && exists && serial_to == 1, "journal: failed insertion not stored");
+
+	for (int i = 0; i < GROUP_ZONES; i++) {
+		changeset_free(ins[i].ch);
+		changeset_free(ins[i].extra);
+		knot_dname_free((knot_dname_t *)ins[i].j.zone, NULL);
+	}
+	pthread_barrier_destroy(&barrier);
+	knot_lmdb_deinit(&gdb);
+	free(group_dir);
+	unset_conf();
+}
+
 static void test_stress_base(const knot_dname_t *apex,
                              size_t update_size, size_t file_size)
 {
@@ -869,6 +1237,16 @@ int main(int argc, char *argv[])
 
 	test_merge(apex);
 
+	test_suspend(apex);
+
+	test_compression(apex);
+
+	test_borrowed();
+
+	test_prefetch();
+
+	test_group_commit();
+
 	test_stress(apex);
 
 	knot_lmdb_deinit(&jdb);
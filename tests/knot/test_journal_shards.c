@@ -0,0 +1,163 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <tap/basic.h>
+#include <tap/files.h>
+
+#include "knot/journal/journal_metadata.h"
+#include "knot/journal/journal_shards.h"
+#include "knot/journal/journal_write.h"
+#include "libknot/libknot.h"
+#include "test_conf.h"
+
+#define ZONES		16
+#define MAPSIZE		(64 * 1024 * 1024)
+
+static knot_rrset_t *soa(const knot_dname_t *apex, uint32_t serial)
+{
+	uint8_t rdata[1 + 1 + 20] = { 0 }; // root mname and rname
+	knot_wire_write_u32(rdata + 2, serial);
+
+	knot_rrset_t *rr = knot_rrset_new(apex, KNOT_RRTYPE_SOA, KNOT_CLASS_IN, 3600, NULL);
+	(void)knot_rrset_add_rdata(rr, rdata, sizeof(rdata), NULL);
+	return rr;
+}
+
+static int insert(journal_shards_t *js, const knot_dname_t *zone)
+{
+	changeset_t *ch = changeset_new(zone);
+	if (ch == NULL) {
+		return KNOT_ENOMEM;
+	}
+	ch->soa_from = soa(zone, 1);
+	ch->soa_to = soa(zone, 2);
+
+	zone_journal_t j = { journal_shard(js, zone), zone, conf() };
+	int ret = journal_insert(j, ch, NULL);
+	changeset_free(ch);
+	return ret;
+}
+
+/*! \brief Check that each zone is only in its shard. */
+static bool zones_placed(journal_shards_t *js, knot_dname_t **zones)
+{
+	for (size_t i = 0; i < ZONES; i++) {
+		for (unsigned s = 0; s < JOURNAL_SHARDS_MAX; s++) {
+			knot_lmdb_db_t *db = &js->shards[s];
+			bool exists = false;
+			if (knot_lmdb_exists(db) == KNOT_EOK) {
+				zone_journal_t j = { db, zones[i] };
+				(void)journal_info(j, &exists, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+			}
+			if (exists != (db == journal_shard(js, zones[i]))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void test_index(knot_dname_t **zones)
+{
+	bool in_range = true, stable = true;
+	unsigned used = 0;
+	for (size_t i = 0; i < ZONES; i++) {
+		unsigned idx = journal_shard_index(zones[i], 4);
+		in_range &= (idx < 4);
+		stable &= (idx == journal_shard_index(zones[i], 4));
+		used |= 1 << idx;
+		in_range &= (journal_shard_index(zones[i], 1) == 0);
+	}
+	ok(in_range && stable, "shards: index in range and stable");
+	ok(used == 0xf, "shards: zones spread over shards");
+
+	char *path = journal_shard_path("/journal", 0);
+	ok(path != NULL && strcmp(path, "/journal") == 0, "shards: first shard path");
+	free(path);
+	path = journal_shard_path("/journal", 3);
+	ok(path != NULL && strcmp(path, "/journal/shard-3") == 0, "shards: other shard path");
+	free(path);
+}
+
+static void test_migrate(const char *dir, knot_dname_t **zones)
+{
+	int ret = test_conf("template:\n"
+	                    " - id: default\n"
+	                    "   journal-max-usage: 1M\n", NULL);
+	is_int(KNOT_EOK, ret, "shards: configuration");
+
+	journal_shards_t js = { 0 };
+	journal_shards_init(&js, dir, 1, MAPSIZE, 0);
+	for (size_t i = 0; i < ZONES && ret == KNOT_EOK; i++) {
+		ret = insert(&js, zones[i]);
+	}
+	is_int(KNOT_EOK, ret, "shards: insert into one shard");
+
+	size_t moved = 0;
+	ret = journal_shards_reinit(&js, dir, 4, MAPSIZE, 0);
+	is_int(KNOT_EISCONN, ret, "shards: refuse resharding when open");
+	journal_shards_deinit(&js);
+
+	journal_shards_init(&js, dir, 4, MAPSIZE, 0);
+	ret = journal_shards_migrate(&js, &moved);
+	ok(ret == KNOT_EOK && moved > 0 && moved < ZONES, "shards: migrate to 4 shards (%zu)", moved);
+	ok(zones_placed(&js, zones), "shards: zones in their shards");
+
+	uint64_t txns = 0, wait_us = 0;
+	journal_shards_write_stats(&js, &txns, &wait_us);
+	ok(txns >= 2 * moved, "shards: write transactions counted");
+
+	for (unsigned i = 0; i < JOURNAL_SHARDS_MAX; i++) {
+		knot_lmdb_close(&js.shards[i]);
+	}
+	ret = journal_shards_reinit(&js, dir, 1, MAPSIZE, 0);
+	is_int(KNOT_EOK, ret, "shards: reinit closed shards");
+	ret = journal_shards_migrate(&js, &moved);
+	ok(ret == KNOT_EOK && zones_placed(&js, zones), "shards: migrate back to one shard");
+
+	ret = journal_shards_migrate(&js, &moved);
+	ok(ret == KNOT_EOK && moved == 0, "shards: nothing to migrate");
+
+	journal_shards_deinit(&js);
+	test_conf_free();
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	knot_dname_t *zones[ZONES];
+	for (size_t i = 0; i < ZONES; i++) {
+		char name[32];
+		(void)snprintf(name, sizeof(name), "zone%zu.example.", i);
+		zones[i] = knot_dname_from_str_alloc(name);
+	}
+
+	char *dir = test_mkdtemp();
+
+	test_index(zones);
+	test_migrate(dir, zones);
+
+	test_rm_rf(dir);
+	free(dir);
+	for (size_t i = 0; i < ZONES; i++) {
+		knot_dname_free(zones[i], NULL);
+	}
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <tap/basic.h>
+
+#include "knot/dnssec/nsec3-cache.h"
+#include "knot/dnssec/zone-nsec.h"
+#include "libknot/libknot.h"
+
+static bool owner_ok(nsec3_cache_t *cache, const knot_dname_t *name,
+                     const knot_dname_t *apex, const dnssec_nsec3_params_t *params)
+{
+	knot_dname_storage_t cached, expected;
+	int ret1 = nsec3_cache_owner(cache, cached, name, apex, params);
+	int ret2 = knot_create_nsec3_owner(expected, sizeof(expected), name, apex, params);
+
+	return ret1 == KNOT_EOK && ret2 == KNOT_EOK && knot_dname_is_equal(cached, expected);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	nsec3_caches_t caches = { 0 };
+	int ret = nsec3_caches_init(&caches, 2);
+	ok(ret == KNOT_EOK && caches.count == 2, "init");
+	ok(nsec3_caches_get(&caches, 2) == NULL, "no cache for unknown thread");
+
+	nsec3_cache_t *cache = nsec3_caches_get(&caches, 1);
+	const knot_dname_t *apex = (const knot_dname_t *)"\x07""example";
+	const knot_dname_t *name = (const knot_dname_t *)"\x03""www""\x07""example";
+	dnssec_nsec3_params_t params = {
+		.algorithm = DNSSEC_NSEC3_ALGORITHM_SHA1,
+		.iterations = 10,
+		.salt = { .size = 4, .data = (uint8_t *)"\xaa\xbb\xcc\xdd" }
+	};
+
+	ok(owner_ok(NULL, name, apex, &params) && nsec3_caches_hashes(&caches) == 0,
+	   "no cache");
+
+	ok(owner_ok(cache, name, apex, &params) &&
+	   nsec3_caches_hashes(&caches) == 1 && nsec3_caches_hits(&caches) == 0,
+	   "computed");
+	ok(owner_ok(cache, name, apex, &params) &&
+	   nsec3_caches_hashes(&caches) == 1 && nsec3_caches_hits(&caches) == 1,
+	   "cached");
+
+	params.salt.data = (uint8_t *)"\xaa\xbb\xcc\xde";
+	ok(owner_ok(cache, name, apex, &params) && nsec3_caches_hashes(&caches) == 2,
+	   "salt change");
+	params.iterations = 0;
+	ok(owner_ok(cache, name, apex, &params) && nsec3_caches_hashes(&caches) == 3,
+	   "iterations change");
+
+	const knot_dname_t *other = (const knot_dname_t *)"\x03""www""\x07""example""\x03""com";
+	const knot_dname_t *other_apex = (const knot_dname_t *)"\x07""example""\x03""com";
+	ok(owner_ok(cache, other, other_apex, &params) && nsec3_caches_hashes(&caches) == 4,
+	   "other zone");
+
+	bool valid = true;
+	char txt[64];
+	for (int i = 0; i < 3 * NSEC3_CACHE_SIZE; i++) {
+		(void)snprintf(txt, sizeof(txt), "n%d.example.", i % (2 * NSEC3_CACHE_SIZE));
+		knot_dname_t *n = knot_dname_from_str_alloc(txt);
+		valid = valid && owner_ok(cache, n, apex, &params);
+		knot_dname_free(n, NULL);
+	}
+	ok(valid, "evictions");
+
+	uint64_t hashes = nsec3_caches_hashes(&caches);
+	ok(hashes > 4 + 2 * NSEC3_CACHE_SIZE && hashes <= 4 + 3 * NSEC3_CACHE_SIZE &&
+	   nsec3_caches_hits(&caches) == 1 + 4 + 3 * NSEC3_CACHE_SIZE - hashes,
+	   "counters");
+
+	knot_time_t now = knot_time();
+	uint64_t rate = nsec3_caches_rate(&caches, now) + nsec3_caches_rate(&caches, now + 1);
+	ok(rate > 0 && rate <= hashes, "rate");
+	ok(nsec3_caches_rate(&caches, now + 10) == 0, "rate expired");
+
+	params.algorithm = 2;
+	knot_dname_storage_t out;
+	ok(nsec3_cache_owner(cache, out, name, apex, &params) != KNOT_EOK, "unknown algorithm");
+
+	nsec3_caches_deinit(&caches);
+	ok(caches.caches == NULL && caches.count == 0, "deinit");
+
+	return 0;
+}
@@ -0,0 +1,194 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <tap/basic.h>
+
+#include "knot/zone/node.h"
+#include "knot/zone/rdata_store.h"
+#include "libknot/libknot.h"
+
+static knot_rrset_t *create_rrset(const knot_dname_t *owner, uint16_t type,
+                                  const char *data)
+{
+	knot_rrset_t *r = knot_rrset_new(owner, type, KNOT_CLASS_IN, 3600, NULL);
+	assert(r);
+	int ret = knot_rrset_add_rdata(r, (const uint8_t *)data, strlen(data), NULL);
+	assert(ret == KNOT_EOK);
+	(void)ret;
+	return r;
+}
+
+static void test_store(void)
+{
+	rdata_store_t *store = rdata_store_new();
+	ok(store != NULL, "store: create");
+
+	knot_dname_t *owner = knot_dname_from_str_alloc("test.");
+	knot_rrset_t *a = create_rrset(owner, KNOT_RRTYPE_TXT, "same");
+	knot_rrset_t *b = create_rrset(owner, KNOT_RRTYPE_TXT, "same");
+	knot_rrset_t *c = create_rrset(owner, KNOT_RRTYPE_TXT, "other");
+
+	knot_rdataset_t sa, sb, sc;
+	int ret = rdata_store_intern(store, &a->rrs, &sa);
+	ok(ret == KNOT_EOK && knot_rdataset_eq(&sa, &a->rrs) &&
+	   sa.rdata != a->rrs.rdata, "store: intern");
+	ret = rdata_store_intern(store, &b->rrs, &sb);
+	ok(ret == KNOT_EOK && sb.rdata == sa.rdata, "store: identical data shared");
+	ret = rdata_store_intern(store, &c->rrs, &sc);
+	ok(ret == KNOT_EOK && sc.rdata != sa.rdata, "store: different data not shared");
+
+	rdata_store_stats_t stats;
+	rdata_store_stats(store, &stats);
+	ok(stats.entries == 2 && stats.refs == 3 &&
+	   stats.ref_bytes == 2 * sa.size + sc.size, "store: statistics");
+
+	rdata_store_release(&sa);
+	ok(sa.rdata == NULL && sa.count == 0, "store: release");
+	ok(knot_rdataset_eq(&sb, &b->rrs), "store: data kept while referenced");
+	rdata_store_release(&sb);
+	rdata_store_release(&sc);
+	rdata_store_stats(store, &stats);
+	ok(stats.entries == 0 && stats.refs == 0 && stats.bytes == 0, "store: empty");
+
+	ok(!rdata_store_candidate(KNOT_RRTYPE_SOA) &&
+	   !rdata_store_candidate(KNOT_RRTYPE_RRSIG) &&
+	   rdata_store_candidate(KNOT_RRTYPE_NS), "store: candidate types");
+
+	knot_rrset_free(a, NULL);
+	knot_rrset_free(b, NULL);
+	knot_rrset_free(c, NULL);
+	knot_dname_free(owner, NULL);
+	rdata_store_unref(store);
+}
+
+static void test_node(void)
+{
+	rdata_store_t *store = rdata_store_new();
+	assert(store);
+
+	knot_dname_t *owner1 = knot_dname_from_str_alloc("a.test.");
+	knot_dname_t *owner2 = knot_dname_from_str_alloc("b.test.");
+	zone_node_t *n1 = node_new(owner1, false, false, NULL);
+	zone_node_t *n2 = node_new(owner2, false, false, NULL);
+	assert(n1 && n2);
+
+	knot_rrset_t *ns = create_rrset(owner1, KNOT_RRTYPE_NS, "\x02ns\x04test");
+	knot_rrset_t *soa = create_rrset(owner1, KNOT_RRTYPE_SOA, "soa");
+	int ret = node_add_rrset(n1, ns, NULL);
+	ret |= node_add_rrset(n1, soa, NULL);
+	ret |= node_add_rrset(n2, ns, NULL);
+	assert(ret == KNOT_EOK);
+
+	ret = node_intern_rrsets(n1, store);
+	ret |= node_intern_rrsets(n2, store);
+	knot_rdataset_t *ns1 = node_rdataset(n1, KNOT_RRTYPE_NS);
+	knot_rdataset_t *ns2 = node_rdataset(n2, KNOT_RRTYPE_NS);
+	ok(ret == KNOT_EOK && ns1->rdata == ns2->rdata &&
+	   knot_rdataset_eq(ns1, &ns->rrs), "node: identical rdatasets shared");
+	ok(!n1->rrs[1].interned && n1->rrs[1].type == KNOT_RRTYPE_SOA,
+	   "node: SOA not shared");
+
+	knot_rrset_t *ns_add = create_rrset(owner1, KNOT_RRTYPE_NS, "\x03ns2\x04test");
+	ret = node_add_rrset(n1, ns_add, NULL);
+	ns1 = node_rdataset(n1, KNOT_RRTYPE_NS);
+	ok(ret == KNOT_EOK && ns1->count == 2 && ns2->count == 1 &&
+	   ns1->rdata != ns2->rdata, "node: copy on add");
+
+	ret = node_intern_rrsets(n1, store);
+	ok(ret == KNOT_EOK && n1->rrs[0].interned, "node: re-intern changed rdataset");
+
+	ret = node_remove_rrset(n1, ns_add, NULL);
+	ns1 = node_rdataset(n1, KNOT_RRTYPE_NS);
+	ok(ret == KNOT_EOK && ns1->count == 1 && !n1->rrs[0].interned &&
+	   knot_rdataset_eq(ns1, ns2), "node: copy on remove");
+
+	rdata_store_stats_t stats;
+	rdata_store_stats(store, &stats);
+	ok(stats.entries == 1 && stats.refs == 1, "node: unused data released");
+
+	node_free_rrsets(n1, NULL);
+	node_free_rrsets(n2, NULL);
+	rdata_store_stats(store, &stats);
+	ok(stats.entries == 0, "node: free releases shared data");
+
+	node_free(n1, NULL);
+	node_free(n2, NULL);
+	knot_rrset_free(ns, NULL);
+	knot_rrset_free(ns_add, NULL);
+	knot_rrset_free(soa, NULL);
+	knot_dname_free(owner1, NULL);
+	knot_dname_free(owner2, NULL);
+	rdata_store_unref(store);
+}
+
+static void test_binode(void)
+{
+	rdata_store_t *store = rdata_store_new();
+	assert(store);
+
+	knot_dname_t *owner = knot_dname_from_str_alloc("a.test.");
+	zone_node_t *old = node_new(owner, true, false, NULL);
+	assert(old);
+
+	knot_rrset_t *ns = create_rrset(owner, KNOT_RRTYPE_NS, "\x02ns\x04test");
+	knot_rrset_t *ns_add = create_rrset(owner, KNOT_RRTYPE_NS, "\x03ns2\x04test");
+	int ret = node_add_rrset(old, ns, NULL);
+	ret |= node_intern_rrsets(old, store);
+	assert(ret == KNOT_EOK);
+
+	// Update of the new version ending with the same rdataset.
+	zone_node_t *new = binode_counterpart(old);
+	new->rrs = old->rrs;
+	new->rrset_count = old->rrset_count;
+	ret = binode_prepare_change(new, NULL);
+	ret |= node_add_rrset(new, ns_add, NULL);
+	ret |= node_remove_rrset(new, ns_add, NULL);
+	ret |= node_intern_rrsets(new, store);
+	ok(ret == KNOT_EOK && new->rrs[0].interned &&
+	   binode_rdata_shared(new, KNOT_RRTYPE_NS), "binode: data interned back");
+
+	rdata_store_stats_t stats;
+	rdata_store_stats(store, &stats);
+	ok(stats.entries == 1 && stats.refs == 1, "binode: one reference");
+
+	binode_unify(new, false, NULL);
+	rdata_store_stats(store, &stats);
+	ok(stats.entries == 1 && stats.refs == 1, "binode: unify");
+
+	node_free_rrsets(old, NULL);
+	new->rrs = NULL;
+	new->rrset_count = 0;
+	rdata_store_stats(store, &stats);
+	ok(stats.entries == 0, "binode: data released");
+
+	node_free(old, NULL);
+	knot_rrset_free(ns, NULL);
+	knot_rrset_free(ns_add, NULL);
+	knot_dname_free(owner, NULL);
+	rdata_store_unref(store);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	test_store();
+	test_node();
+	test_binode();
+
+	return 0;
+}
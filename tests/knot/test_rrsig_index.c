@@ -0,0 +1,207 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <tap/basic.h>
+
+#include "knot/dnssec/rrsig-index.h"
+#include "knot/zone/node.h"
+#include "libknot/libknot.h"
+
+typedef struct {
+	knot_dname_t *owners[4];
+	bool nsec3[4];
+	size_t count;
+} due_t;
+
+static int collect(const knot_dname_t *owner, bool nsec3, void *ctx)
+{
+	due_t *due = ctx;
+	if (due->count >= 4) {
+		return KNOT_ESPACE;
+	}
+	due->owners[due->count] = knot_dname_copy(owner, NULL);
+	due->nsec3[due->count] = nsec3;
+	due->count++;
+	return KNOT_EOK;
+}
+
+static void due_clear(due_t *due)
+{
+	for (size_t i = 0; i < due->count; i++) {
+		knot_dname_free(due->owners[i], NULL);
+	}
+	due->count = 0;
+}
+
+static void test_index(void)
+{
+	rrsig_index_t *index = rrsig_index_new();
+	ok(index != NULL, "index: create");
+
+	knot_dname_t *a = knot_dname_from_str_alloc("a.example.");
+	knot_dname_t *b = knot_dname_from_str_alloc("b.example.");
+	knot_dname_t *c = knot_dname_from_str_alloc("c.example.");
+
+	int ret = rrsig_index_set(index, a, false, 3000);
+	ret |= rrsig_index_set(index, b, false, 1000);
+	ret |= rrsig_index_set(index, c, true, 2000);
+	ok(ret == KNOT_EOK, "index: set");
+
+	due_t due = { 0 };
+	ret = rrsig_index_due(index, 2000, collect, &due);
+	ok(ret == KNOT_EOK && due.count == 2 &&
+	   knot_dname_is_equal(due.owners[0], b) && !due.nsec3[0] &&
+	   knot_dname_is_equal(due.owners[1], c) && due.nsec3[1],
+	   "index: due entries in order");
+	due_clear(&due);
+
+	ok(rrsig_index_next(index, 0) == 1000, "index: next from start");
+	ok(rrsig_index_next(index, 1000) == 2000, "index: next after");
+	ok(rrsig_index_next(index, 1500) == 2000, "index: next in between");
+	ok(rrsig_index_next(index, 3000) == 0, "index: no next");
+
+	ret = rrsig_index_set(index, b, false, 4000);
+	ok(ret == KNOT_EOK && rrsig_index_next(index, 0) == 2000 &&
+	   rrsig_index_next(index, 3000) == 4000, "index: move entry");
+
+	ret = rrsig_index_set(index, c, false, 500);
+	ok(ret == KNOT_EOK && rrsig_index_next(index, 0) == 500 &&
+	   rrsig_index_next(index, 500) == 2000, "index: tree flag distinguishes");
+
+	ret = rrsig_index_set(index, c, true, 0);
+	ret |= rrsig_index_set(index, c, false, 0);
+	ok(ret == KNOT_EOK && rrsig_index_next(index, 0) == 3000, "index: remove");
+
+	index->id = 42;
+	rrsig_index_clear(index);
+	ret = rrsig_index_due(index, UINT32_MAX, collect, &due);
+	ok(ret == KNOT_EOK && due.count == 0 && index->id == 0, "index: clear");
+
+	knot_dname_free(a, NULL);
+	knot_dname_free(b, NULL);
+	knot_dname_free(c, NULL);
+	rrsig_index_free(index);
+}
+
+static void add_rr(zone_node_t *node, uint16_t type, const uint8_t *data, uint16_t len)
+{
+	knot_rrset_t rrset;
+	knot_rrset_init(&rrset, node->owner, type, KNOT_CLASS_IN, 3600);
+	int ret = knot_rrset_add_rdata(&rrset, data, len, NULL);
+	assert(ret == KNOT_EOK);
+	ret = node_add_rrset(node, &rrset, NULL);
+	assert(ret == KNOT_EOK);
+	knot_rdataset_clear(&rrset.rrs, NULL);
+	(void)ret;
+}
+
+static void add_rrsig(zone_node_t *node, uint16_t covered, uint32_t expiration)
+{
+	uint8_t rrsig[18 + 1 + 4] = { 0 };
+	knot_wire_write_u16(rrsig, covered);
+	rrsig[2] = DNSSEC_KEY_ALGORITHM_ECDSA_P256_SHA256;
+	knot_wire_write_u32(rrsig + 8, expiration);
+	add_rr(node, KNOT_RRTYPE_RRSIG, rrsig, sizeof(rrsig));
+}
+
+static void test_node(void)
+{
+	knot_dname_t *owner = knot_dname_from_str_alloc("node.example.");
+	zone_node_t *node = node_new(owner, false, false, NULL);
+	assert(node);
+
+	ok(rrsig_index_node_expires(node) == 0, "node: nothing to sign");
+
+	const uint8_t a[] = { 192, 0, 2, 1 };
+	add_rr(node, KNOT_RRTYPE_A, a, sizeof(a));
+	ok(rrsig_index_node_expires(node) == 1, "node: missing signature");
+
+	add_rrsig(node, KNOT_RRTYPE_A, 5000);
+	ok(rrsig_index_node_expires(node) == 5000, "node: signature expiration");
+
+	const uint8_t txt[] = { 1, 'x' };
+	add_rr(node, KNOT_RRTYPE_TXT, txt, sizeof(txt));
+	add_rrsig(node, KNOT_RRTYPE_TXT, 4000);
+	ok(rrsig_index_node_expires(node) == 4000, "node: earliest expiration");
+
+	node->flags |= NODE_FLAGS_NONAUTH;
+	rrsig_index_t *index = rrsig_index_new();
+	int ret = rrsig_index_set(index, owner, false, 4000);
+	ret |= rrsig_index_node(index, node, false);
+	ok(ret == KNOT_EOK && rrsig_index_node_expires(node) == 4000 &&
+	   rrsig_index_next(index, 0) == 4000, "node: signatures of non-authoritative data");
+
+	node_free_rrsets(node, NULL);
+	ret = rrsig_index_node(index, node, false);
+	ok(ret == KNOT_EOK && rrsig_index_next(index, 0) == 0, "node: removed if empty");
+
+	rrsig_index_free(index);
+	node_free(node, NULL);
+	knot_dname_free(owner, NULL);
+}
+
+static void test_spread(void)
+{
+	knot_kasp_policy_t policy = {
+		.rrsig_lifetime = 14 * 86400,
+		.rrsig_refresh_before = 7 * 86400,
+		.rrsig_prerefresh = 3600,
+	};
+	kdnssec_ctx_t ctx = { .now = 1600000000, .policy = &policy };
+
+	knot_time_t min = ctx.now + policy.rrsig_refresh_before + policy.rrsig_prerefresh;
+	knot_time_t max = ctx.now + policy.rrsig_lifetime;
+	knot_time_t period = policy.rrsig_lifetime - policy.rrsig_refresh_before -
+	                     policy.rrsig_prerefresh;
+
+	bool in_range = true, stable = true;
+	size_t halves[2] = { 0 };
+	char name[32];
+	for (int i = 0; i < 1000; i++) {
+		(void)snprintf(name, sizeof(name), "n%d.example.", i);
+		knot_dname_t *owner = knot_dname_from_str_alloc(name);
+		knot_time_t exp = rrsig_index_spread(owner, &ctx);
+		in_range = in_range && exp > min && exp <= max;
+		halves[(exp - min - 1) * 2 / period]++;
+
+		// Re-signed when due, the phase is kept.
+		kdnssec_ctx_t later = ctx;
+		later.now = exp - policy.rrsig_refresh_before - policy.rrsig_prerefresh;
+		stable = stable && rrsig_index_spread(owner, &later) == exp + period;
+		knot_dname_free(owner, NULL);
+	}
+	ok(in_range, "spread: expiration within limits");
+	ok(halves[0] > 400 && halves[1] > 400, "spread: evenly distributed");
+	ok(stable, "spread: refreshed once per period");
+
+	policy.rrsig_refresh_before = policy.rrsig_lifetime;
+	knot_dname_t *owner = knot_dname_from_str_alloc("example.");
+	ok(rrsig_index_spread(owner, &ctx) == max, "spread: fallback to plain lifetime");
+	knot_dname_free(owner, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	test_index();
+	test_node();
+	test_spread();
+
+	return 0;
+}
@@ -0,0 +1,257 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tap/basic.h>
+#include <time.h>
+
+#include "knot/query/soa_probe.h"
+#include "contrib/net.h"
+#include "contrib/sockaddr.h"
+#include "libknot/libknot.h"
+
+#define ZONES		200
+#define SPECIAL		3    // drop, refused, keyed
+#define TIMEOUT		300
+
+/*!
+ * \brief Master answering the SOA queries of "zoneN." with serial N.
+ *
+ * Queries for "drop." aren't answered, "refused." gets REFUSED.
+ */
+typedef struct {
+	int fd;
+	volatile bool stop;
+	uint16_t ports[8];    // distinct source ports of the queries
+	size_t nports;
+} master_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	size_t done;
+	int ret[ZONES + SPECIAL];
+	uint32_t serial[ZONES + SPECIAL];
+} results_t;
+
+static knot_rrset_t *soa(const knot_dname_t *apex, uint32_t serial)
+{
+	uint8_t rdata[1 + 1 + 20] = { 0 }; // root mname and rname
+	knot_wire_write_u32(rdata + 2, serial);
+
+	knot_rrset_t *rr = knot_rrset_new(apex, KNOT_RRTYPE_SOA, KNOT_CLASS_IN, 3600, NULL);
+	(void)knot_rrset_add_rdata(rr, rdata, sizeof(rdata), NULL);
+	return rr;
+}
+
+static void answer(int fd, uint8_t *wire, size_t size, const struct sockaddr_storage *from)
+{
+	knot_pkt_t *query = knot_pkt_new(wire, size, NULL);
+	knot_pkt_t *resp = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	if (query == NULL || resp == NULL || knot_pkt_parse(query, 0) != KNOT_EOK ||
+	    knot_pkt_init_response(resp, query) != KNOT_EOK) {
+		goto cleanup;
+	}
+
+	char name[KNOT_DNAME_TXT_MAXLEN];
+	(void)knot_dname_to_str(name, knot_pkt_qname(query), sizeof(name));
+	if (strcmp(name, "drop.") == 0) {
+		goto cleanup;
+	} else if (strcmp(name, "refused.") == 0) {
+		knot_wire_set_rcode(resp->wire, KNOT_RCODE_REFUSED);
+	} else {
+		uint32_t serial = strncmp(name, "zone", 4) == 0 ? atoi(name + 4) : 0;
+		knot_rrset_t *rr = soa(knot_pkt_qname(query), serial);
+		knot_pkt_begin(resp, KNOT_ANSWER);
+		(void)knot_pkt_put(resp, KNOT_COMPR_HINT_NONE, rr, 0);
+		knot_rrset_free(rr, NULL);
+	}
+
+	(void)sendto(fd, resp->wire, resp->size, 0, (const struct sockaddr *)from,
+	             sockaddr_len(from));
+cleanup:
+	knot_pkt_free(query);
+	knot_pkt_free(resp);
+}
+
+static void add_port(master_t *master, const struct sockaddr_storage *from)
+{
+	uint16_t port = sockaddr_port(from);
+	for (size_t i = 0; i < master->nports; i++) {
+		if (master->ports[i] == port) {
+			return;
+		}
+	}
+	if (master->nports < sizeof(master->ports) / sizeof(master->ports[0])) {
+		master->ports[master->nports++] = port;
+	}
+}
+
+static void *master_thread(void *arg)
+{
+	master_t *master = arg;
+	uint8_t wire[KNOT_WIRE_MAX_PKTSIZE];
+
+	while (!master->stop) {
+		struct pollfd pfd = { .fd = master->fd, .events = POLLIN };
+		if (poll(&pfd, 1, 20) <= 0) {
+			continue;
+		}
+		struct sockaddr_storage from;
+		socklen_t from_len = sizeof(from);
+		ssize_t size = recvfrom(master->fd, wire, sizeof(wire), 0,
+		                        (struct sockaddr *)&from, &from_len);
+		if (size > 0) {
+			add_port(master, &from);
+			answer(master->fd, wire, size, &from);
+		}
+	}
+
+	return NULL;
+}
+
+static size_t zone_index(const knot_dname_t *zone)
+{
+	char name[KNOT_DNAME_TXT_MAXLEN];
+	(void)knot_dname_to_str(name, zone, sizeof(name));
+	if (strcmp(name, "drop.") == 0) {
+		return ZONES;
+	} else if (strcmp(name, "refused.") == 0) {
+		return ZONES + 1;
+	} else if (strcmp(name, "keyed.") == 0) {
+		return ZONES + 2;
+	}
+	return atoi(name + 4);
+}
+
+static void probe_done(const knot_dname_t *zone, const soa_probe_result_t *result,
+                       void *ctx)
+{
+	results_t *results = ctx;
+	size_t idx = zone_index(zone);
+
+	pthread_mutex_lock(&results->lock);
+	results->ret[idx] = result->ret;
+	results->serial[idx] = result->serial;
+	results->done++;
+	pthread_cond_signal(&results->cond);
+	pthread_mutex_unlock(&results->lock);
+}
+
+static bool wait_done(results_t *results, size_t count)
+{
+	struct timespec until;
+	clock_gettime(CLOCK_REALTIME, &until);
+	until.tv_sec += 10;
+
+	pthread_mutex_lock(&results->lock);
+	while (results->done < count) {
+		if (pthread_cond_timedwait(&results->cond, &results->lock, &until) != 0) {
+			break;
+		}
+	}
+	bool done = (results->done == count);
+	pthread_mutex_unlock(&results->lock);
+
+	return done;
+}
+
+static int submit(soa_probe_t *probe, const char *name, const conf_remote_t *remote,
+                  const struct query_edns_data *edns)
+{
+	knot_dname_t *zone = knot_dname_from_str_alloc(name);
+	int ret = soa_probe_submit(probe, zone, remote, edns);
+	knot_dname_free(zone, NULL);
+	return ret;
+}
+
+static void test_probe(conf_remote_t *remote)
+{
+	results_t results = { .done = 0 };
+	pthread_mutex_init(&results.lock, NULL);
+	pthread_cond_init(&results.cond, NULL);
+
+	soa_probe_t *probe = NULL;
+	int ret = soa_probe_new(probe_done, &results, &probe);
+	is_int(KNOT_EOK, ret, "probe: start");
+	soa_probe_set(probe, 20, TIMEOUT);
+
+	struct query_edns_data edns = { .max_payload = 1232 };
+	for (size_t i = 0; i < ZONES && ret == KNOT_EOK; i++) {
+		char name[32];
+		(void)snprintf(name, sizeof(name), "zone%zu.", i);
+		ret = submit(probe, name, remote, (i % 2 == 0) ? &edns : NULL);
+	}
+	is_int(KNOT_EOK, ret, "probe: submit");
+
+	ok(wait_done(&results, ZONES), "probe: all results");
+	bool all_ok = true;
+	for (size_t i = 0; i < ZONES; i++) {
+		all_ok &= (results.ret[i] == KNOT_EOK && results.serial[i] == i);
+	}
+	ok(all_ok, "probe: serials matched");
+
+	uint64_t queries, batches;
+	soa_probe_stats(probe, &queries, &batches);
+	ok(queries == ZONES && batches < ZONES / 10,
+	   "probe: queries sent in batches (%"PRIu64")", batches);
+
+	conf_remote_t keyed = *remote;
+	ret = knot_tsig_key_init_str(&keyed.key, "hmac-sha256:key.:Zm9vYmFyYmF6");
+	is_int(KNOT_EOK, ret, "probe: TSIG key");
+	ret = submit(probe, "drop.", remote, NULL);
+	ret += submit(probe, "refused.", remote, NULL);
+	ret += submit(probe, "keyed.", &keyed, NULL);
+	knot_tsig_key_deinit(&keyed.key);
+	ok(ret == KNOT_EOK && wait_done(&results, ZONES + SPECIAL), "probe: failing probes");
+	is_int(KNOT_ETIMEOUT, results.ret[ZONES], "probe: timeout");
+	is_int(KNOT_EDENIED, results.ret[ZONES + 1], "probe: refused");
+	is_int(KNOT_EMALF, results.ret[ZONES + 2], "probe: unsigned response");
+
+	soa_probe_free(probe);
+	pthread_cond_destroy(&results.cond);
+	pthread_mutex_destroy(&results.lock);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	conf_remote_t remote = { { 0 } };
+	sockaddr_set(&remote.addr, AF_INET, "127.0.0.1", 0);
+	master_t master = { .fd = net_bound_socket(SOCK_DGRAM, &remote.addr, 0) };
+	socklen_t addr_len = sizeof(remote.addr);
+	int ret = getsockname(master.fd, (struct sockaddr *)&remote.addr, &addr_len);
+	ok(master.fd >= 0 && ret == 0, "master: bound");
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, master_thread, &master);
+
+	test_probe(&remote);
+
+	master.stop = true;
+	pthread_join(thread, NULL);
+	close(master.fd);
+
+	ok(master.nports > 1, "probe: source port changed between batches");
+
+	return 0;
+}
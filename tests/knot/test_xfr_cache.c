@@ -0,0 +1,205 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <tap/basic.h>
+
+#include "knot/nameserver/xfr_cache.h"
+#include "libknot/libknot.h"
+
+static knot_pkt_t *msg_new(const knot_dname_t *qname, const char *owner)
+{
+	knot_pkt_t *pkt = knot_pkt_new(NULL, KNOT_WIRE_MAX_PKTSIZE, NULL);
+	if (pkt == NULL ||
+	    knot_pkt_put_question(pkt, qname, KNOT_CLASS_IN, KNOT_RRTYPE_IXFR) != KNOT_EOK) {
+		knot_pkt_free(pkt);
+		return NULL;
+	}
+
+	if (owner != NULL) {
+		knot_dname_t *name = knot_dname_from_str_alloc(owner);
+		knot_rrset_t *rr = knot_rrset_new(name, KNOT_RRTYPE_A, KNOT_CLASS_IN, 3600, NULL);
+		uint8_t addr[4] = { 192, 0, 2, 1 };
+		(void)knot_rrset_add_rdata(rr, addr, sizeof(addr), NULL);
+		(void)knot_pkt_put(pkt, 0, rr, 0);
+		knot_rrset_free(rr, NULL);
+		knot_dname_free(name, NULL);
+	}
+
+	return pkt;
+}
+
+static void test_entry(const knot_dname_t *zone)
+{
+	xfr_cache_entry_t *entry = xfr_cache_entry_new(1, 2);
+	ok(entry != NULL && entry->refs == 1, "entry: create");
+	xfr_cache_entry_ref(entry);
+	ok(entry->refs == 2, "entry: reference");
+	xfr_cache_entry_unref(entry);
+
+	knot_pkt_t *m1 = msg_new(zone, "a.example.");
+	knot_pkt_t *m2 = msg_new(zone, "b.example.");
+	int ret = xfr_cache_entry_add(entry, m1);
+	ret |= xfr_cache_entry_add(entry, m2);
+	ok(ret == KNOT_EOK && entry->count == 2 &&
+	   entry->qname_size == knot_dname_size(zone), "entry: add messages");
+
+	/* Write with a differently cased question of the same size. */
+	knot_dname_t *upper = knot_dname_from_str_alloc("EXAMPLE.");
+	knot_pkt_t *answer = msg_new(upper, NULL);
+	knot_wire_set_id(answer->wire, knot_wire_get_id(m2->wire));
+	ret = xfr_cache_entry_write(entry, 1, answer);
+	ok(ret == KNOT_EOK && answer->size == m2->size &&
+	   knot_wire_get_ancount(answer->wire) == 1 &&
+	   memcmp(answer->wire + KNOT_WIRE_HEADER_SIZE + answer->qname_size,
+	          m2->wire + KNOT_WIRE_HEADER_SIZE + m2->qname_size,
+	          m2->size - KNOT_WIRE_HEADER_SIZE - m2->qname_size) == 0,
+	   "entry: write message");
+
+	ret = xfr_cache_entry_write(entry, 0, answer);
+	ok(ret == KNOT_EINVAL, "entry: write into non-empty answer");
+	ret = xfr_cache_entry_write(entry, 2, answer);
+	ok(ret == KNOT_EINVAL, "entry: write out of range");
+
+	knot_pkt_clear(answer);
+	(void)knot_pkt_put_question(answer, upper, KNOT_CLASS_IN, KNOT_RRTYPE_IXFR);
+	answer->max_size = answer->size + entry->msgs[0].size - 1;
+	ret = xfr_cache_entry_write(entry, 0, answer);
+	ok(ret == KNOT_ESPACE, "entry: write into small answer");
+
+	knot_pkt_free(answer);
+	knot_dname_free(upper, NULL);
+	knot_pkt_free(m1);
+	knot_pkt_free(m2);
+	xfr_cache_entry_unref(entry);
+}
+
+static void test_cache(const knot_dname_t *zone)
+{
+	xfr_cache_t *cache = xfr_cache_new();
+	ok(cache != NULL, "cache: create");
+
+	ok(xfr_cache_get(cache, 1, 2) == NULL, "cache: miss");
+
+	knot_pkt_t *msg = msg_new(zone, "a.example.");
+	uint64_t epoch = xfr_cache_epoch(cache);
+	xfr_cache_entry_t *entry = xfr_cache_entry_new(1, 2);
+	(void)xfr_cache_entry_add(entry, msg);
+	int ret = xfr_cache_insert(cache, entry, epoch);
+	ok(ret == KNOT_EOK && entry->refs == 2, "cache: insert");
+
+	xfr_cache_entry_t *found = xfr_cache_get(cache, 1, 2);
+	ok(found == entry && entry->refs == 3, "cache: hit");
+	xfr_cache_entry_unref(found);
+	ok(xfr_cache_get(cache, 1, 3) == NULL, "cache: other range miss");
+
+	/* Clearing keeps the entries in use alive. */
+	xfr_cache_clear(cache);
+	ok(xfr_cache_get(cache, 1, 2) == NULL && entry->refs == 1 && cache->bytes == 0,
+	   "cache: clear");
+
+	xfr_cache_entry_t *stale = xfr_cache_entry_new(1, 2);
+	(void)xfr_cache_entry_add(stale, msg);
+	ret = xfr_cache_insert(cache, stale, epoch);
+	ok(ret == KNOT_EAGAIN && xfr_cache_get(cache, 1, 2) == NULL,
+	   "cache: reject entry rendered before clear");
+	xfr_cache_entry_unref(stale);
+	xfr_cache_entry_unref(entry);
+
+	/* The least recently used entry is evicted. */
+	epoch = xfr_cache_epoch(cache);
+	for (uint32_t i = 0; i <= XFR_CACHE_ENTRIES; i++) {
+		if (i == XFR_CACHE_ENTRIES) {
+			xfr_cache_entry_unref(xfr_cache_get(cache, 0, 1));
+		}
+		entry = xfr_cache_entry_new(i, i + 1);
+		(void)xfr_cache_entry_add(entry, msg);
+		(void)xfr_cache_insert(cache, entry, epoch);
+		xfr_cache_entry_unref(entry);
+	}
+	found = xfr_cache_get(cache, 1, 2);
+	ok(found == NULL, "cache: evict least recently used");
+	found = xfr_cache_get(cache, 0, 1);
+	ok(found != NULL, "cache: keep recently used");
+	xfr_cache_entry_unref(found);
+
+	knot_pkt_free(msg);
+	xfr_cache_free(cache);
+}
+
+typedef struct {
+	knot_pkt_t *msg;
+	int ret;
+	unsigned calls;
+} render_ctx_t;
+
+static int render(xfr_cache_entry_t *entry, void *ctx)
+{
+	render_ctx_t *render = ctx;
+	render->calls++;
+	if (render->ret != KNOT_EOK) {
+		return render->ret;
+	}
+	return xfr_cache_entry_add(entry, render->msg);
+}
+
+static void test_render(const knot_dname_t *zone)
+{
+	xfr_cache_t *cache = xfr_cache_new();
+	render_ctx_t ctx = { .msg = msg_new(zone, "a.example.") };
+
+	xfr_cache_entry_t *rendered = NULL;
+	bool failed = false;
+	xfr_cache_entry_t *entry = xfr_cache_render_once(cache, &rendered, &failed, 1,
+	                                                 render, &ctx);
+	ok(entry != NULL && entry == rendered && entry->count == 1 &&
+	   entry->refs == 2 && ctx.calls == 1 && !failed, "render: first transfer");
+	xfr_cache_entry_unref(entry);
+
+	entry = xfr_cache_render_once(cache, &rendered, &failed, 1, render, &ctx);
+	ok(entry == rendered && entry->refs == 2 && ctx.calls == 1,
+	   "render: second transfer reuses the wire");
+	xfr_cache_entry_unref(entry);
+	xfr_cache_entry_unref(rendered);
+
+	/* Another version whose rendering fails. */
+	ctx.ret = KNOT_ESPACE;
+	ctx.calls = 0;
+	rendered = NULL;
+	entry = xfr_cache_render_once(cache, &rendered, &failed, 2, render, &ctx);
+	ok(entry == NULL && rendered == NULL && failed && ctx.calls == 1,
+	   "render: failure");
+	entry = xfr_cache_render_once(cache, &rendered, &failed, 2, render, &ctx);
+	ok(entry == NULL && ctx.calls == 1, "render: failure not retried");
+
+	knot_pkt_free(ctx.msg);
+	xfr_cache_free(cache);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	knot_dname_t *zone = knot_dname_from_str_alloc("example.");
+
+	test_entry(zone);
+	test_cache(zone);
+	test_render(zone);
+
+	knot_dname_free(zone, NULL);
+
+	return 0;
+}
@@ -76,6 +76,115 @@ static int ztree_node_counter(zone_node_t *node, void *data)
 	return KNOT_EOK;
 }
 
+static zone_node_t *ztree_new_node(const knot_dname_t *dname, void *ctx)
+{
+	return node_new_for_tree(dname, ctx, NULL);
+}
+
+static int ztree_node_free(zone_node_t *node, void *data)
+{
+	(void)data;
+	node_free(node, NULL);
+	return KNOT_EOK;
+}
+
+static zone_tree_t *ztree_load(const char **names, size_t count, bool bulk)
+{
+	zone_tree_t *t = zone_tree_create(false);
+	knot_dname_t *apex_name = knot_dname_from_str_alloc("example.");
+	zone_node_t *apex = node_new(apex_name, false, false, NULL);
+	apex->flags |= NODE_FLAGS_APEX;
+	knot_dname_free(apex_name, NULL);
+	zone_tree_insert(t, &apex);
+
+	if (bulk && zone_tree_bulk_begin(t) != KNOT_EOK) {
+		return t;
+	}
+	for (size_t i = 0; i < count; i++) {
+		knot_dname_t *name = knot_dname_from_str_alloc(names[i]);
+		zone_node_t *node = NULL;
+		int ret = zone_tree_add_node(t, apex, name, ztree_new_node, t, &node);
+		knot_dname_free(name, NULL);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+		node->rrset_count = 1;
+	}
+	if (bulk) {
+		zone_tree_bulk_end(t);
+	}
+
+	return t;
+}
+
+static bool ztree_equal(zone_tree_t *t1, zone_tree_t *t2)
+{
+	if (zone_tree_count(t1) != zone_tree_count(t2)) {
+		return false;
+	}
+
+	zone_tree_it_t it1 = { 0 }, it2 = { 0 };
+	zone_tree_it_begin(t1, &it1);
+	zone_tree_it_begin(t2, &it2);
+	bool equal = true;
+	while (!zone_tree_it_finished(&it1) && !zone_tree_it_finished(&it2)) {
+		zone_node_t *n1 = zone_tree_it_val(&it1), *n2 = zone_tree_it_val(&it2);
+		if (!knot_dname_is_equal(n1->owner, n2->owner) ||
+		    n1->children != n2->children || n1->flags != n2->flags ||
+		    n1->rrset_count != n2->rrset_count ||
+		    (n1->parent == NULL) != (n2->parent == NULL) ||
+		    (n1->parent != NULL && !knot_dname_is_equal(n1->parent->owner, n2->parent->owner)) ||
+		    zone_tree_get(t1, n1->owner) != n1) {
+			equal = false;
+			break;
+		}
+		zone_tree_it_next(&it1);
+		zone_tree_it_next(&it2);
+	}
+	equal = equal && zone_tree_it_finished(&it1) && zone_tree_it_finished(&it2);
+	zone_tree_it_free(&it1);
+	zone_tree_it_free(&it2);
+
+	return equal;
+}
+
+static void ztree_free_nodes(zone_tree_t **t)
+{
+	zone_tree_apply(*t, ztree_node_free, NULL);
+	zone_tree_free(t);
+}
+
+static void test_bulk(void)
+{
+	const char *sorted[] = {
+		"example.", "a.example.", "x.b.a.example.", "*.c.example.",
+		"a.*.c.example.", "d.example.", "e.d.example.", "z.z.z.example.",
+	};
+	const char *unsorted[] = {
+		"a.example.", "x.b.a.example.", "z.example.", "c.example.",
+		"y.b.a.example.", "b.example.",
+	};
+
+	zone_tree_t *exp = ztree_load(sorted, sizeof(sorted) / sizeof(*sorted), false);
+	zone_tree_t *t = ztree_load(sorted, sizeof(sorted) / sizeof(*sorted), true);
+	ok(t->bulk == NULL && ztree_equal(t, exp), "ztree: bulk load sorted");
+	ztree_free_nodes(&t);
+	ztree_free_nodes(&exp);
+
+	exp = ztree_load(unsorted, sizeof(unsorted) / sizeof(*unsorted), false);
+	t = ztree_load(unsorted, sizeof(unsorted) / sizeof(*unsorted), true);
+	ok(t->bulk == NULL && ztree_equal(t, exp), "ztree: bulk load unsorted");
+	ztree_free_nodes(&t);
+	ztree_free_nodes(&exp);
+
+	/* Lookup in the middle of the bulk loading. */
+	t = ztree_load(sorted, 3, true);
+	ok(zone_tree_bulk_begin(t) == KNOT_EOK && zone_tree_count(t) == 4 &&
+	   zone_tree_get(t, (const knot_dname_t *)"\x01""a""\x07""example") != NULL &&
+	   t->bulk == NULL, "ztree: bulk load interrupted");
+	ztree_free_nodes(&t);
+}
+
 int main(int argc, char *argv[])
 {
 	plan_lazy();
@@ -131,5 +240,9 @@ int main(int argc, char *argv[])
 
 	zone_tree_free(&t);
 	ztree_free_data();
+
+	/* 7. bulk loading */
+	test_bulk();
+
 	return 0;
 }
@@ -0,0 +1,150 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <tap/basic.h>
+
+#include "test_conf.h"
+#include "knot/common/evsched.h"
+#include "knot/events/handlers.h"
+#include "knot/server/server.h"
+#include "knot/worker/pool.h"
+#include "knot/zone/cold.h"
+#include "knot/zone/zone.h"
+#include "libknot/libknot.h"
+
+#define CONTENTS_SIZE 1000
+
+static bool load_planned(zone_t *zone)
+{
+	bool planned = zone_events_get_time(zone, ZONE_EVENT_LOAD) > 0;
+	zone_events_schedule_at(zone, ZONE_EVENT_LOAD, (time_t)0);
+	return planned;
+}
+
+static zone_t *cold_zone(const char *name, server_t *server, worker_pool_t *pool,
+                         evsched_t *sched)
+{
+	knot_dname_t *dname = knot_dname_from_str_alloc(name);
+	zone_t *zone = zone_new(dname);
+	knot_dname_free(dname, NULL);
+	if (zone == NULL || zone_events_setup(zone, pool, sched) != KNOT_EOK) {
+		return NULL;
+	}
+	zone->server = server;
+	zone->cold.enabled = true;
+	zone_cold_mark_evicted(zone);
+	return zone;
+}
+
+static void load(zone_t *zone)
+{
+	zone_contents_t *contents = zone_contents_new(zone->name, false);
+	contents->size = CONTENTS_SIZE;
+	(void)zone_switch_contents(zone, contents);
+}
+
+static void test_load(zone_t *zone)
+{
+	cold_zones_t *cold = &zone->server->cold_zones;
+
+	zone_cold_touch(zone);
+	ok(load_planned(zone), "load: planned by query");
+	zone_cold_touch(zone);
+	ok(!load_planned(zone), "load: planned only once");
+
+	ok(!zone_cold_load_needed(zone, ZONE_EVENT_LOAD) &&
+	   zone_cold_load_needed(zone, ZONE_EVENT_REFRESH), "load: needed by events");
+
+	// Failed load.
+	zone_cold_update(conf(), zone, true);
+	ok(zone->cold.evicted && cold->count == 0, "load: still evicted after failure");
+	zone_cold_touch(zone);
+	ok(load_planned(zone), "load: planned again after failure");
+
+	load(zone);
+	zone_cold_update(conf(), zone, true);
+	ok(!zone->cold.evicted && cold->count == 1 && cold->size == CONTENTS_SIZE,
+	   "load: accounted");
+	zone_cold_touch(zone);
+	ok(!load_planned(zone) && zone->cold.referenced, "load: loaded zone referenced");
+}
+
+static void test_evict(zone_t *zone1, zone_t *zone2)
+{
+	cold_zones_t *cold = &zone1->server->cold_zones;
+
+	load(zone2);
+	zone_cold_update(conf(), zone2, true);
+	ok(zone_events_get_time(zone1, ZONE_EVENT_EVICT) > 0 &&
+	   zone_events_get_time(zone2, ZONE_EVENT_EVICT) <= 0, "evict: LRU zone planned");
+	ok(cold->count == 1 && cold->size == CONTENTS_SIZE, "evict: unaccounted");
+
+	int ret = event_evict(conf(), zone1);
+	ok(ret == KNOT_EOK && zone1->contents == NULL && zone1->cold.evicted,
+	   "evict: contents dropped");
+	zone_cold_touch(zone1);
+	ok(load_planned(zone1), "evict: load planned by query");
+
+	ok(zone_cold_load_needed(zone1, ZONE_EVENT_EXPIRE) == false &&
+	   !zone1->cold.evicted, "evict: not loaded on expire");
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	const char *conf_str =
+		"server:\n"
+		"  cold-zones-max-size: 1500\n"
+		"template:\n"
+		"  - id: default\n"
+		"    cold-load: on\n"
+		"    journal-content: all\n"
+		"    zonefile-load: none\n"
+		"zone:\n"
+		"  - domain: one.\n"
+		"  - domain: two.\n";
+	int ret = test_conf(conf_str, NULL);
+	ok(ret == KNOT_EOK, "prepare configuration");
+
+	evsched_t sched = { 0 };
+	ret = evsched_init(&sched, NULL);
+	worker_pool_t *pool = worker_pool_create(1);
+	ok(ret == KNOT_EOK && pool != NULL, "prepare events");
+
+	server_t server = { 0 };
+	cold_zones_init(&server.cold_zones);
+
+	zone_t *zone1 = cold_zone("one.", &server, pool, &sched);
+	zone_t *zone2 = cold_zone("two.", &server, pool, &sched);
+	ok(zone1 != NULL && zone2 != NULL, "create zones");
+
+	test_load(zone1);
+	test_evict(zone1, zone2);
+
+	zone_cold_forget(zone1);
+	zone_cold_forget(zone2);
+	zone1->server = NULL;
+	zone2->server = NULL;
+	zone_free(&zone1);
+	zone_free(&zone2);
+	cold_zones_deinit(&server.cold_zones);
+	worker_pool_destroy(pool);
+	evsched_deinit(&sched);
+	test_conf_free();
+
+	return 0;
+}
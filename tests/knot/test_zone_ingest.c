@@ -0,0 +1,118 @@
+/*  Copyright (C) 2021 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <tap/basic.h>
+
+#include "knot/zone/ingest.h"
+#include "libknot/libknot.h"
+
+#define RECORDS		20000
+#define BATCH		100
+
+static knot_dname_t *apex;
+
+static int add_record(zone_ingest_t *ingest, size_t i, uint16_t rdata_count)
+{
+	char name[64];
+	(void)snprintf(name, sizeof(name), "host%zu.example.", i);
+	knot_dname_storage_t owner;
+	if (knot_dname_from_str(owner, name, sizeof(owner)) == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	knot_rrset_t rr;
+	knot_rrset_init(&rr, owner, KNOT_RRTYPE_A, KNOT_CLASS_IN, 3600);
+	for (uint16_t j = 0; j < rdata_count; j++) {
+		uint8_t a[4] = { 192, 0, (i >> 8) & 0xff, (i + j) & 0xff };
+		(void)knot_rrset_add_rdata(&rr, a, sizeof(a), NULL);
+	}
+
+	int ret = zone_ingest_add(ingest, &rr);
+	knot_rdataset_clear(&rr.rrs, NULL);
+	return ret;
+}
+
+static void test_insert(void)
+{
+	zone_contents_t *contents = zone_contents_new(apex, true);
+	zone_ingest_t *ingest = NULL;
+	int ret = zone_ingest_start(contents, &ingest);
+	is_int(KNOT_EOK, ret, "ingest: start");
+
+	for (size_t i = 0; i < RECORDS && ret == KNOT_EOK; i++) {
+		ret = add_record(ingest, i, 1);
+		if (ret == KNOT_EOK && i % BATCH == BATCH - 1) {
+			ret = zone_ingest_flush(ingest);
+		}
+	}
+	is_int(KNOT_EOK, ret, "ingest: add records");
+
+	ret = zone_ingest_finish(ingest);
+	is_int(KNOT_EOK, ret, "ingest: finish");
+
+	ok(zone_tree_count(contents->nodes) == RECORDS + 1, "ingest: all records inserted");
+
+	knot_dname_t *last = knot_dname_from_str_alloc("host19999.example.");
+	const zone_node_t *node = zone_contents_find_node(contents, last);
+	ok(node != NULL && node_rrtype_exists(node, KNOT_RRTYPE_A), "ingest: last record found");
+	knot_dname_free(last, NULL);
+
+	zone_contents_deep_free(contents);
+}
+
+static void test_error(void)
+{
+	zone_contents_t *contents = zone_contents_new(apex, true);
+	zone_ingest_t *ingest = NULL;
+	int ret = zone_ingest_start(contents, &ingest);
+
+	// Records must come one by one, as in a DNS message.
+	for (size_t i = 0; i < 10 && ret == KNOT_EOK; i++) {
+		ret = add_record(ingest, i, (i == 5) ? 2 : 1);
+	}
+	(void)zone_ingest_flush(ingest);
+	ret = zone_ingest_finish(ingest);
+	is_int(KNOT_EINVAL, ret, "ingest: insertion error reported");
+	zone_contents_deep_free(contents);
+
+	contents = zone_contents_new(apex, true);
+	ret = zone_ingest_start(contents, &ingest);
+	for (size_t i = 0; i < 10 * BATCH && ret == KNOT_EOK; i++) {
+		ret = add_record(ingest, i, 1);
+		if (ret == KNOT_EOK && i % BATCH == BATCH - 1) {
+			ret = zone_ingest_flush(ingest);
+		}
+	}
+	zone_ingest_abort(ingest);
+	ok(ret == KNOT_EOK && zone_tree_count(contents->nodes) <= 10 * BATCH + 1,
+	   "ingest: abort");
+	zone_contents_deep_free(contents);
+}
+
+int main(int argc, char *argv[])
+{
+	plan_lazy();
+
+	apex = knot_dname_from_str_alloc("example.");
+
+	test_insert();
+	test_error();
+
+	knot_dname_free(apex, NULL);
+
+	return 0;
+}
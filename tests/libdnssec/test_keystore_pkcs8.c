@@ -14,6 +14,8 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
+#include <unistd.h>
 #include <tap/basic.h>
 #include <tap/files.h>
 
@@ -21,6 +23,59 @@
 #include "key.h"
 #include "keystore.h"
 
+typedef struct {
+	dnssec_keystore_t *store;
+	dnssec_keystore_session_t *session;
+	uint64_t wait_ns;
+} waiter_t;
+
+static void *session_waiter(void *arg)
+{
+	waiter_t *w = arg;
+	dnssec_keystore_session_get(w->store, &w->session, &w->wait_ns);
+	return NULL;
+}
+
+static void check_sessions(dnssec_keystore_t *store, const char *id,
+                           const dnssec_key_t *key)
+{
+	dnssec_keystore_session_t *s1 = NULL, *s2 = NULL;
+	int r = dnssec_keystore_session_get(store, &s1, NULL);
+	ok(r == DNSSEC_EINVAL, "session: pool disabled");
+
+	r = dnssec_keystore_set_sessions(store, 2);
+	ok(r == DNSSEC_EOK, "session: set pool size");
+
+	uint64_t wait_ns = 1;
+	r = dnssec_keystore_session_get(store, &s1, &wait_ns);
+	ok(r == DNSSEC_EOK && s1 != NULL && wait_ns == 0, "session: get first");
+	r = dnssec_keystore_session_get(store, &s2, NULL);
+	ok(r == DNSSEC_EOK && s2 != NULL && s2 != s1, "session: get second");
+
+	const dnssec_key_t *k1 = NULL, *k2 = NULL, *k1_again = NULL;
+	r = dnssec_keystore_session_key(store, s1, id, key, &k1);
+	ok(r == DNSSEC_EOK && dnssec_key_can_sign(k1), "session: private key");
+	r = dnssec_keystore_session_key(store, s2, id, key, &k2);
+	ok(r == DNSSEC_EOK && k2 != k1, "session: own private key");
+	r = dnssec_keystore_session_key(store, s1, id, key, &k1_again);
+	ok(r == DNSSEC_EOK && k1_again == k1, "session: cached private key");
+	r = dnssec_keystore_session_key(store, s1, "0000", key, &k1_again);
+	ok(r != DNSSEC_EOK, "session: unknown key");
+
+	// third one waits for a returned session
+	waiter_t waiter = { .store = store };
+	pthread_t thread;
+	pthread_create(&thread, NULL, session_waiter, &waiter);
+	usleep(50000);
+	ok(waiter.session == NULL, "session: pool exhausted");
+	dnssec_keystore_session_put(store, s1);
+	pthread_join(thread, NULL);
+	ok(waiter.session == s1 && waiter.wait_ns > 0, "session: waited for a session");
+
+	dnssec_keystore_session_put(store, waiter.session);
+	dnssec_keystore_session_put(store, s2);
+}
+
 int main(void)
 {
 	plan_lazy();
@@ -69,6 +124,14 @@ int main(void)
 	ok(r == DNSSEC_EOK, "read B");
 	dnssec_key_free(key);
 
+	// session pool
+
+	dnssec_key_new(&key);
+	dnssec_key_set_algorithm(key, DNSSEC_KEY_ALGORITHM_RSA_SHA256);
+	dnssec_keystore_get_private(store, id_B, key);
+	check_sessions(store, id_B, key);
+	dnssec_key_free(key);
+
 	// content removal
 
 	r = dnssec_keystore_remove(store, id_A);
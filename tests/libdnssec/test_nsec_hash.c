@@ -14,6 +14,7 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
 #include <string.h>
 #include <tap/basic.h>
 
@@ -84,6 +85,83 @@ static void test_hashing(void)
 	dnssec_binary_free(&hash);
 }
 
+static void test_hashing_batch(void)
+{
+	// Various lengths around the block boundaries, the longest one doesn't fit a lane.
+	const size_t sizes[] = { 1, 13, 40, 41, 55, 56, 63, 64, 100, 119, 120, 255, 300, 600 };
+	const size_t count = sizeof(sizes) / sizeof(*sizes);
+
+	dnssec_binary_t data[count];
+	uint8_t buf[count][600];
+	for (size_t i = 0; i < count; i++) {
+		for (size_t j = 0; j < sizes[i]; j++) {
+			buf[i][j] = i * 7 + j;
+		}
+		data[i].data = buf[i];
+		data[i].size = sizes[i];
+	}
+
+	uint8_t salt[255];
+	memset(salt, 0xab, sizeof(salt));
+	const size_t salt_sizes[] = { 0, 14, 44, 255 };
+	const uint16_t iterations[] = { 0, 1, 10 };
+
+	uint8_t hashes[count * 20];
+	bool valid = true;
+	for (size_t s = 0; s < sizeof(salt_sizes) / sizeof(*salt_sizes); s++) {
+		for (size_t it = 0; it < sizeof(iterations) / sizeof(*iterations); it++) {
+			const dnssec_nsec3_params_t params = {
+				.algorithm = DNSSEC_NSEC3_ALGORITHM_SHA1,
+				.iterations = iterations[it],
+				.salt = { .size = salt_sizes[s], .data = salt }
+			};
+
+			memset(hashes, 0, sizeof(hashes));
+			int result = dnssec_nsec3_hash_batch(data, count, &params, hashes);
+			valid = valid && result == DNSSEC_EOK;
+
+			for (size_t i = 0; i < count; i++) {
+				dnssec_binary_t hash = { 0 };
+				result = dnssec_nsec3_hash(&data[i], &params, &hash);
+				valid = valid && result == DNSSEC_EOK && hash.size == 20 &&
+				        memcmp(hash.data, hashes + i * 20, 20) == 0;
+				dnssec_binary_free(&hash);
+			}
+		}
+	}
+	ok(valid, "dnssec_nsec3_hash_batch() matches dnssec_nsec3_hash()");
+
+	const dnssec_nsec3_params_t params = {
+		.algorithm = DNSSEC_NSEC3_ALGORITHM_SHA1,
+		.iterations = 7,
+		.salt = { .size = 14, .data = (uint8_t *) "happywithnsec3" }
+	};
+	const dnssec_binary_t dname = {
+		.size = 13,
+		.data = (uint8_t *) "\x08""knot-dns""\x02""cz"
+	};
+	const uint8_t expected[] = {
+		0x72, 0x40, 0x55, 0x83, 0x92, 0x93, 0x95, 0x28, 0xee, 0xa2,
+		0xcc, 0xe1, 0x13, 0xbe, 0xcd, 0x41, 0xee, 0x8a, 0x71, 0xfd
+	};
+	dnssec_binary_t same[] = { dname, dname, dname };
+	uint8_t same_hashes[3 * 20];
+	int result = dnssec_nsec3_hash_batch(same, 3, &params, same_hashes);
+	ok(result == DNSSEC_EOK &&
+	   memcmp(same_hashes, expected, 20) == 0 &&
+	   memcmp(same_hashes + 20, expected, 20) == 0 &&
+	   memcmp(same_hashes + 40, expected, 20) == 0,
+	   "dnssec_nsec3_hash_batch() valid hashes");
+
+	ok(dnssec_nsec3_hash_batch(NULL, 0, &params, NULL) == DNSSEC_EOK,
+	   "dnssec_nsec3_hash_batch() empty batch");
+
+	dnssec_nsec3_params_t unknown = params;
+	unknown.algorithm = 2;
+	ok(dnssec_nsec3_hash_batch(same, 3, &unknown, same_hashes) == DNSSEC_INVALID_NSEC3_ALGORITHM,
+	   "dnssec_nsec3_hash_batch() unknown algorithm");
+}
+
 static void test_clear(void)
 {
 	const dnssec_nsec3_params_t empty = { 0 };
@@ -108,6 +186,7 @@ int main(void)
 	test_length();
 	test_parsing();
 	test_hashing();
+	test_hashing_batch();
 	test_clear();
 
 	return 0;
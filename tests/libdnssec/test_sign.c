@@ -91,6 +91,43 @@ static dnssec_binary_t binary_set_string(char *str)
 	return result;
 }
 
+static void check_batch(dnssec_sign_ctx_t *ctx, const dnssec_binary_t *data)
+{
+	int r;
+
+	size_t max_size = dnssec_sign_max_size(ctx);
+	ok(max_size > 0, "batch: maximal signature size");
+
+	dnssec_binary_t batch[3] = {
+		*data, binary_set_string("bind"), binary_set_string("knot is the best")
+	};
+	uint8_t buffer[3 * max_size];
+	dnssec_binary_t signatures[3];
+	for (int i = 0; i < 3; i++) {
+		signatures[i].data = buffer + i * max_size;
+		signatures[i].size = max_size;
+	}
+
+	r = dnssec_sign_batch(ctx, DNSSEC_SIGN_NORMAL, batch, 3, signatures);
+	ok(r == DNSSEC_EOK, "batch: write signatures");
+
+	bool valid = true;
+	for (int i = 0; i < 3; i++) {
+		valid = valid && signatures[i].size > 0 && signatures[i].size <= max_size &&
+		        dnssec_sign_init(ctx) == DNSSEC_EOK &&
+		        dnssec_sign_add(ctx, &batch[i]) == DNSSEC_EOK &&
+		        dnssec_sign_verify(ctx, false, &signatures[i]) == DNSSEC_EOK;
+	}
+	ok(valid, "batch: verify signatures");
+
+	r = dnssec_sign_batch(ctx, DNSSEC_SIGN_NORMAL, batch, 0, NULL);
+	ok(r == DNSSEC_EOK, "batch: empty");
+
+	signatures[0].size = max_size / 2;
+	r = dnssec_sign_batch(ctx, DNSSEC_SIGN_NORMAL, batch, 1, signatures);
+	ok(r != DNSSEC_EOK, "batch: small buffer");
+}
+
 static void check_key(const key_parameters_t *key_data, const dnssec_binary_t *data,
 		      const dnssec_binary_t *signature, bool signature_match)
 {
@@ -172,6 +209,10 @@ static void check_key(const key_parameters_t *key_data, const dnssec_binary_t *d
 
 	dnssec_binary_free(&new_signature);
 
+	// batch signing
+
+	check_batch(ctx, data);
+
 	// cleanup
 
 	dnssec_sign_free(ctx);